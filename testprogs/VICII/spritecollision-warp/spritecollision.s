@@ -0,0 +1,216 @@
+; spritecollision.s - sprite collisions on frames that are not drawn
+;
+; Moves eight sprites over a screen full of characters for 256 frames,
+; switching sprite multicolour, expansion and priority and text multicolour
+; as it goes. $d01f and $d01e are read once per frame in the lower border,
+; where no sprite is shown, and logged at $4000. A checksum of all reads is
+; compared to the one taken from x64sc with every frame drawn.
+;
+; Run it with and without -warp: in warp mode x64sc skips drawing the
+; frames that are not shown and only emulates the collisions, so both runs
+; must give the same result.
+;
+; The border turns green when the test passes and red when it fails, and
+; the result is written to the debug cartridge at $d7ff (0 = pass).
+
+debugcart   = $d7ff
+
+frame       = $02
+ptr         = $fb
+sum1        = $fd
+sum2        = $fe
+ypos        = $f0               ; 8 bytes, y phase of the odd sprites
+
+spritedata  = $2000
+log         = $4000
+
+expected1   = $f2
+expected2   = $2e
+
+            * = $0801
+            !byte $0b, $08, $0a, $00, $9e, $32, $30, $36, $31, $00, $00, $00
+
+start       sei
+            lda #0
+            sta $d020
+            sta $d021
+
+            ; a screen of all 256 characters, colours 0-15
+            ldx #0
+fill        txa
+            sta $0400,x
+            sta $0500,x
+            sta $0600,x
+            sta $0700,x
+            and #$0f
+            sta $d800,x
+            sta $d900,x
+            sta $da00,x
+            sta $db00,x
+            inx
+            bne fill
+
+            ldx #63
+data        txa
+            eor #$5a
+            sta spritedata,x
+            dex
+            bpl data
+
+            ldx #7
+sprites     lda #spritedata / 64
+            sta $07f8,x
+            txa
+            clc
+            adc #1
+            sta $d027,x
+            txa
+            asl
+            asl
+            asl
+            asl
+            clc
+            adc #30
+            sta ypos,x
+            dex
+            bpl sprites
+
+            ldx #0
+            ldy #0
+position    tya
+            asl
+            asl
+            asl
+            clc
+            adc #30
+            sta $d000,x
+            lda ypos,y
+            sta $d001,x
+            inx
+            inx
+            iny
+            cpy #8
+            bne position
+
+            lda #0
+            sta $d010
+            sta frame
+            sta sum1
+            sta sum2
+            sta ptr
+            lda #>log
+            sta ptr+1
+            lda #$ff
+            sta $d015
+            lda #$1b
+            sta $d011
+
+            ; the first reads clear what piled up while setting up
+            jsr wait
+            lda $d01f
+            lda $d01e
+
+loop        jsr wait
+
+            ldy #0
+            lda $d01f
+            sta (ptr),y
+            jsr checksum
+            iny
+            lda $d01e
+            sta (ptr),y
+            jsr checksum
+            lda ptr
+            clc
+            adc #2
+            sta ptr
+            bcc +
+            inc ptr+1
++
+
+            ; move the sprites at different speeds, the odd ones also down
+            inc $d000
+            inc $d002
+            inc $d002
+            inc $d004
+            inc $d004
+            inc $d004
+            inc $d006
+            inc $d008
+            inc $d008
+            inc $d00a
+            inc $d00a
+            inc $d00a
+            inc $d00c
+            inc $d00e
+            inc $d00e
+
+            ldx #1
+down        inc ypos,x
+            lda ypos,x
+            and #$7f
+            clc
+            adc #50
+            sta ytemp
+            txa
+            asl
+            tay
+            lda ytemp
+            sta $d001,y
+            inx
+            inx
+            cpx #9
+            bne down
+
+            ; mode bits from the frame counter
+            lda frame
+            sta $d01c
+            lsr
+            sta $d01d
+            lsr
+            sta $d017
+            lsr
+            eor #$55
+            sta $d01b
+            lda frame
+            and #$10
+            ora #$08
+            sta $d016
+
+            inc frame
+            beq +
+            jmp loop
++
+
+            ldx #5
+            lda #0
+            ldy sum1
+            cpy #expected1
+            bne fail
+            ldy sum2
+            cpy #expected2
+            beq done
+fail        ldx #10
+            lda #$ff
+done        stx $d020
+            sta debugcart
+            jmp *
+
+; wait for the start of raster line 250, below all sprites
+wait        lda $d012
+            cmp #250
+            beq wait
+-           lda $d012
+            cmp #250
+            bne -
+            rts
+
+checksum    clc
+            adc sum1
+            sta sum1
+            clc
+            adc sum2
+            sta sum2
+            rts
+
+ytemp       !byte 0
@@ -100,6 +100,7 @@ syn match vhkActionName "\<smart-attach\>"
 syn match vhkActionName "\<snapshot-load\>"
 syn match vhkActionName "\<snapshot-quickload\>"
 syn match vhkActionName "\<snapshot-quicksave\>"
+syn match vhkActionName "\<snapshot-rewind\>"
 syn match vhkActionName "\<snapshot-save\>"
 syn match vhkActionName "\<speed-cpu-\(10\|25\|50\|100\|200\|custom\)\>"
 syn match vhkActionName "\<speed-fps-\(50\|60\|custom\|real\)\>"
@@ -86,4 +86,49 @@
         }                                       \
     } while (0)
 
+/* Threaded opcode dispatch.  The CPU cores label their opcode handlers with
+   OPCODE() and end each of them with OPCODE_NEXT() instead of `break'.
+
+   With OPCODE_THREADED_DISPATCH, a core whose caller defines
+   CPU_CHAIN_ALLOWED() defines OPCODE_THREADED: OPCODE_NEXT() then does
+   the work between two opcodes itself, fetches the next opcode and jumps
+   straight to its handler through the core's table of handler addresses,
+   so that every handler has its own indirect jump for the host's branch
+   predictor to learn, instead of the single one of the `switch'.  This
+   only happens when nothing but the opcode fetch is due: no alarm, no
+   interrupt, not jammed, not profiling.  Otherwise OPCODE_NEXT() goes
+   back to the start of the core (opcode_start), past the work already
+   done, or leaves the `switch' like `break' when the caller does not want
+   the next opcode to run yet.
+
+   The caller defines:
+   - CPU_CHAIN_ALLOWED(): true if its loop would run the core again right
+     after this opcode, e.g. if the drive CPU has not reached its stop clock.
+   - CPU_OPCODE_DONE(): its work between two opcodes, which its loop must
+     also run after the core.  Optional.  */
+#if defined(FEATURE_THREADED_DISPATCH) && defined(__GNUC__) && !defined(DEBUG)
+#define OPCODE_THREADED_DISPATCH
+#endif
+
+#define OPCODE_LABEL(nr)    &&opcode_##nr
+
+/* Labels of the handlers for opcodes $00-$ff.  */
+#define OPCODE_LABELS_16(hi)                                        \
+    OPCODE_LABEL(hi##0), OPCODE_LABEL(hi##1), OPCODE_LABEL(hi##2),  \
+    OPCODE_LABEL(hi##3), OPCODE_LABEL(hi##4), OPCODE_LABEL(hi##5),  \
+    OPCODE_LABEL(hi##6), OPCODE_LABEL(hi##7), OPCODE_LABEL(hi##8),  \
+    OPCODE_LABEL(hi##9), OPCODE_LABEL(hi##a), OPCODE_LABEL(hi##b),  \
+    OPCODE_LABEL(hi##c), OPCODE_LABEL(hi##d), OPCODE_LABEL(hi##e),  \
+    OPCODE_LABEL(hi##f)
+
+#define OPCODE_LABELS_256                                           \
+    OPCODE_LABELS_16(0x0), OPCODE_LABELS_16(0x1),                   \
+    OPCODE_LABELS_16(0x2), OPCODE_LABELS_16(0x3),                   \
+    OPCODE_LABELS_16(0x4), OPCODE_LABELS_16(0x5),                   \
+    OPCODE_LABELS_16(0x6), OPCODE_LABELS_16(0x7),                   \
+    OPCODE_LABELS_16(0x8), OPCODE_LABELS_16(0x9),                   \
+    OPCODE_LABELS_16(0xa), OPCODE_LABELS_16(0xb),                   \
+    OPCODE_LABELS_16(0xc), OPCODE_LABELS_16(0xd),                   \
+    OPCODE_LABELS_16(0xe), OPCODE_LABELS_16(0xf)
+
 #endif
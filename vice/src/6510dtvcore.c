@@ -52,6 +52,7 @@
 #endif
 #endif
 
+#include "6510core.h"
 #include "traps.h"
 
 #include "profiler.h"
@@ -1706,6 +1707,84 @@ static const uint8_t fetch_tab[] = {
     /* $F0 */  0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 1, 1, 1  /* $F0 */
 };
 
+/* ------------------------------------------------------------------------ */
+/* Recording of the fetched opcode in the CPU history.  */
+
+#ifdef FEATURE_CPUMEMHISTORY
+#define HISTORY_FETCH_START()                                       \
+    do {                                                            \
+        debug_clk = maincpu_clk;                                    \
+        memmap_state |= (MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE); \
+    } while (0)
+
+/* If reg_pc >= bank_limit  then JSR (0x20) hasn't load p2 yet.
+   The earlier LOAD(reg_pc+2) hack can break stealing badly on x64sc.
+   The fixing is now handled in JSR(). */
+#define HISTORY_STORE_OPCODE()                                                  \
+    do {                                                                        \
+        monitor_cpuhistory_store(debug_clk, reg_pc, p0, p1, p2 >> 8,            \
+                                 reg_a_read, reg_x, reg_y, reg_sp,              \
+                                 LOCAL_STATUS(), ORIGIN_MEMSPACE);              \
+        memmap_state &= ~(MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE);            \
+    } while (0)
+#else
+#define HISTORY_FETCH_START()
+#define HISTORY_STORE_OPCODE()
+#endif
+
+/* ------------------------------------------------------------------------ */
+/* Threaded opcode dispatch, see 6510core.h.  */
+
+#if defined(OPCODE_THREADED_DISPATCH) && defined(CPU_CHAIN_ALLOWED)
+#define OPCODE_THREADED
+
+#ifndef CPU_OPCODE_DONE
+#define CPU_OPCODE_DONE()
+#endif
+
+#ifndef CHECK_AND_RUN_ALTERNATE_CPU
+#define CHECK_AND_RUN_ALTERNATE_CPU
+#endif
+
+#ifdef DRIVE_CPU
+#define OPCODE_PROFILING 0
+#else
+#define OPCODE_PROFILING maincpu_profiling
+#endif
+
+#ifdef OPCODE_UPDATE_IN_FETCH
+#define SET_FETCHED_OPCODE()
+#else
+#define SET_FETCHED_OPCODE() SET_LAST_OPCODE(p0)
+#endif
+
+#define OPCODE(nr) case nr: opcode_##nr:
+
+/* Run the work between two opcodes, then fetch the next opcode and jump to
+   its handler if nothing else is due.  This is the start of the core up to
+   the `switch' for an opcode that is not jammed and not profiled.  */
+#define OPCODE_NEXT()                                                   \
+    if (!CPU_CHAIN_ALLOWED() || OPCODE_PROFILING) {                     \
+        break;                                                          \
+    }                                                                   \
+    CPU_OPCODE_DONE();                                                  \
+    CHECK_AND_RUN_ALTERNATE_CPU                                         \
+    if (CLK >= alarm_context_next_pending_clk(ALARM_CONTEXT)            \
+        || CPU_INT_STATUS->global_pending_int != IK_NONE                \
+        || CPU_IS_JAMMED || OPCODE_PROFILING) {                         \
+        goto opcode_start;                                              \
+    }                                                                   \
+    HISTORY_FETCH_START();                                              \
+    SET_LAST_ADDR(reg_pc);                                              \
+    FETCH_OPCODE(opcode);                                               \
+    lastop = p0;                                                        \
+    HISTORY_STORE_OPCODE();                                             \
+    SET_FETCHED_OPCODE();                                               \
+    goto *opcode_dispatch_tab[p0]
+#else
+#define OPCODE(nr) case nr:
+#define OPCODE_NEXT() break
+#endif
 
 /* ------------------------------------------------------------------------ */
 
@@ -1731,6 +1810,9 @@ static const uint8_t fetch_tab[] = {
     CHECK_AND_RUN_ALTERNATE_CPU
 #endif
 
+#ifdef OPCODE_THREADED
+opcode_start:
+#endif
     while (CLK >= alarm_context_next_pending_clk(ALARM_CONTEXT)) {
         alarm_context_dispatch(ALARM_CONTEXT, CLK);
     }
@@ -1773,13 +1855,15 @@ static const uint8_t fetch_tab[] = {
 
     {
         opcode_t opcode;
-#if defined (DEBUG) || defined (FEATURE_CPUMEMHISTORY)
-        debug_clk = maincpu_clk;
+        static uint8_t lastop;
+#ifdef OPCODE_THREADED
+        static const void *const opcode_dispatch_tab[256] = { OPCODE_LABELS_256 };
 #endif
 
-#ifdef FEATURE_CPUMEMHISTORY
-        memmap_state |= (MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE);
+#ifdef DEBUG
+        debug_clk = maincpu_clk;
 #endif
+        HISTORY_FETCH_START();
 
 #if !defined(DRIVE_CPU)
         profiling_clock_start = CLK;
@@ -1799,25 +1883,16 @@ static const uint8_t fetch_tab[] = {
          * the value at the original jam location changed to a non-jam, for
          * whatever reason.
          */
-        {
-            static uint8_t lastop;
-            FETCH_OPCODE(opcode);
-            if (!CPU_IS_JAMMED) {
-                /* remember current opcode */
-                lastop = p0;
-            } else {
-                /* set opcode that made the cpu jam */
-                SET_OPCODE(lastop);
-            }
+        FETCH_OPCODE(opcode);
+        if (!CPU_IS_JAMMED) {
+            /* remember current opcode */
+            lastop = p0;
+        } else {
+            /* set opcode that made the cpu jam */
+            SET_OPCODE(lastop);
         }
 
-#ifdef FEATURE_CPUMEMHISTORY
-        /* If reg_pc >= bank_limit  then JSR (0x20) hasn't load p2 yet.
-           The earlier LOAD(reg_pc+2) hack can break stealing badly on x64sc.
-           The fixing is now handled in JSR(). */
-        monitor_cpuhistory_store(debug_clk, reg_pc, p0, p1, p2 >> 8, reg_a_read, reg_x, reg_y, reg_sp, LOCAL_STATUS(), ORIGIN_MEMSPACE);
-        memmap_state &= ~(MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE);
-#endif
+        HISTORY_STORE_OPCODE();
 
 #ifdef DEBUG
         if (TRACEFLG) {
@@ -1843,950 +1918,950 @@ trap_skipped:
 #endif
 
         switch (p0) {
-            case 0x00:          /* BRK */
+            OPCODE(0x00)        /* BRK */
                 BRK();
-                break;
+                OPCODE_NEXT();
 
-            case 0x01:          /* ORA ($nn,X) */
+            OPCODE(0x01)        /* ORA ($nn,X) */
                 ORA(GET_IND_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x02:          /* JAM - also used for traps */
+            OPCODE(0x02)        /* JAM - also used for traps */
                 STATIC_ASSERT(TRAP_OPCODE == 0x02);
                 JAM_02();
-                break;
-
-            case 0x22:          /* JAM */
-            case 0x52:          /* JAM */
-            case 0x62:          /* JAM */
-            case 0x72:          /* JAM */
-            case 0x92:          /* JAM */
-            case 0xb2:          /* JAM */
-            case 0xd2:          /* JAM */
-            case 0xf2:          /* JAM */
+                OPCODE_NEXT();
+
+            OPCODE(0x22)        /* JAM */
+            OPCODE(0x52)        /* JAM */
+            OPCODE(0x62)        /* JAM */
+            OPCODE(0x72)        /* JAM */
+            OPCODE(0x92)        /* JAM */
+            OPCODE(0xb2)        /* JAM */
+            OPCODE(0xd2)        /* JAM */
+            OPCODE(0xf2)        /* JAM */
 #ifndef C64DTV
-            case 0x12:          /* JAM */
-            case 0x32:          /* JAM */
-            case 0x42:          /* JAM */
+            OPCODE(0x12)        /* JAM */
+            OPCODE(0x32)        /* JAM */
+            OPCODE(0x42)        /* JAM */
 #endif
                 CPU_IS_JAMMED = 1;
                 REWIND_FETCH_OPCODE(CLK);
                 JAM();
-                break;
+                OPCODE_NEXT();
 
 #ifdef C64DTV
-            case 0x12:          /* BRA $nnnn */
+            OPCODE(0x12)        /* BRA $nnnn */
                 BRANCH(1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x32:          /* SAC #$nn */
+            OPCODE(0x32)        /* SAC #$nn */
                 SAC();
-                break;
+                OPCODE_NEXT();
 
-            case 0x42:          /* SIR #$nn */
+            OPCODE(0x42)        /* SIR #$nn */
                 SIR();
-                break;
+                OPCODE_NEXT();
 #endif
 
-            case 0x03:          /* SLO ($nn,X) */
+            OPCODE(0x03)        /* SLO ($nn,X) */
                 SLO(2, GET_IND_X, SET_IND_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x04:          /* NOOP $nn */
-            case 0x44:          /* NOOP $nn */
-            case 0x64:          /* NOOP $nn */
+            OPCODE(0x04)        /* NOOP $nn */
+            OPCODE(0x44)        /* NOOP $nn */
+            OPCODE(0x64)        /* NOOP $nn */
                 NOOP(GET_ZERO_DUMMY, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x05:          /* ORA $nn */
+            OPCODE(0x05)        /* ORA $nn */
                 ORA(GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x06:          /* ASL $nn */
+            OPCODE(0x06)        /* ASL $nn */
                 ASL(2, GET_ZERO, SET_ZERO_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x07:          /* SLO $nn */
+            OPCODE(0x07)        /* SLO $nn */
                 SLO(2, GET_ZERO, SET_ZERO_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x08:          /* PHP */
+            OPCODE(0x08)        /* PHP */
                 PHP();
-                break;
+                OPCODE_NEXT();
 
-            case 0x09:          /* ORA #$nn */
+            OPCODE(0x09)        /* ORA #$nn */
                 ORA(GET_IMM, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x0a:          /* ASL A */
+            OPCODE(0x0a)        /* ASL A */
                 ASL_A();
-                break;
+                OPCODE_NEXT();
 
-            case 0x0b:          /* ANC #$nn */
-            case 0x2b:          /* ANC #$nn */
+            OPCODE(0x0b)        /* ANC #$nn */
+            OPCODE(0x2b)        /* ANC #$nn */
                 ANC();
-                break;
+                OPCODE_NEXT();
 
-            case 0x0c:          /* NOOP $nnnn */
+            OPCODE(0x0c)        /* NOOP $nnnn */
                 NOOP(GET_ABS_DUMMY, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x0d:          /* ORA $nnnn */
+            OPCODE(0x0d)        /* ORA $nnnn */
                 ORA(GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x0e:          /* ASL $nnnn */
+            OPCODE(0x0e)        /* ASL $nnnn */
                 ASL(3, GET_ABS, SET_ABS_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x0f:          /* SLO $nnnn */
+            OPCODE(0x0f)        /* SLO $nnnn */
                 SLO(3, GET_ABS, SET_ABS_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x10:          /* BPL $nnnn */
+            OPCODE(0x10)        /* BPL $nnnn */
                 BRANCH(!LOCAL_SIGN());
-                break;
+                OPCODE_NEXT();
 
-            case 0x11:          /* ORA ($nn),Y */
+            OPCODE(0x11)        /* ORA ($nn),Y */
                 ORA(GET_IND_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x13:          /* SLO ($nn),Y */
+            OPCODE(0x13)        /* SLO ($nn),Y */
                 SLO(2, GET_IND_Y_RMW, SET_IND_RMW);
-                break;
-
-            case 0x14:          /* NOOP $nn,X */
-            case 0x34:          /* NOOP $nn,X */
-            case 0x54:          /* NOOP $nn,X */
-            case 0x74:          /* NOOP $nn,X */
-            case 0xd4:          /* NOOP $nn,X */
-            case 0xf4:          /* NOOP $nn,X */
+                OPCODE_NEXT();
+
+            OPCODE(0x14)        /* NOOP $nn,X */
+            OPCODE(0x34)        /* NOOP $nn,X */
+            OPCODE(0x54)        /* NOOP $nn,X */
+            OPCODE(0x74)        /* NOOP $nn,X */
+            OPCODE(0xd4)        /* NOOP $nn,X */
+            OPCODE(0xf4)        /* NOOP $nn,X */
                 NOOP(GET_ZERO_X_DUMMY, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x15:          /* ORA $nn,X */
+            OPCODE(0x15)        /* ORA $nn,X */
                 ORA(GET_ZERO_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x16:          /* ASL $nn,X */
+            OPCODE(0x16)        /* ASL $nn,X */
                 ASL(2, GET_ZERO_X, SET_ZERO_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x17:          /* SLO $nn,X */
+            OPCODE(0x17)        /* SLO $nn,X */
                 SLO(2, GET_ZERO_X, SET_ZERO_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x18:          /* CLC */
+            OPCODE(0x18)        /* CLC */
                 CLC();
-                break;
+                OPCODE_NEXT();
 
-            case 0x19:          /* ORA $nnnn,Y */
+            OPCODE(0x19)        /* ORA $nnnn,Y */
                 ORA(GET_ABS_Y, 3);
-                break;
-
-            case 0x1a:          /* NOOP */
-            case 0x3a:          /* NOOP */
-            case 0x5a:          /* NOOP */
-            case 0x7a:          /* NOOP */
-            case 0xda:          /* NOOP */
-            case 0xfa:          /* NOOP */
-            case 0xea:          /* NOP */
+                OPCODE_NEXT();
+
+            OPCODE(0x1a)        /* NOOP */
+            OPCODE(0x3a)        /* NOOP */
+            OPCODE(0x5a)        /* NOOP */
+            OPCODE(0x7a)        /* NOOP */
+            OPCODE(0xda)        /* NOOP */
+            OPCODE(0xfa)        /* NOOP */
+            OPCODE(0xea)        /* NOP */
                 NOOP(GET_IMM_DUMMY, 1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x1b:          /* SLO $nnnn,Y */
+            OPCODE(0x1b)        /* SLO $nnnn,Y */
                 SLO(3, GET_ABS_Y_RMW, SET_ABS_Y_RMW);
-                break;
-
-            case 0x1c:          /* NOOP $nnnn,X */
-            case 0x3c:          /* NOOP $nnnn,X */
-            case 0x5c:          /* NOOP $nnnn,X */
-            case 0x7c:          /* NOOP $nnnn,X */
-            case 0xdc:          /* NOOP $nnnn,X */
-            case 0xfc:          /* NOOP $nnnn,X */
+                OPCODE_NEXT();
+
+            OPCODE(0x1c)        /* NOOP $nnnn,X */
+            OPCODE(0x3c)        /* NOOP $nnnn,X */
+            OPCODE(0x5c)        /* NOOP $nnnn,X */
+            OPCODE(0x7c)        /* NOOP $nnnn,X */
+            OPCODE(0xdc)        /* NOOP $nnnn,X */
+            OPCODE(0xfc)        /* NOOP $nnnn,X */
                 NOOP(GET_ABS_X_DUMMY, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x1d:          /* ORA $nnnn,X */
+            OPCODE(0x1d)        /* ORA $nnnn,X */
                 ORA(GET_ABS_X, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x1e:          /* ASL $nnnn,X */
+            OPCODE(0x1e)        /* ASL $nnnn,X */
                 ASL(3, GET_ABS_X_RMW, SET_ABS_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x1f:          /* SLO $nnnn,X */
+            OPCODE(0x1f)        /* SLO $nnnn,X */
                 SLO(3, GET_ABS_X_RMW, SET_ABS_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x20:          /* JSR $nnnn */
+            OPCODE(0x20)        /* JSR $nnnn */
                 JSR();
-                break;
+                OPCODE_NEXT();
 
-            case 0x21:          /* AND ($nn,X) */
+            OPCODE(0x21)        /* AND ($nn,X) */
                 AND(GET_IND_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x23:          /* RLA ($nn,X) */
+            OPCODE(0x23)        /* RLA ($nn,X) */
                 RLA(2, GET_IND_X, SET_IND_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x24:          /* BIT $nn */
+            OPCODE(0x24)        /* BIT $nn */
                 BIT(GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x25:          /* AND $nn */
+            OPCODE(0x25)        /* AND $nn */
                 AND(GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x26:          /* ROL $nn */
+            OPCODE(0x26)        /* ROL $nn */
                 ROL(2, GET_ZERO, SET_ZERO_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x27:          /* RLA $nn */
+            OPCODE(0x27)        /* RLA $nn */
                 RLA(2, GET_ZERO, SET_ZERO_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x28:          /* PLP */
+            OPCODE(0x28)        /* PLP */
                 PLP();
-                break;
+                OPCODE_NEXT();
 
-            case 0x29:          /* AND #$nn */
+            OPCODE(0x29)        /* AND #$nn */
                 AND(GET_IMM, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x2a:          /* ROL A */
+            OPCODE(0x2a)        /* ROL A */
                 ROL_A();
-                break;
+                OPCODE_NEXT();
 
-            case 0x2c:          /* BIT $nnnn */
+            OPCODE(0x2c)        /* BIT $nnnn */
                 BIT(GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x2d:          /* AND $nnnn */
+            OPCODE(0x2d)        /* AND $nnnn */
                 AND(GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x2e:          /* ROL $nnnn */
+            OPCODE(0x2e)        /* ROL $nnnn */
                 ROL(3, GET_ABS, SET_ABS_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x2f:          /* RLA $nnnn */
+            OPCODE(0x2f)        /* RLA $nnnn */
                 RLA(3, GET_ABS, SET_ABS_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x30:          /* BMI $nnnn */
+            OPCODE(0x30)        /* BMI $nnnn */
                 BRANCH(LOCAL_SIGN());
-                break;
+                OPCODE_NEXT();
 
-            case 0x31:          /* AND ($nn),Y */
+            OPCODE(0x31)        /* AND ($nn),Y */
                 AND(GET_IND_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x33:          /* RLA ($nn),Y */
+            OPCODE(0x33)        /* RLA ($nn),Y */
                 RLA(2, GET_IND_Y_RMW, SET_IND_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x35:          /* AND $nn,X */
+            OPCODE(0x35)        /* AND $nn,X */
                 AND(GET_ZERO_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x36:          /* ROL $nn,X */
+            OPCODE(0x36)        /* ROL $nn,X */
                 ROL(2, GET_ZERO_X, SET_ZERO_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x37:          /* RLA $nn,X */
+            OPCODE(0x37)        /* RLA $nn,X */
                 RLA(2, GET_ZERO_X, SET_ZERO_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x38:          /* SEC */
+            OPCODE(0x38)        /* SEC */
                 SEC();
-                break;
+                OPCODE_NEXT();
 
-            case 0x39:          /* AND $nnnn,Y */
+            OPCODE(0x39)        /* AND $nnnn,Y */
                 AND(GET_ABS_Y, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x3b:          /* RLA $nnnn,Y */
+            OPCODE(0x3b)        /* RLA $nnnn,Y */
                 RLA(3, GET_ABS_Y_RMW, SET_ABS_Y_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x3d:          /* AND $nnnn,X */
+            OPCODE(0x3d)        /* AND $nnnn,X */
                 AND(GET_ABS_X, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x3e:          /* ROL $nnnn,X */
+            OPCODE(0x3e)        /* ROL $nnnn,X */
                 ROL(3, GET_ABS_X_RMW, SET_ABS_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x3f:          /* RLA $nnnn,X */
+            OPCODE(0x3f)        /* RLA $nnnn,X */
                 RLA(3, GET_ABS_X_RMW, SET_ABS_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x40:          /* RTI */
+            OPCODE(0x40)        /* RTI */
                 RTI();
-                break;
+                OPCODE_NEXT();
 
-            case 0x41:          /* EOR ($nn,X) */
+            OPCODE(0x41)        /* EOR ($nn,X) */
                 EOR(GET_IND_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x43:          /* SRE ($nn,X) */
+            OPCODE(0x43)        /* SRE ($nn,X) */
                 SRE(2, GET_IND_X, SET_IND_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x45:          /* EOR $nn */
+            OPCODE(0x45)        /* EOR $nn */
                 EOR(GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x46:          /* LSR $nn */
+            OPCODE(0x46)        /* LSR $nn */
                 LSR(2, GET_ZERO, SET_ZERO_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x47:          /* SRE $nn */
+            OPCODE(0x47)        /* SRE $nn */
                 SRE(2, GET_ZERO, SET_ZERO_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x48:          /* PHA */
+            OPCODE(0x48)        /* PHA */
                 PHA();
-                break;
+                OPCODE_NEXT();
 
-            case 0x49:          /* EOR #$nn */
+            OPCODE(0x49)        /* EOR #$nn */
                 EOR(GET_IMM, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x4a:          /* LSR A */
+            OPCODE(0x4a)        /* LSR A */
                 LSR_A();
-                break;
+                OPCODE_NEXT();
 
-            case 0x4b:          /* ASR #$nn */
+            OPCODE(0x4b)        /* ASR #$nn */
                 ASR();
-                break;
+                OPCODE_NEXT();
 
-            case 0x4c:          /* JMP $nnnn */
+            OPCODE(0x4c)        /* JMP $nnnn */
                 JMP(p2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x4d:          /* EOR $nnnn */
+            OPCODE(0x4d)        /* EOR $nnnn */
                 EOR(GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x4e:          /* LSR $nnnn */
+            OPCODE(0x4e)        /* LSR $nnnn */
                 LSR(3, GET_ABS, SET_ABS_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x4f:          /* SRE $nnnn */
+            OPCODE(0x4f)        /* SRE $nnnn */
                 SRE(3, GET_ABS, SET_ABS_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x50:          /* BVC $nnnn */
+            OPCODE(0x50)        /* BVC $nnnn */
                 BRANCH(!LOCAL_OVERFLOW());
-                break;
+                OPCODE_NEXT();
 
-            case 0x51:          /* EOR ($nn),Y */
+            OPCODE(0x51)        /* EOR ($nn),Y */
                 EOR(GET_IND_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x53:          /* SRE ($nn),Y */
+            OPCODE(0x53)        /* SRE ($nn),Y */
                 SRE(2, GET_IND_Y_RMW, SET_IND_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x55:          /* EOR $nn,X */
+            OPCODE(0x55)        /* EOR $nn,X */
                 EOR(GET_ZERO_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x56:          /* LSR $nn,X */
+            OPCODE(0x56)        /* LSR $nn,X */
                 LSR(2, GET_ZERO_X, SET_ZERO_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x57:          /* SRE $nn,X */
+            OPCODE(0x57)        /* SRE $nn,X */
                 SRE(2, GET_ZERO_X, SET_ZERO_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x58:          /* CLI */
+            OPCODE(0x58)        /* CLI */
                 CLI();
-                break;
+                OPCODE_NEXT();
 
-            case 0x59:          /* EOR $nnnn,Y */
+            OPCODE(0x59)        /* EOR $nnnn,Y */
                 EOR(GET_ABS_Y, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x5b:          /* SRE $nnnn,Y */
+            OPCODE(0x5b)        /* SRE $nnnn,Y */
                 SRE(3, GET_ABS_Y_RMW, SET_ABS_Y_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x5d:          /* EOR $nnnn,X */
+            OPCODE(0x5d)        /* EOR $nnnn,X */
                 EOR(GET_ABS_X, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x5e:          /* LSR $nnnn,X */
+            OPCODE(0x5e)        /* LSR $nnnn,X */
                 LSR(3, GET_ABS_X_RMW, SET_ABS_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x5f:          /* SRE $nnnn,X */
+            OPCODE(0x5f)        /* SRE $nnnn,X */
                 SRE(3, GET_ABS_X_RMW, SET_ABS_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x60:          /* RTS */
+            OPCODE(0x60)        /* RTS */
                 RTS();
-                break;
+                OPCODE_NEXT();
 
-            case 0x61:          /* ADC ($nn,X) */
+            OPCODE(0x61)        /* ADC ($nn,X) */
                 ADC(GET_IND_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x63:          /* RRA ($nn,X) */
+            OPCODE(0x63)        /* RRA ($nn,X) */
                 RRA(2, GET_IND_X, SET_IND_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x65:          /* ADC $nn */
+            OPCODE(0x65)        /* ADC $nn */
                 ADC(GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x66:          /* ROR $nn */
+            OPCODE(0x66)        /* ROR $nn */
                 ROR(2, GET_ZERO, SET_ZERO_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x67:          /* RRA $nn */
+            OPCODE(0x67)        /* RRA $nn */
                 RRA(2, GET_ZERO, SET_ZERO_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x68:          /* PLA */
+            OPCODE(0x68)        /* PLA */
                 PLA();
-                break;
+                OPCODE_NEXT();
 
-            case 0x69:          /* ADC #$nn */
+            OPCODE(0x69)        /* ADC #$nn */
                 ADC(GET_IMM, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x6a:          /* ROR A */
+            OPCODE(0x6a)        /* ROR A */
                 ROR_A();
-                break;
+                OPCODE_NEXT();
 
-            case 0x6b:          /* ARR #$nn */
+            OPCODE(0x6b)        /* ARR #$nn */
                 ARR();
-                break;
+                OPCODE_NEXT();
 
-            case 0x6c:          /* JMP ($nnnn) */
+            OPCODE(0x6c)        /* JMP ($nnnn) */
                 JMP_IND();
-                break;
+                OPCODE_NEXT();
 
-            case 0x6d:          /* ADC $nnnn */
+            OPCODE(0x6d)        /* ADC $nnnn */
                 ADC(GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x6e:          /* ROR $nnnn */
+            OPCODE(0x6e)        /* ROR $nnnn */
                 ROR(3, GET_ABS, SET_ABS_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x6f:          /* RRA $nnnn */
+            OPCODE(0x6f)        /* RRA $nnnn */
                 RRA(3, GET_ABS, SET_ABS_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x70:          /* BVS $nnnn */
+            OPCODE(0x70)        /* BVS $nnnn */
                 BRANCH(LOCAL_OVERFLOW());
-                break;
+                OPCODE_NEXT();
 
-            case 0x71:          /* ADC ($nn),Y */
+            OPCODE(0x71)        /* ADC ($nn),Y */
                 ADC(GET_IND_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x73:          /* RRA ($nn),Y */
+            OPCODE(0x73)        /* RRA ($nn),Y */
                 RRA(2, GET_IND_Y_RMW, SET_IND_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x75:          /* ADC $nn,X */
+            OPCODE(0x75)        /* ADC $nn,X */
                 ADC(GET_ZERO_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x76:          /* ROR $nn,X */
+            OPCODE(0x76)        /* ROR $nn,X */
                 ROR(2, GET_ZERO_X, SET_ZERO_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x77:          /* RRA $nn,X */
+            OPCODE(0x77)        /* RRA $nn,X */
                 RRA(2, GET_ZERO_X, SET_ZERO_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x78:          /* SEI */
+            OPCODE(0x78)        /* SEI */
                 SEI();
-                break;
+                OPCODE_NEXT();
 
-            case 0x79:          /* ADC $nnnn,Y */
+            OPCODE(0x79)        /* ADC $nnnn,Y */
                 ADC(GET_ABS_Y, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x7b:          /* RRA $nnnn,Y */
+            OPCODE(0x7b)        /* RRA $nnnn,Y */
                 RRA(3, GET_ABS_Y_RMW, SET_ABS_Y_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x7d:          /* ADC $nnnn,X */
+            OPCODE(0x7d)        /* ADC $nnnn,X */
                 ADC(GET_ABS_X, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x7e:          /* ROR $nnnn,X */
+            OPCODE(0x7e)        /* ROR $nnnn,X */
                 ROR(3, GET_ABS_X_RMW, SET_ABS_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x7f:          /* RRA $nnnn,X */
+            OPCODE(0x7f)        /* RRA $nnnn,X */
                 RRA(3, GET_ABS_X_RMW, SET_ABS_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x80:          /* NOOP #$nn */
-            case 0x82:          /* NOOP #$nn */
-            case 0x89:          /* NOOP #$nn */
-            case 0xc2:          /* NOOP #$nn */
-            case 0xe2:          /* NOOP #$nn */
+            OPCODE(0x80)        /* NOOP #$nn */
+            OPCODE(0x82)        /* NOOP #$nn */
+            OPCODE(0x89)        /* NOOP #$nn */
+            OPCODE(0xc2)        /* NOOP #$nn */
+            OPCODE(0xe2)        /* NOOP #$nn */
                 NOOP(GET_IMM_DUMMY, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x81:          /* STA ($nn,X) */
+            OPCODE(0x81)        /* STA ($nn,X) */
                 ST(reg_a_read, SET_IND_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x83:          /* SAX ($nn,X) */
+            OPCODE(0x83)        /* SAX ($nn,X) */
                 ST(reg_a_read & reg_x, SET_IND_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x84:          /* STY $nn */
+            OPCODE(0x84)        /* STY $nn */
                 ST(reg_y, SET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x85:          /* STA $nn */
+            OPCODE(0x85)        /* STA $nn */
                 ST(reg_a_read, SET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x86:          /* STX $nn */
+            OPCODE(0x86)        /* STX $nn */
                 ST(reg_x, SET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x87:          /* SAX $nn */
+            OPCODE(0x87)        /* SAX $nn */
                 ST(reg_a_read & reg_x, SET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x88:          /* DEY */
+            OPCODE(0x88)        /* DEY */
                 DEY();
-                break;
+                OPCODE_NEXT();
 
-            case 0x8a:          /* TXA */
+            OPCODE(0x8a)        /* TXA */
                 TXA();
-                break;
+                OPCODE_NEXT();
 
-            case 0x8b:          /* ANE #$nn */
+            OPCODE(0x8b)        /* ANE #$nn */
                 ANE();
-                break;
+                OPCODE_NEXT();
 
-            case 0x8c:          /* STY $nnnn */
+            OPCODE(0x8c)        /* STY $nnnn */
                 ST(reg_y, SET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x8d:          /* STA $nnnn */
+            OPCODE(0x8d)        /* STA $nnnn */
                 ST(reg_a_read, SET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x8e:          /* STX $nnnn */
+            OPCODE(0x8e)        /* STX $nnnn */
                 ST(reg_x, SET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x8f:          /* SAX $nnnn */
+            OPCODE(0x8f)        /* SAX $nnnn */
                 ST(reg_a_read & reg_x, SET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x90:          /* BCC $nnnn */
+            OPCODE(0x90)        /* BCC $nnnn */
                 BRANCH(!LOCAL_CARRY());
-                break;
+                OPCODE_NEXT();
 
-            case 0x91:          /* STA ($nn),Y */
+            OPCODE(0x91)        /* STA ($nn),Y */
                 ST(reg_a_read, SET_IND_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x93:          /* SHA ($nn),Y */
+            OPCODE(0x93)        /* SHA ($nn),Y */
                 SHA_IND_Y();
-                break;
+                OPCODE_NEXT();
 
-            case 0x94:          /* STY $nn,X */
+            OPCODE(0x94)        /* STY $nn,X */
                 ST(reg_y, SET_ZERO_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x95:          /* STA $nn,X */
+            OPCODE(0x95)        /* STA $nn,X */
                 ST(reg_a_read, SET_ZERO_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x96:          /* STX $nn,Y */
+            OPCODE(0x96)        /* STX $nn,Y */
                 ST(reg_x, SET_ZERO_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x97:          /* SAX $nn,Y */
+            OPCODE(0x97)        /* SAX $nn,Y */
                 ST(reg_a_read & reg_x, SET_ZERO_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x98:          /* TYA */
+            OPCODE(0x98)        /* TYA */
                 TYA();
-                break;
+                OPCODE_NEXT();
 
-            case 0x99:          /* STA $nnnn,Y */
+            OPCODE(0x99)        /* STA $nnnn,Y */
                 ST(reg_a_read, SET_ABS_Y, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x9a:          /* TXS */
+            OPCODE(0x9a)        /* TXS */
                 TXS();
-                break;
+                OPCODE_NEXT();
 
-            case 0x9b:          /* NOP (SHS) $nnnn,Y */
+            OPCODE(0x9b)        /* NOP (SHS) $nnnn,Y */
 #ifdef C64DTV
                 NOOP(GET_ABS_Y_DUMMY, 3);
 #else
                 SHS_ABS_Y();
 #endif
-                break;
+                OPCODE_NEXT();
 
-            case 0x9c:          /* SHY $nnnn,X */
+            OPCODE(0x9c)        /* SHY $nnnn,X */
                 SH_ABS_I(reg_y, reg_x);
-                break;
+                OPCODE_NEXT();
 
-            case 0x9d:          /* STA $nnnn,X */
+            OPCODE(0x9d)        /* STA $nnnn,X */
                 ST(reg_a_read, SET_ABS_X, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x9e:          /* SHX $nnnn,Y */
+            OPCODE(0x9e)        /* SHX $nnnn,Y */
                 SH_ABS_I(reg_x, reg_y);
-                break;
+                OPCODE_NEXT();
 
-            case 0x9f:          /* SHA $nnnn,Y */
+            OPCODE(0x9f)        /* SHA $nnnn,Y */
                 SH_ABS_I(reg_a_read & reg_x, reg_y);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa0:          /* LDY #$nn */
+            OPCODE(0xa0)        /* LDY #$nn */
                 LD(reg_y, GET_IMM, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa1:          /* LDA ($nn,X) */
+            OPCODE(0xa1)        /* LDA ($nn,X) */
                 LD(reg_a_write, GET_IND_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa2:          /* LDX #$nn */
+            OPCODE(0xa2)        /* LDX #$nn */
                 LD(reg_x, GET_IMM, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa3:          /* LAX ($nn,X) */
+            OPCODE(0xa3)        /* LAX ($nn,X) */
                 LAX(GET_IND_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa4:          /* LDY $nn */
+            OPCODE(0xa4)        /* LDY $nn */
                 LD(reg_y, GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa5:          /* LDA $nn */
+            OPCODE(0xa5)        /* LDA $nn */
                 LD(reg_a_write, GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa6:          /* LDX $nn */
+            OPCODE(0xa6)        /* LDX $nn */
                 LD(reg_x, GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa7:          /* LAX $nn */
+            OPCODE(0xa7)        /* LAX $nn */
                 LAX(GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa8:          /* TAY */
+            OPCODE(0xa8)        /* TAY */
                 TAY();
-                break;
+                OPCODE_NEXT();
 
-            case 0xa9:          /* LDA #$nn */
+            OPCODE(0xa9)        /* LDA #$nn */
                 LD(reg_a_write, GET_IMM, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xaa:          /* TAX */
+            OPCODE(0xaa)        /* TAX */
                 TAX();
-                break;
+                OPCODE_NEXT();
 
-            case 0xab:          /* LXA #$nn */
+            OPCODE(0xab)        /* LXA #$nn */
                 LXA();
-                break;
+                OPCODE_NEXT();
 
-            case 0xac:          /* LDY $nnnn */
+            OPCODE(0xac)        /* LDY $nnnn */
                 LD(reg_y, GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xad:          /* LDA $nnnn */
+            OPCODE(0xad)        /* LDA $nnnn */
                 LD(reg_a_write, GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xae:          /* LDX $nnnn */
+            OPCODE(0xae)        /* LDX $nnnn */
                 LD(reg_x, GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xaf:          /* LAX $nnnn */
+            OPCODE(0xaf)        /* LAX $nnnn */
                 LAX(GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb0:          /* BCS $nnnn */
+            OPCODE(0xb0)        /* BCS $nnnn */
                 BRANCH(LOCAL_CARRY());
-                break;
+                OPCODE_NEXT();
 
-            case 0xb1:          /* LDA ($nn),Y */
+            OPCODE(0xb1)        /* LDA ($nn),Y */
                 LD(reg_a_write, GET_IND_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb3:          /* LAX ($nn),Y */
+            OPCODE(0xb3)        /* LAX ($nn),Y */
                 LAX(GET_IND_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb4:          /* LDY $nn,X */
+            OPCODE(0xb4)        /* LDY $nn,X */
                 LD(reg_y, GET_ZERO_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb5:          /* LDA $nn,X */
+            OPCODE(0xb5)        /* LDA $nn,X */
                 LD(reg_a_write, GET_ZERO_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb6:          /* LDX $nn,Y */
+            OPCODE(0xb6)        /* LDX $nn,Y */
                 LD(reg_x, GET_ZERO_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb7:          /* LAX $nn,Y */
+            OPCODE(0xb7)        /* LAX $nn,Y */
                 LAX(GET_ZERO_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb8:          /* CLV */
+            OPCODE(0xb8)        /* CLV */
                 CLV();
-                break;
+                OPCODE_NEXT();
 
-            case 0xb9:          /* LDA $nnnn,Y */
+            OPCODE(0xb9)        /* LDA $nnnn,Y */
                 LD(reg_a_write, GET_ABS_Y, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xba:          /* TSX */
+            OPCODE(0xba)        /* TSX */
                 TSX();
-                break;
+                OPCODE_NEXT();
 
-            case 0xbb:          /* LAS $nnnn,Y */
+            OPCODE(0xbb)        /* LAS $nnnn,Y */
                 LAS();
-                break;
+                OPCODE_NEXT();
 
-            case 0xbc:          /* LDY $nnnn,X */
+            OPCODE(0xbc)        /* LDY $nnnn,X */
                 LD(reg_y, GET_ABS_X, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xbd:          /* LDA $nnnn,X */
+            OPCODE(0xbd)        /* LDA $nnnn,X */
                 LD(reg_a_write, GET_ABS_X, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xbe:          /* LDX $nnnn,Y */
+            OPCODE(0xbe)        /* LDX $nnnn,Y */
                 LD(reg_x, GET_ABS_Y, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xbf:          /* LAX $nnnn,Y */
+            OPCODE(0xbf)        /* LAX $nnnn,Y */
                 LAX(GET_ABS_Y, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc0:          /* CPY #$nn */
+            OPCODE(0xc0)        /* CPY #$nn */
                 CP(reg_y, GET_IMM, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc1:          /* CMP ($nn,X) */
+            OPCODE(0xc1)        /* CMP ($nn,X) */
                 CP(reg_a_read, GET_IND_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc3:          /* DCP ($nn,X) */
+            OPCODE(0xc3)        /* DCP ($nn,X) */
                 DCP(2, GET_IND_X, SET_IND_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc4:          /* CPY $nn */
+            OPCODE(0xc4)        /* CPY $nn */
                 CP(reg_y, GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc5:          /* CMP $nn */
+            OPCODE(0xc5)        /* CMP $nn */
                 CP(reg_a_read, GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc6:          /* DEC $nn */
+            OPCODE(0xc6)        /* DEC $nn */
                 DEC(2, GET_ZERO, SET_ZERO_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc7:          /* DCP $nn */
+            OPCODE(0xc7)        /* DCP $nn */
                 DCP(2, GET_ZERO, SET_ZERO_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc8:          /* INY */
+            OPCODE(0xc8)        /* INY */
                 INY();
-                break;
+                OPCODE_NEXT();
 
-            case 0xc9:          /* CMP #$nn */
+            OPCODE(0xc9)        /* CMP #$nn */
                 CP(reg_a_read, GET_IMM, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xca:          /* DEX */
+            OPCODE(0xca)        /* DEX */
                 DEX();
-                break;
+                OPCODE_NEXT();
 
-            case 0xcb:          /* SBX #$nn */
+            OPCODE(0xcb)        /* SBX #$nn */
                 SBX();
-                break;
+                OPCODE_NEXT();
 
-            case 0xcc:          /* CPY $nnnn */
+            OPCODE(0xcc)        /* CPY $nnnn */
                 CP(reg_y, GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xcd:          /* CMP $nnnn */
+            OPCODE(0xcd)        /* CMP $nnnn */
                 CP(reg_a_read, GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xce:          /* DEC $nnnn */
+            OPCODE(0xce)        /* DEC $nnnn */
                 DEC(3, GET_ABS, SET_ABS_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xcf:          /* DCP $nnnn */
+            OPCODE(0xcf)        /* DCP $nnnn */
                 DCP(3, GET_ABS, SET_ABS_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd0:          /* BNE $nnnn */
+            OPCODE(0xd0)        /* BNE $nnnn */
                 BRANCH(!LOCAL_ZERO());
-                break;
+                OPCODE_NEXT();
 
-            case 0xd1:          /* CMP ($nn),Y */
+            OPCODE(0xd1)        /* CMP ($nn),Y */
                 CP(reg_a_read, GET_IND_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd3:          /* DCP ($nn),Y */
+            OPCODE(0xd3)        /* DCP ($nn),Y */
                 DCP(2, GET_IND_Y_RMW, SET_IND_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd5:          /* CMP $nn,X */
+            OPCODE(0xd5)        /* CMP $nn,X */
                 CP(reg_a_read, GET_ZERO_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd6:          /* DEC $nn,X */
+            OPCODE(0xd6)        /* DEC $nn,X */
                 DEC(2, GET_ZERO_X, SET_ZERO_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd7:          /* DCP $nn,X */
+            OPCODE(0xd7)        /* DCP $nn,X */
                 DCP(2, GET_ZERO_X, SET_ZERO_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd8:          /* CLD */
+            OPCODE(0xd8)        /* CLD */
                 CLD();
-                break;
+                OPCODE_NEXT();
 
-            case 0xd9:          /* CMP $nnnn,Y */
+            OPCODE(0xd9)        /* CMP $nnnn,Y */
                 CP(reg_a_read, GET_ABS_Y, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xdb:          /* DCP $nnnn,Y */
+            OPCODE(0xdb)        /* DCP $nnnn,Y */
                 DCP(3, GET_ABS_Y_RMW, SET_ABS_Y_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xdd:          /* CMP $nnnn,X */
+            OPCODE(0xdd)        /* CMP $nnnn,X */
                 CP(reg_a_read, GET_ABS_X, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xde:          /* DEC $nnnn,X */
+            OPCODE(0xde)        /* DEC $nnnn,X */
                 DEC(3, GET_ABS_X_RMW, SET_ABS_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xdf:          /* DCP $nnnn,X */
+            OPCODE(0xdf)        /* DCP $nnnn,X */
                 DCP(3, GET_ABS_X_RMW, SET_ABS_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe0:          /* CPX #$nn */
+            OPCODE(0xe0)        /* CPX #$nn */
                 CP(reg_x, GET_IMM, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe1:          /* SBC ($nn,X) */
+            OPCODE(0xe1)        /* SBC ($nn,X) */
                 SBC(GET_IND_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe3:          /* ISB ($nn,X) */
+            OPCODE(0xe3)        /* ISB ($nn,X) */
                 ISB(2, GET_IND_X, SET_IND_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe4:          /* CPX $nn */
+            OPCODE(0xe4)        /* CPX $nn */
                 CP(reg_x, GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe5:          /* SBC $nn */
+            OPCODE(0xe5)        /* SBC $nn */
                 SBC(GET_ZERO, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe6:          /* INC $nn */
+            OPCODE(0xe6)        /* INC $nn */
                 INC(2, GET_ZERO, SET_ZERO_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe7:          /* ISB $nn */
+            OPCODE(0xe7)        /* ISB $nn */
                 ISB(2, GET_ZERO, SET_ZERO_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe8:          /* INX */
+            OPCODE(0xe8)        /* INX */
                 INX();
-                break;
+                OPCODE_NEXT();
 
-            case 0xe9:          /* SBC #$nn */
-            case 0xeb:          /* USBC #$nn (same as SBC) */
+            OPCODE(0xe9)        /* SBC #$nn */
+            OPCODE(0xeb)        /* USBC #$nn (same as SBC) */
                 SBC(GET_IMM, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xec:          /* CPX $nnnn */
+            OPCODE(0xec)        /* CPX $nnnn */
                 CP(reg_x, GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xed:          /* SBC $nnnn */
+            OPCODE(0xed)        /* SBC $nnnn */
                 SBC(GET_ABS, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xee:          /* INC $nnnn */
+            OPCODE(0xee)        /* INC $nnnn */
                 INC(3, GET_ABS, SET_ABS_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xef:          /* ISB $nnnn */
+            OPCODE(0xef)        /* ISB $nnnn */
                 ISB(3, GET_ABS, SET_ABS_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf0:          /* BEQ $nnnn */
+            OPCODE(0xf0)        /* BEQ $nnnn */
                 BRANCH(LOCAL_ZERO());
-                break;
+                OPCODE_NEXT();
 
-            case 0xf1:          /* SBC ($nn),Y */
+            OPCODE(0xf1)        /* SBC ($nn),Y */
                 SBC(GET_IND_Y, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf3:          /* ISB ($nn),Y */
+            OPCODE(0xf3)        /* ISB ($nn),Y */
                 ISB(2, GET_IND_Y_RMW, SET_IND_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf5:          /* SBC $nn,X */
+            OPCODE(0xf5)        /* SBC $nn,X */
                 SBC(GET_ZERO_X, 2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf6:          /* INC $nn,X */
+            OPCODE(0xf6)        /* INC $nn,X */
                 INC(2, GET_ZERO_X, SET_ZERO_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf7:          /* ISB $nn,X */
+            OPCODE(0xf7)        /* ISB $nn,X */
                 ISB(2, GET_ZERO_X, SET_ZERO_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf8:          /* SED */
+            OPCODE(0xf8)        /* SED */
                 SED();
-                break;
+                OPCODE_NEXT();
 
-            case 0xf9:          /* SBC $nnnn,Y */
+            OPCODE(0xf9)        /* SBC $nnnn,Y */
                 SBC(GET_ABS_Y, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xfb:          /* ISB $nnnn,Y */
+            OPCODE(0xfb)        /* ISB $nnnn,Y */
                 ISB(3, GET_ABS_Y_RMW, SET_ABS_Y_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xfd:          /* SBC $nnnn,X */
+            OPCODE(0xfd)        /* SBC $nnnn,X */
                 SBC(GET_ABS_X, 3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xfe:          /* INC $nnnn,X */
+            OPCODE(0xfe)        /* INC $nnnn,X */
                 INC(3, GET_ABS_X_RMW, SET_ABS_X_RMW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xff:          /* ISB $nnnn,X */
+            OPCODE(0xff)        /* ISB $nnnn,X */
                 ISB(3, GET_ABS_X_RMW, SET_ABS_X_RMW);
-                break;
+                OPCODE_NEXT();
         }
 
 #if !defined(DRIVE_CPU)
@@ -67,6 +67,7 @@
 #define CPU_STR "65816/65802 CPU"
 #endif
 
+#include "6510core.h"
 #include "traps.h"
 
 /* To avoid 'magic' numbers, the following defines are used. */
@@ -2541,17 +2542,55 @@
       }                                         \
   } while (0)
 
+/* ------------------------------------------------------------------------ */
+/* Threaded opcode dispatch, see 6510core.h.  */
+
+#if defined(OPCODE_THREADED_DISPATCH) && defined(CPU_CHAIN_ALLOWED)
+#define OPCODE_THREADED
+
+#ifndef CPU_OPCODE_DONE
+#define CPU_OPCODE_DONE()
+#endif
+
+#define OPCODE(nr) case nr: opcode_##nr:
+
+/* Run the work between two opcodes, then fetch the next opcode and jump to
+   its handler if no interrupt is due.  This is the start of the core up to
+   the `switch' for an opcode that is not an interrupt.  */
+#define OPCODE_NEXT()                                                   \
+    if (!CPU_CHAIN_ALLOWED()) {                                         \
+        break;                                                          \
+    }                                                                   \
+    CPU_OPCODE_DONE();                                                  \
+    if (interrupt65816 != IK_NONE) {                                    \
+        goto opcode_start;                                              \
+    }                                                                   \
+    CHECK_INTERRUPT();                                                  \
+    p0 = FETCH_PARAM(reg_pc);                                           \
+    SET_LAST_ADDR(reg_pc);                                              \
+    SET_LAST_OPCODE(p0);                                                \
+    goto *opcode_dispatch_tab[p0]
+#else
+#define OPCODE(nr) case nr:
+#define OPCODE_NEXT() break
+#endif
+
 /* ------------------------------------------------------------------------ */
 
 /* Here, the CPU is emulated. */
 
 {
-
+#ifdef OPCODE_THREADED
+opcode_start:
+#endif
     {
         unsigned int p0 = 0;
         unsigned int p1 = 0;
         unsigned int p2 = 0;
         unsigned int p3 = 0;
+#ifdef OPCODE_THREADED
+        static const void *const opcode_dispatch_tab[256] = { OPCODE_LABELS_256 };
+#endif
 #ifdef DEBUG
         CLOCK debug_clk = 0;
         unsigned int debug_pc = 0;
@@ -2603,1042 +2642,1042 @@ trap_skipped:
 
         switch (p0) {
 
-          case 0x00:            /* BRK */
+          OPCODE(0x00)          /* BRK */
             BRK();
-            break;
+            OPCODE_NEXT();
 
-          case 0x01:            /* ORA ($nn,X) */
+          OPCODE(0x01)          /* ORA ($nn,X) */
             ORA(LOAD_INDIRECT_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x02:            /* NOP #$nn - also used for traps */
+          OPCODE(0x02)          /* NOP #$nn - also used for traps */
             STATIC_ASSERT(TRAP_OPCODE == 0x02);
             COP_02();
-            break;
+            OPCODE_NEXT();
 
-          case 0x03:            /* ORA $nn,S */
+          OPCODE(0x03)          /* ORA $nn,S */
             ORA(LOAD_STACK_REL_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x04:            /* TSB $nn */
+          OPCODE(0x04)          /* TSB $nn */
             TSB(LOAD_DIRECT_PAGE_FUNC_RRW, STORE_DIRECT_PAGE_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x05:            /* ORA $nn */
+          OPCODE(0x05)          /* ORA $nn */
             ORA(LOAD_DIRECT_PAGE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x06:            /* ASL $nn */
+          OPCODE(0x06)          /* ASL $nn */
             ASL(LOAD_DIRECT_PAGE_FUNC_RRW, STORE_DIRECT_PAGE_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x07:            /* ORA [$nn] */
+          OPCODE(0x07)          /* ORA [$nn] */
             ORA(LOAD_INDIRECT_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x08:            /* PHP */
+          OPCODE(0x08)          /* PHP */
             PHP(STORE_STACK);
-            break;
+            OPCODE_NEXT();
 
-          case 0x09:            /* ORA #$nn */
+          OPCODE(0x09)          /* ORA #$nn */
             ORA(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x0a:            /* ASL A */
+          OPCODE(0x0a)          /* ASL A */
             ASL(LOAD_ACCU_RRW, STORE_ACCU_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x0b:            /* PHD */
+          OPCODE(0x0b)          /* PHD */
             PHD();
-            break;
+            OPCODE_NEXT();
 
-          case 0x0c:            /* TSB $nnnn */
+          OPCODE(0x0c)          /* TSB $nnnn */
             TSB(LOAD_ABS_FUNC_RRW, STORE_ABS_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x0d:            /* ORA $nnnn */
+          OPCODE(0x0d)          /* ORA $nnnn */
             ORA(LOAD_ABS_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x0e:            /* ASL $nnnn */
+          OPCODE(0x0e)          /* ASL $nnnn */
             ASL(LOAD_ABS_FUNC_RRW, STORE_ABS_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x0f:            /* ORA $nnnnnn */
+          OPCODE(0x0f)          /* ORA $nnnnnn */
             ORA(LOAD_ABS_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x10:            /* BPL $nnnn */
+          OPCODE(0x10)          /* BPL $nnnn */
             BRANCH(!LOCAL_SIGN());
-            break;
+            OPCODE_NEXT();
 
-          case 0x11:            /* ORA ($nn),Y */
+          OPCODE(0x11)          /* ORA ($nn),Y */
             ORA(LOAD_INDIRECT_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x12:            /* ORA ($nn) */
+          OPCODE(0x12)          /* ORA ($nn) */
             ORA(LOAD_INDIRECT_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x13:            /* ORA ($nn,S),Y */
+          OPCODE(0x13)          /* ORA ($nn,S),Y */
             ORA(LOAD_STACK_REL_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x14:            /* TRB $nn */
+          OPCODE(0x14)          /* TRB $nn */
             TRB(LOAD_DIRECT_PAGE_FUNC_RRW, STORE_DIRECT_PAGE_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x15:            /* ORA $nn,X */
+          OPCODE(0x15)          /* ORA $nn,X */
             ORA(LOAD_DIRECT_PAGE_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x16:            /* ASL $nn,X */
+          OPCODE(0x16)          /* ASL $nn,X */
             ASL(LOAD_DIRECT_PAGE_X_FUNC_RRW, STORE_DIRECT_PAGE_X_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x17:            /* ORA [$nn],Y */
+          OPCODE(0x17)          /* ORA [$nn],Y */
             ORA(LOAD_INDIRECT_LONG_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x18:            /* CLC */
+          OPCODE(0x18)          /* CLC */
             CLC();
-            break;
+            OPCODE_NEXT();
 
-          case 0x19:            /* ORA $nnnn,Y */
+          OPCODE(0x19)          /* ORA $nnnn,Y */
             ORA(LOAD_ABS_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x1a:            /* INA */
+          OPCODE(0x1a)          /* INA */
             INC(LOAD_ACCU_RRW, STORE_ACCU_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x1b:            /* TCS */
+          OPCODE(0x1b)          /* TCS */
             TCS();
-            break;
+            OPCODE_NEXT();
 
-          case 0x1c:            /* TRB $nnnn */
+          OPCODE(0x1c)          /* TRB $nnnn */
             TRB(LOAD_ABS_FUNC_RRW, STORE_ABS_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x1d:            /* ORA $nnnn,X */
+          OPCODE(0x1d)          /* ORA $nnnn,X */
             ORA(LOAD_ABS_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x1e:            /* ASL $nnnn,X */
+          OPCODE(0x1e)          /* ASL $nnnn,X */
             ASL(LOAD_ABS_X_FUNC_RRW, STORE_ABS_X_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x1f:            /* ORA $nnnnnn,X */
+          OPCODE(0x1f)          /* ORA $nnnnnn,X */
             ORA(LOAD_ABS_LONG_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x20:            /* JSR $nnnn */
+          OPCODE(0x20)          /* JSR $nnnn */
             JSR();
-            break;
+            OPCODE_NEXT();
 
-          case 0x21:            /* AND ($nn,X) */
+          OPCODE(0x21)          /* AND ($nn,X) */
             AND(LOAD_INDIRECT_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x22:            /* JSR $nnnnnn */
+          OPCODE(0x22)          /* JSR $nnnnnn */
             JSR_LONG();
-            break;
+            OPCODE_NEXT();
 
-          case 0x23:            /* AND $nn,S */
+          OPCODE(0x23)          /* AND $nn,S */
             AND(LOAD_STACK_REL_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x24:            /* BIT $nn */
+          OPCODE(0x24)          /* BIT $nn */
             BIT(LOAD_DIRECT_PAGE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x25:            /* AND $nn */
+          OPCODE(0x25)          /* AND $nn */
             AND(LOAD_DIRECT_PAGE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x26:            /* ROL $nn */
+          OPCODE(0x26)          /* ROL $nn */
             ROL(LOAD_DIRECT_PAGE_FUNC_RRW, STORE_DIRECT_PAGE_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x27:            /* AND [$nn] */
+          OPCODE(0x27)          /* AND [$nn] */
             AND(LOAD_INDIRECT_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x28:            /* PLP */
+          OPCODE(0x28)          /* PLP */
             PLP(LOAD_STACK);
-            break;
+            OPCODE_NEXT();
 
-          case 0x29:            /* AND #$nn */
+          OPCODE(0x29)          /* AND #$nn */
             AND(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x2a:            /* ROL A */
+          OPCODE(0x2a)          /* ROL A */
             ROL(LOAD_ACCU_RRW, STORE_ACCU_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x2b:            /* PLD */
+          OPCODE(0x2b)          /* PLD */
             PLD();
-            break;
+            OPCODE_NEXT();
 
-          case 0x2c:            /* BIT $nnnn */
+          OPCODE(0x2c)          /* BIT $nnnn */
             BIT(LOAD_ABS_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x2d:            /* AND $nnnn */
+          OPCODE(0x2d)          /* AND $nnnn */
             AND(LOAD_ABS_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x2e:            /* ROL $nnnn */
+          OPCODE(0x2e)          /* ROL $nnnn */
             ROL(LOAD_ABS_FUNC_RRW, STORE_ABS_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x2f:            /* AND $nnnnnn */
+          OPCODE(0x2f)          /* AND $nnnnnn */
             AND(LOAD_ABS_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x30:            /* BMI $nnnn */
+          OPCODE(0x30)          /* BMI $nnnn */
             BRANCH(LOCAL_SIGN());
-            break;
+            OPCODE_NEXT();
 
-          case 0x31:            /* AND ($nn),Y */
+          OPCODE(0x31)          /* AND ($nn),Y */
             AND(LOAD_INDIRECT_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x32:            /* AND ($nn) */
+          OPCODE(0x32)          /* AND ($nn) */
             AND(LOAD_INDIRECT_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x33:            /* AND ($nn,S),Y */
+          OPCODE(0x33)          /* AND ($nn,S),Y */
             AND(LOAD_STACK_REL_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x34:            /* BIT $nn,X */
+          OPCODE(0x34)          /* BIT $nn,X */
             BIT(LOAD_DIRECT_PAGE_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x35:            /* AND $nn,X */
+          OPCODE(0x35)          /* AND $nn,X */
             AND(LOAD_DIRECT_PAGE_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x36:            /* ROL $nn,X */
+          OPCODE(0x36)          /* ROL $nn,X */
             ROL(LOAD_DIRECT_PAGE_X_FUNC_RRW, STORE_DIRECT_PAGE_X_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x37:            /* AND [$nn],Y */
+          OPCODE(0x37)          /* AND [$nn],Y */
             AND(LOAD_INDIRECT_LONG_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x38:            /* SEC */
+          OPCODE(0x38)          /* SEC */
             SEC();
-            break;
+            OPCODE_NEXT();
 
-          case 0x39:            /* AND $nnnn,Y */
+          OPCODE(0x39)          /* AND $nnnn,Y */
             AND(LOAD_ABS_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x3a:            /* DEA */
+          OPCODE(0x3a)          /* DEA */
             DEC(LOAD_ACCU_RRW, STORE_ACCU_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x3b:            /* TSC */
+          OPCODE(0x3b)          /* TSC */
             TSC();
-            break;
+            OPCODE_NEXT();
 
-          case 0x3c:            /* BIT $nnnn,X */
+          OPCODE(0x3c)          /* BIT $nnnn,X */
             BIT(LOAD_ABS_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x3d:            /* AND $nnnn,X */
+          OPCODE(0x3d)          /* AND $nnnn,X */
             AND(LOAD_ABS_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x3e:            /* ROL $nnnn,X */
+          OPCODE(0x3e)          /* ROL $nnnn,X */
             ROL(LOAD_ABS_X_FUNC_RRW, STORE_ABS_X_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x3f:            /* AND $nnnnnn,X */
+          OPCODE(0x3f)          /* AND $nnnnnn,X */
             AND(LOAD_ABS_LONG_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x40:            /* RTI */
+          OPCODE(0x40)          /* RTI */
             RTI();
-            break;
+            OPCODE_NEXT();
 
-          case 0x41:            /* EOR ($nn,X) */
+          OPCODE(0x41)          /* EOR ($nn,X) */
             EOR(LOAD_INDIRECT_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x42:            /* WDM */
+          OPCODE(0x42)          /* WDM */
             WDM();
-            break;
+            OPCODE_NEXT();
 
-          case 0x43:            /* EOR $nn,S */
+          OPCODE(0x43)          /* EOR $nn,S */
             EOR(LOAD_STACK_REL_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x44:            /* MVP $nn,$nn */
+          OPCODE(0x44)          /* MVP $nn,$nn */
             MVP();
-            break;
+            OPCODE_NEXT();
 
-          case 0x45:            /* EOR $nn */
+          OPCODE(0x45)          /* EOR $nn */
             EOR(LOAD_DIRECT_PAGE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x46:            /* LSR $nn */
+          OPCODE(0x46)          /* LSR $nn */
             LSR(LOAD_DIRECT_PAGE_FUNC_RRW, STORE_DIRECT_PAGE_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x47:            /* EOR [$nn] */
+          OPCODE(0x47)          /* EOR [$nn] */
             EOR(LOAD_INDIRECT_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x48:            /* PHA */
+          OPCODE(0x48)          /* PHA */
             PHA(STORE_STACK);
-            break;
+            OPCODE_NEXT();
 
-          case 0x49:            /* EOR #$nn */
+          OPCODE(0x49)          /* EOR #$nn */
             EOR(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x4a:            /* LSR A */
+          OPCODE(0x4a)          /* LSR A */
             LSR(LOAD_ACCU_RRW, STORE_ACCU_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x4b:            /* PHK */
+          OPCODE(0x4b)          /* PHK */
             PHK(STORE_STACK);
-            break;
+            OPCODE_NEXT();
 
-          case 0x4c:            /* JMP $nnnn */
+          OPCODE(0x4c)          /* JMP $nnnn */
             JMP();
-            break;
+            OPCODE_NEXT();
 
-          case 0x4d:            /* EOR $nnnn */
+          OPCODE(0x4d)          /* EOR $nnnn */
             EOR(LOAD_ABS_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x4e:            /* LSR $nnnn */
+          OPCODE(0x4e)          /* LSR $nnnn */
             LSR(LOAD_ABS_FUNC_RRW, STORE_ABS_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x4f:            /* EOR $nnnnnn */
+          OPCODE(0x4f)          /* EOR $nnnnnn */
             EOR(LOAD_ABS_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x50:            /* BVC $nnnn */
+          OPCODE(0x50)          /* BVC $nnnn */
             BRANCH(!LOCAL_OVERFLOW());
-            break;
+            OPCODE_NEXT();
 
-          case 0x51:            /* EOR ($nn),Y */
+          OPCODE(0x51)          /* EOR ($nn),Y */
             EOR(LOAD_INDIRECT_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x52:            /* EOR ($nn) */
+          OPCODE(0x52)          /* EOR ($nn) */
             EOR(LOAD_INDIRECT_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x53:            /* EOR ($nn,S),Y */
+          OPCODE(0x53)          /* EOR ($nn,S),Y */
             EOR(LOAD_STACK_REL_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x54:            /* MVN $nn,$nn */
+          OPCODE(0x54)          /* MVN $nn,$nn */
             MVN();
-            break;
+            OPCODE_NEXT();
 
-          case 0x55:            /* EOR $nn,X */
+          OPCODE(0x55)          /* EOR $nn,X */
             EOR(LOAD_DIRECT_PAGE_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x56:            /* LSR $nn,X */
+          OPCODE(0x56)          /* LSR $nn,X */
             LSR(LOAD_DIRECT_PAGE_X_FUNC_RRW, STORE_DIRECT_PAGE_X_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x57:            /* EOR [$nn],Y */
+          OPCODE(0x57)          /* EOR [$nn],Y */
             EOR(LOAD_INDIRECT_LONG_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x58:            /* CLI */
+          OPCODE(0x58)          /* CLI */
             CLI();
-            break;
+            OPCODE_NEXT();
 
-          case 0x59:            /* EOR $nnnn,Y */
+          OPCODE(0x59)          /* EOR $nnnn,Y */
             EOR(LOAD_ABS_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x5a:            /* PHY */
+          OPCODE(0x5a)          /* PHY */
             PHY(STORE_STACK);
-            break;
+            OPCODE_NEXT();
 
-          case 0x5b:            /* TCD */
+          OPCODE(0x5b)          /* TCD */
             TCD();
-            break;
+            OPCODE_NEXT();
 
-          case 0x5c:            /* JMP $nnnnnn */
+          OPCODE(0x5c)          /* JMP $nnnnnn */
             JMP_LONG();
-            break;
+            OPCODE_NEXT();
 
-          case 0x5d:            /* EOR $nnnn,X */
+          OPCODE(0x5d)          /* EOR $nnnn,X */
             EOR(LOAD_ABS_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x5e:            /* LSR $nnnn,X */
+          OPCODE(0x5e)          /* LSR $nnnn,X */
             LSR(LOAD_ABS_X_FUNC_RRW, STORE_ABS_X_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x5f:            /* EOR $nnnnnn,X */
+          OPCODE(0x5f)          /* EOR $nnnnnn,X */
             EOR(LOAD_ABS_LONG_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x60:            /* RTS */
+          OPCODE(0x60)          /* RTS */
             RTS();
-            break;
+            OPCODE_NEXT();
 
-          case 0x61:            /* ADC ($nn,X) */
+          OPCODE(0x61)          /* ADC ($nn,X) */
             ADC(LOAD_INDIRECT_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x62:            /* PER $nnnn */
+          OPCODE(0x62)          /* PER $nnnn */
             PER();
-            break;
+            OPCODE_NEXT();
 
-          case 0x63:            /* ADC $nn,S */
+          OPCODE(0x63)          /* ADC $nn,S */
             ADC(LOAD_STACK_REL_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x64:            /* STZ $nn */
+          OPCODE(0x64)          /* STZ $nn */
             STZ(STORE_DIRECT_PAGE);
-            break;
+            OPCODE_NEXT();
 
-          case 0x65:            /* ADC $nn */
+          OPCODE(0x65)          /* ADC $nn */
             ADC(LOAD_DIRECT_PAGE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x66:            /* ROR $nn */
+          OPCODE(0x66)          /* ROR $nn */
             ROR(LOAD_DIRECT_PAGE_FUNC_RRW, STORE_DIRECT_PAGE_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x67:            /* ADC [$nn] */
+          OPCODE(0x67)          /* ADC [$nn] */
             ADC(LOAD_INDIRECT_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x68:            /* PLA */
+          OPCODE(0x68)          /* PLA */
             PLA(LOAD_STACK);
-            break;
+            OPCODE_NEXT();
 
-          case 0x69:            /* ADC #$nn */
+          OPCODE(0x69)          /* ADC #$nn */
             ADC(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x6a:            /* ROR A */
+          OPCODE(0x6a)          /* ROR A */
             ROR(LOAD_ACCU_RRW, STORE_ACCU_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x6b:            /* RTL */
+          OPCODE(0x6b)          /* RTL */
             RTL();
-            break;
+            OPCODE_NEXT();
 
-          case 0x6c:            /* JMP ($nnnn) */
+          OPCODE(0x6c)          /* JMP ($nnnn) */
             JMP_IND();
-            break;
+            OPCODE_NEXT();
 
-          case 0x6d:            /* ADC $nnnn */
+          OPCODE(0x6d)          /* ADC $nnnn */
             ADC(LOAD_ABS_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x6e:            /* ROR $nnnn */
+          OPCODE(0x6e)          /* ROR $nnnn */
             ROR(LOAD_ABS_FUNC_RRW, STORE_ABS_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x6f:            /* ADC $nnnnnn */
+          OPCODE(0x6f)          /* ADC $nnnnnn */
             ADC(LOAD_ABS_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x70:            /* BVS $nnnn */
+          OPCODE(0x70)          /* BVS $nnnn */
             BRANCH(LOCAL_OVERFLOW());
-            break;
+            OPCODE_NEXT();
 
-          case 0x71:            /* ADC ($nn),Y */
+          OPCODE(0x71)          /* ADC ($nn),Y */
             ADC(LOAD_INDIRECT_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x72:            /* ADC ($nn) */
+          OPCODE(0x72)          /* ADC ($nn) */
             ADC(LOAD_INDIRECT_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x73:            /* ADC ($nn,S),Y */
+          OPCODE(0x73)          /* ADC ($nn,S),Y */
             ADC(LOAD_STACK_REL_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x74:            /* STZ $nn,X */
+          OPCODE(0x74)          /* STZ $nn,X */
             STZ(STORE_DIRECT_PAGE_X);
-            break;
+            OPCODE_NEXT();
 
-          case 0x75:            /* ADC $nn,X */
+          OPCODE(0x75)          /* ADC $nn,X */
             ADC(LOAD_DIRECT_PAGE_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x76:            /* ROR $nn,X */
+          OPCODE(0x76)          /* ROR $nn,X */
             ROR(LOAD_DIRECT_PAGE_X_FUNC_RRW, STORE_DIRECT_PAGE_X_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x77:            /* ADC [$nn],Y */
+          OPCODE(0x77)          /* ADC [$nn],Y */
             ADC(LOAD_INDIRECT_LONG_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x78:            /* SEI */
+          OPCODE(0x78)          /* SEI */
             SEI();
-            break;
+            OPCODE_NEXT();
 
-          case 0x79:            /* ADC $nnnn,Y */
+          OPCODE(0x79)          /* ADC $nnnn,Y */
             ADC(LOAD_ABS_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x7a:            /* PLY */
+          OPCODE(0x7a)          /* PLY */
             PLY(LOAD_STACK);
-            break;
+            OPCODE_NEXT();
 
-          case 0x7b:            /* TDC */
+          OPCODE(0x7b)          /* TDC */
             TDC();
-            break;
+            OPCODE_NEXT();
 
-          case 0x7c:            /* JMP ($nnnn,X) */
+          OPCODE(0x7c)          /* JMP ($nnnn,X) */
             JMP_IND_X();
-            break;
+            OPCODE_NEXT();
 
-          case 0x7d:            /* ADC $nnnn,X */
+          OPCODE(0x7d)          /* ADC $nnnn,X */
             ADC(LOAD_ABS_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x7e:            /* ROR $nnnn,X */
+          OPCODE(0x7e)          /* ROR $nnnn,X */
             ROR(LOAD_ABS_X_FUNC_RRW, STORE_ABS_X_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0x7f:            /* ADC $nnnnnn,X */
+          OPCODE(0x7f)          /* ADC $nnnnnn,X */
             ADC(LOAD_ABS_LONG_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x80:            /* BRA $nnnn */
+          OPCODE(0x80)          /* BRA $nnnn */
             BRANCH(1);
-            break;
+            OPCODE_NEXT();
 
-          case 0x81:            /* STA ($nn,X) */
+          OPCODE(0x81)          /* STA ($nn,X) */
             STA(STORE_INDIRECT_X);
-            break;
+            OPCODE_NEXT();
 
-          case 0x82:            /* BRL $nnnn */
+          OPCODE(0x82)          /* BRL $nnnn */
             BRANCH_LONG();
-            break;
+            OPCODE_NEXT();
 
-          case 0x83:            /* STA $nn,S */
+          OPCODE(0x83)          /* STA $nn,S */
             STA(STORE_STACK_REL);
-            break;
+            OPCODE_NEXT();
 
-          case 0x84:            /* STY $nn */
+          OPCODE(0x84)          /* STY $nn */
             STY(STORE_DIRECT_PAGE);
-            break;
+            OPCODE_NEXT();
 
-          case 0x85:            /* STA $nn */
+          OPCODE(0x85)          /* STA $nn */
             STA(STORE_DIRECT_PAGE);
-            break;
+            OPCODE_NEXT();
 
-          case 0x86:            /* STX $nn */
+          OPCODE(0x86)          /* STX $nn */
             STX(STORE_DIRECT_PAGE);
-            break;
+            OPCODE_NEXT();
 
-          case 0x87:            /* STA [$nn] */
+          OPCODE(0x87)          /* STA [$nn] */
             STA(STORE_INDIRECT_LONG);
-            break;
+            OPCODE_NEXT();
 
-          case 0x88:            /* DEY */
+          OPCODE(0x88)          /* DEY */
             DEY();
-            break;
+            OPCODE_NEXT();
 
-          case 0x89:            /* BIT #$nn */
+          OPCODE(0x89)          /* BIT #$nn */
             BIT_IMM(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0x8a:            /* TXA */
+          OPCODE(0x8a)          /* TXA */
             TXA();
-            break;
+            OPCODE_NEXT();
 
-          case 0x8b:            /* PHB */
+          OPCODE(0x8b)          /* PHB */
             PHB(STORE_STACK);
-            break;
+            OPCODE_NEXT();
 
-          case 0x8c:            /* STY $nnnn */
+          OPCODE(0x8c)          /* STY $nnnn */
             STY(STORE_ABS);
-            break;
+            OPCODE_NEXT();
 
-          case 0x8d:            /* STA $nnnn */
+          OPCODE(0x8d)          /* STA $nnnn */
             STA(STORE_ABS);
-            break;
+            OPCODE_NEXT();
 
-          case 0x8e:            /* STX $nnnn */
+          OPCODE(0x8e)          /* STX $nnnn */
             STX(STORE_ABS);
-            break;
+            OPCODE_NEXT();
 
-          case 0x8f:            /* STA $nnnnnn */
+          OPCODE(0x8f)          /* STA $nnnnnn */
             STA(STORE_ABS_LONG);
-            break;
+            OPCODE_NEXT();
 
-          case 0x90:            /* BCC $nnnn */
+          OPCODE(0x90)          /* BCC $nnnn */
             BRANCH(!LOCAL_CARRY());
-            break;
+            OPCODE_NEXT();
 
-          case 0x91:            /* STA ($nn),Y */
+          OPCODE(0x91)          /* STA ($nn),Y */
             STA(STORE_INDIRECT_Y);
-            break;
+            OPCODE_NEXT();
 
-          case 0x92:            /* STA ($nn) */
+          OPCODE(0x92)          /* STA ($nn) */
             STA(STORE_INDIRECT);
-            break;
+            OPCODE_NEXT();
 
-          case 0x93:            /* STA ($nn,S),Y */
+          OPCODE(0x93)          /* STA ($nn,S),Y */
             STA(STORE_STACK_REL_Y);
-            break;
+            OPCODE_NEXT();
 
-          case 0x94:            /* STY $nn,X */
+          OPCODE(0x94)          /* STY $nn,X */
             STY(STORE_DIRECT_PAGE_X);
-            break;
+            OPCODE_NEXT();
 
-          case 0x95:            /* STA $nn,X */
+          OPCODE(0x95)          /* STA $nn,X */
             STA(STORE_DIRECT_PAGE_X);
-            break;
+            OPCODE_NEXT();
 
-          case 0x96:            /* STX $nn,Y */
+          OPCODE(0x96)          /* STX $nn,Y */
             STX(STORE_DIRECT_PAGE_Y);
-            break;
+            OPCODE_NEXT();
 
-          case 0x97:            /* STA [$nn],Y */
+          OPCODE(0x97)          /* STA [$nn],Y */
             STA(STORE_INDIRECT_LONG_Y);
-            break;
+            OPCODE_NEXT();
 
-          case 0x98:            /* TYA */
+          OPCODE(0x98)          /* TYA */
             TYA();
-            break;
+            OPCODE_NEXT();
 
-          case 0x99:            /* STA $nnnn,Y */
+          OPCODE(0x99)          /* STA $nnnn,Y */
             STA(STORE_ABS_Y);
-            break;
+            OPCODE_NEXT();
 
-          case 0x9a:            /* TXS */
+          OPCODE(0x9a)          /* TXS */
             TXS();
-            break;
+            OPCODE_NEXT();
 
-          case 0x9b:            /* TXY */
+          OPCODE(0x9b)          /* TXY */
             TXY();
-            break;
+            OPCODE_NEXT();
 
-          case 0x9c:            /* STZ $nnnn */
+          OPCODE(0x9c)          /* STZ $nnnn */
             STZ(STORE_ABS);
-            break;
+            OPCODE_NEXT();
 
-          case 0x9d:            /* STA $nnnn,X */
+          OPCODE(0x9d)          /* STA $nnnn,X */
             STA(STORE_ABS_X);
-            break;
+            OPCODE_NEXT();
 
-          case 0x9e:            /* STZ $nnnn,X */
+          OPCODE(0x9e)          /* STZ $nnnn,X */
             STZ(STORE_ABS_X);
-            break;
+            OPCODE_NEXT();
 
-          case 0x9f:            /* STA $nnnnnn,X */
+          OPCODE(0x9f)          /* STA $nnnnnn,X */
             STA(STORE_ABS_LONG_X);
-            break;
+            OPCODE_NEXT();
 
-          case 0xa0:            /* LDY #$nn */
+          OPCODE(0xa0)          /* LDY #$nn */
             LDY(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xa1:            /* LDA ($nn,X) */
+          OPCODE(0xa1)          /* LDA ($nn,X) */
             LDA(LOAD_INDIRECT_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xa2:            /* LDX #$nn */
+          OPCODE(0xa2)          /* LDX #$nn */
             LDX(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xa3:            /* LDA $nn,S */
+          OPCODE(0xa3)          /* LDA $nn,S */
             LDA(LOAD_STACK_REL_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xa4:            /* LDY $nn */
+          OPCODE(0xa4)          /* LDY $nn */
             LDY(LOAD_DIRECT_PAGE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xa5:            /* LDA $nn */
+          OPCODE(0xa5)          /* LDA $nn */
             LDA(LOAD_DIRECT_PAGE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xa6:            /* LDX $nn */
+          OPCODE(0xa6)          /* LDX $nn */
             LDX(LOAD_DIRECT_PAGE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xa7:            /* LDA [$nn] */
+          OPCODE(0xa7)          /* LDA [$nn] */
             LDA(LOAD_INDIRECT_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xa8:            /* TAY */
+          OPCODE(0xa8)          /* TAY */
             TAY();
-            break;
+            OPCODE_NEXT();
 
-          case 0xa9:            /* LDA #$nn */
+          OPCODE(0xa9)          /* LDA #$nn */
             LDA(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xaa:            /* TAX */
+          OPCODE(0xaa)          /* TAX */
             TAX();
-            break;
+            OPCODE_NEXT();
 
-          case 0xab:            /* PLB */
+          OPCODE(0xab)          /* PLB */
             PLB(LOAD_STACK);
-            break;
+            OPCODE_NEXT();
 
-          case 0xac:            /* LDY $nnnn */
+          OPCODE(0xac)          /* LDY $nnnn */
             LDY(LOAD_ABS_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xad:            /* LDA $nnnn */
+          OPCODE(0xad)          /* LDA $nnnn */
             LDA(LOAD_ABS_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xae:            /* LDX $nnnn */
+          OPCODE(0xae)          /* LDX $nnnn */
             LDX(LOAD_ABS_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xaf:            /* LDA $nnnnnn */
+          OPCODE(0xaf)          /* LDA $nnnnnn */
             LDA(LOAD_ABS_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xb0:            /* BCS $nnnn */
+          OPCODE(0xb0)          /* BCS $nnnn */
             BRANCH(LOCAL_CARRY());
-            break;
+            OPCODE_NEXT();
 
-          case 0xb1:            /* LDA ($nn),Y */
+          OPCODE(0xb1)          /* LDA ($nn),Y */
             LDA(LOAD_INDIRECT_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xb2:            /* LDA ($nn) */
+          OPCODE(0xb2)          /* LDA ($nn) */
             LDA(LOAD_INDIRECT_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xb3:            /* LDA ($nn,S),Y */
+          OPCODE(0xb3)          /* LDA ($nn,S),Y */
             LDA(LOAD_STACK_REL_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xb4:            /* LDY $nn,X */
+          OPCODE(0xb4)          /* LDY $nn,X */
             LDY(LOAD_DIRECT_PAGE_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xb5:            /* LDA $nn,X */
+          OPCODE(0xb5)          /* LDA $nn,X */
             LDA(LOAD_DIRECT_PAGE_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xb6:            /* LDX $nn,Y */
+          OPCODE(0xb6)          /* LDX $nn,Y */
             LDX(LOAD_DIRECT_PAGE_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xb7:            /* LDA [$nn],Y */
+          OPCODE(0xb7)          /* LDA [$nn],Y */
             LDA(LOAD_INDIRECT_LONG_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xb8:            /* CLV */
+          OPCODE(0xb8)          /* CLV */
             CLV();
-            break;
+            OPCODE_NEXT();
 
-          case 0xb9:            /* LDA $nnnn,Y */
+          OPCODE(0xb9)          /* LDA $nnnn,Y */
             LDA(LOAD_ABS_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xba:            /* TSX */
+          OPCODE(0xba)          /* TSX */
             TSX();
-            break;
+            OPCODE_NEXT();
 
-          case 0xbb:            /* TYX */
+          OPCODE(0xbb)          /* TYX */
             TYX();
-            break;
+            OPCODE_NEXT();
 
-          case 0xbc:            /* LDY $nnnn,X */
+          OPCODE(0xbc)          /* LDY $nnnn,X */
             LDY(LOAD_ABS_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xbd:            /* LDA $nnnn,X */
+          OPCODE(0xbd)          /* LDA $nnnn,X */
             LDA(LOAD_ABS_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xbe:            /* LDX $nnnn,Y */
+          OPCODE(0xbe)          /* LDX $nnnn,Y */
             LDX(LOAD_ABS_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xbf:            /* LDA $nnnnnn,X */
+          OPCODE(0xbf)          /* LDA $nnnnnn,X */
             LDA(LOAD_ABS_LONG_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xc0:            /* CPY #$nn */
+          OPCODE(0xc0)          /* CPY #$nn */
             CPY(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xc1:            /* CMP ($nn,X) */
+          OPCODE(0xc1)          /* CMP ($nn,X) */
             CMP(LOAD_INDIRECT_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xc2:            /* REP #$nn */
+          OPCODE(0xc2)          /* REP #$nn */
             REP(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xc3:            /* CMP $nn,S */
+          OPCODE(0xc3)          /* CMP $nn,S */
             CMP(LOAD_STACK_REL_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xc4:            /* CPY $nn */
+          OPCODE(0xc4)          /* CPY $nn */
             CPY(LOAD_DIRECT_PAGE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xc5:            /* CMP $nn */
+          OPCODE(0xc5)          /* CMP $nn */
             CMP(LOAD_DIRECT_PAGE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xc6:            /* DEC $nn */
+          OPCODE(0xc6)          /* DEC $nn */
             DEC(LOAD_DIRECT_PAGE_FUNC_RRW, STORE_DIRECT_PAGE_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0xc7:            /* CMP [$nn] */
+          OPCODE(0xc7)          /* CMP [$nn] */
             CMP(LOAD_INDIRECT_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xc8:            /* INY */
+          OPCODE(0xc8)          /* INY */
             INY();
-            break;
+            OPCODE_NEXT();
 
-          case 0xc9:            /* CMP #$nn */
+          OPCODE(0xc9)          /* CMP #$nn */
             CMP(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xca:            /* DEX */
+          OPCODE(0xca)          /* DEX */
             DEX();
-            break;
+            OPCODE_NEXT();
 
-          case 0xcb:            /* WAI */
+          OPCODE(0xcb)          /* WAI */
             WAI_65816();
-            break;
+            OPCODE_NEXT();
 
-          case 0xcc:            /* CPY $nnnn */
+          OPCODE(0xcc)          /* CPY $nnnn */
             CPY(LOAD_ABS_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xcd:            /* CMP $nnnn */
+          OPCODE(0xcd)          /* CMP $nnnn */
             CMP(LOAD_ABS_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xce:            /* DEC $nnnn */
+          OPCODE(0xce)          /* DEC $nnnn */
             DEC(LOAD_ABS_FUNC_RRW, STORE_ABS_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0xcf:            /* CMP $nnnnnn */
+          OPCODE(0xcf)          /* CMP $nnnnnn */
             CMP(LOAD_ABS_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xd0:            /* BNE $nnnn */
+          OPCODE(0xd0)          /* BNE $nnnn */
             BRANCH(!LOCAL_ZERO());
-            break;
+            OPCODE_NEXT();
 
-          case 0xd1:            /* CMP ($nn),Y */
+          OPCODE(0xd1)          /* CMP ($nn),Y */
             CMP(LOAD_INDIRECT_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xd2:            /* CMP ($nn) */
+          OPCODE(0xd2)          /* CMP ($nn) */
             CMP(LOAD_INDIRECT_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xd3:            /* CMP ($nn,S),Y */
+          OPCODE(0xd3)          /* CMP ($nn,S),Y */
             CMP(LOAD_STACK_REL_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xd4:            /* PEI ($nn) */
+          OPCODE(0xd4)          /* PEI ($nn) */
             PEI();
-            break;
+            OPCODE_NEXT();
 
-          case 0xd5:            /* CMP $nn,X */
+          OPCODE(0xd5)          /* CMP $nn,X */
             CMP(LOAD_DIRECT_PAGE_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xd6:            /* DEC $nn,X */
+          OPCODE(0xd6)          /* DEC $nn,X */
             DEC(LOAD_DIRECT_PAGE_X_FUNC_RRW, STORE_DIRECT_PAGE_X_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0xd7:            /* CMP [$nn],Y */
+          OPCODE(0xd7)          /* CMP [$nn],Y */
             CMP(LOAD_INDIRECT_LONG_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xd8:            /* CLD */
+          OPCODE(0xd8)          /* CLD */
             CLD();
-            break;
+            OPCODE_NEXT();
 
-          case 0xd9:            /* CMP $nnnn,Y */
+          OPCODE(0xd9)          /* CMP $nnnn,Y */
             CMP(LOAD_ABS_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xda:            /* PHX */
+          OPCODE(0xda)          /* PHX */
             PHX(STORE_STACK);
-            break;
+            OPCODE_NEXT();
 
-          case 0xdb:            /* STP (WDC65C02) */
+          OPCODE(0xdb)          /* STP (WDC65C02) */
             STP_65816();
-            break;
+            OPCODE_NEXT();
 
-          case 0xdc:            /* JMP [$nnnn] */
+          OPCODE(0xdc)          /* JMP [$nnnn] */
             JMP_IND_LONG();
-            break;
+            OPCODE_NEXT();
 
-          case 0xdd:            /* CMP $nnnn,X */
+          OPCODE(0xdd)          /* CMP $nnnn,X */
             CMP(LOAD_ABS_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xde:            /* DEC $nnnn,X */
+          OPCODE(0xde)          /* DEC $nnnn,X */
             DEC(LOAD_ABS_X_FUNC_RRW, STORE_ABS_X_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0xdf:            /* CMP $nnnnnn,X */
+          OPCODE(0xdf)          /* CMP $nnnnnn,X */
             CMP(LOAD_ABS_LONG_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xe0:            /* CPX #$nn */
+          OPCODE(0xe0)          /* CPX #$nn */
             CPX(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xe1:            /* SBC ($nn,X) */
+          OPCODE(0xe1)          /* SBC ($nn,X) */
             SBC(LOAD_INDIRECT_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xe2:            /* SEP #$nn */
+          OPCODE(0xe2)          /* SEP #$nn */
             SEP(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xe3:            /* SBC $nn,S */
+          OPCODE(0xe3)          /* SBC $nn,S */
             SBC(LOAD_STACK_REL_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xe4:            /* CPX $nn */
+          OPCODE(0xe4)          /* CPX $nn */
             CPX(LOAD_DIRECT_PAGE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xe5:            /* SBC $nn */
+          OPCODE(0xe5)          /* SBC $nn */
             SBC(LOAD_DIRECT_PAGE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xe6:            /* INC $nn */
+          OPCODE(0xe6)          /* INC $nn */
             INC(LOAD_DIRECT_PAGE_FUNC_RRW, STORE_DIRECT_PAGE_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0xe7:            /* SBC [$nn] */
+          OPCODE(0xe7)          /* SBC [$nn] */
             SBC(LOAD_INDIRECT_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xe8:            /* INX */
+          OPCODE(0xe8)          /* INX */
             INX();
-            break;
+            OPCODE_NEXT();
 
-          case 0xe9:            /* SBC #$nn */
+          OPCODE(0xe9)          /* SBC #$nn */
             SBC(LOAD_IMMEDIATE_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xea:            /* NOP */
+          OPCODE(0xea)          /* NOP */
             NOP();
-            break;
+            OPCODE_NEXT();
 
-          case 0xeb:            /* XBA */
+          OPCODE(0xeb)          /* XBA */
             XBA();
-            break;
+            OPCODE_NEXT();
 
-          case 0xec:            /* CPX $nnnn */
+          OPCODE(0xec)          /* CPX $nnnn */
             CPX(LOAD_ABS_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xed:            /* SBC $nnnn */
+          OPCODE(0xed)          /* SBC $nnnn */
             SBC(LOAD_ABS_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xee:            /* INC $nnnn */
+          OPCODE(0xee)          /* INC $nnnn */
             INC(LOAD_ABS_FUNC_RRW, STORE_ABS_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0xef:            /* SBC $nnnnnn */
+          OPCODE(0xef)          /* SBC $nnnnnn */
             SBC(LOAD_ABS_LONG_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xf0:            /* BEQ $nnnn */
+          OPCODE(0xf0)          /* BEQ $nnnn */
             BRANCH(LOCAL_ZERO());
-            break;
+            OPCODE_NEXT();
 
-          case 0xf1:            /* SBC ($nn),Y */
+          OPCODE(0xf1)          /* SBC ($nn),Y */
             SBC(LOAD_INDIRECT_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xf2:            /* SBC ($nn) */
+          OPCODE(0xf2)          /* SBC ($nn) */
             SBC(LOAD_INDIRECT_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xf3:            /* SBC ($nn,S),Y */
+          OPCODE(0xf3)          /* SBC ($nn,S),Y */
             SBC(LOAD_STACK_REL_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xf4:            /* PEA $nnnn */
+          OPCODE(0xf4)          /* PEA $nnnn */
             PEA();
-            break;
+            OPCODE_NEXT();
 
-          case 0xf5:            /* SBC $nn,X */
+          OPCODE(0xf5)          /* SBC $nn,X */
             SBC(LOAD_DIRECT_PAGE_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xf6:            /* INC $nn,X */
+          OPCODE(0xf6)          /* INC $nn,X */
             INC(LOAD_DIRECT_PAGE_X_FUNC_RRW, STORE_DIRECT_PAGE_X_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0xf7:            /* SBC [$nn],Y */
+          OPCODE(0xf7)          /* SBC [$nn],Y */
             SBC(LOAD_INDIRECT_LONG_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xf8:            /* SED */
+          OPCODE(0xf8)          /* SED */
             SED();
-            break;
+            OPCODE_NEXT();
 
-          case 0xf9:            /* SBC $nnnn,Y */
+          OPCODE(0xf9)          /* SBC $nnnn,Y */
             SBC(LOAD_ABS_Y_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xfa:            /* PLX */
+          OPCODE(0xfa)          /* PLX */
             PLX(LOAD_STACK);
-            break;
+            OPCODE_NEXT();
 
-          case 0xfb:            /* XCE */
+          OPCODE(0xfb)          /* XCE */
             XCE();
-            break;
+            OPCODE_NEXT();
 
-          case 0xfc:            /* JSR ($nnnn,X) */
+          OPCODE(0xfc)          /* JSR ($nnnn,X) */
             JSR_IND_X();
-            break;
+            OPCODE_NEXT();
 
-          case 0xfd:            /* SBC $nnnn,X */
+          OPCODE(0xfd)          /* SBC $nnnn,X */
             SBC(LOAD_ABS_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
-          case 0xfe:            /* INC $nnnn,X */
+          OPCODE(0xfe)          /* INC $nnnn,X */
             INC(LOAD_ABS_X_FUNC_RRW, STORE_ABS_X_RRW);
-            break;
+            OPCODE_NEXT();
 
-          case 0xff:            /* SBC $nnnnnn,X */
+          OPCODE(0xff)          /* SBC $nnnnnn,X */
             SBC(LOAD_ABS_LONG_X_FUNC);
-            break;
+            OPCODE_NEXT();
 
           case 0x100:           /* IRQ */
             IRQ();
-            break;
+            OPCODE_NEXT();
 
           case 0x101:           /* NMI */
             NMI();
-            break;
+            OPCODE_NEXT();
 
           case 0x102:           /* RES */
             RES();
-            break;
+            OPCODE_NEXT();
         }
 #ifdef DEBUG
         if (TRACEFLG && p0 < 0x100) {
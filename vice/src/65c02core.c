@@ -51,6 +51,7 @@
 #define CPU_STR "65(S)C02 CPU"
 #endif
 
+#include "6510core.h"
 #include "traps.h"
 
 /* To avoid 'magic' numbers, we will use the following defines. */
@@ -118,8 +119,10 @@
         alarm_context_dispatch(ALARM_CONTEXT, CLK);                \
         CPU_DELAY_CLK                                              \
     }
+#define ALARMS_PENDING() (CLK >= alarm_context_next_pending_clk(ALARM_CONTEXT))
 #else
 #define PROCESS_ALARMS
+#define ALARMS_PENDING() 0
 #endif
 
 /* ------------------------------------------------------------------------- */
@@ -1595,6 +1598,85 @@
 #endif
 #endif
 
+/* ------------------------------------------------------------------------ */
+/* Recording of the fetched opcode in the CPU history.  */
+
+#ifdef FEATURE_CPUMEMHISTORY
+#ifndef DRIVE_CPU
+#define HISTORY_FETCH_START()                                       \
+    do {                                                            \
+        history_clk = maincpu_clk;                                  \
+        memmap_state |= (MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE); \
+    } while (0)
+#define HISTORY_FETCH_END() (memmap_state &= ~(MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE))
+/* HACK to cope with FETCH_OPCODE optimization in x64 */
+#define HISTORY_MARK_FETCH()                \
+    do {                                    \
+        if (((int)reg_pc) < bank_limit) {   \
+            memmap_mem_read(reg_pc);        \
+        }                                   \
+    } while (0)
+#else
+#define HISTORY_FETCH_START() (history_clk = CLK)
+#define HISTORY_FETCH_END()
+#define HISTORY_MARK_FETCH()
+#endif
+
+#define HISTORY_STORE_OPCODE()                                                          \
+    do {                                                                                \
+        HISTORY_MARK_FETCH();                                                           \
+        if (p0 == 0x20) {                                                               \
+            monitor_cpuhistory_store(history_clk, reg_pc, p0, p1, LOAD(reg_pc + 2),     \
+                                     reg_a, reg_x, reg_y, reg_sp,                       \
+                                     LOCAL_STATUS(), ORIGIN_MEMSPACE);                  \
+        } else {                                                                        \
+            monitor_cpuhistory_store(history_clk, reg_pc, p0, p1, p2 >> 8,              \
+                                     reg_a, reg_x, reg_y, reg_sp,                       \
+                                     LOCAL_STATUS(), ORIGIN_MEMSPACE);                  \
+        }                                                                               \
+        HISTORY_FETCH_END();                                                            \
+    } while (0)
+#else
+#define HISTORY_FETCH_START()
+#define HISTORY_STORE_OPCODE()
+#endif
+
+/* ------------------------------------------------------------------------ */
+/* Threaded opcode dispatch, see 6510core.h.  */
+
+#if defined(OPCODE_THREADED_DISPATCH) && defined(CPU_CHAIN_ALLOWED)
+#define OPCODE_THREADED
+
+#ifndef CPU_OPCODE_DONE
+#define CPU_OPCODE_DONE()
+#endif
+
+#define OPCODE(nr) case nr: opcode_##nr:
+
+/* Run the work between two opcodes, then fetch the next opcode and jump to
+   its handler if nothing else is due.  This is the start of the core up to
+   the `switch'.  */
+#define OPCODE_NEXT()                                                   \
+    if (!CPU_CHAIN_ALLOWED()) {                                         \
+        break;                                                          \
+    }                                                                   \
+    CPU_OPCODE_DONE();                                                  \
+    CPU_DELAY_CLK;                                                      \
+    if (ALARMS_PENDING()                                                \
+        || CPU_INT_STATUS->global_pending_int != IK_NONE) {             \
+        goto opcode_start;                                              \
+    }                                                                   \
+    HISTORY_FETCH_START();                                              \
+    SET_LAST_ADDR(reg_pc);                                              \
+    FETCH_OPCODE(opcode);                                               \
+    HISTORY_STORE_OPCODE();                                             \
+    SET_LAST_OPCODE(p0);                                                \
+    goto *opcode_dispatch_tab[p0]
+#else
+#define OPCODE(nr) case nr:
+#define OPCODE_NEXT() break
+#endif
+
 /* ------------------------------------------------------------------------ */
 
 /* Here, the CPU is emulated. */
@@ -1602,6 +1684,9 @@
 {
     CPU_DELAY_CLK;
 
+#ifdef OPCODE_THREADED
+opcode_start:
+#endif
     PROCESS_ALARMS;
 
     {
@@ -1628,6 +1713,9 @@
 
     {
         opcode_t opcode;
+#ifdef OPCODE_THREADED
+        static const void *const opcode_dispatch_tab[256] = { OPCODE_LABELS_256 };
+#endif
 #ifdef DEBUG
         CLOCK debug_clk;
 #ifdef DRIVE_CPU
@@ -1639,32 +1727,12 @@
 
 #ifdef FEATURE_CPUMEMHISTORY
         CLOCK history_clk;
-#ifndef DRIVE_CPU
-        history_clk = maincpu_clk;
-        memmap_state |= (MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE);
-#else
-        history_clk = CLK;
-#endif
 #endif
+
+        HISTORY_FETCH_START();
         SET_LAST_ADDR(reg_pc);
         FETCH_OPCODE(opcode);
-
-#ifdef FEATURE_CPUMEMHISTORY
-#ifndef DRIVE_CPU
-        /* HACK to cope with FETCH_OPCODE optimization in x64 */
-        if (((int)reg_pc) < bank_limit) {
-            memmap_mem_read(reg_pc);
-        }
-#endif
-        if (p0 == 0x20) {
-            monitor_cpuhistory_store(history_clk, reg_pc, p0, p1, LOAD(reg_pc + 2), reg_a, reg_x, reg_y, reg_sp, LOCAL_STATUS(), ORIGIN_MEMSPACE);
-        } else {
-            monitor_cpuhistory_store(history_clk, reg_pc, p0, p1, p2 >> 8, reg_a, reg_x, reg_y, reg_sp, LOCAL_STATUS(), ORIGIN_MEMSPACE);
-        }
-#ifndef DRIVE_CPU
-        memmap_state &= ~(MEMMAP_STATE_INSTR | MEMMAP_STATE_OPCODE);
-#endif
-#endif
+        HISTORY_STORE_OPCODE();
 
 #ifdef DEBUG
 #ifdef DRIVE_CPU
@@ -1706,890 +1774,919 @@ trap_skipped:
         SET_LAST_OPCODE(p0);
 
         switch (p0) {
-            default:            /* 1 byte, 1 cycle NOP */
+            OPCODE(0x03)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x0b)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x13)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x1b)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x23)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x2b)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x33)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x3b)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x43)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x4b)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x53)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x5b)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x63)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x6b)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x73)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x7b)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x83)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x8b)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x93)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0x9b)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0xa3)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0xab)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0xb3)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0xbb)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0xc3)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0xd3)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0xe3)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0xeb)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0xf3)        /* 1 byte, 1 cycle NOP */
+            OPCODE(0xfb)        /* 1 byte, 1 cycle NOP */
                 NOOP_IMM(SIZE_1);
-                break;
-
-            case 0x22:          /* NOP #$nn */
-            case 0x42:          /* NOP #$nn */
-            case 0x62:          /* NOP #$nn */
-            case 0x82:          /* NOP #$nn */
-            case 0xc2:          /* NOP #$nn */
-            case 0xe2:          /* NOP #$nn */
+                OPCODE_NEXT();
+
+            OPCODE(0x22)        /* NOP #$nn */
+            OPCODE(0x42)        /* NOP #$nn */
+            OPCODE(0x62)        /* NOP #$nn */
+            OPCODE(0x82)        /* NOP #$nn */
+            OPCODE(0xc2)        /* NOP #$nn */
+            OPCODE(0xe2)        /* NOP #$nn */
                 NOOP_IMM(SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x44:          /* NOP $nn */
+            OPCODE(0x44)        /* NOP $nn */
                 NOOP_ZP();
-                break;
+                OPCODE_NEXT();
 
-            case 0x54:          /* NOP $nn,X */
-            case 0xd4:          /* NOP $nn,X */
-            case 0xf4:          /* NOP $nn,X */
+            OPCODE(0x54)        /* NOP $nn,X */
+            OPCODE(0xd4)        /* NOP $nn,X */
+            OPCODE(0xf4)        /* NOP $nn,X */
                 NOOP_ZP_X();
-                break;
+                OPCODE_NEXT();
 
-            case 0xdc:          /* NOP $nnnn */
-            case 0xfc:          /* NOP $nnnn */
+            OPCODE(0xdc)        /* NOP $nnnn */
+            OPCODE(0xfc)        /* NOP $nnnn */
                 NOOP_ABS();
-                break;
+                OPCODE_NEXT();
 
-            case 0x5c:          /* NOP broken */
+            OPCODE(0x5c)        /* NOP broken */
                 NOOP_5C();
-                break;
+                OPCODE_NEXT();
 
-            case 0x00:          /* BRK */
+            OPCODE(0x00)        /* BRK */
                 BRK();
-                break;
+                OPCODE_NEXT();
 
-            case 0x01:          /* ORA ($nn,X) */
+            OPCODE(0x01)        /* ORA ($nn,X) */
                 ORA(LOAD_IND_X(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x02:          /* NOP #$nn - also used for traps */
+            OPCODE(0x02)        /* NOP #$nn - also used for traps */
                 STATIC_ASSERT(TRAP_OPCODE == 0x02);
                 NOP_02();
-                break;
+                OPCODE_NEXT();
 
-            case 0x04:          /* TSB $nn */
+            OPCODE(0x04)        /* TSB $nn */
                 TSB(p1, CYCLES_3, SIZE_2, LOAD_ZERO, STORE_ZERO);
-                break;
+                OPCODE_NEXT();
 
-            case 0x05:          /* ORA $nn */
+            OPCODE(0x05)        /* ORA $nn */
                 ORA(LOAD_ZERO(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x06:          /* ASL $nn */
+            OPCODE(0x06)        /* ASL $nn */
                 ASL(p1, CYCLES_1, SIZE_2, LOAD_ZERO, STORE_ZERO_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x07:          /* RMB0 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x07)        /* RMB0 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 RMB(BIT_0);
-                break;
+                OPCODE_NEXT();
 
-            case 0x08:          /* PHP */
+            OPCODE(0x08)        /* PHP */
                 PHP();
-                break;
+                OPCODE_NEXT();
 
-            case 0x09:          /* ORA #$nn */
+            OPCODE(0x09)        /* ORA #$nn */
                 ORA(p1, CYCLES_0, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x0a:          /* ASL A */
+            OPCODE(0x0a)        /* ASL A */
                 ASL_A();
-                break;
+                OPCODE_NEXT();
 
-            case 0x0c:          /* TSB $nnnn */
+            OPCODE(0x0c)        /* TSB $nnnn */
                 TSB(p2, CYCLES_1, SIZE_3, LOAD_ABS, STORE_ABS_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x0d:          /* ORA $nnnn */
+            OPCODE(0x0d)        /* ORA $nnnn */
                 ORA(LOAD(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x0e:          /* ASL $nnnn */
+            OPCODE(0x0e)        /* ASL $nnnn */
                 ASL(p2, CYCLES_1, SIZE_3, LOAD_ABS, STORE_ABS_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x0f:          /* BBR0 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x0f)        /* BBR0 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBR(BIT_0);
-                break;
+                OPCODE_NEXT();
 
-            case 0x10:          /* BPL $nnnn */
+            OPCODE(0x10)        /* BPL $nnnn */
                 BRANCH(!LOCAL_SIGN(), p1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x11:          /* ORA ($nn),Y */
+            OPCODE(0x11)        /* ORA ($nn),Y */
                 ORA(LOAD_IND_Y(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x12:          /* ORA ($nn) */
+            OPCODE(0x12)        /* ORA ($nn) */
                 ORA(LOAD_INDIRECT(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x14:          /* TRB $nn */
+            OPCODE(0x14)        /* TRB $nn */
                 TRB(p1, CYCLES_1, SIZE_2, LOAD_ZERO, STORE_ZERO_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x15:          /* ORA $nn,X */
+            OPCODE(0x15)        /* ORA $nn,X */
                 ORA(LOAD_ZERO_X(p1), CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x16:          /* ASL $nn,X */
+            OPCODE(0x16)        /* ASL $nn,X */
                 ASL(p1, CYCLES_2, SIZE_2, LOAD_ZERO_X, STORE_ZERO_RRW_X);
-                break;
+                OPCODE_NEXT();
 
-            case 0x17:          /* RMB1 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x17)        /* RMB1 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 RMB(BIT_1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x18:          /* CLC */
+            OPCODE(0x18)        /* CLC */
                 CLC();
-                break;
+                OPCODE_NEXT();
 
-            case 0x19:          /* ORA $nnnn,Y */
+            OPCODE(0x19)        /* ORA $nnnn,Y */
                 ORA(LOAD_ABS_Y(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x1a:          /* INA */
+            OPCODE(0x1a)        /* INA */
                 INA();
-                break;
+                OPCODE_NEXT();
 
-            case 0x1c:          /* TRB $nnnn */
+            OPCODE(0x1c)        /* TRB $nnnn */
                 TRB(p2, CYCLES_1, SIZE_3, LOAD_ABS, STORE_ABS_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x1d:          /* ORA $nnnn,X */
+            OPCODE(0x1d)        /* ORA $nnnn,X */
                 ORA(LOAD_ABS_X(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x1e:          /* ASL $nnnn,X */
+            OPCODE(0x1e)        /* ASL $nnnn,X */
                 ASL(p2, CYCLES_1, SIZE_3, LOAD_ABS_X, STORE_ABS_X_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x1f:          /* BBR1 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x1f)        /* BBR1 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBR(BIT_1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x20:          /* JSR $nnnn */
+            OPCODE(0x20)        /* JSR $nnnn */
                 JSR();
-                break;
+                OPCODE_NEXT();
 
-            case 0x21:          /* AND ($nn,X) */
+            OPCODE(0x21)        /* AND ($nn,X) */
                 AND(LOAD_IND_X(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x24:          /* BIT $nn */
+            OPCODE(0x24)        /* BIT $nn */
                 BIT(LOAD_ZERO(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x25:          /* AND $nn */
+            OPCODE(0x25)        /* AND $nn */
                 AND(LOAD_ZERO(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x26:          /* ROL $nn */
+            OPCODE(0x26)        /* ROL $nn */
                 ROL(p1, CYCLES_1, SIZE_2, LOAD_ZERO, STORE_ZERO_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x27:          /* RMB2 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x27)        /* RMB2 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 RMB(BIT_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x28:          /* PLP */
+            OPCODE(0x28)        /* PLP */
                 PLP();
-                break;
+                OPCODE_NEXT();
 
-            case 0x29:          /* AND #$nn */
+            OPCODE(0x29)        /* AND #$nn */
                 AND(p1, CYCLES_0, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x2a:          /* ROL A */
+            OPCODE(0x2a)        /* ROL A */
                 ROL_A();
-                break;
+                OPCODE_NEXT();
 
-            case 0x2c:          /* BIT $nnnn */
+            OPCODE(0x2c)        /* BIT $nnnn */
                 BIT(LOAD(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x2d:          /* AND $nnnn */
+            OPCODE(0x2d)        /* AND $nnnn */
                 AND(LOAD(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x2e:          /* ROL $nnnn */
+            OPCODE(0x2e)        /* ROL $nnnn */
                 ROL(p2, CYCLES_1, SIZE_3, LOAD_ABS, STORE_ABS_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x2f:          /* BBR2 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x2f)        /* BBR2 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBR(BIT_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x30:          /* BMI $nnnn */
+            OPCODE(0x30)        /* BMI $nnnn */
                 BRANCH(LOCAL_SIGN(), p1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x31:          /* AND ($nn),Y */
+            OPCODE(0x31)        /* AND ($nn),Y */
                 AND(LOAD_IND_Y(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x32:          /* AND ($nn) */
+            OPCODE(0x32)        /* AND ($nn) */
                 AND(LOAD_INDIRECT(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x34:          /* BIT $nn,X */
+            OPCODE(0x34)        /* BIT $nn,X */
                 BIT(LOAD_ZERO_X(p1), CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x35:          /* AND $nn,X */
+            OPCODE(0x35)        /* AND $nn,X */
                 AND(LOAD_ZERO_X(p1), CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x36:          /* ROL $nn,X */
+            OPCODE(0x36)        /* ROL $nn,X */
                 ROL(p1, CYCLES_2, SIZE_2, LOAD_ZERO_X, STORE_ZERO_RRW_X);
-                break;
+                OPCODE_NEXT();
 
-            case 0x37:          /* RMB3 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x37)        /* RMB3 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 RMB(BIT_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x38:          /* SEC */
+            OPCODE(0x38)        /* SEC */
                 SEC();
-                break;
+                OPCODE_NEXT();
 
-            case 0x39:          /* AND $nnnn,Y */
+            OPCODE(0x39)        /* AND $nnnn,Y */
                 AND(LOAD_ABS_Y(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x3a:          /* DEA */
+            OPCODE(0x3a)        /* DEA */
                 DEA();
-                break;
+                OPCODE_NEXT();
 
-            case 0x3c:          /* BIT $nnnn,X */
+            OPCODE(0x3c)        /* BIT $nnnn,X */
                 BIT(LOAD_ABS_X(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x3d:          /* AND $nnnn,X */
+            OPCODE(0x3d)        /* AND $nnnn,X */
                 AND(LOAD_ABS_X(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x3e:          /* ROL $nnnn,X */
+            OPCODE(0x3e)        /* ROL $nnnn,X */
                 ROL(p2, CYCLES_1, SIZE_3, LOAD_ABS_X, STORE_ABS_X_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x3f:          /* BBR3 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x3f)        /* BBR3 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBR(BIT_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x40:          /* RTI */
+            OPCODE(0x40)        /* RTI */
                 RTI();
-                break;
+                OPCODE_NEXT();
 
-            case 0x41:          /* EOR ($nn,X) */
+            OPCODE(0x41)        /* EOR ($nn,X) */
                 EOR(LOAD_IND_X(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x45:          /* EOR $nn */
+            OPCODE(0x45)        /* EOR $nn */
                 EOR(LOAD_ZERO(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x46:          /* LSR $nn */
+            OPCODE(0x46)        /* LSR $nn */
                 LSR(p1, CYCLES_1, SIZE_2, LOAD_ZERO, STORE_ZERO_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x47:          /* RMB4 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x47)        /* RMB4 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 RMB(BIT_4);
-                break;
+                OPCODE_NEXT();
 
-            case 0x48:          /* PHA */
+            OPCODE(0x48)        /* PHA */
                 PHA();
-                break;
+                OPCODE_NEXT();
 
-            case 0x49:          /* EOR #$nn */
+            OPCODE(0x49)        /* EOR #$nn */
                 EOR(p1, CYCLES_0, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x4a:          /* LSR A */
+            OPCODE(0x4a)        /* LSR A */
                 LSR_A();
-                break;
+                OPCODE_NEXT();
 
-            case 0x4c:          /* JMP $nnnn */
+            OPCODE(0x4c)        /* JMP $nnnn */
                 JMP(p2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x4d:          /* EOR $nnnn */
+            OPCODE(0x4d)        /* EOR $nnnn */
                 EOR(LOAD(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x4e:          /* LSR $nnnn */
+            OPCODE(0x4e)        /* LSR $nnnn */
                 LSR(p2, CYCLES_1, SIZE_3, LOAD_ABS, STORE_ABS_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x4f:          /* BBR4 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x4f)        /* BBR4 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBR(BIT_4);
-                break;
+                OPCODE_NEXT();
 
-            case 0x50:          /* BVC $nnnn */
+            OPCODE(0x50)        /* BVC $nnnn */
                 BRANCH(!LOCAL_OVERFLOW(), p1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x51:          /* EOR ($nn),Y */
+            OPCODE(0x51)        /* EOR ($nn),Y */
                 EOR(LOAD_IND_Y(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x52:          /* EOR ($nn) */
+            OPCODE(0x52)        /* EOR ($nn) */
                 EOR(LOAD_INDIRECT(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x55:          /* EOR $nn,X */
+            OPCODE(0x55)        /* EOR $nn,X */
                 EOR(LOAD_ZERO_X(p1), CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x56:          /* LSR $nn,X */
+            OPCODE(0x56)        /* LSR $nn,X */
                 LSR(p1, CYCLES_2, SIZE_2, LOAD_ZERO_X, STORE_ZERO_RRW_X);
-                break;
+                OPCODE_NEXT();
 
-            case 0x57:          /* RMB5 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x57)        /* RMB5 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 RMB(BIT_5);
-                break;
+                OPCODE_NEXT();
 
-            case 0x58:          /* CLI */
+            OPCODE(0x58)        /* CLI */
                 CLI();
-                break;
+                OPCODE_NEXT();
 
-            case 0x59:          /* EOR $nnnn,Y */
+            OPCODE(0x59)        /* EOR $nnnn,Y */
                 EOR(LOAD_ABS_Y(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x5a:          /* PHY */
+            OPCODE(0x5a)        /* PHY */
                 PHY();
-                break;
+                OPCODE_NEXT();
 
-            case 0x5d:          /* EOR $nnnn,X */
+            OPCODE(0x5d)        /* EOR $nnnn,X */
                 EOR(LOAD_ABS_X(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x5e:          /* LSR $nnnn,X */
+            OPCODE(0x5e)        /* LSR $nnnn,X */
                 LSR(p2, CYCLES_1, SIZE_3, LOAD_ABS_X, STORE_ABS_X_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x5f:          /* BBR5 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x5f)        /* BBR5 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBR(BIT_5);
-                break;
+                OPCODE_NEXT();
 
-            case 0x60:          /* RTS */
+            OPCODE(0x60)        /* RTS */
                 RTS();
-                break;
+                OPCODE_NEXT();
 
-            case 0x61:          /* ADC ($nn,X) */
+            OPCODE(0x61)        /* ADC ($nn,X) */
                 ADC(LOAD_IND_X(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x64:          /* STZ $nn */
+            OPCODE(0x64)        /* STZ $nn */
                 STZ_ZERO(p1, CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x65:          /* ADC $nn */
+            OPCODE(0x65)        /* ADC $nn */
                 ADC(LOAD_ZERO(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x66:          /* ROR $nn */
+            OPCODE(0x66)        /* ROR $nn */
                 ROR(p1, CYCLES_1, SIZE_2, LOAD_ZERO, STORE_ZERO_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x67:          /* RMB6 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x67)        /* RMB6 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 RMB(BIT_6);
-                break;
+                OPCODE_NEXT();
 
-            case 0x68:          /* PLA */
+            OPCODE(0x68)        /* PLA */
                 PLA();
-                break;
+                OPCODE_NEXT();
 
-            case 0x69:          /* ADC #$nn */
+            OPCODE(0x69)        /* ADC #$nn */
                 ADC(p1, CYCLES_0, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x6a:          /* ROR A */
+            OPCODE(0x6a)        /* ROR A */
                 ROR_A();
-                break;
+                OPCODE_NEXT();
 
-            case 0x6c:          /* JMP ($nnnn) */
+            OPCODE(0x6c)        /* JMP ($nnnn) */
                 JMP_IND();
-                break;
+                OPCODE_NEXT();
 
-            case 0x6d:          /* ADC $nnnn */
+            OPCODE(0x6d)        /* ADC $nnnn */
                 ADC(LOAD(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x6e:          /* ROR $nnnn */
+            OPCODE(0x6e)        /* ROR $nnnn */
                 ROR(p2, CYCLES_1, SIZE_3, LOAD_ABS, STORE_ABS_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x6f:          /* BBR6 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x6f)        /* BBR6 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBR(BIT_6);
-                break;
+                OPCODE_NEXT();
 
-            case 0x70:          /* BVS $nnnn */
+            OPCODE(0x70)        /* BVS $nnnn */
                 BRANCH(LOCAL_OVERFLOW(), p1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x71:          /* ADC ($nn),Y */
+            OPCODE(0x71)        /* ADC ($nn),Y */
                 ADC(LOAD_IND_Y(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x72:          /* ADC ($nn) */
+            OPCODE(0x72)        /* ADC ($nn) */
                 ADC(LOAD_INDIRECT(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x74:          /* STZ $nn,X */
+            OPCODE(0x74)        /* STZ $nn,X */
                 STZ_ZERO_X(p1, CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x75:          /* ADC $nn,X */
+            OPCODE(0x75)        /* ADC $nn,X */
                 ADC(LOAD_ZERO_X(p1), CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x76:          /* ROR $nn,X */
+            OPCODE(0x76)        /* ROR $nn,X */
                 ROR(p1, CYCLES_2, SIZE_2, LOAD_ZERO_X, STORE_ZERO_RRW_X);
-                break;
+                OPCODE_NEXT();
 
-            case 0x77:          /* RMB7 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x77)        /* RMB7 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 RMB(BIT_7);
-                break;
+                OPCODE_NEXT();
 
-            case 0x78:          /* SEI */
+            OPCODE(0x78)        /* SEI */
                 SEI();
-                break;
+                OPCODE_NEXT();
 
-            case 0x79:          /* ADC $nnnn,Y */
+            OPCODE(0x79)        /* ADC $nnnn,Y */
                 ADC(LOAD_ABS_Y(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x7a:          /* PLY */
+            OPCODE(0x7a)        /* PLY */
                 PLY();
-                break;
+                OPCODE_NEXT();
 
-            case 0x7c:          /* JMP ($nnnn,X) */
+            OPCODE(0x7c)        /* JMP ($nnnn,X) */
                 JMP_IND_X();
-                break;
+                OPCODE_NEXT();
 
-            case 0x7d:          /* ADC $nnnn,X */
+            OPCODE(0x7d)        /* ADC $nnnn,X */
                 ADC(LOAD_ABS_X(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0x7e:          /* ROR $nnnn,X */
+            OPCODE(0x7e)        /* ROR $nnnn,X */
                 ROR(p2, CYCLES_1, SIZE_3, LOAD_ABS_X, STORE_ABS_X_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0x7f:          /* BBR7 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x7f)        /* BBR7 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBR(BIT_7);
-                break;
+                OPCODE_NEXT();
 
-            case 0x80:          /* BRA $nnnn */
+            OPCODE(0x80)        /* BRA $nnnn */
                 BRANCH(1, p1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x81:          /* STA ($nn,X) */
+            OPCODE(0x81)        /* STA ($nn,X) */
                 STA(LOAD_ZERO_ADDR_X(p1), CYCLES_3, CYCLES_1, SIZE_2, STORE_ABS);
-                break;
+                OPCODE_NEXT();
 
-            case 0x84:          /* STY $nn */
+            OPCODE(0x84)        /* STY $nn */
                 STY_ZERO(p1, CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x85:          /* STA $nn */
+            OPCODE(0x85)        /* STA $nn */
                 STA_ZERO(p1, CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x86:          /* STX $nn */
+            OPCODE(0x86)        /* STX $nn */
                 STX_ZERO(p1, CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x87:          /* SMB0 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x87)        /* SMB0 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 SMB(BIT_0);
-                break;
+                OPCODE_NEXT();
 
-            case 0x88:          /* DEY */
+            OPCODE(0x88)        /* DEY */
                 DEY();
-                break;
+                OPCODE_NEXT();
 
-            case 0x89:          /* BIT #$nn */
+            OPCODE(0x89)        /* BIT #$nn */
                 BIT_IMM(p1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x8a:          /* TXA */
+            OPCODE(0x8a)        /* TXA */
                 TXA();
-                break;
+                OPCODE_NEXT();
 
-            case 0x8c:          /* STY $nnnn */
+            OPCODE(0x8c)        /* STY $nnnn */
                 STY(p2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x8d:          /* STA $nnnn */
+            OPCODE(0x8d)        /* STA $nnnn */
                 STA(p2, CYCLES_0, CYCLES_1, SIZE_3, STORE_ABS);
-                break;
+                OPCODE_NEXT();
 
-            case 0x8e:          /* STX $nnnn */
+            OPCODE(0x8e)        /* STX $nnnn */
                 STX(p2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x8f:          /* BBS0 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x8f)        /* BBS0 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBS(BIT_0);
-                break;
+                OPCODE_NEXT();
 
-            case 0x90:          /* BCC $nnnn */
+            OPCODE(0x90)        /* BCC $nnnn */
                 BRANCH(!LOCAL_CARRY(), p1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x91:          /* STA ($nn),Y */
+            OPCODE(0x91)        /* STA ($nn),Y */
                 STA_IND_Y(p1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x92:          /* STA ($nn) */
+            OPCODE(0x92)        /* STA ($nn) */
                 STA(LOAD_ZERO_ADDR(p1), CYCLES_2, CYCLES_1, SIZE_2, STORE_ABS);
-                break;
+                OPCODE_NEXT();
 
-            case 0x94:          /* STY $nn,X */
+            OPCODE(0x94)        /* STY $nn,X */
                 STY_ZERO_X(p1, CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x95:          /* STA $nn,X */
+            OPCODE(0x95)        /* STA $nn,X */
                 STA_ZERO_X(p1, CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x96:          /* STX $nn,Y */
+            OPCODE(0x96)        /* STX $nn,Y */
                 STX_ZERO_Y(p1, CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0x97:          /* SMB1 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x97)        /* SMB1 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 SMB(BIT_1);
-                break;
+                OPCODE_NEXT();
 
-            case 0x98:          /* TYA */
+            OPCODE(0x98)        /* TYA */
                 TYA();
-                break;
+                OPCODE_NEXT();
 
-            case 0x99:          /* STA $nnnn,Y */
+            OPCODE(0x99)        /* STA $nnnn,Y */
                 STA(p2, CYCLES_0, CYCLES_0, SIZE_3, STORE_ABS_Y);
-                break;
+                OPCODE_NEXT();
 
-            case 0x9a:          /* TXS */
+            OPCODE(0x9a)        /* TXS */
                 TXS();
-                break;
+                OPCODE_NEXT();
 
-            case 0x9c:          /* STZ $nnnn */
+            OPCODE(0x9c)        /* STZ $nnnn */
                 STZ(p2, CYCLES_1, SIZE_3, STORE_ABS);
-                break;
+                OPCODE_NEXT();
 
-            case 0x9d:          /* STA $nnnn,X */
+            OPCODE(0x9d)        /* STA $nnnn,X */
                 STA(p2, CYCLES_0, CYCLES_0, SIZE_3, STORE_ABS_X);
-                break;
+                OPCODE_NEXT();
 
-            case 0x9e:          /* STZ $nnnn,X */
+            OPCODE(0x9e)        /* STZ $nnnn,X */
                 STZ(p2, CYCLES_0, SIZE_3, STORE_ABS_X);
-                break;
+                OPCODE_NEXT();
 
-            case 0x9f:          /* BBS1 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0x9f)        /* BBS1 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBS(BIT_1);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa0:          /* LDY #$nn */
+            OPCODE(0xa0)        /* LDY #$nn */
                 LDY(p1, CYCLES_0, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa1:          /* LDA ($nn,X) */
+            OPCODE(0xa1)        /* LDA ($nn,X) */
                 LDA(LOAD_IND_X(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa2:          /* LDX #$nn */
+            OPCODE(0xa2)        /* LDX #$nn */
                 LDX(p1, CYCLES_0, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa4:          /* LDY $nn */
+            OPCODE(0xa4)        /* LDY $nn */
                 LDY(LOAD_ZERO(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa5:          /* LDA $nn */
+            OPCODE(0xa5)        /* LDA $nn */
                 LDA(LOAD_ZERO(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa6:          /* LDX $nn */
+            OPCODE(0xa6)        /* LDX $nn */
                 LDX(LOAD_ZERO(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa7:          /* SMB2 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0xa7)        /* SMB2 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 SMB(BIT_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xa8:          /* TAY */
+            OPCODE(0xa8)        /* TAY */
                 TAY();
-                break;
+                OPCODE_NEXT();
 
-            case 0xa9:          /* LDA #$nn */
+            OPCODE(0xa9)        /* LDA #$nn */
                 LDA(p1, CYCLES_0, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xaa:          /* TAX */
+            OPCODE(0xaa)        /* TAX */
                 TAX();
-                break;
+                OPCODE_NEXT();
 
-            case 0xac:          /* LDY $nnnn */
+            OPCODE(0xac)        /* LDY $nnnn */
                 LDY(LOAD(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xad:          /* LDA $nnnn */
+            OPCODE(0xad)        /* LDA $nnnn */
                 LDA(LOAD(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xae:          /* LDX $nnnn */
+            OPCODE(0xae)        /* LDX $nnnn */
                 LDX(LOAD(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xaf:          /* BBS2 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0xaf)        /* BBS2 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBS(BIT_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb0:          /* BCS $nnnn */
+            OPCODE(0xb0)        /* BCS $nnnn */
                 BRANCH(LOCAL_CARRY(), p1);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb1:          /* LDA ($nn),Y */
+            OPCODE(0xb1)        /* LDA ($nn),Y */
                 LDA(LOAD_IND_Y_BANK(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb2:          /* LDA ($nn) */
+            OPCODE(0xb2)        /* LDA ($nn) */
                 LDA(LOAD_INDIRECT(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb4:          /* LDY $nn,X */
+            OPCODE(0xb4)        /* LDY $nn,X */
                 LDY(LOAD_ZERO_X(p1), CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb5:          /* LDA $nn,X */
+            OPCODE(0xb5)        /* LDA $nn,X */
                 LDA(LOAD_ZERO_X(p1), CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb6:          /* LDX $nn,Y */
+            OPCODE(0xb6)        /* LDX $nn,Y */
                 LDX(LOAD_ZERO_Y(p1), CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb7:          /* SMB3 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0xb7)        /* SMB3 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 SMB(BIT_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xb8:          /* CLV */
+            OPCODE(0xb8)        /* CLV */
                 CLV();
-                break;
+                OPCODE_NEXT();
 
-            case 0xb9:          /* LDA $nnnn,Y */
+            OPCODE(0xb9)        /* LDA $nnnn,Y */
                 LDA(LOAD_ABS_Y(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xba:          /* TSX */
+            OPCODE(0xba)        /* TSX */
                 TSX();
-                break;
+                OPCODE_NEXT();
 
-            case 0xbc:          /* LDY $nnnn,X */
+            OPCODE(0xbc)        /* LDY $nnnn,X */
                 LDY(LOAD_ABS_X(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xbd:          /* LDA $nnnn,X */
+            OPCODE(0xbd)        /* LDA $nnnn,X */
                 LDA(LOAD_ABS_X(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xbe:          /* LDX $nnnn,Y */
+            OPCODE(0xbe)        /* LDX $nnnn,Y */
                 LDX(LOAD_ABS_Y(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xbf:          /* BBS3 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0xbf)        /* BBS3 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBS(BIT_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc0:          /* CPY #$nn */
+            OPCODE(0xc0)        /* CPY #$nn */
                 CPY(p1, CYCLES_0, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc1:          /* CMP ($nn,X) */
+            OPCODE(0xc1)        /* CMP ($nn,X) */
                 CMP(LOAD_IND_X(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc4:          /* CPY $nn */
+            OPCODE(0xc4)        /* CPY $nn */
                 CPY(LOAD_ZERO(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc5:          /* CMP $nn */
+            OPCODE(0xc5)        /* CMP $nn */
                 CMP(LOAD_ZERO(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc6:          /* DEC $nn */
+            OPCODE(0xc6)        /* DEC $nn */
                 DEC(p1, CYCLES_1, SIZE_2, LOAD_ZERO, STORE_ZERO_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc7:          /* SMB4 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0xc7)        /* SMB4 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 SMB(BIT_4);
-                break;
+                OPCODE_NEXT();
 
-            case 0xc8:          /* INY */
+            OPCODE(0xc8)        /* INY */
                 INY();
-                break;
+                OPCODE_NEXT();
 
-            case 0xc9:          /* CMP #$nn */
+            OPCODE(0xc9)        /* CMP #$nn */
                 CMP(p1, CYCLES_0, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xca:          /* DEX */
+            OPCODE(0xca)        /* DEX */
                 DEX();
-                break;
+                OPCODE_NEXT();
 
-            case 0xcb:          /* WAI (WDC65C02) / single byte, single cycle NOP (R65C02/65SC02) */
+            OPCODE(0xcb)        /* WAI (WDC65C02) / single byte, single cycle NOP (R65C02/65SC02) */
                 WAI();
-                break;
+                OPCODE_NEXT();
 
-            case 0xcc:          /* CPY $nnnn */
+            OPCODE(0xcc)        /* CPY $nnnn */
                 CPY(LOAD(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xcd:          /* CMP $nnnn */
+            OPCODE(0xcd)        /* CMP $nnnn */
                 CMP(LOAD(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xce:          /* DEC $nnnn */
+            OPCODE(0xce)        /* DEC $nnnn */
                 DEC(p2, CYCLES_1, SIZE_3, LOAD_ABS, STORE_ABS_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xcf:          /* BBS4 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0xcf)        /* BBS4 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBS(BIT_4);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd0:          /* BNE $nnnn */
+            OPCODE(0xd0)        /* BNE $nnnn */
                 BRANCH(!LOCAL_ZERO(), p1);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd1:          /* CMP ($nn),Y */
+            OPCODE(0xd1)        /* CMP ($nn),Y */
                 CMP(LOAD_IND_Y(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd2:          /* CMP ($nn) */
+            OPCODE(0xd2)        /* CMP ($nn) */
                 CMP(LOAD_INDIRECT(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd5:          /* CMP $nn,X */
+            OPCODE(0xd5)        /* CMP $nn,X */
                 CMP(LOAD_ZERO_X(p1), CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd6:          /* DEC $nn,X */
+            OPCODE(0xd6)        /* DEC $nn,X */
                 DEC(p1, CYCLES_2, SIZE_2, LOAD_ZERO_X, STORE_ZERO_RRW_X);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd7:          /* SMB5 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0xd7)        /* SMB5 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 SMB(BIT_5);
-                break;
+                OPCODE_NEXT();
 
-            case 0xd8:          /* CLD */
+            OPCODE(0xd8)        /* CLD */
                 CLD();
-                break;
+                OPCODE_NEXT();
 
-            case 0xd9:          /* CMP $nnnn,Y */
+            OPCODE(0xd9)        /* CMP $nnnn,Y */
                 CMP(LOAD_ABS_Y(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xda:          /* PHX */
+            OPCODE(0xda)        /* PHX */
                 PHX();
-                break;
+                OPCODE_NEXT();
 
-            case 0xdb:          /* STP (WDC65C02) / single byte, single cycle NOP (R65C02/65SC02) */
+            OPCODE(0xdb)        /* STP (WDC65C02) / single byte, single cycle NOP (R65C02/65SC02) */
                 STP();
-                break;
+                OPCODE_NEXT();
 
-            case 0xdd:          /* CMP $nnnn,X */
+            OPCODE(0xdd)        /* CMP $nnnn,X */
                 CMP(LOAD_ABS_X(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xde:          /* DEC $nnnn,X */
+            OPCODE(0xde)        /* DEC $nnnn,X */
                 DEC(p2, CYCLES_1, SIZE_3, LOAD_ABS_X_RMW, STORE_ABS_X_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xdf:          /* BBS5 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0xdf)        /* BBS5 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBS(BIT_5);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe0:          /* CPX #$nn */
+            OPCODE(0xe0)        /* CPX #$nn */
                 CPX(p1, CYCLES_0, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe1:          /* SBC ($nn,X) */
+            OPCODE(0xe1)        /* SBC ($nn,X) */
                 SBC(LOAD_IND_X(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe4:          /* CPX $nn */
+            OPCODE(0xe4)        /* CPX $nn */
                 CPX(LOAD_ZERO(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe5:          /* SBC $nn */
+            OPCODE(0xe5)        /* SBC $nn */
                 SBC(LOAD_ZERO(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe6:          /* INC $nn */
+            OPCODE(0xe6)        /* INC $nn */
                 INC(p1, CYCLES_1, SIZE_2, LOAD_ZERO, STORE_ZERO_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe7:          /* SMB6 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0xe7)        /* SMB6 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 SMB(BIT_6);
-                break;
+                OPCODE_NEXT();
 
-            case 0xe8:          /* INX */
+            OPCODE(0xe8)        /* INX */
                 INX();
-                break;
+                OPCODE_NEXT();
 
-            case 0xe9:          /* SBC #$nn */
+            OPCODE(0xe9)        /* SBC #$nn */
                 SBC(p1, CYCLES_0, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xea:          /* NOP */
+            OPCODE(0xea)        /* NOP */
                 NOP();
-                break;
+                OPCODE_NEXT();
 
-            case 0xec:          /* CPX $nnnn */
+            OPCODE(0xec)        /* CPX $nnnn */
                 CPX(LOAD(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xed:          /* SBC $nnnn */
+            OPCODE(0xed)        /* SBC $nnnn */
                 SBC(LOAD(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xee:          /* INC $nnnn */
+            OPCODE(0xee)        /* INC $nnnn */
                 INC(p2, CYCLES_1, SIZE_3, LOAD_ABS, STORE_ABS_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xef:          /* BBS6 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0xef)        /* BBS6 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBS(BIT_6);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf0:          /* BEQ $nnnn */
+            OPCODE(0xf0)        /* BEQ $nnnn */
                 BRANCH(LOCAL_ZERO(), p1);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf1:          /* SBC ($nn),Y */
+            OPCODE(0xf1)        /* SBC ($nn),Y */
                 SBC(LOAD_IND_Y(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf2:          /* SBC ($nn) */
+            OPCODE(0xf2)        /* SBC ($nn) */
                 SBC(LOAD_INDIRECT(p1), CYCLES_1, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf5:          /* SBC $nn,X */
+            OPCODE(0xf5)        /* SBC $nn,X */
                 SBC(LOAD_ZERO_X(p1), CYCLES_2, SIZE_2);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf6:          /* INC $nn,X */
+            OPCODE(0xf6)        /* INC $nn,X */
                 INC(p1, CYCLES_2, SIZE_2, LOAD_ZERO_X, STORE_ZERO_RRW_X);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf7:          /* SMB7 $nn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0xf7)        /* SMB7 $nn (65C02) / single byte, single cycle NOP (65SC02) */
                 SMB(BIT_7);
-                break;
+                OPCODE_NEXT();
 
-            case 0xf8:          /* SED */
+            OPCODE(0xf8)        /* SED */
                 SED();
-                break;
+                OPCODE_NEXT();
 
-            case 0xf9:          /* SBC $nnnn,Y */
+            OPCODE(0xf9)        /* SBC $nnnn,Y */
                 SBC(LOAD_ABS_Y(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xfa:          /* PLX */
+            OPCODE(0xfa)        /* PLX */
                 PLX();
-                break;
+                OPCODE_NEXT();
 
-            case 0xfd:          /* SBC $nnnn,X */
+            OPCODE(0xfd)        /* SBC $nnnn,X */
                 SBC(LOAD_ABS_X(p2), CYCLES_1, SIZE_3);
-                break;
+                OPCODE_NEXT();
 
-            case 0xfe:          /* INC $nnnn,X */
+            OPCODE(0xfe)        /* INC $nnnn,X */
                 INC(p2, CYCLES_1, SIZE_3, LOAD_ABS_X_RMW, STORE_ABS_X_RRW);
-                break;
+                OPCODE_NEXT();
 
-            case 0xff:          /* BBS7 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
+            OPCODE(0xff)        /* BBS7 $nn,$nnnn (65C02) / single byte, single cycle NOP (65SC02) */
                 BBS(BIT_7);
-                break;
+                OPCODE_NEXT();
         }
     }
 }
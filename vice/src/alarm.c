@@ -31,6 +31,7 @@
 #include <stdlib.h>
 
 #include "alarm.h"
+#include "archdep.h"
 #include "lib.h"
 #include "log.h"
 #include "types.h"
@@ -54,6 +55,13 @@ void alarm_context_init(alarm_context_t *context, const char *name)
 
     context->num_pending_alarms = 0;
     context->next_pending_alarm_clk = CLOCK_MAX;
+    context->next_pending_alarm_idx = -1;
+#ifdef FEATURE_ALARM_HEAP
+    context->next_seq = 0;
+#endif
+#ifdef FEATURE_BENCHMARK_HOOKS
+    context->traced = 0;
+#endif
 }
 
 void alarm_context_destroy(alarm_context_t *context)
@@ -98,6 +106,11 @@ void alarm_context_time_warp(alarm_context_t *context, CLOCK warp_amount,
     } else {
         context->next_pending_alarm_clk -= warp_amount;
     }
+
+    for (i = 0; i < context->num_pending_alarms; i++) {
+        ALARM_TRACE(context, ALARM_TRACE_SET, context->pending_alarms[i].alarm,
+                    context->pending_alarms[i].clk);
+    }
 }
 
 /* ------------------------------------------------------------------------ */
@@ -164,10 +177,13 @@ void alarm_destroy(alarm_t *alarm)
     lib_free(alarm);
 }
 
+#ifdef FEATURE_ALARM_HEAP
+
 void alarm_unset(alarm_t *alarm)
 {
     alarm_context_t *context;
     int idx;
+    int last;
 
     idx = alarm->pending_idx;
 
@@ -176,6 +192,45 @@ void alarm_unset(alarm_t *alarm)
     }
     context = alarm->context;
 
+    ALARM_TRACE(context, ALARM_TRACE_UNSET, alarm, 0);
+
+    last = (int)(--context->num_pending_alarms);
+
+    if (last != idx) {
+        /* Fill the hole with the last entry and restore the heap order.  */
+        pending_alarms_t old = context->pending_alarms[idx];
+
+        context->pending_alarms[idx] = context->pending_alarms[last];
+        context->pending_alarms[idx].alarm->pending_idx = idx;
+
+        if (alarm_pending_before(&context->pending_alarms[idx], &old)) {
+            alarm_context_sift_up(context, idx);
+        } else {
+            alarm_context_sift_down(context, idx);
+        }
+    }
+
+    alarm_context_update_next_pending(context);
+
+    alarm->pending_idx = -1;
+}
+
+#else /* !FEATURE_ALARM_HEAP */
+
+void alarm_unset(alarm_t *alarm)
+{
+    alarm_context_t *context;
+    int idx;
+
+    idx = alarm->pending_idx;
+
+    if (idx < 0) {
+        return;                 /* Not pending.  */
+    }
+    context = alarm->context;
+
+    ALARM_TRACE(context, ALARM_TRACE_UNSET, alarm, 0);
+
     if (context->num_pending_alarms > 1) {
         int last;
 
@@ -206,7 +261,172 @@ void alarm_unset(alarm_t *alarm)
     alarm->pending_idx = -1;
 }
 
+#endif /* !FEATURE_ALARM_HEAP */
+
 void alarm_log_too_many_alarms(void)
 {
     log_error(LOG_DEFAULT, "alarm_set(): Too many alarms set!");
 }
+
+/* ------------------------------------------------------------------------ */
+
+/* The "alarms" micro benchmark records the alarm traffic of a context
+   while the machine runs the cycles given with -benchmark, and then replays
+   it on a context of its own, to time the pending alarm handling without
+   the rest of the emulation.  */
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+
+/* Maximum number of recorded alarm operations.  */
+#define ALARM_TRACE_MAX         (4 * 1024 * 1024)
+
+/* The recorded traffic is replayed until this much host time has passed.  */
+#define ALARM_TRACE_SECONDS     1.0
+
+typedef struct alarm_trace_entry_s {
+    alarm_t *alarm;
+    CLOCK clk;
+    int op;
+} alarm_trace_entry_t;
+
+static alarm_context_t *trace_context = NULL;
+static alarm_trace_entry_t *trace = NULL;
+static unsigned int trace_num = 0;
+
+void alarm_trace_record(int op, alarm_t *alarm, CLOCK clk)
+{
+    if (trace_num == ALARM_TRACE_MAX) {
+        return;
+    }
+    trace[trace_num].alarm = alarm;
+    trace[trace_num].clk = clk;
+    trace[trace_num].op = op;
+    trace_num++;
+}
+
+static void alarm_trace_start(void)
+{
+    unsigned int i;
+
+    if (trace == NULL) {
+        trace = lib_malloc(ALARM_TRACE_MAX * sizeof(alarm_trace_entry_t));
+    }
+    trace_num = 0;
+    trace_context->traced = 1;
+
+    /* The alarms already pending are set first on replay.  */
+    for (i = 0; i < trace_context->num_pending_alarms; i++) {
+        alarm_trace_record(ALARM_TRACE_SET,
+                           trace_context->pending_alarms[i].alarm,
+                           trace_context->pending_alarms[i].clk);
+    }
+}
+
+static void alarm_trace_dummy_callback(CLOCK offset, void *data)
+{
+}
+
+static int alarm_trace_replay(void)
+{
+    alarm_context_t *context;
+    alarm_t **recorded;
+    alarm_t **alarms;
+    unsigned int *ids;
+    unsigned int num_alarms = 0;
+    unsigned int i, j;
+    unsigned long n = 0;
+    unsigned long dispatches = 0;
+    unsigned long mismatches = 0;
+    tick_t start;
+    double seconds;
+
+    trace_context->traced = 0;
+
+    if (trace_num == 0) {
+        log_error(LOG_DEFAULT,
+                  "No alarm traffic recorded, run with -benchmark <cycles>.");
+        return -1;
+    }
+    if (trace_num == ALARM_TRACE_MAX) {
+        log_warning(LOG_DEFAULT, "Alarm trace full, replaying the first %u operations.",
+                    trace_num);
+    }
+
+    /* Map the recorded alarms to alarms of a context of our own.  */
+    recorded = lib_malloc(trace_num * sizeof(alarm_t *));
+    ids = lib_malloc(trace_num * sizeof(unsigned int));
+    for (i = 0; i < trace_num; i++) {
+        for (j = 0; j < num_alarms; j++) {
+            if (recorded[j] == trace[i].alarm) {
+                break;
+            }
+        }
+        if (j == num_alarms) {
+            recorded[num_alarms++] = trace[i].alarm;
+        }
+        ids[i] = j;
+    }
+
+    context = alarm_context_new("Replay");
+    alarms = lib_malloc(num_alarms * sizeof(alarm_t *));
+    for (j = 0; j < num_alarms; j++) {
+        alarms[j] = alarm_new(context, "Replay", alarm_trace_dummy_callback, NULL);
+    }
+
+    start = tick_now();
+    do {
+        for (i = 0; i < trace_num; i++) {
+            switch (trace[i].op) {
+                case ALARM_TRACE_SET:
+                    alarm_set(alarms[ids[i]], trace[i].clk);
+                    break;
+                case ALARM_TRACE_UNSET:
+                    alarm_unset(alarms[ids[i]]);
+                    break;
+                default:
+                    /* the emulation dispatched the alarm due first; alarms
+                       due on the same clock tick may be dispatched in a
+                       different order, so only the clock is checked */
+                    if (alarm_context_next_pending_clk(context) != trace[i].clk) {
+                        mismatches++;
+                    }
+                    dispatches++;
+                    break;
+            }
+        }
+        for (j = 0; j < num_alarms; j++) {
+            alarm_unset(alarms[j]);
+        }
+        n++;
+        seconds = (double)tick_now_delta(start) / tick_per_second();
+    } while (seconds < ALARM_TRACE_SECONDS);
+
+    benchmark_kernel_result("alarms", "replay",
+                            seconds, (double)trace_num * n, "operations");
+    printf("Benchmark alarms: %u alarms, %u operations replayed %lu times, %lu dispatches, %lu mismatches\n",
+           num_alarms, trace_num, n, dispatches, mismatches);
+
+    alarm_context_destroy(context);
+    lib_free(alarms);
+    lib_free(ids);
+    lib_free(recorded);
+    lib_free(trace);
+    trace = NULL;
+    trace_num = 0;
+
+    return mismatches ? -1 : 0;
+}
+
+#endif
+
+/* Register the "alarms" micro benchmark, recording the traffic of
+   `context'.  */
+void alarm_benchmark_init(alarm_context_t *context)
+{
+#ifdef FEATURE_BENCHMARK_HOOKS
+    trace_context = context;
+    benchmark_kernel_register("alarms",
+                              "replay the main CPU alarm traffic of -benchmark",
+                              alarm_trace_start, alarm_trace_replay);
+#endif
+}
@@ -28,6 +28,7 @@
 #ifndef VICE_ALARM_H
 #define VICE_ALARM_H
 
+#include "benchmark.h"
 #include "types.h"
 
 #define ALARM_CONTEXT_MAX_PENDING_ALARMS 0x100
@@ -63,6 +64,12 @@ struct pending_alarms_s {
 
     /* Clock tick at which this alarm should be activated.  */
     CLOCK clk;
+
+#ifdef FEATURE_ALARM_HEAP
+    /* Order in which the alarms were set, to dispatch alarms that are due
+       on the same clock tick first come, first served.  */
+    CLOCK seq;
+#endif
 };
 typedef struct pending_alarms_s pending_alarms_t;
 
@@ -75,7 +82,8 @@ struct alarm_context_s {
     struct alarm_s *alarms;
 
     /* Pending alarm array.  Statically allocated because it's slightly
-       faster this way.  */
+       faster this way.  With FEATURE_ALARM_HEAP it is kept ordered as a
+       binary min-heap on `clk', so the next alarm is always at index 0.  */
     pending_alarms_t pending_alarms[ALARM_CONTEXT_MAX_PENDING_ALARMS];
     unsigned int num_pending_alarms;
 
@@ -84,6 +92,17 @@ struct alarm_context_s {
 
     /* Pending alarm number.  */
     int next_pending_alarm_idx;
+
+#ifdef FEATURE_ALARM_HEAP
+    /* Sequence number for the next alarm_set().  */
+    CLOCK next_seq;
+#endif
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+    /* If non-zero, alarm traffic is recorded for the "alarms" micro
+       benchmark.  */
+    int traced;
+#endif
 };
 typedef struct alarm_context_s alarm_context_t;
 
@@ -97,6 +116,26 @@ alarm_t *alarm_new(alarm_context_t *context, const char *name, alarm_callback_t
 void alarm_destroy(alarm_t *alarm);
 void alarm_unset(alarm_t *alarm);
 void alarm_log_too_many_alarms(void);
+void alarm_benchmark_init(alarm_context_t *context);
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+enum {
+    ALARM_TRACE_SET,
+    ALARM_TRACE_UNSET,
+    ALARM_TRACE_DISPATCH
+};
+
+void alarm_trace_record(int op, alarm_t *alarm, CLOCK clk);
+
+#define ALARM_TRACE(context, op, alarm, clk)            \
+    do {                                                \
+        if ((context)->traced) {                        \
+            alarm_trace_record((op), (alarm), (clk));   \
+        }                                               \
+    } while (0)
+#else
+#define ALARM_TRACE(context, op, alarm, clk)
+#endif
 
 /* ------------------------------------------------------------------------- */
 
@@ -107,6 +146,150 @@ inline static CLOCK alarm_context_next_pending_clk(alarm_context_t *context)
     return context->next_pending_alarm_clk;
 }
 
+#ifdef FEATURE_ALARM_HEAP
+
+inline static void alarm_context_swap_pending(alarm_context_t *context,
+                                              int a, int b)
+{
+    pending_alarms_t tmp;
+
+    tmp = context->pending_alarms[a];
+    context->pending_alarms[a] = context->pending_alarms[b];
+    context->pending_alarms[b] = tmp;
+
+    context->pending_alarms[a].alarm->pending_idx = a;
+    context->pending_alarms[b].alarm->pending_idx = b;
+}
+
+/* Return non-zero if the pending alarm `a' is due before `b': earlier
+   `clk' first, and alarms due on the same `clk' in the order they were
+   set.  */
+inline static int alarm_pending_before(const pending_alarms_t *a,
+                                       const pending_alarms_t *b)
+{
+    return a->clk < b->clk || (a->clk == b->clk && a->seq < b->seq);
+}
+
+/* Move the pending alarm at `idx' towards the root of the heap until its
+   parent is due before itself.  */
+inline static void alarm_context_sift_up(alarm_context_t *context, int idx)
+{
+    while (idx > 0) {
+        int parent = (idx - 1) / 2;
+
+        if (!alarm_pending_before(&context->pending_alarms[idx],
+                                  &context->pending_alarms[parent])) {
+            break;
+        }
+        alarm_context_swap_pending(context, parent, idx);
+        idx = parent;
+    }
+}
+
+/* Move the pending alarm at `idx' towards the leaves of the heap until
+   none of its children is due before itself.  */
+inline static void alarm_context_sift_down(alarm_context_t *context, int idx)
+{
+    int num = (int)(context->num_pending_alarms);
+
+    for (;;) {
+        int child = 2 * idx + 1;
+
+        if (child >= num) {
+            break;
+        }
+        if (child + 1 < num
+            && alarm_pending_before(&context->pending_alarms[child + 1],
+                                    &context->pending_alarms[child])) {
+            child++;
+        }
+        if (!alarm_pending_before(&context->pending_alarms[child],
+                                  &context->pending_alarms[idx])) {
+            break;
+        }
+        alarm_context_swap_pending(context, idx, child);
+        idx = child;
+    }
+}
+
+/* With the heap the earliest alarm is always at the root, so this does not
+   need to scan anything.  */
+inline static void alarm_context_update_next_pending(alarm_context_t *context)
+{
+    if (context->num_pending_alarms > 0) {
+        context->next_pending_alarm_clk = context->pending_alarms[0].clk;
+        context->next_pending_alarm_idx = 0;
+    } else {
+        context->next_pending_alarm_clk = CLOCK_MAX;
+        context->next_pending_alarm_idx = -1;
+    }
+}
+
+inline static void alarm_context_dispatch(alarm_context_t *context,
+                                          CLOCK cpu_clk)
+{
+    CLOCK offset;
+    alarm_t *alarm;
+
+    BENCHMARK_ENTER(BENCHMARK_ALARMS);
+
+    offset = cpu_clk - context->next_pending_alarm_clk;
+
+    alarm = context->pending_alarms[0].alarm;
+    ALARM_TRACE(context, ALARM_TRACE_DISPATCH, alarm,
+                context->next_pending_alarm_clk);
+
+    (alarm->callback)(offset, alarm->data);
+
+    BENCHMARK_LEAVE();
+}
+
+inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
+{
+    alarm_context_t *context;
+    int idx;
+
+    context = alarm->context;
+    idx = alarm->pending_idx;
+
+    ALARM_TRACE(context, ALARM_TRACE_SET, alarm, cpu_clk);
+
+    if (idx < 0) {
+        /* Not pending yet: add.  */
+
+        idx = (int)(context->num_pending_alarms);
+        if (idx >= (int)ALARM_CONTEXT_MAX_PENDING_ALARMS) {
+            alarm_log_too_many_alarms();
+            return;
+        }
+
+        context->pending_alarms[idx].alarm = alarm;
+        context->pending_alarms[idx].clk = cpu_clk;
+        context->pending_alarms[idx].seq = context->next_seq++;
+        alarm->pending_idx = idx;
+
+        context->num_pending_alarms++;
+
+        alarm_context_sift_up(context, idx);
+    } else {
+        /* Already pending: modify.  Setting it again queues it behind the
+           other alarms due on the same clock tick.  */
+        CLOCK old_clk = context->pending_alarms[idx].clk;
+
+        context->pending_alarms[idx].clk = cpu_clk;
+        context->pending_alarms[idx].seq = context->next_seq++;
+        if (cpu_clk < old_clk) {
+            alarm_context_sift_up(context, idx);
+        } else {
+            alarm_context_sift_down(context, idx);
+        }
+    }
+
+    alarm_context_update_next_pending(context);
+}
+
+#else /* !FEATURE_ALARM_HEAP */
+
 inline static void alarm_context_update_next_pending(alarm_context_t *context)
 {
     CLOCK next_pending_alarm_clk = CLOCK_MAX;
@@ -135,12 +318,18 @@ inline static void alarm_context_dispatch(alarm_context_t *context,
     int idx;
     alarm_t *alarm;
 
+    BENCHMARK_ENTER(BENCHMARK_ALARMS);
+
     offset = cpu_clk - context->next_pending_alarm_clk;
 
     idx = context->next_pending_alarm_idx;
     alarm = context->pending_alarms[idx].alarm;
+    ALARM_TRACE(context, ALARM_TRACE_DISPATCH, alarm,
+                context->next_pending_alarm_clk);
 
     (alarm->callback)(offset, alarm->data);
+
+    BENCHMARK_LEAVE();
 }
 
 inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
@@ -151,6 +340,8 @@ inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
     context = alarm->context;
     idx = alarm->pending_idx;
 
+    ALARM_TRACE(context, ALARM_TRACE_SET, alarm, cpu_clk);
+
     if (idx < 0) {
         int new_idx;
 
@@ -184,4 +375,6 @@ inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
     }
 }
 
+#endif /* !FEATURE_ALARM_HEAP */
+
 #endif
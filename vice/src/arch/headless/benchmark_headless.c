@@ -0,0 +1,352 @@
+/** \file   benchmark_headless.c
+ * \brief   Benchmark mode of the headless UI
+ *
+ * With -benchmark the emulation runs in warp mode with the dummy sound
+ * device and no video output for the given number of cycles, after which
+ * the host time it took is printed, once for humans and once as a single
+ * line of JSON, and VICE quits. When built with --enable-benchmark-hooks
+ * the CPU time of the emulation thread is also split between the
+ * emulator's subsystems, by sampling the subsystem the hooks in
+ * benchmark.h mark as running from a timer on that thread's CPU clock.
+ * CPU time used by other threads (OpenMP workers, the VIC-II render thread,
+ * ...) is reported on its own line, not charged to any subsystem.
+ *
+ * With -microbenchmark a registered micro benchmark runs instead of the
+ * machine, see benchmark_kernel_register().
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(FEATURE_BENCHMARK_HOOKS) && defined(HAVE_TIMER_CREATE) && defined(CLOCK_THREAD_CPUTIME_ID)
+#include <signal.h>
+#endif
+
+#include "archdep.h"
+#include "benchmark.h"
+#include "benchmark_headless.h"
+#include "cmdline.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "maincpu.h"
+#include "resources.h"
+#include "types.h"
+#include "vsync.h"
+
+#if defined(FEATURE_BENCHMARK_HOOKS) && defined(HAVE_TIMER_CREATE) && defined(CLOCK_THREAD_CPUTIME_ID)
+#define BENCHMARK_SAMPLING
+
+/** \brief  Sampling interval of the profiling timer in nanoseconds
+ */
+#define SAMPLE_INTERVAL 1000000
+
+/** \brief  Number of samples taken per subsystem
+ */
+static volatile unsigned long samples[BENCHMARK_NUM];
+
+/** \brief  Timer on the emulation thread's CPU clock
+ */
+static timer_t sample_timer;
+#endif
+
+/** \brief  Number of cycles to run, 0 when not benchmarking
+ */
+static CLOCK benchmark_cycles = 0;
+
+/** \brief  Name of the micro benchmark to run, NULL when not running one
+ */
+static char *microbenchmark_name = NULL;
+
+/** \brief  Benchmark has started
+ */
+static int running = 0;
+
+static CLOCK start_clk;
+static double start_cpu;
+static double start_thread_cpu;
+static tick_t last_tick;
+
+/** \brief  Host time since the start, summed up frame by frame so that the
+ *          32-bit tick counter cannot wrap around
+ */
+static double wall_seconds;
+
+
+static int cmdline_benchmark(const char *param, void *extra_param)
+{
+    uint64_t cycles = strtoull(param, NULL, 0);
+
+    if (cycles == 0 || cycles > CLOCK_MAX) {
+        fprintf(stderr, "invalid number of cycles '%s'\n", param);
+        return -1;
+    }
+    benchmark_cycles = (CLOCK)cycles;
+    return 0;
+}
+
+static int cmdline_microbenchmark(const char *param, void *extra_param)
+{
+    lib_free(microbenchmark_name);
+    microbenchmark_name = lib_strdup(param);
+    return 0;
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-benchmark", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_benchmark, NULL, NULL, NULL,
+      "<cycles>", "Run <cycles> cycles in warp mode without sound and video output, print the host time taken and quit" },
+    { "-microbenchmark", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_microbenchmark, NULL, NULL, NULL,
+      "<name>", "Run the micro benchmark <name> and quit, after the cycles given with -benchmark if any (\"list\" lists them)" },
+    CMDLINE_LIST_END
+};
+
+
+/** \brief  Register the -benchmark command line option
+ *
+ * \return  0 on success, -1 on failure
+ */
+int benchmark_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
+
+
+/** \brief  Get the CPU time of the process, all threads together
+ *
+ * \return  CPU time in seconds
+ */
+static double process_cpu_seconds(void)
+{
+#ifdef CLOCK_PROCESS_CPUTIME_ID
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0) {
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+#endif
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/** \brief  Get the CPU time of the calling thread
+ *
+ * \return  CPU time in seconds, or the process CPU time if the system has
+ *          no per-thread CPU clock
+ */
+static double thread_cpu_seconds(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+#endif
+    return process_cpu_seconds();
+}
+
+
+#ifdef BENCHMARK_SAMPLING
+static void sample(int signo)
+{
+    samples[benchmark_subsystem]++;
+}
+
+/* The timer runs on the CPU clock of the calling thread, which must be the
+   emulation thread, so the samples only count its CPU time.  */
+static void sampling_start(void)
+{
+    struct sigevent event;
+    struct itimerspec spec;
+
+    memset(&event, 0, sizeof event);
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGPROF;
+    signal(SIGPROF, sample);
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &sample_timer) < 0) {
+        log_error(LOG_DEFAULT, "Benchmark: cannot create the sampling timer.");
+        signal(SIGPROF, SIG_DFL);
+        return;
+    }
+    spec.it_interval.tv_sec = 0;
+    spec.it_interval.tv_nsec = SAMPLE_INTERVAL;
+    spec.it_value = spec.it_interval;
+    timer_settime(sample_timer, 0, &spec, NULL);
+}
+
+static void sampling_stop(void)
+{
+    timer_delete(sample_timer);
+    signal(SIGPROF, SIG_DFL);
+}
+#endif
+
+
+static void benchmark_start(void)
+{
+    /* no sound output, but keep synthesizing so that it shows up */
+    resources_set_string("SoundDeviceName", "dummy");
+    resources_set_int("Sound", 1);
+    vsync_set_warp_mode(1);
+    /* no frames are drawn or rendered from here on, unless something needs
+       the draw buffer (see raster_canvas_handle_end_of_frame()) */
+    video_disabled_mode = true;
+
+    start_clk = maincpu_clk;
+    start_cpu = process_cpu_seconds();
+    start_thread_cpu = thread_cpu_seconds();
+    last_tick = tick_now();
+    wall_seconds = 0.0;
+#ifdef BENCHMARK_SAMPLING
+    sampling_start();
+#endif
+    running = 1;
+
+    log_message(LOG_DEFAULT, "Benchmark: running %"PRIu64" cycles.", benchmark_cycles);
+}
+
+static void benchmark_report(void)
+{
+    CLOCK cycles = maincpu_clk - start_clk;
+    double cpu_seconds = process_cpu_seconds() - start_cpu;
+    double emu_cpu_seconds = thread_cpu_seconds() - start_thread_cpu;
+    double other_cpu_seconds = cpu_seconds > emu_cpu_seconds ? cpu_seconds - emu_cpu_seconds : 0.0;
+    double cycles_per_second = wall_seconds > 0.0 ? cycles / wall_seconds : 0.0;
+    long machine_cycles_per_second = machine_get_cycles_per_second();
+    double speed = machine_cycles_per_second > 0
+                   ? cycles_per_second * 100.0 / machine_cycles_per_second : 0.0;
+#ifdef BENCHMARK_SAMPLING
+    unsigned long total = 0;
+    int i;
+
+    for (i = 0; i < BENCHMARK_NUM; i++) {
+        total += samples[i];
+    }
+#endif
+
+    printf("Benchmark: %s, %"PRIu64" cycles in %.3f s (%.3f s CPU), %.0f cycles/s, %.1f%% of real time\n",
+           machine_get_name(), cycles, wall_seconds, cpu_seconds,
+           cycles_per_second, speed);
+    printf("  emulation thread %9.3f s CPU, other threads %9.3f s CPU\n",
+           emu_cpu_seconds, other_cpu_seconds);
+#ifdef BENCHMARK_SAMPLING
+    for (i = 0; i < BENCHMARK_NUM; i++) {
+        double share = total ? (double)samples[i] / total : 0.0;
+
+        printf("  %-10s %9.3f s CPU %6.1f%%\n",
+               benchmark_subsystem_name(i), share * emu_cpu_seconds, share * 100.0);
+    }
+#else
+    printf("  (no split by subsystem, configure with --enable-benchmark-hooks)\n");
+#endif
+
+    printf("{\"machine\":\"%s\",\"cycles\":%"PRIu64",\"host_seconds\":%.6f,"
+           "\"cpu_seconds\":%.6f,\"emulation_thread_cpu_seconds\":%.6f,"
+           "\"other_threads_cpu_seconds\":%.6f,"
+           "\"cycles_per_second\":%.0f,\"speed_percent\":%.2f,"
+           "\"subsystems\":",
+           machine_get_name(), cycles, wall_seconds, cpu_seconds,
+           emu_cpu_seconds, other_cpu_seconds,
+           cycles_per_second, speed);
+#ifdef BENCHMARK_SAMPLING
+    printf("{");
+    for (i = 0; i < BENCHMARK_NUM; i++) {
+        double share = total ? (double)samples[i] / total : 0.0;
+
+        printf("%s\"%s\":%.6f", i ? "," : "",
+               benchmark_subsystem_name(i), share * emu_cpu_seconds);
+    }
+    printf("}}\n");
+#else
+    printf("null}\n");
+#endif
+    fflush(stdout);
+}
+
+
+/** \brief  Run the micro benchmark and quit
+ */
+static void microbenchmark_run(void)
+{
+    int result = benchmark_kernel_run(microbenchmark_name);
+
+    lib_free(microbenchmark_name);
+    microbenchmark_name = NULL;
+    archdep_vice_exit(result < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+
+/** \brief  Start, or check for the end of, the benchmark
+ *
+ * Called once a frame; when the requested number of cycles has run, the
+ * results are printed and VICE quits. A micro benchmark runs on the first
+ * frame, once the machine has been set up, or after the cycles given with
+ * -benchmark have run, if any.
+ */
+void benchmark_vsync_hook(void)
+{
+    tick_t now;
+
+    if (microbenchmark_name != NULL && !running) {
+        if (strcmp(microbenchmark_name, "list") == 0) {
+            benchmark_kernel_list();
+            archdep_vice_exit(EXIT_SUCCESS);
+        }
+        if (benchmark_kernel_prepare(microbenchmark_name) < 0) {
+            archdep_vice_exit(EXIT_FAILURE);
+        }
+        if (benchmark_cycles == 0) {
+            microbenchmark_run();
+        }
+    }
+
+    if (benchmark_cycles == 0) {
+        return;
+    }
+    if (!running) {
+        benchmark_start();
+        return;
+    }
+
+    now = tick_now();
+    wall_seconds += (double)tick_now_delta(last_tick) / tick_per_second();
+    last_tick = now;
+
+    if (maincpu_clk - start_clk >= benchmark_cycles) {
+#ifdef BENCHMARK_SAMPLING
+        sampling_stop();
+#endif
+        if (microbenchmark_name != NULL) {
+            microbenchmark_run();
+        }
+        benchmark_report();
+        archdep_vice_exit(EXIT_SUCCESS);
+    }
+}
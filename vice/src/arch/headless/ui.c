@@ -46,6 +46,7 @@
 #include "archdep.h"
 
 #include "autostart.h"
+#include "benchmark_headless.h"
 #include "cmdline.h"
 #include "drive.h"
 #include "interrupt.h"
@@ -103,6 +104,9 @@ int ui_cmdline_options_init(void)
 {
     /* printf("%s\n", __func__); */
 
+    if (benchmark_cmdline_options_init() < 0) {
+        return -1;
+    }
     return cmdline_register_options(cmdline_options_common);
 }
 
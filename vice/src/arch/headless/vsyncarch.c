@@ -30,6 +30,7 @@
 
 #include "vice.h"
 
+#include "benchmark_headless.h"
 #include "kbdbuf.h"
 #include "mainlock.h"
 #include "ui.h"
@@ -75,6 +76,7 @@ void vsyncarch_postsync(void)
         ui_pause_enable();
         pause_pending = 0;
     }
+    benchmark_vsync_hook();
 }
 
 void vsyncarch_advance_frame(void)
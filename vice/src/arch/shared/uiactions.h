@@ -289,6 +289,7 @@ enum {
     ACTION_SNAPSHOT_LOAD,
     ACTION_SNAPSHOT_QUICKLOAD,
     ACTION_SNAPSHOT_QUICKSAVE,
+    ACTION_SNAPSHOT_REWIND,
     ACTION_SNAPSHOT_SAVE,
     ACTION_SPEED_CPU_10,
     ACTION_SPEED_CPU_25,
@@ -34,7 +34,9 @@
 
 #include "archdep.h"
 #include "attach.h"
+#include "benchmark.h"
 #include "cmdline.h"
+#include "diskconstants.h"
 #include "diskimage.h"
 #include "driveimage.h"
 #include "drive.h"
@@ -91,6 +93,9 @@ static int attach_disk_image(disk_image_t *oldimage, vdrive_t *vdrive,
                              const char *filename, unsigned int unit,
                              unsigned int drive,
                              int devicetype);
+#ifdef FEATURE_BENCHMARK_HOOKS
+static int attach_benchmark(void);
+#endif
 
 #define UNIT_AND_DRIVE(unit, drive)     ((unit << 8) | drive)
 #define GET_UNIT(du)                    ((du >> 8) & 0xFF)
@@ -289,6 +294,11 @@ void file_system_init(void)
         }
         file_system_set_serial_hooks(i + 8, file_system_device_enabled[i]);
     }
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+    benchmark_kernel_register("attach", "attach and detach 35, 40 and 42 track D64 images on unit 8",
+                              NULL, attach_benchmark);
+#endif
 }
 
 void file_system_shutdown(void)
@@ -821,3 +831,121 @@ void file_system_event_playback(unsigned int unit, unsigned int drive, const cha
         file_system_attach_disk_internal(unit, drive, filename);
     }
 }
+
+/* ------------------------------------------------------------------------- */
+
+/* The "attach" micro benchmark times attaching and detaching D64 images of
+   35, 40 and 42 tracks on unit 8, once as is and once with the GCR data of
+   every track generated right after attaching, as a program reading the
+   whole disk needs it. With the true drive emulation off there is no GCR
+   data to generate.  */
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+
+/* Each image size and mode is timed for this long.  */
+#define ATTACH_BENCHMARK_SECONDS    0.5
+
+/* write a D64 image of `num_tracks' tracks to `filename' */
+static int attach_benchmark_image(const char *filename, unsigned int num_tracks)
+{
+    uint8_t buffer[256];
+    unsigned int track, sector, i;
+    FILE *fd;
+
+    fd = fopen(filename, MODE_WRITE);
+    if (fd == NULL) {
+        return -1;
+    }
+    for (track = 1; track <= num_tracks; track++) {
+        unsigned int max_sector = disk_image_sector_per_track(DISK_IMAGE_TYPE_D64, track);
+
+        for (sector = 0; sector < max_sector; sector++) {
+            for (i = 0; i < 256; i++) {
+                buffer[i] = (uint8_t)(i * 7 + track * 13 + sector * 29);
+            }
+            if (track == BAM_TRACK_1541 && sector == BAM_SECTOR_1541) {
+                memset(buffer, 0, 256);
+                buffer[0] = BAM_TRACK_1541;
+                buffer[1] = 1;
+                buffer[2] = 0x41;
+                memset(&buffer[BAM_NAME_1541], 0xa0, 27);
+                memcpy(&buffer[BAM_NAME_1541], "BENCHMARK", 9);
+                buffer[BAM_ID_1541] = 'V';
+                buffer[BAM_ID_1541 + 1] = 'B';
+                buffer[BAM_ID_1541 + 3] = '2';
+                buffer[BAM_ID_1541 + 4] = 'A';
+            }
+            if (fwrite(buffer, 1, 256, fd) != 256) {
+                fclose(fd);
+                return -1;
+            }
+        }
+    }
+    return fclose(fd) == 0 ? 0 : -1;
+}
+
+static int attach_benchmark(void)
+{
+    static const unsigned int sizes[] = { 35, 40, 42 };
+    char *filename;
+    int log_limit;
+    unsigned int i;
+    int generate;
+    int result = 0;
+
+    filename = archdep_tmpnam();
+    file_system_detach_disk(8, 0);
+    log_limit = log_get_limit();
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]) && result == 0; i++) {
+        if (attach_benchmark_image(filename, sizes[i]) < 0) {
+            log_error(attach_log, "Cannot write the benchmark image `%s'.", filename);
+            result = -1;
+            break;
+        }
+        for (generate = 0; generate < 2 && result == 0; generate++) {
+            unsigned long attaches = 0;
+            char test[48];
+            tick_t start;
+            double seconds;
+
+            /* every attach logs a few lines */
+            log_set_limit(LOG_LIMIT_SILENT);
+            start = tick_now();
+            do {
+                disk_image_t *image;
+
+                if (file_system_attach_disk(8, 0, filename) < 0) {
+                    result = -1;
+                    break;
+                }
+                image = file_system_get_image(8, 0);
+                if (generate && image != NULL) {
+                    unsigned int half_track;
+
+                    for (half_track = 2; half_track <= image->tracks * 2; half_track += 2) {
+                        disk_image_gcr_track_prepare(image, half_track);
+                    }
+                }
+                file_system_detach_disk(8, 0);
+                attaches++;
+                seconds = (double)tick_now_delta(start) / tick_per_second();
+            } while (seconds < ATTACH_BENCHMARK_SECONDS);
+            log_set_limit(log_limit);
+
+            if (result < 0) {
+                log_error(attach_log, "Cannot attach the benchmark image `%s'.", filename);
+                break;
+            }
+            sprintf(test, "%u tracks%s", sizes[i], generate ? ", all tracks generated" : "");
+            benchmark_kernel_result("attach", test, seconds, (double)attaches, "attaches");
+        }
+    }
+
+    archdep_remove(filename);
+    lib_free(filename);
+
+    return result;
+}
+
+#endif
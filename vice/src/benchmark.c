@@ -0,0 +1,196 @@
+/** \file   benchmark.c
+ * \brief   Subsystem instrumentation hooks for benchmarking
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "log.h"
+
+/** \brief  Maximum number of micro benchmarks
+ */
+#define BENCHMARK_MAX_KERNELS   16
+
+/** \brief  A registered micro benchmark
+ */
+typedef struct benchmark_kernel_entry_s {
+    const char *name;           /**< name given to -microbenchmark */
+    const char *description;    /**< what it measures */
+    benchmark_prepare_t prepare;/**< function preparing it, or NULL */
+    benchmark_kernel_t kernel;  /**< function running it */
+} benchmark_kernel_entry_t;
+
+static benchmark_kernel_entry_t kernels[BENCHMARK_MAX_KERNELS];
+static int num_kernels = 0;
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+/** \brief  Subsystem currently running, read from the sampling signal handler
+ */
+volatile sig_atomic_t benchmark_subsystem = BENCHMARK_MAINCPU;
+#endif
+
+/** \brief  Names of the subsystems, also used as keys in the JSON summary
+ */
+static const char * const subsystem_names[BENCHMARK_NUM] = {
+    "maincpu",
+    "drive",
+    "videochip",
+    "sound",
+    "render",
+    "alarms",
+    "other"
+};
+
+
+/** \brief  Get name of subsystem
+ *
+ * \param[in]   subsystem   subsystem (BENCHMARK_MAINCPU ...)
+ *
+ * \return  name, or "unknown" for an invalid \a subsystem
+ */
+const char *benchmark_subsystem_name(int subsystem)
+{
+    if (subsystem < 0 || subsystem >= BENCHMARK_NUM) {
+        return "unknown";
+    }
+    return subsystem_names[subsystem];
+}
+
+
+/** \brief  Register a micro benchmark
+ *
+ * Registering the same name again is ignored, so modules can do this from
+ * init code that runs more than once.
+ *
+ * \param[in]   name        name to run it with -microbenchmark
+ * \param[in]   description one line description
+ * \param[in]   prepare     function preparing the benchmark, or NULL
+ * \param[in]   kernel      function running the benchmark
+ */
+void benchmark_kernel_register(const char *name, const char *description,
+                               benchmark_prepare_t prepare,
+                               benchmark_kernel_t kernel)
+{
+    int i;
+
+    for (i = 0; i < num_kernels; i++) {
+        if (strcmp(kernels[i].name, name) == 0) {
+            return;
+        }
+    }
+    if (num_kernels == BENCHMARK_MAX_KERNELS) {
+        log_error(LOG_DEFAULT, "Too many micro benchmarks, cannot add '%s'.", name);
+        return;
+    }
+    kernels[num_kernels].name = name;
+    kernels[num_kernels].description = description;
+    kernels[num_kernels].prepare = prepare;
+    kernels[num_kernels].kernel = kernel;
+    num_kernels++;
+}
+
+
+/** \brief  Prepare a micro benchmark
+ *
+ * \param[in]   name    name of the benchmark
+ *
+ * \return  0 on success, -1 if there is no such benchmark
+ */
+int benchmark_kernel_prepare(const char *name)
+{
+    int i;
+
+    for (i = 0; i < num_kernels; i++) {
+        if (strcmp(kernels[i].name, name) == 0) {
+            if (kernels[i].prepare != NULL) {
+                kernels[i].prepare();
+            }
+            return 0;
+        }
+    }
+    log_error(LOG_DEFAULT, "Unknown micro benchmark '%s'.", name);
+    benchmark_kernel_list();
+    return -1;
+}
+
+
+/** \brief  Run a micro benchmark
+ *
+ * \param[in]   name    name of the benchmark
+ *
+ * \return  0 if it ran and its checks passed, -1 otherwise
+ */
+int benchmark_kernel_run(const char *name)
+{
+    int i;
+
+    for (i = 0; i < num_kernels; i++) {
+        if (strcmp(kernels[i].name, name) == 0) {
+            return kernels[i].kernel();
+        }
+    }
+    log_error(LOG_DEFAULT, "Unknown micro benchmark '%s'.", name);
+    benchmark_kernel_list();
+    return -1;
+}
+
+
+/** \brief  Print the micro benchmarks available in this emulator
+ */
+void benchmark_kernel_list(void)
+{
+    int i;
+
+    printf("Available micro benchmarks:\n");
+    for (i = 0; i < num_kernels; i++) {
+        printf("  %-12s %s\n", kernels[i].name, kernels[i].description);
+    }
+}
+
+
+/** \brief  Print one result of a micro benchmark
+ *
+ * Prints a line for humans and a line of JSON.
+ *
+ * \param[in]   name    name of the benchmark
+ * \param[in]   test    what was measured
+ * \param[in]   seconds host time it took
+ * \param[in]   count   number of \a unit processed in that time
+ * \param[in]   unit    unit of \a count (frames, tracks, ...)
+ */
+void benchmark_kernel_result(const char *name, const char *test,
+                             double seconds, double count, const char *unit)
+{
+    double per_second = seconds > 0.0 ? count / seconds : 0.0;
+
+    printf("Benchmark %s: %s, %.0f %s in %.3f s, %.1f %s/s\n",
+           name, test, count, unit, seconds, per_second, unit);
+    printf("{\"benchmark\":\"%s\",\"test\":\"%s\",\"seconds\":%.6f,"
+           "\"count\":%.0f,\"unit\":\"%s\",\"per_second\":%.3f}\n",
+           name, test, seconds, count, unit, per_second);
+    fflush(stdout);
+}
@@ -0,0 +1,101 @@
+/** \file   benchmark.h
+ * \brief   Subsystem instrumentation hooks for benchmarking - header
+ *
+ * The hooks only record which emulator subsystem is currently running;
+ * a benchmark driver (see the headless UI's -benchmark option) samples
+ * that state periodically to split the host time between subsystems.
+ * They are compiled out unless FEATURE_BENCHMARK_HOOKS is defined.
+ *
+ * Modules can also register micro benchmarks of single kernels, which the
+ * headless UI's -microbenchmark option runs instead of the machine.
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_BENCHMARK_H
+#define VICE_BENCHMARK_H
+
+/** \brief  Subsystems the host time is split into
+ */
+enum {
+    BENCHMARK_MAINCPU = 0,      /**< main CPU, including memory and I/O */
+    BENCHMARK_DRIVE,            /**< drive CPUs and disk rotation */
+    BENCHMARK_VIDEOCHIP,        /**< VIC-II, VIC, TED, CRTC, VDC raster emulation */
+    BENCHMARK_SOUND,            /**< sound synthesis */
+    BENCHMARK_RENDER,           /**< rendering of the frame for the host */
+    BENCHMARK_ALARMS,           /**< alarm dispatch (timers, ...) */
+    BENCHMARK_OTHER,            /**< vsync, UI and everything else */
+    BENCHMARK_NUM
+};
+
+const char *benchmark_subsystem_name(int subsystem);
+
+/** \brief  Micro benchmark of a single kernel
+ *
+ * Runs on the emulation thread after the machine has been set up, prints
+ * its results with benchmark_kernel_result() and returns 0 if its own
+ * checks passed, -1 otherwise.
+ */
+typedef int (*benchmark_kernel_t)(void);
+
+/** \brief  Preparation of a micro benchmark
+ *
+ * Called before the machine runs the cycles given with -benchmark, for
+ * micro benchmarks that replay what the machine did (e.g. start recording).
+ */
+typedef void (*benchmark_prepare_t)(void);
+
+void benchmark_kernel_register(const char *name, const char *description,
+                               benchmark_prepare_t prepare,
+                               benchmark_kernel_t kernel);
+int  benchmark_kernel_prepare(const char *name);
+int  benchmark_kernel_run(const char *name);
+void benchmark_kernel_list(void);
+void benchmark_kernel_result(const char *name, const char *test,
+                             double seconds, double count, const char *unit);
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+
+#include <signal.h>
+
+extern volatile sig_atomic_t benchmark_subsystem;
+
+/* The mark is a single global for the emulation thread, so the hooks must
+   only be used in code running on it; time spent in other threads is
+   accounted separately by the benchmark driver.  */
+
+/* Mark the start of a subsystem's code; must be paired with
+   BENCHMARK_LEAVE() in the same block, on every path out of it.  */
+#define BENCHMARK_ENTER(subsystem)                                      \
+    sig_atomic_t benchmark_saved_subsystem = benchmark_subsystem;       \
+    benchmark_subsystem = (subsystem)
+
+#define BENCHMARK_LEAVE()   (benchmark_subsystem = benchmark_saved_subsystem)
+
+#else
+
+#define BENCHMARK_ENTER(subsystem)
+#define BENCHMARK_LEAVE()
+
+#endif
+
+#endif
@@ -78,6 +78,65 @@ static io_source_list_t c64io_dd00_head = { NULL, NULL, NULL };
 static io_source_list_t c64io_de00_head = { NULL, NULL, NULL };
 static io_source_list_t c64io_df00_head = { NULL, NULL, NULL };
 
+/* list heads indexed by bits 8-11 of the address */
+static io_source_list_t * const c64io_heads[0x10] = {
+    &c64io_d000_head, &c64io_d100_head, &c64io_d200_head, &c64io_d300_head,
+    &c64io_d400_head, &c64io_d500_head, &c64io_d600_head, &c64io_d700_head,
+    NULL, NULL, NULL, NULL, NULL,
+    &c64io_dd00_head, &c64io_de00_head, &c64io_df00_head
+};
+
+/* Direct-mapped dispatch table, rebuilt whenever an I/O source is registered
+   or unregistered, or its range is changed (io_source_ranges_changed()): for
+   every address the one device claiming it, NULL when no device claims it,
+   or IO_SOURCE_SHARED when several devices do and the list has to be walked
+   to resolve the collision. */
+static io_source_t io_source_shared;
+#define IO_SOURCE_SHARED (&io_source_shared)
+
+static io_source_t *c64io_dispatch[0x10][0x100];
+
+static void io_dispatch_update(void)
+{
+    io_source_list_t *current;
+    io_source_t *found;
+    unsigned int page, i;
+    uint16_t addr;
+
+    for (page = 0; page < 0x10; page++) {
+        for (i = 0; i < 0x100; i++) {
+            addr = (uint16_t)(0xd000 + (page << 8) + i);
+            found = NULL;
+            current = c64io_heads[page] ? c64io_heads[page]->next : NULL;
+            while (current) {
+                if (addr >= current->device->start_address && addr <= current->device->end_address) {
+                    if (found != NULL) {
+                        found = IO_SOURCE_SHARED;
+                        break;
+                    }
+                    found = current->device;
+                }
+                current = current->next;
+            }
+            c64io_dispatch[page][i] = found;
+        }
+    }
+}
+
+/* Return the device for `addr' if it is the only one claiming the address.
+   The range is checked again as some devices shrink their range while they
+   are registered. */
+static inline io_source_t *io_dispatch_single(uint16_t addr)
+{
+    io_source_t *device = c64io_dispatch[(addr >> 8) & 0x0f][addr & 0xff];
+
+    if (device == NULL || device == IO_SOURCE_SHARED
+        || addr < device->start_address || addr > device->end_address) {
+        return NULL;
+    }
+    return device;
+}
+
 static void io_source_detach(io_source_detach_t *source)
 {
     switch (source->det_id) {
@@ -301,9 +360,19 @@ static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
     uint8_t retval = 0;
     uint8_t firstval = 0;
     unsigned int lowest_order = 0xffffffff;
+    io_source_t *device;
 
     vicii_handle_pending_alarms_external(0);
 
+    if (c64io_dispatch[(addr >> 8) & 0x0f][addr & 0xff] == NULL) {
+        return vicii_read_phi1();
+    }
+    device = io_dispatch_single(addr);
+    if (device != NULL && device->read != NULL) {
+        retval = device->read((uint16_t)(addr & device->address_mask));
+        return device->io_source_valid ? retval : vicii_read_phi1();
+    }
+
     while (current) {
         if (current->device->read != NULL) {
             if ((addr >= current->device->start_address) && (addr <= current->device->end_address)) {
@@ -375,6 +444,16 @@ static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
 static inline uint8_t io_peek(io_source_list_t *list, uint16_t addr)
 {
     io_source_list_t *current = list->next;
+    io_source_t *device = io_dispatch_single(addr);
+
+    if (device != NULL) {
+        if (device->peek) {
+            return device->peek((uint16_t)(addr & device->address_mask));
+        } else if (device->read) {
+            return device->read((uint16_t)(addr & device->address_mask));
+        }
+        return vicii_read_phi1();
+    }
 
     while (current) {
         if (addr >= current->device->start_address && addr <= current->device->end_address) {
@@ -396,9 +475,21 @@ static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value
     uint16_t addy = 0xffff;
     io_source_list_t *current = list->next;
     void (*store)(uint16_t address, uint8_t data) = NULL;
+    io_source_t *device;
 
     vicii_handle_pending_alarms_external_write();
 
+    if (c64io_dispatch[(addr >> 8) & 0x0f][addr & 0xff] == NULL) {
+        return;
+    }
+    device = io_dispatch_single(addr);
+    if (device != NULL) {
+        if (device->store != NULL) {
+            device->store((uint16_t)(addr & device->address_mask), value);
+        }
+        return;
+    }
+
     while (current) {
         if (current->device->store != NULL) {
             if (addr >= current->device->start_address && addr <= current->device->end_address) {
@@ -482,6 +573,8 @@ io_source_list_t *io_source_register(io_source_t *device)
     retval->next = NULL;
     retval->device->order = order++;
 
+    io_dispatch_update();
+
     return retval;
 }
 
@@ -506,6 +599,8 @@ void io_source_unregister(io_source_list_t *device)
     }
 
     lib_free(device);
+
+    io_dispatch_update();
 }
 
 void cartio_shutdown(void)
@@ -584,6 +679,11 @@ void cartio_set_highest_order(unsigned int nr)
     order = nr;
 }
 
+void io_source_ranges_changed(void)
+{
+    io_dispatch_update();
+}
+
 /* ---------------------------------------------------------------------------------------------------------- */
 
 uint8_t c64io_d000_read(uint16_t addr)
@@ -835,6 +835,10 @@ unsigned int disk_image_sector_per_track(unsigned int format, unsigned int track
     return 0;
 }
 
+void disk_image_gcr_track_prepare(const disk_image_t *image, unsigned int half_track)
+{
+}
+
 int disk_image_write_p64_image(const disk_image_t *image)
 {
     return 0;
@@ -280,6 +280,10 @@ typedef struct io_source_detach_s {
 io_source_list_t *io_source_register(io_source_t *device);
 void io_source_unregister(io_source_list_t *device);
 
+/* Must be called when start_address or end_address of a registered device
+   is changed in place, without unregistering and registering it again. */
+void io_source_ranges_changed(void);
+
 void cartio_shutdown(void);
 
 void c64io_vicii_init(void);
@@ -549,6 +549,11 @@ void cartio_set_highest_order(unsigned int nr)
     order = nr;
 }
 
+void io_source_ranges_changed(void)
+{
+    /* the device lists are walked on every access, nothing to update */
+}
+
 /* ---------------------------------------------------------------------------------------------------------- */
 
 uint8_t cbm2io_d800_read(uint16_t addr)
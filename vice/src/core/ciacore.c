@@ -2139,9 +2139,9 @@ void ciacore_shutdown(cia_context_t *cia_context)
 /* -------------------------------------------------------------------------- */
 
 #define CIA_DUMP_VER_MAJOR      2
-#define CIA_DUMP_VER_MINOR      5
+#define CIA_DUMP_VER_MINOR      6
 
-/* CIA 2.5 snapshot module format:
+/* CIA 2.6 snapshot module format:
 
    type  | name             |Version|  description
    -------------------------------------------------
@@ -2190,6 +2190,8 @@ void ciacore_shutdown(cia_context_t *cia_context)
    DWORD | IFR_DELAY        | 2.5+  | event/history bits for the interrupt flag reg.
    BYTE  | ACK_IRQFLAGS     | 2.5+  | flags in IFR to acknowledge, i.e. clear.
    BYTE  | NEW_IRQFLAGS     | 2.5+  | new flags in IFR that were set recently.
+   DWORD | POWER_TICKCOUNTER| 2.6+  | power ticks in the current second
+   DWORD | POWER_TICKS      | 2.6+  | clk ticks of the power ticks in the current second
 */
 
 /* FIXME!!!  Error check.  */
@@ -2317,13 +2319,18 @@ int ciacore_snapshot_write_module(cia_context_t *cia_context, snapshot_t *s)
     /* 2.5 */
 
     SMW_DW(m, cia_context->ifr_delay);    /* IFR_DELAY */
-    SMW_DB(m, cia_context->ack_irqflags); /* ACK_IRQFLAGS */
-    SMW_DB(m, cia_context->new_irqflags); /* NEW_IRQFLAGS */
+    SMW_B(m, (uint8_t)cia_context->ack_irqflags); /* ACK_IRQFLAGS */
+    SMW_B(m, (uint8_t)cia_context->new_irqflags); /* NEW_IRQFLAGS */
     /*
      * We don't need to save ifr_clock, since we made sure it
      * is up to date, i.e. equal to rclk.
      */
 
+    /* 2.6 */
+
+    SMW_DW(m, (uint32_t)cia_context->power_tickcounter);  /* POWER_TICKCOUNTER */
+    SMW_DW(m, (uint32_t)cia_context->power_ticks);        /* POWER_TICKS */
+
     snapshot_module_close(m);
 
     return 0;
@@ -2518,14 +2525,33 @@ int ciacore_snapshot_read_module(cia_context_t *cia_context, snapshot_t *s)
         cia_context->ifr_delay = dword;
         cia_context->ifr_clock = rclk + 1;
 
-        SMR_B(m, &byte);        /* ACK_IRQFLAGS */
-        cia_context->ack_irqflags = byte;
-        SMR_B(m, &byte);        /* NEW_IRQFLAGS */
-        cia_context->new_irqflags = byte;
+        if (vminor > 5) {
+            SMR_B(m, &byte);        /* ACK_IRQFLAGS */
+            cia_context->ack_irqflags = byte;
+            SMR_B(m, &byte);        /* NEW_IRQFLAGS */
+            cia_context->new_irqflags = byte;
+        } else {
+            /* 2.5 wrote these as doubles */
+            double db;
+
+            SMR_DB(m, &db);         /* ACK_IRQFLAGS */
+            cia_context->ack_irqflags = (uint8_t)db;
+            SMR_DB(m, &db);         /* NEW_IRQFLAGS */
+            cia_context->new_irqflags = (uint8_t)db;
+        }
 
         cia_ifr_current(cia_context, rclk, CIA_IFR_NEXT);
     }
 
+    if (vminor > 5) {
+        uint32_t dword;
+
+        SMR_DW(m, &dword);      /* POWER_TICKCOUNTER */
+        cia_context->power_tickcounter = (int)dword;
+        SMR_DW(m, &dword);      /* POWER_TICKS */
+        cia_context->power_ticks = dword;
+    }
+
     if (snapshot_module_close(m) < 0) {
         return -1;
     }
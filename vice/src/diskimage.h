@@ -148,6 +148,7 @@ unsigned int disk_image_sync_size(unsigned int format, unsigned int track);
 int disk_image_read_image(const disk_image_t *image);
 int disk_image_write_p64_image(const disk_image_t *image);
 int disk_image_write_half_track(disk_image_t *image, unsigned int half_track, const struct disk_track_s *raw);
+void disk_image_gcr_track_prepare(const disk_image_t *image, unsigned int half_track);
 
 unsigned int disk_image_speed_map(unsigned int format, unsigned int track);
 
@@ -46,6 +46,7 @@
 #include "fsimage-gcr.h"
 #include "fsimage-p64.h"
 #include "fsimage.h"
+#include "gcr.h"
 #include "lib.h"
 #include "log.h"
 #include "realimage.h"
@@ -723,6 +724,10 @@ int disk_image_write_half_track(disk_image_t *image, unsigned int half_track,
 
 int disk_image_read_image(const disk_image_t *image)
 {
+    if (image->gcr != NULL) {
+        memset(image->gcr->pending, 0, sizeof(image->gcr->pending));
+    }
+
     switch (image->type) {
         case DISK_IMAGE_TYPE_P64:
             return fsimage_read_p64_image(image);
@@ -734,6 +739,24 @@ int disk_image_read_image(const disk_image_t *image)
     }
 }
 
+/* Generate the GCR data of half track `half_track' if that was postponed
+   when the image was read */
+void disk_image_gcr_track_prepare(const disk_image_t *image, unsigned int half_track)
+{
+    gcr_t *gcr = image->gcr;
+
+    if (gcr == NULL || half_track < 2 || half_track - 2 >= MAX_GCR_TRACKS
+        || !gcr->pending[half_track - 2]) {
+        return;
+    }
+    gcr->pending[half_track - 2] = 0;
+
+    if (fsimage_dxx_read_half_track(image, half_track, &gcr->tracks[half_track - 2]) < 0) {
+        log_error(disk_image_log, "Cannot generate GCR data of track %u.", half_track / 2);
+        memset(gcr->tracks[half_track - 2].data, 0x55, gcr->tracks[half_track - 2].size);
+    }
+}
+
 int disk_image_write_p64_image(const disk_image_t *image)
 {
     return fsimage_write_p64_image(image);
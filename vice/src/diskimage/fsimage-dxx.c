@@ -56,6 +56,8 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
 
     track = half_track / 2;
 
+    disk_image_gcr_track_prepare(image, half_track);
+
     max_sector = disk_image_sector_per_track(image->type, track);
     sectors = disk_image_check_sector(image, track, 0);
     if (sectors < 0) {
@@ -146,24 +148,135 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
     return 0;
 }
 
-int fsimage_read_dxx_image(const disk_image_t *image)
+/* Skew (byte offset) of the first sector of `track', see
+   fsimage_dxx_read_half_track() */
+static unsigned long fsimage_dxx_track_skew(const disk_image_t *image, unsigned int track)
 {
-    uint8_t buffer[256], *bam_id;
+    unsigned int t, track_size, max_sector;
+    int gap, headergap, synclen;
+    unsigned long trackoffset = 0;
+
+    for (t = 1; t <= track && t <= image->tracks; t++) {
+        track_size = disk_image_raw_track_size(image->type, t);
+        gap = disk_image_gap_size(image->type, t);
+        headergap = disk_image_header_gap_size(image->type, t);
+        synclen = disk_image_sync_size(image->type, t);
+        max_sector = disk_image_sector_per_track(image->type, t);
+
+        /* On real disks, the track skew depends on many factors of which
+           none is exactly defined: the mechanical properties of the drive,
+           and last not least the code used for formatting the disk. Thus
+           the offset we use here is somewhat arbitrary, the choosen values
+           are tweaked to be somewhat close to what the skew1.prg program
+           shows for the first few tracks. */
+        trackoffset += max_sector * (SECTOR_GCR_SIZE_WITH_HEADER + headergap + gap + (synclen * 2)) - gap; /* bytes we have written */
+        trackoffset += (track_size * 100) / 270; /* time it takes to step */
+        trackoffset %= track_size;
+    }
+    return trackoffset;
+}
+
+/* Generate the GCR data of (even) half track `half_track' from the sectors
+   in the image. `raw' must already have the size of the track. */
+int fsimage_dxx_read_half_track(const disk_image_t *image, unsigned int half_track,
+                                disk_track_t *raw)
+{
+    uint8_t buffer[256];
     int gap, headergap, synclen;
     unsigned int track, sector, track_size;
     gcr_header_t header;
     fdc_err_t rf;
-    int image_has_two_single_sides = 0;
-    int double_sided_drive = 0;
     fsimage_t *fsimage = image->media.fsimage;
     unsigned int max_sector;
     uint8_t *ptr;
-    int half_track;
     int sectors;
     long offset;
-    unsigned long trackoffset = 0;
+    unsigned long trackoffset;
     uint8_t *tempgcr;
 
+    track = half_track / 2;
+    track_size = disk_image_raw_track_size(image->type, track);
+    if (raw->data == NULL || raw->size != (int)track_size || track > image->tracks) {
+        return -1;
+    }
+
+    /* special case for second side of the 1571. If each side was formatted
+       separately in one-sided mode, we must start from track 1 again and use
+       the ID from the BAM on the second side. */
+    if (fsimage->gcr_two_single_sides && track >= 36) {
+        header.id1 = fsimage->gcr_id[1][0];
+        header.id2 = fsimage->gcr_id[1][1];
+        header.track = track - 35;
+    } else {
+        header.id1 = fsimage->gcr_id[0][0];
+        header.id2 = fsimage->gcr_id[0][1];
+        header.track = track;
+    }
+
+    /* get temp buffer */
+    ptr = tempgcr = lib_malloc(track_size);
+
+    gap = disk_image_gap_size(image->type, track);
+    headergap = disk_image_header_gap_size(image->type, track);
+    synclen = disk_image_sync_size(image->type, track);
+
+    max_sector = disk_image_sector_per_track(image->type, track);
+
+    /* Clear track to avoid read errors.  */
+    memset(ptr, 0x55, track_size);
+
+    for (sector = 0; sector < max_sector; sector++) {
+        sectors = disk_image_check_sector(image, track, sector);
+        offset = sectors * 256;
+
+#ifdef HAVE_X64_IMAGE
+        if (image->type == DISK_IMAGE_TYPE_X64) {
+            offset += X64_HEADER_LENGTH;
+        }
+#endif
+        if (sectors >= 0) {
+            rf = CBMDOS_FDC_ERR_DRIVE;
+            if (util_fpread(fsimage->fd, buffer, 256, offset) >= 0) {
+                if (fsimage->error_info.map != NULL) {
+                    rf = fsimage->error_info.map[sectors];
+                }
+            }
+            header.sector = sector;
+            gcr_convert_sector_to_GCR(buffer, ptr, &header, headergap, synclen, rf);
+        }
+
+        ptr += SECTOR_GCR_SIZE_WITH_HEADER + headergap + gap + (synclen * 2);
+    }
+
+#if 0
+    /* copy gcr data to buffer (this creates perfectly aligned tracks) */
+    memcpy(raw->data, tempgcr, track_size);
+#else
+    /* copy gcr data to final buffer with offset + wraparound */
+    trackoffset = fsimage_dxx_track_skew(image, track);
+    /*printf("track: %2u sectors: %2u size: %5u offset: %5lu\n", track, max_sector, track_size, trackoffset);*/
+    ptr = raw->data;
+    memset(ptr, 0x55, track_size);
+    memcpy(ptr + trackoffset, tempgcr, track_size - trackoffset);
+    memcpy(ptr, tempgcr + (track_size - trackoffset), track_size - (track_size - trackoffset));
+#endif
+    lib_free(tempgcr);
+    return 0;
+}
+
+/* Set up the GCR tracks of the image. The GCR data of the tracks that hold
+   sectors is not generated here, but only when the track is first needed,
+   see disk_image_gcr_track_prepare(). */
+int fsimage_read_dxx_image(const disk_image_t *image)
+{
+    uint8_t buffer[256], *bam_id;
+    unsigned int track, track_size;
+    int double_sided_drive = 0;
+    fsimage_t *fsimage = image->media.fsimage;
+    uint8_t *ptr;
+    int half_track;
+    int sectors;
+
     if (image->type == DISK_IMAGE_TYPE_D80
         || image->type == DISK_IMAGE_TYPE_D82) {
         sectors = disk_image_check_sector(image, HDR_TRACK_8050, HDR_SECTOR_8050);
@@ -179,18 +292,28 @@ int fsimage_read_dxx_image(const disk_image_t *image)
     } else {
         return -1;
     }
-    header.id1 = bam_id[0];
-    header.id2 = bam_id[1];
+    fsimage->gcr_id[0][0] = bam_id[0];
+    fsimage->gcr_id[0][1] = bam_id[1];
 
     /* check double sided images */
-    image_has_two_single_sides = (image->type == DISK_IMAGE_TYPE_D71) && !(buffer[0x03] & 0x80);
+    fsimage->gcr_two_single_sides = (image->type == DISK_IMAGE_TYPE_D71) && !(buffer[0x03] & 0x80);
+    if (fsimage->gcr_two_single_sides) {
+        sectors = disk_image_check_sector(image, BAM_TRACK_1571 + 35, BAM_SECTOR_1571);
+
+        buffer[BAM_ID_1571] = buffer[BAM_ID_1571 + 1] = 0xa0;
+        if (sectors >= 0) {
+            util_fpread(fsimage->fd, buffer, 256, sectors << 8);
+        }
+        fsimage->gcr_id[1][0] = buffer[BAM_ID_1571];
+        fsimage->gcr_id[1][1] = buffer[BAM_ID_1571 + 1];
+    }
     double_sided_drive = (drive_get_disk_drive_type(image->device) == DRIVE_TYPE_1571) ||
                          (drive_get_disk_drive_type(image->device) == DRIVE_TYPE_1571CR);
 
     /* special case for 1571: if we are inserting a d64 image into a 1571, fill
        the second side with "unformatted" data */
     if (double_sided_drive && (image->type != DISK_IMAGE_TYPE_D71)) {
-        for (header.track = track = 1; track <= image->max_half_tracks / 2; track++, header.track++) {
+        for (track = 1; track <= image->max_half_tracks / 2; track++) {
             half_track = (36 + track) * 2 - 2;
 
             track_size = disk_image_raw_track_size(image->type, track);
@@ -219,7 +342,7 @@ int fsimage_read_dxx_image(const disk_image_t *image)
         }
     }
 
-    for (header.track = track = 1; track <= image->max_half_tracks / 2; track++, header.track++) {
+    for (track = 1; track <= image->max_half_tracks / 2; track++) {
         half_track = track * 2 - 2;
 
         track_size = disk_image_raw_track_size(image->type, track);
@@ -232,78 +355,8 @@ int fsimage_read_dxx_image(const disk_image_t *image)
         image->gcr->tracks[half_track].size = track_size;
 
         if (track <= image->tracks) {
-            /* get temp buffer */
-            ptr = tempgcr = lib_malloc(track_size);
-
-            /* special case for second side of the 1571. If each side was formatted
-               separately in one-sided mode, we must start from track 1 again and use
-               the ID from the BAM on the second side. */
-            if (image_has_two_single_sides && track == 36) {
-                sectors = disk_image_check_sector(image, BAM_TRACK_1571 + 35, BAM_SECTOR_1571);
-
-                buffer[BAM_ID_1571] = buffer[BAM_ID_1571 + 1] = 0xa0;
-                if (sectors >= 0) {
-                    util_fpread(fsimage->fd, buffer, 256, sectors << 8);
-                }
-                header.id1 = buffer[BAM_ID_1571]; /* second side, update id and track */
-                header.id2 = buffer[BAM_ID_1571 + 1];
-                header.track = 1;
-            }
-
-            gap = disk_image_gap_size(image->type, track);
-            headergap = disk_image_header_gap_size(image->type, track);
-            synclen = disk_image_sync_size(image->type, track);
-
-            max_sector = disk_image_sector_per_track(image->type, track);
-
-            /* Clear track to avoid read errors.  */
-            memset(ptr, 0x55, track_size);
-
-            for (sector = 0; sector < max_sector; sector++) {
-                sectors = disk_image_check_sector(image, track, sector);
-                offset = sectors * 256;
-
-#ifdef HAVE_X64_IMAGE
-                if (image->type == DISK_IMAGE_TYPE_X64) {
-                    offset += X64_HEADER_LENGTH;
-                }
-#endif
-                if (sectors >= 0) {
-                    rf = CBMDOS_FDC_ERR_DRIVE;
-                    if (util_fpread(fsimage->fd, buffer, 256, offset) >= 0) {
-                        if (fsimage->error_info.map != NULL) {
-                            rf = fsimage->error_info.map[sectors];
-                        }
-                    }
-                    header.sector = sector;
-                    gcr_convert_sector_to_GCR(buffer, ptr, &header, headergap, synclen, rf);
-                }
-
-                ptr += SECTOR_GCR_SIZE_WITH_HEADER + headergap + gap + (synclen * 2);
-            }
-
-#if 0
-            /* copy gcr data to buffer (this creates perfectly aligned tracks) */
-            ptr = image->gcr->tracks[half_track].data;
-            memcpy(ptr, tempgcr, track_size);
-#else
-            /* copy gcr data to final buffer with offset + wraparound */
-            /* On real disks, the track skew depends on many factors of which
-               none is exactly defined: the mechanical properties of the drive,
-               and last not least the code used for formatting the disk. Thus
-               the offset we use here is somewhat arbitrary, the choosen values
-               are tweaked to be somewhat close to what the skew1.prg program
-               shows for the first few tracks. */
-            trackoffset += (ptr - tempgcr) - gap; /* bytes we have written */
-            trackoffset += (track_size * 100) / 270; /* time it takes to step */
-            trackoffset %= track_size;
-            /*printf("track: %2u sectors: %2u size: %5u offset: %5lu\n", track, max_sector, track_size, trackoffset);*/
-            ptr = image->gcr->tracks[half_track].data;
-            memset(ptr, 0x55, track_size);
-            memcpy(ptr + trackoffset, tempgcr, track_size - trackoffset);
-            memcpy(ptr, tempgcr + (track_size - trackoffset), track_size - (track_size - trackoffset));
-#endif
-            lib_free(tempgcr);
+            /* generated on first access */
+            image->gcr->pending[half_track] = 1;
         } else {
             memset(ptr, 0x55, track_size);
         }
@@ -382,6 +435,7 @@ int fsimage_dxx_read_sector(const disk_image_t *image, uint8_t *buf, const disk_
                 rf = fsimage->error_info.map ? fsimage->error_info.map[sectors] : CBMDOS_FDC_ERR_OK;
             }
         } else {
+            disk_image_gcr_track_prepare(image, dadr->track * 2);
             rf = gcr_read_sector(&image->gcr->tracks[(dadr->track * 2) - 2], buf, (uint8_t)dadr->sector);
             /* HACK: if the image has an error map, and the "FDC" did not detect an
             error in the GCR stream, use the error from the error map instead.
@@ -455,7 +509,8 @@ int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk
                   dadr->track, dadr->sector);
         return -1;
     }
-    if (image->gcr != NULL) {
+    /* a track that is still pending is generated from the new data later */
+    if (image->gcr != NULL && !image->gcr->pending[(dadr->track * 2) - 2]) {
         gcr_write_sector(&image->gcr->tracks[(dadr->track * 2) - 2], buf, (uint8_t)dadr->sector);
     }
 
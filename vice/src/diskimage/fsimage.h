@@ -42,6 +42,9 @@ typedef struct fsimage_s {
         int dirty;
         int len;
     } error_info;
+    /* disk ID of each side, used to generate the GCR tracks of D64/D71 */
+    uint8_t gcr_id[2][2];
+    int gcr_two_single_sides;
 } fsimage_t;
 
 
@@ -159,6 +159,100 @@ static int drive_snapshot_read_p64image_module(snapshot_t *s, unsigned int dnr);
 #define DRIVE_SNAP_MAJOR 2
 #define DRIVE_SNAP_MINOR 0
 
+/*
+ * In-memory snapshots (rewind history) do not write the dirty GCR tracks
+ * back to the disk images, they record which tracks are dirty instead:
+
+   type  | name              | description
+   ------------------------------------------
+   BYTE  | dirty track       | current track of the drive is dirty
+   ARRAY | dirty half tracks | 2 * (DRIVE_HALFTRACKS_1571 + 1) flags
+
+ * for both drives of each unit. Restoring one marks these tracks dirty
+ * again, in addition to the ones dirty at that time; the GCR data itself
+ * is not part of these snapshots, so no track written since may be lost.
+ */
+
+#define GCRDIRTY_SNAP_MAJOR 1
+#define GCRDIRTY_SNAP_MINOR 0
+
+static int drive_snapshot_write_gcrdirty_module(snapshot_t *s)
+{
+    snapshot_module_t *m;
+    drive_t *drive;
+    unsigned int unr, dnr;
+
+    m = snapshot_module_create(s, "GCRDIRTY", GCRDIRTY_SNAP_MAJOR, GCRDIRTY_SNAP_MINOR);
+    if (m == NULL) {
+        return -1;
+    }
+
+    for (unr = 0; unr < NUM_DISK_UNITS; unr++) {
+        for (dnr = 0; dnr < NUM_DRIVES; dnr++) {
+            drive = diskunit_context[unr]->drives[dnr];
+            if (drive == NULL) {
+                continue;
+            }
+            if (0
+                || SMW_B(m, (uint8_t)drive->GCR_dirty_track) < 0
+                || SMW_BA(m, &drive->GCR_dirty_half_tracks[0][0],
+                          sizeof(drive->GCR_dirty_half_tracks)) < 0) {
+                snapshot_module_close(m);
+                return -1;
+            }
+        }
+    }
+
+    return snapshot_module_close(m);
+}
+
+static int drive_snapshot_read_gcrdirty_module(snapshot_t *s)
+{
+    uint8_t major_version, minor_version;
+    uint8_t dirty_half_tracks[2][DRIVE_HALFTRACKS_1571 + 1];
+    uint8_t dirty_track;
+    snapshot_module_t *m;
+    drive_t *drive;
+    unsigned int unr, dnr, side, i;
+
+    m = snapshot_module_open(s, "GCRDIRTY", &major_version, &minor_version);
+    if (m == NULL) {
+        return 0;
+    }
+
+    if (snapshot_version_is_bigger(major_version, minor_version, GCRDIRTY_SNAP_MAJOR, GCRDIRTY_SNAP_MINOR)) {
+        snapshot_set_error(SNAPSHOT_MODULE_HIGHER_VERSION);
+        snapshot_module_close(m);
+        return -1;
+    }
+
+    for (unr = 0; unr < NUM_DISK_UNITS; unr++) {
+        for (dnr = 0; dnr < NUM_DRIVES; dnr++) {
+            drive = diskunit_context[unr]->drives[dnr];
+            if (drive == NULL) {
+                continue;
+            }
+            if (0
+                || SMR_B(m, &dirty_track) < 0
+                || SMR_BA(m, &dirty_half_tracks[0][0], sizeof(dirty_half_tracks)) < 0) {
+                snapshot_module_close(m);
+                return -1;
+            }
+            if (drive->image == NULL) {
+                continue;
+            }
+            drive->GCR_dirty_track |= dirty_track;
+            for (side = 0; side < 2; side++) {
+                for (i = 0; i <= DRIVE_HALFTRACKS_1571; i++) {
+                    drive->GCR_dirty_half_tracks[side][i] |= dirty_half_tracks[side][i];
+                }
+            }
+        }
+    }
+
+    return snapshot_module_close(m);
+}
+
 int drive_snapshot_write_module(snapshot_t *s, int save_disks, int save_roms)
 {
     int unr, dnr;
@@ -176,7 +270,14 @@ int drive_snapshot_write_module(snapshot_t *s, int save_disks, int save_roms)
         return -1;
     }
 
-    drive_gcr_data_writeback_all();
+    if (snapshot_is_memory(s)) {
+        drive_gcr_data_writeback_defer_all();
+        if (drive_snapshot_write_gcrdirty_module(s) < 0) {
+            return -1;
+        }
+    } else {
+        drive_gcr_data_writeback_all();
+    }
     rotation_table_get(rotation_table_ptr); /* FIXME: should this not be per drive rather than unit? */
 
     for (unr = 0; unr < NUM_DISK_UNITS; unr++) {
@@ -370,7 +471,12 @@ int drive_snapshot_read_module(snapshot_t *s)
     int half_track[NUM_DISK_UNITS];
     int has_drives[NUM_DISK_UNITS];
 
-    drive_gcr_data_writeback_all();
+    if (snapshot_is_memory(s)) {
+        /* the tracks the drives are on now stay dirty, see GCRDIRTY */
+        drive_gcr_data_writeback_defer_all();
+    } else {
+        drive_gcr_data_writeback_all();
+    }
 
     for (unr = 0; unr < NUM_DISK_UNITS; unr++) {
         unit = diskunit_context[unr];
@@ -634,6 +740,10 @@ int drive_snapshot_read_module(snapshot_t *s)
         return -1;
     }
 
+    if (drive_snapshot_read_gcrdirty_module(s) < 0) {
+        return -1;
+    }
+
     DBG(("drive_snapshot_read_module done\n"));
     return 0;
 }
@@ -885,6 +995,9 @@ static int drive_snapshot_write_gcrimage_module(snapshot_t *s, unsigned int dnr)
 
     /* Write half track data */
     for (i = 0; i < num_half_tracks; i++) {
+        if (drive->image != NULL) {
+            disk_image_gcr_track_prepare(drive->image, i + 2);
+        }
         data = drive->gcr->tracks[i].data;
         track_size = data ? drive->gcr->tracks[i].size : 0;
         if (0
@@ -979,6 +1092,7 @@ static int drive_snapshot_read_gcrimage_module(snapshot_t *s, unsigned int dnr)
     }
     snapshot_module_close(m);
 
+    memset(drive->gcr->pending, 0, sizeof(drive->gcr->pending));
     drive->GCR_image_loaded = 1;
     drive->complicated_image_loaded = 1; /* TODO: verify if it's really like this */
     drive->image = NULL;
@@ -48,6 +48,7 @@
 
 #include "attach.h"
 #include "archdep.h"
+#include "benchmark.h"
 #include "diskconstants.h"
 #include "diskimage.h"
 #include "drive-check.h"
@@ -182,6 +183,7 @@ int drive_init(void)
 
     driverom_init();
     drive_image_init();
+    drivecpu_benchmark_init();
 
     drive_log = log_open("Drive");
 
@@ -732,6 +734,9 @@ void drive_set_half_track(int num, int side, drive_t *dptr)
     /* FIXME: why would the offset be different for D71 and G71? */
     tmp = (dptr->image && dptr->image->type == DISK_IMAGE_TYPE_G71) ? DRIVE_HALFTRACKS_1571 : 70;
 
+    if (dptr->image) {
+        disk_image_gcr_track_prepare(dptr->image, dptr->current_half_track + (dptr->side * tmp));
+    }
     dptr->GCR_track_start_ptr = dptr->gcr->tracks[dptr->current_half_track - 2 + (dptr->side * tmp)].data;
 
     if (dptr->GCR_current_track_size != 0) {
@@ -755,44 +760,32 @@ void drive_move_head(int step, drive_t *drive)
     if ((step < -1) || (step > 1)) {
         log_warning(drive_log, "ambiguous step count (%d)", step);
     }
-    drive_gcr_data_writeback(drive);
+    drive_gcr_data_writeback_defer(drive);
     drive_sound_head(drive->current_half_track, step, drive->diskunit->mynumber);
     drive_set_half_track(drive->current_half_track + step, drive->side, drive);
 }
 
-void drive_gcr_data_writeback(drive_t *drive)
+/* Write half track `current_half_track' of side `side' back to the image */
+static void drive_gcr_write_half_track(drive_t *drive, unsigned int current_half_track,
+                                       unsigned int side)
 {
     unsigned int half_track, track, end_half_track;
     int tmp;
 
-    if (drive->image == NULL) {
-        return;
-    }
-
     /* FIXME: why would the offset be different for D71 and G71? */
     tmp = (drive->image && drive->image->type == DISK_IMAGE_TYPE_G71) ? DRIVE_HALFTRACKS_1571 : 70;
-    half_track = drive->current_half_track + (drive->side * tmp);
-    track = drive->current_half_track / 2;
-
-    if (drive->image->type == DISK_IMAGE_TYPE_P64) {
-        return;
-    }
-
-    if (!(drive->GCR_dirty_track)) {
-        return;
-    }
+    half_track = current_half_track + (side * tmp);
+    track = current_half_track / 2;
 
     /* always write track to GCR images, no need to extend the image */
     if ((drive->image->type == DISK_IMAGE_TYPE_G64) ||
         (drive->image->type == DISK_IMAGE_TYPE_G71)) {
         disk_image_write_half_track(drive->image, half_track,
                                     &drive->gcr->tracks[half_track - 2]);
-        drive->GCR_dirty_track = 0;
         return;
     }
     /* writing beyond max tracks allowed in this image is not possible */
     if (half_track > drive->image->max_half_tracks) {
-        drive->GCR_dirty_track = 0;
         return;
     }
     /* when trying beyond the image, check if we should extend the image */
@@ -806,25 +799,21 @@ void drive_gcr_data_writeback(drive_t *drive)
 #endif
             (drive->image->type == DISK_IMAGE_TYPE_D81)) {
             drive->ask_extend_disk_image = DRIVE_EXTEND_ASK;
-            drive->GCR_dirty_track = 0;
             return;
         }
         /* depending on the selected extend policy, ask or never/always extend */
         switch (drive->extend_image_policy) {
             case DRIVE_EXTEND_NEVER:
                 drive->ask_extend_disk_image = DRIVE_EXTEND_ASK;
-                drive->GCR_dirty_track = 0;
                 return;
             case DRIVE_EXTEND_ASK:
                 if (drive->ask_extend_disk_image == DRIVE_EXTEND_ASK) {
                     if (ui_extend_image_dialog() == 0) {
-                        drive->GCR_dirty_track = 0;
                         drive->ask_extend_disk_image = DRIVE_EXTEND_NEVER;
                         return;
                     }
                     drive->ask_extend_disk_image = DRIVE_EXTEND_ACCESS;
                 } else if (drive->ask_extend_disk_image == DRIVE_EXTEND_NEVER) {
-                    drive->GCR_dirty_track = 0;
                     return;
                 }
                 break;
@@ -856,8 +845,73 @@ void drive_gcr_data_writeback(drive_t *drive)
         DBG(("write track: %u drive->image->max_half_tracks: %u drive->image->tracks: %u", track, drive->image->max_half_tracks, drive->image->tracks));
         disk_image_write_half_track(drive->image, half_track, &drive->gcr->tracks[half_track - 2]);
     }
+}
+
+/* Remember the current track as dirty when the head leaves it, instead of
+   writing it back to the image right away. Dirty tracks are written by
+   drive_gcr_data_writeback() when the motor is turned off, the image is
+   detached or a snapshot is taken. */
+void drive_gcr_data_writeback_defer(drive_t *drive)
+{
+    if (drive->image == NULL) {
+        return;
+    }
+
+    if (drive->image->type == DISK_IMAGE_TYPE_P64) {
+        return;
+    }
+
+    if (!(drive->GCR_dirty_track)) {
+        return;
+    }
 
     drive->GCR_dirty_track = 0;
+    if (drive->side > 1 || drive->current_half_track > DRIVE_HALFTRACKS_1571) {
+        drive_gcr_write_half_track(drive, drive->current_half_track, drive->side);
+    } else {
+        drive->GCR_dirty_half_tracks[drive->side][drive->current_half_track] = 1;
+    }
+}
+
+void drive_gcr_data_writeback(drive_t *drive)
+{
+    unsigned int side, half_track;
+
+    if (drive->image == NULL) {
+        return;
+    }
+
+    if (drive->image->type == DISK_IMAGE_TYPE_P64) {
+        return;
+    }
+
+    drive_gcr_data_writeback_defer(drive);
+
+    for (side = 0; side < 2; side++) {
+        for (half_track = 2; half_track <= DRIVE_HALFTRACKS_1571; half_track++) {
+            if (drive->GCR_dirty_half_tracks[side][half_track]) {
+                drive->GCR_dirty_half_tracks[side][half_track] = 0;
+                drive_gcr_write_half_track(drive, half_track, side);
+            }
+        }
+    }
+}
+
+/* Only mark the current tracks of all drives as dirty, without writing
+   anything to the images; used for in-memory snapshots.  */
+void drive_gcr_data_writeback_defer_all(void)
+{
+    drive_t *drive;
+    unsigned int i, j;
+
+    for (i = 0; i < NUM_DISK_UNITS; i++) {
+        for (j = 0; j < 2; j++) {
+            drive = diskunit_context[i]->drives[j];
+            if (drive) {
+                drive_gcr_data_writeback_defer(drive);
+            }
+        }
+    }
 }
 
 void drive_gcr_data_writeback_all(void)
@@ -1005,6 +1059,8 @@ int drive_num_leds(unsigned int dnr)
 /* run drive cpu for given main clock value */
 void drive_cpu_execute_one(diskunit_context_t *drv, CLOCK clk_value)
 {
+    BENCHMARK_ENTER(BENCHMARK_DRIVE);
+
     if (drv->type == DRIVE_TYPE_2000 ||
         drv->type == DRIVE_TYPE_4000 ||
         drv->type == DRIVE_TYPE_CMDHD) {
@@ -1012,6 +1068,8 @@ void drive_cpu_execute_one(diskunit_context_t *drv, CLOCK clk_value)
     } else {
         drivecpu_execute(drv, clk_value);
     }
+
+    BENCHMARK_LEAVE();
 }
 
 /* execute the CPU of all (enabled) drives */
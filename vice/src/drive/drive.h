@@ -280,6 +280,10 @@ typedef struct drive_s {
     /* Flag: does the current track need to be written out to disk?  */
     int GCR_dirty_track;
 
+    /* Flags: half tracks (per side) that have been left dirty, and are
+       written out to disk by drive_gcr_data_writeback().  */
+    uint8_t GCR_dirty_half_tracks[2][DRIVE_HALFTRACKS_1571 + 1];
+
     /* GCR value being written to the disk.  */
     uint8_t GCR_write_value;
 
@@ -421,7 +425,9 @@ int drive_get_disk_drive_type(int dnr);
 void drive_enable_update_ui(struct diskunit_context_s *drv);
 void drive_update_ui_status(void);
 void drive_gcr_data_writeback(struct drive_s *drive);
+void drive_gcr_data_writeback_defer(struct drive_s *drive);
 void drive_gcr_data_writeback_all(void);
+void drive_gcr_data_writeback_defer_all(void);
 void drive_set_active_led_color(unsigned int type, unsigned int dnr);
 int drive_set_disk_drive_type(unsigned int drive_type,
                               struct diskunit_context_s *drv);
@@ -37,6 +37,7 @@
 
 #include "6510core.h"
 #include "alarm.h"
+#include "benchmark.h"
 #include "debug.h"
 #include "drive.h"
 #include "drivecpu.h"
@@ -445,6 +446,8 @@ void drivecpu_execute(diskunit_context_t *drv, CLOCK clk_value)
 
 #define DMA_ON_RESET
 
+#define FETCH_OPCODE_LAST_DATA(value) (cpu->cpu_last_data = (uint8_t)(value))
+
 #define drivecpu_byte_ready_egde_clear()  \
     do {                                  \
         drv->drives[0]->byte_ready_edge = 0;  \
@@ -462,6 +465,9 @@ void drivecpu_execute(diskunit_context_t *drv, CLOCK clk_value)
 #define bank_start (cpu->d_bank_start)
 #define bank_base (cpu->d_bank_base)
 
+/* the core may go on with the next opcode itself, see 6510core.h */
+#define CPU_CHAIN_ALLOWED() (*drv->clk_ptr < cpu->stop_clk)
+
 #include "6510core.c"
     }
 
@@ -565,6 +571,148 @@ static void drivecpu_jam(diskunit_context_t *drv)
 
 /* ------------------------------------------------------------------------- */
 
+/* The "cpu" micro benchmark runs a fixed mix of 6502 instructions (loads,
+   stores, ALU, indexed and indirect addressing, JSR/RTS and branches) in
+   the RAM of drive 8 and reports how many instructions the drive CPU core
+   executes per second of host time.  */
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+
+#define CPU_BENCHMARK_SECONDS   1.0
+
+/* drive cycles run per call of drivecpu_execute() */
+#define CPU_BENCHMARK_CHUNK     100000
+
+/* the loop at $0300; counts its iterations in $10-$13 and stores the
+   result of each iteration in $18/$19 */
+static const uint8_t cpu_benchmark_code[] = {
+    0x78,               /* $0300       SEI */
+    0xd8,               /* $0301       CLD */
+    0xe6, 0x10,         /* $0302 loop: INC $10 */
+    0xd0, 0x0a,         /* $0304       BNE body */
+    0xe6, 0x11,         /* $0306       INC $11 */
+    0xd0, 0x06,         /* $0308       BNE body */
+    0xe6, 0x12,         /* $030a       INC $12 */
+    0xd0, 0x02,         /* $030c       BNE body */
+    0xe6, 0x13,         /* $030e       INC $13 */
+    0xa2, 0x0f,         /* $0310 body: LDX #$0f */
+    0xa9, 0x00,         /* $0312       LDA #$00 */
+    0x85, 0x15,         /* $0314       STA $15 */
+    0x18,               /* $0316 sum:  CLC */
+    0x7d, 0x80, 0x03,   /* $0317       ADC $0380,X */
+    0xa8,               /* $031a       TAY */
+    0xb1, 0x16,         /* $031b       LDA ($16),Y */
+    0x45, 0x15,         /* $031d       EOR $15 */
+    0x85, 0x15,         /* $031f       STA $15 */
+    0x98,               /* $0321       TYA */
+    0x20, 0x31, 0x03,   /* $0322       JSR sub */
+    0xca,               /* $0325       DEX */
+    0x10, 0xee,         /* $0326       BPL sum */
+    0x85, 0x18,         /* $0328       STA $18 */
+    0xa5, 0x15,         /* $032a       LDA $15 */
+    0x85, 0x19,         /* $032c       STA $19 */
+    0x4c, 0x02, 0x03,   /* $032e       JMP loop */
+    0x0a,               /* $0331 sub:  ASL A */
+    0x69, 0x35,         /* $0332       ADC #$35 */
+    0x60                /* $0334       RTS */
+};
+
+/* instructions of one iteration of the loop, if no counter byte carries */
+#define CPU_BENCHMARK_LOOP_INSNS    (2 + 3 + 16 * 13 + 4)
+
+/* the drive RAM used by the benchmark: zero page, code and tables */
+#define CPU_BENCHMARK_RAM_SIZE      0x0500
+
+static int drivecpu_benchmark(void)
+{
+    diskunit_context_t *drv = diskunit_context[0];
+    drivecpu_context_t *cpu = drv->cpu;
+    mos6510_regs_t saved_regs;
+    uint8_t saved_ram[CPU_BENCHMARK_RAM_SIZE];
+    uint8_t *ram = drv->drive_ram;
+    unsigned int a, e, x, y, carry;
+    unsigned long iterations;
+    double insns, seconds;
+    tick_t start;
+    int result = 0;
+
+    if (!drv->enable || drv->type == DRIVE_TYPE_NONE
+        || drv->type == DRIVE_TYPE_2000 || drv->type == DRIVE_TYPE_4000
+        || drv->type == DRIVE_TYPE_CMDHD) {
+        log_error(drv->log, "CPU benchmark: needs true drive emulation of a 6502 drive as unit 8.");
+        return -1;
+    }
+
+    memcpy(&saved_regs, &cpu->cpu_regs, sizeof(saved_regs));
+    memcpy(saved_ram, ram, sizeof(saved_ram));
+
+    memset(&ram[0x10], 0, 0x0a);
+    ram[0x16] = 0x00;
+    ram[0x17] = 0x04;
+    memcpy(&ram[0x0300], cpu_benchmark_code, sizeof(cpu_benchmark_code));
+    for (x = 0; x < 0x10; x++) {
+        ram[0x0380 + x] = (uint8_t)(x * 0x1d + 0x07);
+    }
+    for (y = 0; y < 0x100; y++) {
+        ram[0x0400 + y] = (uint8_t)((y * 0x9b) ^ (y >> 3));
+    }
+
+    reg_sp = 0xff;
+    reg_pc = 0x0300;
+    drivecpu_set_bank_base((void *)drv);
+
+    start = tick_now();
+    do {
+        cpu->stop_clk = *(drv->clk_ptr) + CPU_BENCHMARK_CHUNK;
+        drivecpu_execute(drv, cpu->last_clk);
+        seconds = (double)tick_now_delta(start) / tick_per_second();
+    } while (seconds < CPU_BENCHMARK_SECONDS && !cpu->is_jammed);
+
+    /* what each iteration of the loop stores in $18/$19 */
+    a = 0;
+    e = 0;
+    for (x = 0x10; x-- > 0;) {
+        a += ram[0x0380 + x];
+        y = a & 0xff;
+        e ^= ram[0x0400 + y];
+        carry = (y >> 7) & 1;
+        a = ((y << 1) & 0xff) + 0x35 + carry;
+    }
+
+    iterations = (unsigned long)ram[0x10] | ((unsigned long)ram[0x11] << 8)
+                 | ((unsigned long)ram[0x12] << 16) | ((unsigned long)ram[0x13] << 24);
+    insns = (double)iterations * CPU_BENCHMARK_LOOP_INSNS
+            + 2.0 * (double)(iterations >> 8) + 2.0 * (double)(iterations >> 16)
+            + (double)(iterations >> 24);
+
+    if (cpu->is_jammed || iterations == 0
+        || ram[0x18] != (a & 0xff) || ram[0x19] != e) {
+        log_error(drv->log, "CPU benchmark: wrong result $%02X/$%02X after %lu loops, expected $%02X/$%02X.",
+                  ram[0x18], ram[0x19], iterations, a & 0xff, e);
+        result = -1;
+    }
+    benchmark_kernel_result("cpu", "drive 8", seconds, insns, "instructions");
+    printf("Benchmark cpu: %.2f MIPS\n", seconds > 0.0 ? insns / seconds / 1e6 : 0.0);
+
+    memcpy(ram, saved_ram, sizeof(saved_ram));
+    memcpy(&cpu->cpu_regs, &saved_regs, sizeof(saved_regs));
+    drivecpu_set_bank_base((void *)drv);
+
+    return result;
+}
+
+#endif
+
+void drivecpu_benchmark_init(void)
+{
+#ifdef FEATURE_BENCHMARK_HOOKS
+    benchmark_kernel_register("cpu", "run a 6502 instruction mix in the RAM of drive 8, in MIPS",
+                              NULL, drivecpu_benchmark);
+#endif
+}
+
+/* ------------------------------------------------------------------------- */
+
 /* DRIVECPU 1.3 snapshot module format:
 
    type  | name                 | description
@@ -45,6 +45,7 @@ struct snapshot_s;
 void drivecpu_setup_context(struct diskunit_context_s *drv, int i);
 
 void drivecpu_init(struct diskunit_context_s *drv, int type);
+void drivecpu_benchmark_init(void);
 void drivecpu_reset(struct diskunit_context_s *drv);
 void drivecpu_sleep(struct diskunit_context_s *drv);
 void drivecpu_wake_up(struct diskunit_context_s *drv);
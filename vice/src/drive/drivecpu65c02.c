@@ -410,6 +410,9 @@ void drivecpu65c02_execute(diskunit_context_t *drv, CLOCK clk_value)
 #define WDC_STP()
 #define WDC_WAI()
 
+/* the core may go on with the next opcode itself, see 6510core.h */
+#define CPU_CHAIN_ALLOWED() (*drv->clk_ptr < cpu->stop_clk)
+
 #include "65c02core.c"
     }
 
@@ -29,12 +29,16 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "archdep.h"
+#include "benchmark.h"
+#include "cbmdos.h"
 #include "diskconstants.h"
 #include "diskimage.h"
 #include "drive.h"
 #include "driveimage.h"
 #include "drivetypes.h"
 #include "gcr.h"
+#include "lib.h"
 #include "log.h"
 #include "types.h"
 
@@ -274,6 +278,7 @@ int drive_image_detach(disk_image_t *image, unsigned int unit, unsigned int drv)
             drive->gcr->tracks[i].data = NULL;
             drive->gcr->tracks[i].size = 0;
         }
+        drive->gcr->pending[i] = 0;
     }
     drive->detach_clk = diskunit_clk[dnr];
     drive->GCR_image_loaded = 0;
@@ -285,7 +290,121 @@ int drive_image_detach(disk_image_t *image, unsigned int unit, unsigned int drv)
     return 0;
 }
 
+/* ------------------------------------------------------------------------- */
+
+/* The "gcr" micro benchmark decodes all sectors of the GCR tracks of D64
+   images of 35, 40 and 42 tracks with gcr_read_sector(), as the drive
+   does when writing back or for the virtual drive.  */
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+
+/* Each image size is decoded for this long.  */
+#define GCR_BENCHMARK_SECONDS   1.0
+
+/* contents of sector `sector' of track `track' in the benchmark image */
+static void gcr_benchmark_sector(uint8_t *buffer, unsigned int track, unsigned int sector)
+{
+    unsigned int i;
+
+    for (i = 0; i < 256; i++) {
+        buffer[i] = (uint8_t)(i * 7 + track * 13 + sector * 29);
+    }
+}
+
+/* generate the GCR tracks of a D64 image of `num_tracks' tracks, the way
+   fsimage_dxx_read_half_track() does */
+static void gcr_benchmark_tracks(disk_track_t *tracks, unsigned int num_tracks)
+{
+    uint8_t buffer[256];
+    gcr_header_t header;
+    unsigned int track, sector;
+
+    header.id1 = 0x41;
+    header.id2 = 0x42;
+    for (track = 1; track <= num_tracks; track++) {
+        unsigned int size = disk_image_raw_track_size(DISK_IMAGE_TYPE_D64, track);
+        int gap = (int)disk_image_gap_size(DISK_IMAGE_TYPE_D64, track);
+        int headergap = (int)disk_image_header_gap_size(DISK_IMAGE_TYPE_D64, track);
+        int synclen = (int)disk_image_sync_size(DISK_IMAGE_TYPE_D64, track);
+        unsigned int max_sector = disk_image_sector_per_track(DISK_IMAGE_TYPE_D64, track);
+        uint8_t *ptr;
+
+        tracks[track - 1].data = ptr = lib_malloc(size);
+        tracks[track - 1].size = (int)size;
+        memset(ptr, 0x55, size);
+        header.track = (uint8_t)track;
+        for (sector = 0; sector < max_sector; sector++) {
+            header.sector = (uint8_t)sector;
+            gcr_benchmark_sector(buffer, track, sector);
+            gcr_convert_sector_to_GCR(buffer, ptr, &header, headergap, synclen,
+                                      CBMDOS_FDC_ERR_OK);
+            ptr += SECTOR_GCR_SIZE_WITH_HEADER + headergap + gap + (synclen * 2);
+        }
+    }
+}
+
+static int gcr_benchmark(void)
+{
+    static const unsigned int sizes[] = { 35, 40, 42 };
+    disk_track_t tracks[42];
+    uint8_t expected[256], data[256];
+    unsigned long errors = 0;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        unsigned int num_tracks = sizes[i];
+        unsigned long sectors = 0;
+        unsigned int track, sector;
+        char test[32];
+        tick_t start;
+        double seconds;
+        int pass = 0;
+
+        gcr_benchmark_tracks(tracks, num_tracks);
+
+        start = tick_now();
+        do {
+            for (track = 1; track <= num_tracks; track++) {
+                unsigned int max_sector = disk_image_sector_per_track(DISK_IMAGE_TYPE_D64, track);
+
+                for (sector = 0; sector < max_sector; sector++) {
+                    fdc_err_t rf = gcr_read_sector(&tracks[track - 1], data, (uint8_t)sector);
+
+                    /* check the data on the first pass */
+                    if (pass == 0) {
+                        gcr_benchmark_sector(expected, track, sector);
+                        if (rf != CBMDOS_FDC_ERR_OK || memcmp(data, expected, 256) != 0) {
+                            log_error(driveimage_log, "GCR benchmark: track %u sector %u read wrong (%d).",
+                                      track, sector, (int)rf);
+                            errors++;
+                        }
+                    }
+                }
+                sectors += max_sector;
+            }
+            pass++;
+            seconds = (double)tick_now_delta(start) / tick_per_second();
+        } while (seconds < GCR_BENCHMARK_SECONDS);
+
+        sprintf(test, "%u tracks", num_tracks);
+        benchmark_kernel_result("gcr", test, seconds, (double)sectors, "sectors");
+
+        for (track = 0; track < num_tracks; track++) {
+            lib_free(tracks[track].data);
+        }
+    }
+    printf("Benchmark gcr: %lu sectors read wrong\n", errors);
+
+    return errors ? -1 : 0;
+}
+
+#endif
+
 void drive_image_init(void)
 {
     driveimage_log = log_open("DriveImage");
+#ifdef FEATURE_BENCHMARK_HOOKS
+    benchmark_kernel_register("gcr", "decode all sectors of 35, 40 and 42 track GCR images",
+                              NULL, gcr_benchmark);
+#endif
 }
@@ -61,6 +61,8 @@
 
 static drive_read_func_t *read_tab_watch[0x101];
 static drive_store_func_t *store_tab_watch[0x101];
+/* all NULL: opcodes are fetched through the watch functions as well */
+static uint8_t *read_base_tab_watch[0x101];
 
 /* Current watchpoint state.
           0 = no watchpoints
@@ -129,6 +131,7 @@ void drivemem_toggle_watchpoints(int flag, void *context)
     if (flag) {
         drv->cpud->read_func_ptr = read_tab_watch;
         drv->cpud->store_func_ptr = store_tab_watch;
+        drv->cpud->read_base_tab_ptr = read_base_tab_watch;
         if (flag > 1) {
             /* enable watchpoints on dummy accesses */
             drv->cpud->read_func_ptr_dummy = read_tab_watch;
@@ -142,7 +145,11 @@ void drivemem_toggle_watchpoints(int flag, void *context)
         drv->cpud->store_func_ptr = drv->cpud->store_tab[0];
         drv->cpud->read_func_ptr_dummy = drv->cpud->read_tab[0];
         drv->cpud->store_func_ptr_dummy = drv->cpud->store_tab[0];
+        drv->cpud->read_base_tab_ptr = drv->cpud->read_base_tab[0];
     }
+    /* make the next JUMP() pick up the new base table */
+    drv->cpu->d_bank_start = 0;
+    drv->cpu->d_bank_limit = 0;
     watchpoints_active = flag;
 }
 
@@ -244,6 +251,10 @@ void drivemem_init(diskunit_context_t *unit)
 
     unit->cpud->read_base_tab_ptr = unit->cpud->read_base_tab[0];
     unit->cpud->read_limit_tab_ptr = unit->cpud->read_limit_tab[0];
+
+    /* the memory map may have changed under the CPU's opcode fetch window */
+    unit->cpu->d_bank_start = 0;
+    unit->cpu->d_bank_limit = 0;
 }
 
 mem_ioreg_list_t *drivemem_ioreg_list_get(void *context)
@@ -35,7 +35,7 @@ void glue1571_side_set(unsigned int side, struct drive_s *drive)
 {
     rotation_rotate_disk(drive);
 
-    drive_gcr_data_writeback(drive);
+    drive_gcr_data_writeback_defer(drive);
 
     drive_set_half_track(drive->current_half_track, (int)side, drive);
 }
@@ -334,6 +334,8 @@ static void store_prb(via_context_t *via_context, uint8_t byte, uint8_t poldpb,
                drive_cpu_set_overflow(dc);
                drv->byte_ready_edge = 0;
             }
+            /* the drive is idle, write back the tracks left dirty */
+            drive_gcr_data_writeback(drv);
         }
 /* enable this for experimental fix related to extra stepping when the motor
    is turned on. (bug #1083 "Primitive 7 Sins") */
@@ -72,6 +72,9 @@ static void glue_pport_update(diskunit_context_t *drv)
         drv->drives[0]->byte_ready_active = (output & 0x04) ? BRA_MOTOR_ON|BRA_BYTE_READY : 0;
         if (drv->drives[0]->byte_ready_active == (BRA_MOTOR_ON|BRA_BYTE_READY)) {
             rotation_begins(drv->drives[0]);
+        } else {
+            /* the drive is idle, write back the tracks left dirty */
+            drive_gcr_data_writeback(drv->drives[0]);
         }
     }
 
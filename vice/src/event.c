@@ -343,6 +343,7 @@ void event_record_in_list(event_list_state_t *list, unsigned int type,
         case EVENT_KEYBOARD_MATRIX:     /* fall through */
         case EVENT_KEYBOARD_RESTORE:    /* fall through */
         case EVENT_KEYBOARD_DELAY:      /* fall through */
+        case EVENT_JOYSTICK_DELAY:      /* fall through */
         case EVENT_JOYSTICK_VALUE:      /* fall through */
         case EVENT_DATASETTE:           /* fall through */
         case EVENT_ATTACHDISK:          /* fall through */
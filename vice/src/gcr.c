@@ -65,48 +65,54 @@ static const uint8_t From_GCR_conv_data[32] =
 };
 
 
-static void gcr_convert_4bytes_to_GCR(const uint8_t *source, uint8_t *dest)
+/* GCR code (10 bits) of every byte, and the byte of every 10 bit GCR code,
+   built on first use from the nybble tables above */
+static uint16_t gcr_encode_table[256];
+static uint8_t gcr_decode_table[1024];
+static int gcr_tables_done = 0;
+
+static void gcr_init_tables(void)
 {
     int i;
-    register unsigned int tdest = 0;    /* at least 16 bits for overflow shifting */
-
-    for (i = 2; i < 10; i += 2, source++, dest++)
-    {
-        tdest <<= 5;  /* make room for the upper nybble */
-        tdest |= GCR_conv_data[(*source) >> 4];
 
-        tdest <<= 5;  /* make room for the lower nybble */
-        tdest |= GCR_conv_data[(*source) & 0x0f];
-
-        *dest = (uint8_t)(tdest >> i);
+    for (i = 0; i < 256; i++) {
+        gcr_encode_table[i] = (uint16_t)((GCR_conv_data[i >> 4] << 5)
+                                         | GCR_conv_data[i & 0x0f]);
     }
-
-    *dest = (uint8_t)tdest;
+    for (i = 0; i < 1024; i++) {
+        gcr_decode_table[i] = (uint8_t)((From_GCR_conv_data[i >> 5] << 4)
+                                        | From_GCR_conv_data[i & 0x1f]);
+    }
+    gcr_tables_done = 1;
 }
 
-static void gcr_convert_GCR_to_4bytes(const uint8_t *source, uint8_t *dest)
+static void gcr_convert_4bytes_to_GCR(const uint8_t *source, uint8_t *dest)
 {
-    int i;
-    /* at least 24 bits for shifting into bits 16...20 */
-    register uint32_t tdest = *source;
+    uint64_t tdest;
 
-    tdest <<= 13;
+    if (!gcr_tables_done) {
+        gcr_init_tables();
+    }
 
-    for (i = 5; i < 13; i += 2, dest++)
-    {
-        source++;
-        tdest |= ((uint32_t)(*source)) << i;
+    tdest = ((uint64_t)gcr_encode_table[source[0]] << 30)
+            | ((uint64_t)gcr_encode_table[source[1]] << 20)
+            | ((uint64_t)gcr_encode_table[source[2]] << 10)
+            | gcr_encode_table[source[3]];
 
-        /*  "tdest >> 16" could be optimized to a word
-         *  aligned access, hopefully the compiler does
-         *  this for us (in a portable way)
-         */
-        *dest = From_GCR_conv_data[(tdest >> 16) & 0x1f] << 4;
-        tdest <<= 5;
+    dest[0] = (uint8_t)(tdest >> 32);
+    dest[1] = (uint8_t)(tdest >> 24);
+    dest[2] = (uint8_t)(tdest >> 16);
+    dest[3] = (uint8_t)(tdest >> 8);
+    dest[4] = (uint8_t)tdest;
+}
 
-        *dest |= From_GCR_conv_data[(tdest >> 16) & 0x1f];
-        tdest <<= 5;
-    }
+/* decode 40 bits of GCR data (right aligned in `source') into 4 bytes */
+static void gcr_convert_GCR_to_4bytes(uint64_t source, uint8_t *dest)
+{
+    dest[0] = gcr_decode_table[(source >> 30) & 0x3ff];
+    dest[1] = gcr_decode_table[(source >> 20) & 0x3ff];
+    dest[2] = gcr_decode_table[(source >> 10) & 0x3ff];
+    dest[3] = gcr_decode_table[source & 0x3ff];
 }
 
 void gcr_convert_sector_to_GCR(const uint8_t *buffer, uint8_t *data, const gcr_header_t *header,
@@ -167,36 +173,100 @@ void gcr_convert_sector_to_GCR(const uint8_t *buffer, uint8_t *data, const gcr_h
     gcr_convert_4bytes_to_GCR(buf, data);
 }
 
+/* number of leading one bits in `w' */
+static inline int gcr_leading_ones(uint64_t w)
+{
+#ifdef __GNUC__
+    return ~w ? __builtin_clzll(~w) : 64;
+#else
+    int n = 0;
+
+    while (n < 64 && (w & (((uint64_t)1) << (63 - n)))) {
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* number of trailing one bits in `w' */
+static inline int gcr_trailing_ones(uint64_t w)
+{
+#ifdef __GNUC__
+    return ~w ? __builtin_ctzll(~w) : 64;
+#else
+    int n = 0;
+
+    while (n < 64 && (w & (((uint64_t)1) << n))) {
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* Return the position of the first zero bit that follows at least 10 one
+   bits (the end of a SYNC mark), looking at `s' bits starting at `p'. The
+   track is scanned up to 64 bits at a time instead of bit by bit. */
 static int gcr_find_sync(const disk_track_t *raw, int p, int s)
 {
-    unsigned int w;
-    int b;
+    const uint8_t *d;
+    uint64_t w, t, t1;
+    int track_bits, run, n, lead;
 
     if (!raw->data || !raw->size) {
         return -CBMDOS_FDC_ERR_SYNC;
     }
 
-    w = 0;
-    b = raw->data[p >> 3] << (p & 7);
-    while (s--) {
-        if (b & 0x80) {
-            w = (w << 1) | 1;
+    track_bits = raw->size * 8;
+    run = 0;    /* one bits seen right before `p' */
+
+    while (s > 0) {
+        /* fetch the next `n' bits, left aligned in `w' */
+        d = raw->data + (p >> 3);
+        if (p & 7) {
+            n = 8 - (p & 7);
+            w = (uint64_t)d[0] << (56 + (p & 7));
+        } else if (track_bits - p >= 64) {
+            n = 64;
+            w = ((uint64_t)d[0] << 56) | ((uint64_t)d[1] << 48)
+                | ((uint64_t)d[2] << 40) | ((uint64_t)d[3] << 32)
+                | ((uint64_t)d[4] << 24) | ((uint64_t)d[5] << 16)
+                | ((uint64_t)d[6] << 8) | d[7];
         } else {
-            if (~w & 0x3ff) {
-                w <<= 1;
-            } else {
-                return p;
-            }
+            n = 8;
+            w = (uint64_t)d[0] << 56;
+        }
+        if (n > s) {
+            n = s;
         }
-        if (~p & 7) {
-            p++;
-            b <<= 1;
+        /* fill the unused bits with ones, they can never end a SYNC */
+        if (n < 64) {
+            w |= ~((uint64_t)0) >> n;
+        }
+
+        if (~w == 0) {
+            run += n;
         } else {
-            p++;
-            if (p >= raw->size * 8) {
-                p = 0;
+            /* the first zero bit may end a run started in earlier chunks */
+            lead = gcr_leading_ones(w);
+            if (run + lead >= 10) {
+                return p + lead;
             }
-            b = raw->data[p >> 3];
+            /* any later zero bit needs the 10 bits above it set */
+            t1 = w & (w >> 1);
+            t = t1 & (t1 >> 2);
+            t &= t >> 4;
+            t &= t1 >> 8;
+            t = (t >> 1) & ~w;
+            if (t) {
+                return p + gcr_leading_ones(~t);
+            }
+            run = gcr_trailing_ones(w) - (64 - n);
+        }
+
+        s -= n;
+        p += n;
+        if (p >= track_bits) {
+            p = 0;
         }
     }
     return -CBMDOS_FDC_ERR_SYNC;
@@ -204,30 +274,31 @@ static int gcr_find_sync(const disk_track_t *raw, int p, int s)
 
 static void gcr_decode_block(const disk_track_t *raw, int p, uint8_t *buf, int num)
 {
-    int shift, i, j;
-    uint8_t gcr[5], b;
-    uint8_t *offset, *end = raw->data + raw->size;
+    const uint8_t *offset, *end = raw->data + raw->size;
+    uint64_t acc;
+    int i, nbits;
+
+    if (!gcr_tables_done) {
+        gcr_init_tables();
+    }
 
-    shift = p & 7;
     offset = raw->data + (p >> 3);
+    nbits = 8 - (p & 7);
+    acc = offset[0] & (0xff >> (p & 7));
 
-    b = offset[0] << shift;
     for (i = 0; i < num; i++, buf += 4) {
-        /* get 5 bytes of gcr data */
-        for (j = 0; j < 5; j++) {
+        /* get 40 bits of gcr data */
+        while (nbits < 40) {
             offset++;
             if (offset >= end) {
                 offset = raw->data;
             }
-            if (shift) {
-                gcr[j] = b | ((offset[0] << shift) >> 8);
-                b = offset[0] << shift;
-            } else {
-                gcr[j] = b;
-                b = offset[0];
-            }
+            acc = (acc << 8) | offset[0];
+            nbits += 8;
         }
-        gcr_convert_GCR_to_4bytes(gcr, buf);
+        nbits -= 40;
+        gcr_convert_GCR_to_4bytes(acc >> nbits, buf);
+        acc &= (((uint64_t)1) << nbits) - 1;
     }
 }
 
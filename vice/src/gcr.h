@@ -56,6 +56,9 @@ typedef struct disk_track_s {
 typedef struct gcr_s {
     /* Raw GCR image of the disk.  */
     disk_track_t tracks[MAX_GCR_TRACKS];
+    /* Flags: GCR data of the track still has to be generated from the
+       sectors of the disk image, see disk_image_gcr_track_prepare().  */
+    uint8_t pending[MAX_GCR_TRACKS];
 } gcr_t;
 
 typedef struct gcr_header_s {
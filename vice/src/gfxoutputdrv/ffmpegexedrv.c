@@ -52,6 +52,9 @@
 #include "vice.h"
 
 #include <assert.h>
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#endif
 
 #include <stdio.h>
 #include <string.h>
@@ -61,6 +64,7 @@
 
 #include "archdep.h"
 #include "archdep_sleep.h"
+#include "benchmark.h"
 #include "cmdline.h"
 #include "coproc.h"
 #include "ffmpegexedrv.h"
@@ -230,6 +234,13 @@ static int current_audio_port = SOCKETS_RANGE_FIRST + 1;
 /* input video stream */
 #define INPUT_VIDEO_BPP     3
 
+/* with FFMPEGIndexedFrames each frame is sent as one byte per pixel, followed
+   by the palette as 256 native endian 32-bit ARGB values, which is what the
+   rawvideo demuxer of ffmpeg reads for "pal8". The expansion to RGB (or
+   rather, directly to the pixel format of the encoder) then happens in ffmpeg,
+   and only a third of the data goes through the socket. */
+#define INPUT_PALETTE_SIZE  (256 * 4)
+
 static double time_base;
 static double fps;                  /* frames per second */
 static uint64_t framecounter = 0;   /* number of processed video frames */
@@ -289,6 +300,7 @@ static int video_codec;
 static int audio_bitrate;
 static int video_bitrate;
 static int video_halve_framerate;
+static int video_indexed_frames;
 
 static int set_container_format(const char *val, void *param)
 {
@@ -368,6 +380,20 @@ static int set_video_halve_framerate(int value, void *param)
     return 0;
 }
 
+static int set_video_indexed_frames(int value, void *param)
+{
+    int val = value ? 1 : 0;
+
+    if (video_indexed_frames != val && screenshot_is_recording()) {
+        ui_error("Can't change the frame format while recording. Try again later.");
+        return 0;
+    }
+
+    video_indexed_frames = val;
+
+    return 0;
+}
+
 /*---------- Resources ------------------------------------------------*/
 
 static const resource_string_t resources_string[] = {
@@ -391,6 +417,8 @@ static const resource_int_t resources_int[] = {
       &video_codec, set_video_codec, NULL },
     { "FFMPEGVideoHalveFramerate", 0, RES_EVENT_NO, NULL,
       &video_halve_framerate, set_video_halve_framerate, NULL },
+    { "FFMPEGIndexedFrames", 0, RES_EVENT_NO, NULL,
+      &video_indexed_frames, set_video_indexed_frames, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -417,6 +445,12 @@ static const cmdline_option_t cmdline_options[] =
     { "-ffmpegvideobitrate", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "FFMPEGVideoBitrate", NULL,
       "<value>", "Set bitrate for video stream in media file" },
+    { "-ffmpegindexed", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "FFMPEGIndexedFrames", (resource_value_t)1,
+      NULL, "Send palette indexed frames to the ffmpeg executable, converted to RGB by ffmpeg" },
+    { "+ffmpegindexed", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "FFMPEGIndexedFrames", (resource_value_t)0,
+      NULL, "Send RGB frames to the ffmpeg executable" },
     CMDLINE_LIST_END
 };
 
@@ -436,6 +470,7 @@ static void log_resource_values(const char *func)
     DBG(("%s FFMPEGAudioCodec:%d:'%s'", func, audio_codec, av_codec_get_option(audio_codec)));
     DBG(("%s FFMPEGAudioBitrate:%d", func, audio_bitrate));
     DBG(("%s FFMPEGVideoHalveFramerate:%d", func, video_halve_framerate));
+    DBG(("%s FFMPEGIndexedFrames:%d", func, video_indexed_frames));
 }
 
 static void prepare_port_numbers(void)
@@ -449,9 +484,18 @@ static void prepare_port_numbers(void)
     log_message(ffmpeg_log, "prepare_port_numbers %d:%d", current_video_port, current_audio_port);
 }
 
+/* size of one frame as sent to ffmpeg */
+static ssize_t video_frame_size(void)
+{
+    if (video_indexed_frames) {
+        return video_height * video_width + INPUT_PALETTE_SIZE;
+    }
+    return INPUT_VIDEO_BPP * video_height * video_width;
+}
+
 static ssize_t write_video_frame(VIDEOFrame *pic)
 {
-    ssize_t len = INPUT_VIDEO_BPP * video_height * video_width;
+    ssize_t len = video_frame_size();
     ssize_t res;
 
     if ((video_has_codec > 0) && (video_codec != AV_CODEC_ID_NONE)) {
@@ -473,7 +517,7 @@ static int write_initial_video_frames(void)
     int len;
     int frm;
     /* clear frame */
-    len = INPUT_VIDEO_BPP * video_height * video_width;
+    len = video_frame_size();
     DBG(("video len:%d (%d)", len, len * DUMMY_FRAMES_VIDEO));
     memset(video_st_frame->data, 0, len);
     for (frm = 0; frm < DUMMY_FRAMES_VIDEO; frm++) {
@@ -686,7 +730,7 @@ static int start_ffmpeg_executable(void)
     if ((video_has_codec > 0) && (video_codec != AV_CODEC_ID_NONE)) {
         sprintf(tempcommand,
                 "-f rawvideo "
-                "-pixel_format rgb24 "
+                "-pixel_format %s "
                 "-framerate %s "              /* exact fps */
                 "-r %s "              /* exact fps */
                 "-s %dx%d "                         /* size */
@@ -698,6 +742,7 @@ static int start_ffmpeg_executable(void)
 #else
                 "-i tcp://127.0.0.1:%d?listen "
 #endif
+                , video_indexed_frames ? "pal8" : "rgb24"
                 , fpsstring, fpsstring
                 , video_width, video_height
                 , current_video_port
@@ -1089,6 +1134,41 @@ static soundmovie_funcs_t ffmpegexedrv_soundmovie_funcs = {
    video stream encoding
  *****************************************************************************/
 
+static int video_fill_indexed_image(screenshot_t *screenshot, VIDEOFrame *pic)
+{
+    int y;
+    int dx, dy;
+    unsigned int i;
+    int bufferoffset;
+    int x_dim = screenshot->width;
+    int y_dim = screenshot->height;
+    uint8_t *pal = pic->data + video_height * video_width;
+    uint32_t argb;
+
+    /* center the screenshot in the video */
+    pic->linesize = video_width;
+    dx = (video_width - x_dim) / 2;
+    dy = (video_height - y_dim) / 2;
+    bufferoffset = screenshot->x_offset + (dx < 0 ? -dx : 0)
+        + (screenshot->y_offset + (dy < 0 ? -dy : 0)) * screenshot->draw_buffer_line_size;
+
+    for (y = 0; y < video_height; y++) {
+        memcpy(pic->data + y * pic->linesize, screenshot->draw_buffer + bufferoffset, video_width);
+        bufferoffset += screenshot->draw_buffer_line_size;
+    }
+
+    memset(pal, 0, INPUT_PALETTE_SIZE);
+    for (i = 0; i < screenshot->palette->num_entries && i < 256; i++) {
+        argb = 0xff000000u
+               | ((uint32_t)screenshot->palette->entries[i].red << 16)
+               | ((uint32_t)screenshot->palette->entries[i].green << 8)
+               | (uint32_t)screenshot->palette->entries[i].blue;
+        memcpy(pal + i * 4, &argb, 4);
+    }
+
+    return 0;
+}
+
 static int video_fill_rgb_image(screenshot_t *screenshot, VIDEOFrame *pic)
 {
     int x, y;
@@ -1120,7 +1200,7 @@ static int video_fill_rgb_image(screenshot_t *screenshot, VIDEOFrame *pic)
 }
 
 /* called by ffmpegexedrv_open_video() */
-static VIDEOFrame* video_alloc_picture(int bpp, int width, int height)
+static VIDEOFrame* video_alloc_picture(int bpp, int width, int height, int extra)
 {
     VIDEOFrame *picture;
 
@@ -1128,7 +1208,7 @@ static VIDEOFrame* video_alloc_picture(int bpp, int width, int height)
     if (!picture) {
         return NULL;
     }
-    picture->data = lib_malloc(bpp * width * height);
+    picture->data = lib_malloc(bpp * width * height + extra);
     if (!picture->data) {
         lib_free(picture);
         log_debug(ffmpeg_log, "ffmpegexedrv: Could not allocate frame data");
@@ -1153,7 +1233,12 @@ static int ffmpegexedrv_open_video(void)
     video_is_open = 1;
 
     /* allocate the encoded raw picture */
-    video_st_frame = video_alloc_picture(INPUT_VIDEO_BPP, video_width, video_height);
+    if (video_indexed_frames) {
+        /* the palette follows the pixels */
+        video_st_frame = video_alloc_picture(1, video_width, video_height, INPUT_PALETTE_SIZE);
+    } else {
+        video_st_frame = video_alloc_picture(INPUT_VIDEO_BPP, video_width, video_height, 0);
+    }
     if (!video_st_frame) {
         log_debug(ffmpeg_log, "ffmpegexedrv: could not allocate picture");
         return -1;
@@ -1349,7 +1434,11 @@ static int ffmpegexedrv_record(screenshot_t *screenshot)
     }
 
     /*DBGFRAMES(("ffmpegexedrv_record (%u)", framecounter));*/
-    video_fill_rgb_image(screenshot, video_st_frame);
+    if (video_indexed_frames) {
+        video_fill_indexed_image(screenshot, video_st_frame);
+    } else {
+        video_fill_rgb_image(screenshot, video_st_frame);
+    }
 
     if (write_video_frame(video_st_frame) < 0) {
         return -1;
@@ -1490,6 +1579,209 @@ static void get_formats_and_codecs(void)
 }
 
 /* public, init this output driver */
+/*****************************************************************************
+   "ffmpegexe" micro benchmark: fill and send frames over a loopback socket
+ *****************************************************************************/
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+
+/* Each frame format and size is timed for this long.  */
+#define BENCHMARK_SECONDS   1.0
+
+#ifdef USE_VICE_THREAD
+/* receiving end of the benchmark, in place of ffmpeg */
+static void *benchmark_drain(void *data)
+{
+    vice_network_socket_t *s = data;
+    static uint8_t buffer[65536];
+
+    while (vice_network_receive(s, buffer, sizeof(buffer), 0) > 0) {
+    }
+    return NULL;
+}
+
+static ssize_t benchmark_send(vice_network_socket_t *s, const uint8_t *data, size_t len)
+{
+    return vice_network_send(s, data, len, 0 /* flags */);
+}
+#else
+/* Without thread support the frames are sent in pieces small enough for the
+   socket buffers, and each piece is read back before the next one is sent.
+   The results then include the time taken by the receiving end.  */
+#define BENCHMARK_CHUNK     16384
+
+static vice_network_socket_t *benchmark_receive_socket = NULL;
+
+static ssize_t benchmark_send(vice_network_socket_t *s, const uint8_t *data, size_t len)
+{
+    static uint8_t buffer[BENCHMARK_CHUNK];
+    ssize_t res, received, n;
+
+    res = vice_network_send(s, data, len < BENCHMARK_CHUNK ? len : BENCHMARK_CHUNK, 0 /* flags */);
+    for (received = 0; received < res; received += n) {
+        n = vice_network_receive(benchmark_receive_socket, buffer, res - received, 0);
+        if (n <= 0) {
+            return -1;
+        }
+    }
+    return res;
+}
+#endif
+
+static int benchmark_send_frames(screenshot_t *screenshot, vice_network_socket_t *s)
+{
+    VIDEOFrame *pic;
+    char test[32];
+    ssize_t len, res, sent;
+    unsigned long frames = 0;
+    tick_t start;
+    double seconds;
+
+    video_width = screenshot->width & ~0xf;
+    video_height = screenshot->height & ~0xf;
+    if (video_indexed_frames) {
+        pic = video_alloc_picture(1, video_width, video_height, INPUT_PALETTE_SIZE);
+    } else {
+        pic = video_alloc_picture(INPUT_VIDEO_BPP, video_width, video_height, 0);
+    }
+    len = video_frame_size();
+
+    start = tick_now();
+    do {
+        if (video_indexed_frames) {
+            video_fill_indexed_image(screenshot, pic);
+        } else {
+            video_fill_rgb_image(screenshot, pic);
+        }
+        for (sent = 0; sent < len; sent += res) {
+            res = benchmark_send(s, pic->data + sent, len - sent);
+            if (res <= 0) {
+                video_free_picture(pic);
+                return -1;
+            }
+        }
+        frames++;
+        seconds = (double)tick_now_delta(start) / tick_per_second();
+    } while (seconds < BENCHMARK_SECONDS);
+
+    sprintf(test, "%s %dx%d", video_indexed_frames ? "pal8" : "rgb24",
+            video_width, video_height);
+    benchmark_kernel_result("ffmpegexe", test, seconds, (double)frames, "frames");
+
+    video_free_picture(pic);
+    return 0;
+}
+
+/* Time filling and sending the frames as RGB and as palette indexed, at the
+   native size of the C64 screen and at 1080p, without the ffmpeg executable
+   itself.  */
+static int ffmpegexe_benchmark(void)
+{
+    static const unsigned int sizes[][2] = {
+        { 384, 272 },
+        { 1920, 1080 }
+    };
+    vice_network_socket_address_t *ad = NULL;
+    vice_network_socket_t *listen_socket = NULL;
+    vice_network_socket_t *send_socket = NULL;
+    vice_network_socket_t *receive_socket = NULL;
+#ifdef USE_VICE_THREAD
+    pthread_t drain_thread;
+#endif
+    screenshot_t screenshot;
+    int saved_width = video_width;
+    int saved_height = video_height;
+    int saved_indexed = video_indexed_frames;
+    int port;
+    unsigned int i;
+    int result = 0;
+
+    if (screenshot_is_recording()) {
+        log_error(ffmpeg_log, "Can't run the benchmark while recording.");
+        return -1;
+    }
+
+    for (port = SOCKETS_RANGE_FIRST; port <= SOCKETS_RANGE_LAST; port++) {
+        ad = vice_network_address_generate("127.0.0.1", port);
+        if (ad == NULL) {
+            break;
+        }
+        listen_socket = vice_network_server(ad);
+        if (listen_socket != NULL) {
+            break;
+        }
+        vice_network_address_close(ad);
+        ad = NULL;
+    }
+    if (listen_socket != NULL) {
+        receive_socket = vice_network_client(ad);
+    }
+    if (receive_socket != NULL) {
+        send_socket = vice_network_accept(listen_socket);
+    }
+    if (send_socket == NULL) {
+        log_error(ffmpeg_log, "Can't connect the benchmark socket.");
+        if (receive_socket != NULL) {
+            vice_network_socket_close(receive_socket);
+        }
+        if (listen_socket != NULL) {
+            vice_network_socket_close(listen_socket);
+        }
+        if (ad != NULL) {
+            vice_network_address_close(ad);
+        }
+        return -1;
+    }
+#ifdef USE_VICE_THREAD
+    pthread_create(&drain_thread, NULL, benchmark_drain, receive_socket);
+#else
+    benchmark_receive_socket = receive_socket;
+#endif
+
+    /* a frame of the 16 colours, in vertical stripes */
+    memset(&screenshot, 0, sizeof(screenshot));
+    screenshot.palette = palette_create(16, NULL);
+    for (i = 0; i < 16; i++) {
+        screenshot.palette->entries[i].red = (uint8_t)(i * 16);
+        screenshot.palette->entries[i].green = (uint8_t)(255 - i * 16);
+        screenshot.palette->entries[i].blue = (uint8_t)(i * 8);
+    }
+    screenshot.draw_buffer_line_size = sizes[1][0];
+    screenshot.draw_buffer = lib_malloc(sizes[1][0] * sizes[1][1]);
+    for (i = 0; i < sizes[1][0] * sizes[1][1]; i++) {
+        screenshot.draw_buffer[i] = (uint8_t)((i / 8) & 15);
+    }
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]) && result == 0; i++) {
+        screenshot.width = sizes[i][0];
+        screenshot.height = sizes[i][1];
+        video_indexed_frames = 0;
+        result = benchmark_send_frames(&screenshot, send_socket);
+        if (result == 0) {
+            video_indexed_frames = 1;
+            result = benchmark_send_frames(&screenshot, send_socket);
+        }
+    }
+
+    vice_network_socket_close(send_socket);
+#ifdef USE_VICE_THREAD
+    pthread_join(drain_thread, NULL);
+#endif
+    vice_network_socket_close(receive_socket);
+    vice_network_socket_close(listen_socket);
+    vice_network_address_close(ad);
+    lib_free(screenshot.draw_buffer);
+    palette_free(screenshot.palette);
+
+    video_width = saved_width;
+    video_height = saved_height;
+    video_indexed_frames = saved_indexed;
+
+    return result;
+}
+
+#endif
+
 void gfxoutput_init_ffmpegexe(int help)
 {
     if (help) {
@@ -1500,4 +1792,10 @@ void gfxoutput_init_ffmpegexe(int help)
     get_formats_and_codecs();
 
     gfxoutput_register(&ffmpegexe_drv);
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+    benchmark_kernel_register("ffmpegexe",
+                              "fill and send ffmpeg executable frames, RGB and palette indexed",
+                              NULL, ffmpegexe_benchmark);
+#endif
 }
@@ -30,6 +30,9 @@
 
 #include "vice.h"
 
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#endif
 #include <stdio.h>
 #include <string.h>
 
@@ -78,6 +81,13 @@
 /* each KEYFRAME_INTERVAL frame will be key one */
 #define KEYFRAME_INTERVAL  (300)
 
+/* number of frames and audio chunks that can wait for the encoder thread */
+#ifdef USE_VICE_THREAD
+#define QUEUE_SIZE  (16)
+#else
+#define QUEUE_SIZE  (1)
+#endif
+
 /******************************************************************************/
 
 static int frameno = 0;
@@ -87,10 +97,6 @@ static zmvb_init_flags_t iflg = ZMBV_INIT_FLAG_NONE;
 static int complevel = -1;  /* compression level, -1 means default */
 static int no_zlib = 0;
 
-static uint8_t cur_pal[PALETTE_SIZE];
-
-static int16_t cur_audio[MAX_AUDIO_BUFFER_SIZE];
-
 static zmbv_avi_t zavi;
 static zmbv_codec_t zcodec;
 static zmbv_format_t fmt;
@@ -101,8 +107,6 @@ static void *video_work_buffer = NULL;
 static int video_codec;
 static int audio_codec;
 
-static uint8_t *cur_screen = NULL;
-
 /* general */
 static int file_init_done = 1;
 
@@ -139,6 +143,273 @@ static int zmbvdrv_init_file(void);
 
 /******************************************************************************/
 
+/*--------------------------*/
+/* encoder thread and queue */
+/*--------------------------*/
+
+/*
+ * The frames and the audio are encoded and written to the file on a separate
+ * thread. The emulation thread only copies them into a bounded queue, audio
+ * included so that the chunks stay in order. When the queue is full the
+ * emulation waits for the encoder; how often and how long is logged when the
+ * recording stops.
+ *
+ * There is a single encoder thread, as ZMBV encodes each frame that is not a
+ * keyframe against the previous one.
+ *
+ * Builds without thread support (USE_VICE_THREAD) use a single queue entry
+ * that is encoded and written as soon as it is put.
+ */
+
+#define QUEUE_VIDEO 0
+#define QUEUE_AUDIO 1
+
+typedef struct queue_entry_s {
+    int type;               /* QUEUE_VIDEO or QUEUE_AUDIO */
+    int flags;              /* ZMBV_PREP_FLAG_* of a video frame */
+    int frameno;
+    uint8_t pal[PALETTE_SIZE];
+    uint8_t *screen;        /* indexed pixels, video_width * video_height */
+    int16_t *audio;         /* stereo samples */
+    int audio_size;         /* in bytes */
+} queue_entry_t;
+
+static queue_entry_t *queue = NULL;
+static unsigned int queue_head = 0;     /* number of entries queued */
+static unsigned int queue_tail = 0;     /* number of entries encoded */
+static int encoder_error = 0;
+
+#ifdef USE_VICE_THREAD
+static int queue_quit = 0;
+static int encoder_running = 0;
+
+static pthread_t encoder_thread;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t queue_done_cond = PTHREAD_COND_INITIALIZER;
+
+static void encoder_stop(void);
+
+/* back-pressure statistics */
+static unsigned int stat_full;          /* times the queue was full */
+static unsigned int stat_max_used;      /* most entries waiting at once */
+static tick_t stat_wait_ticks;          /* time waited for the encoder */
+#endif
+
+/* called by encode_entry() */
+static int encode_video(queue_entry_t *entry)
+{
+    int32_t written;
+    int y;
+
+    if (zmbv_encode_prepare_frame(zcodec, entry->flags, fmt, entry->pal, video_work_buffer, work_buffer_size) < 0) {
+        LOG(("FATAL: can't prepare frame for screen #%d", entry->frameno));
+        return -1;
+    }
+    for (y = 0; y < video_height; ++y) {
+        if (zmbv_encode_line(zcodec, entry->screen + (y * video_width)) < 0) {
+            LOG(("FATAL: can't encode line #%d for screen #%d", y, entry->frameno));
+            return -1;
+        }
+    }
+    written = zmvb_encode_finish_frame(zcodec);
+    if (written < 0) {
+        LOG(("FATAL: can't finish frame for screen #%d", entry->frameno));
+        return -1;
+    }
+    /* write avi chunk */
+    if (zmbv_avi_write_chunk_video(zavi, video_work_buffer, written) < 0) {
+        LOG(("FATAL: can't write compressed frame for screen #%d", entry->frameno));
+        return -1;
+    }
+    return 0;
+}
+
+/* called by encode_entry() */
+static int encode_audio(queue_entry_t *entry)
+{
+    /* write avi chunks */
+    if (zmbv_avi_write_chunk_audio(zavi, entry->audio, entry->audio_size) < 0) {
+        LOG(("FATAL: can't write audio frame for screen #%d", entry->frameno));
+        return -1;
+    }
+    return 0;
+}
+
+/* called on the encoder thread, or by queue_put_entry() without it */
+static int encode_entry(queue_entry_t *entry)
+{
+    if (entry->type == QUEUE_VIDEO) {
+        return encode_video(entry);
+    }
+    return encode_audio(entry);
+}
+
+#ifdef USE_VICE_THREAD
+static void *encoder_main(void *unused)
+{
+    queue_entry_t *entry;
+    int ret;
+
+    pthread_mutex_lock(&queue_lock);
+    while (1) {
+        while (queue_tail == queue_head && !queue_quit) {
+            pthread_cond_wait(&queue_work_cond, &queue_lock);
+        }
+        if (queue_tail == queue_head) {
+            /* asked to quit, and everything has been written */
+            break;
+        }
+        entry = &queue[queue_tail % QUEUE_SIZE];
+        pthread_mutex_unlock(&queue_lock);
+
+        ret = encode_entry(entry);
+
+        pthread_mutex_lock(&queue_lock);
+        if (ret < 0) {
+            encoder_error = 1;
+        }
+        queue_tail++;
+        pthread_cond_signal(&queue_done_cond);
+    }
+    pthread_mutex_unlock(&queue_lock);
+
+    return NULL;
+}
+#endif
+
+/* called by zmbvdrv_save() */
+static int encoder_start(void)
+{
+    int i;
+
+    queue = lib_calloc(QUEUE_SIZE, sizeof(queue_entry_t));
+    for (i = 0; i < QUEUE_SIZE; i++) {
+        queue[i].screen = lib_malloc(video_width * video_height);
+        queue[i].audio = lib_malloc(MAX_AUDIO_BUFFER_SIZE * sizeof(int16_t));
+    }
+    queue_head = 0;
+    queue_tail = 0;
+    encoder_error = 0;
+
+#ifdef USE_VICE_THREAD
+    queue_quit = 0;
+    stat_full = 0;
+    stat_max_used = 0;
+    stat_wait_ticks = 0;
+
+    if (pthread_create(&encoder_thread, NULL, encoder_main, NULL) != 0) {
+        log_error(LOG_DEFAULT, "zmbvdrv: Cannot start the encoder thread");
+        encoder_stop();
+        return -1;
+    }
+    encoder_running = 1;
+#endif
+
+    return 0;
+}
+
+/* called by zmbvdrv_close(), waits until everything queued has been written */
+static void encoder_stop(void)
+{
+    int i;
+
+#ifdef USE_VICE_THREAD
+    if (encoder_running) {
+        pthread_mutex_lock(&queue_lock);
+        queue_quit = 1;
+        pthread_cond_signal(&queue_work_cond);
+        pthread_mutex_unlock(&queue_lock);
+        pthread_join(encoder_thread, NULL);
+        encoder_running = 0;
+
+        log_message(LOG_DEFAULT,
+                    "zmbvdrv: %d frames, the encoder queue was full %u times"
+                    " (%.1f ms waited), at most %u of %d entries were used.",
+                    frameno, stat_full,
+                    (double)stat_wait_ticks * 1000.0 / tick_per_second(),
+                    stat_max_used, QUEUE_SIZE);
+    }
+#endif
+
+    if (queue != NULL) {
+        for (i = 0; i < QUEUE_SIZE; i++) {
+            lib_free(queue[i].screen);
+            lib_free(queue[i].audio);
+        }
+        lib_free(queue);
+        queue = NULL;
+    }
+}
+
+#ifdef USE_VICE_THREAD
+/* get the next free entry, waiting for the encoder if the queue is full */
+static queue_entry_t *queue_get_entry(void)
+{
+    pthread_mutex_lock(&queue_lock);
+    if (queue_head - queue_tail >= QUEUE_SIZE) {
+        tick_t start = tick_now();
+
+        stat_full++;
+        while (queue_head - queue_tail >= QUEUE_SIZE) {
+            pthread_cond_wait(&queue_done_cond, &queue_lock);
+        }
+        stat_wait_ticks += tick_now_delta(start);
+    }
+    pthread_mutex_unlock(&queue_lock);
+
+    return &queue[queue_head % QUEUE_SIZE];
+}
+
+/* hand the entry from queue_get_entry() to the encoder */
+static void queue_put_entry(void)
+{
+    pthread_mutex_lock(&queue_lock);
+    queue_head++;
+    if (queue_head - queue_tail > stat_max_used) {
+        stat_max_used = queue_head - queue_tail;
+    }
+    pthread_cond_signal(&queue_work_cond);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+/* check for errors of the encoder */
+static int encoder_failed(void)
+{
+    int ret;
+
+    pthread_mutex_lock(&queue_lock);
+    ret = encoder_error;
+    pthread_mutex_unlock(&queue_lock);
+
+    return ret;
+}
+#else
+/* get the only entry */
+static queue_entry_t *queue_get_entry(void)
+{
+    return &queue[0];
+}
+
+/* encode and write the entry from queue_get_entry() right away */
+static void queue_put_entry(void)
+{
+    if (encode_entry(&queue[0]) < 0) {
+        encoder_error = 1;
+    }
+    queue_head++;
+    queue_tail++;
+}
+
+/* check for errors of the encoder */
+static int encoder_failed(void)
+{
+    return encoder_error;
+}
+#endif
+
+/******************************************************************************/
+
 #define AV_CODEC_ID_NONE            0
 #define AV_CODEC_ID_ZMBV            1
 #define AV_CODEC_ID_PCM_S16LE       2
@@ -326,6 +597,8 @@ static int zmbv_soundmovie_init(int speed, int channels, soundmovie_buffer_t **
 static int zmbv_soundmovie_encode(soundmovie_buffer_t *audio_in)
 {
     int ret = 0;
+    queue_entry_t *entry;
+    int16_t *cur_audio;
 
     clk_last_audio_frame = clk_this_audio_frame;
     clk_this_audio_frame = maincpu_clk;
@@ -333,6 +606,15 @@ static int zmbv_soundmovie_encode(soundmovie_buffer_t *audio_in)
     LOGFRAMES(("zmbv_soundmovie_encode(size:%d used:%d channels:%d) clk:%ld frame:%d",
                audio_in->size, audio_in->used, audio_channels, clk_this_audio_frame, frameno));
 
+    if (queue == NULL || encoder_failed()) {
+        audio_in->used = 0;
+        return -1;
+    }
+    entry = queue_get_entry();
+    entry->type = QUEUE_AUDIO;
+    entry->frameno = frameno;
+    cur_audio = entry->audio;
+
     /* FIXME: we might have an endianess problem here, we might have to swap lo/hi on BE machines */
     if (audio_channels == 1) {
         int i, o;
@@ -342,11 +624,7 @@ static int zmbv_soundmovie_encode(soundmovie_buffer_t *audio_in)
             cur_audio[o] = audio_in->buffer[i];
             cur_audio[o+1] = audio_in->buffer[i];
         }
-        /* write avi chunks */
-        if (zmbv_avi_write_chunk_audio(zavi, &cur_audio[0], audio_in->used * 4) < 0) {
-            LOG(("FATAL: can't write audio frame for screen #%d", frameno));
-            ret = -1;
-        }
+        entry->audio_size = audio_in->used * 4;
 #else
         /* FIXME: we should write the mono stream into the avi instead */
 #endif
@@ -356,15 +634,15 @@ static int zmbv_soundmovie_encode(soundmovie_buffer_t *audio_in)
             cur_audio[o] = audio_in->buffer[i];
             cur_audio[o+1] = audio_in->buffer[i+1];
         }
-        /* write avi chunks */
-        if (zmbv_avi_write_chunk_audio(zavi, &audio_in->buffer[0], audio_in->used * 2) < 0) {
-            LOG(("FATAL: can't write audio frame for screen #%d", frameno));
-            ret = -1;
-        }
+        entry->audio_size = audio_in->used * 2;
     } else {
         ret = -1;
     }
 
+    if (ret == 0) {
+        queue_put_entry();
+    }
+
     audio_in->used = 0;
     return ret;
 }
@@ -387,7 +665,7 @@ static soundmovie_funcs_t zmbvdrv_soundmovie_funcs = {
 /*-----------------------*/
 /* video stream encoding */
 /*-----------------------*/
-static int zmbvdrv_fill_rgb_image(screenshot_t *screenshot)
+static int zmbvdrv_fill_rgb_image(screenshot_t *screenshot, queue_entry_t *entry)
 {
     int x, y;
     int dx, dy;
@@ -406,16 +684,14 @@ static int zmbvdrv_fill_rgb_image(screenshot_t *screenshot)
         + (screenshot->y_offset + (dy < 0 ? -dy : 0)) * screenshot->draw_buffer_line_size;
 
     for (x = 0; x < PALETTE_NUM_COLORS; x++) {
-        cur_pal[(x * (PALETTE_COLORS_BPP / 8)) + 0] = screenshot->palette->entries[x].red;
-        cur_pal[(x * (PALETTE_COLORS_BPP / 8)) + 1] = screenshot->palette->entries[x].green;
-        cur_pal[(x * (PALETTE_COLORS_BPP / 8)) + 2] = screenshot->palette->entries[x].blue;
+        entry->pal[(x * (PALETTE_COLORS_BPP / 8)) + 0] = screenshot->palette->entries[x].red;
+        entry->pal[(x * (PALETTE_COLORS_BPP / 8)) + 1] = screenshot->palette->entries[x].green;
+        entry->pal[(x * (PALETTE_COLORS_BPP / 8)) + 2] = screenshot->palette->entries[x].blue;
     }
 
     LOGFRAMES(("zmbvdrv_fill_rgb_image video_width/height: %dx%d", video_width, video_height));
     for (y = 0; y < video_height; y++) {
-        for (x = 0; x < video_width; x++) {
-            cur_screen[(y * video_width) + x] = screenshot->draw_buffer[bufferoffset + x];
-        }
+        memcpy(entry->screen + (y * video_width), screenshot->draw_buffer + bufferoffset, video_width);
         bufferoffset += screenshot->draw_buffer_line_size;
     }
     LOGFRAMES(("zmbvdrv_fill_rgb_image done"));
@@ -423,24 +699,13 @@ static int zmbvdrv_fill_rgb_image(screenshot_t *screenshot)
     return 0;
 }
 
-static uint8_t *zmbvdrv_alloc_picture(int width, int height)
-{
-    /* the pixel format is always 8bpp, with a 256 entries, 24bit, palette */
-    LOG(("zmbvdrv_alloc_picture width:%d height:%d", width, height));
-    return lib_malloc(width * height);
-}
-
 /* called by zmbvdrv_init_file() */
 static int zmbvdrv_open_video(int width, int height)
 {
     LOG(("zmbvdrv_open_video width:%d height:%d", width, height));
     /* MOVE? open the codec */
     video_is_open = 1;
-    /* FIXME: allocate the encoded raw picture */
-    cur_screen = zmbvdrv_alloc_picture(width, height);
-    if (cur_screen == NULL) {
-        return -1;
-    }
+    /* the pictures are allocated with the encoder queue, see encoder_start() */
     return 0;
 }
 
@@ -449,10 +714,6 @@ static void zmbvdrv_close_video(void)
 {
     LOG(("zmbvdrv_close_video"));
     video_is_open = 0;
-    if (cur_screen != NULL) {
-        lib_free (cur_screen);
-        cur_screen = NULL;
-    }
 }
 /* called by zmbvdrv_save */
 static void zmbvdrv_init_video(screenshot_t *screenshot)
@@ -555,6 +816,10 @@ static int zmbvdrv_save(screenshot_t *screenshot, const char *filename)
 
     frameno = 0;
 
+    if (encoder_start() < 0) {
+        return -1;
+    }
+
     soundmovie_start(&zmbvdrv_soundmovie_funcs);
 
     return 0;
@@ -567,6 +832,9 @@ static int zmbvdrv_close(screenshot_t *screenshot)
 
     soundmovie_stop();
 
+    /* write out everything that is still queued */
+    encoder_stop();
+
     zmbvdrv_close_video();
     zmbvdrv_close_audio();
 
@@ -590,9 +858,7 @@ static int zmbvdrv_close(screenshot_t *screenshot)
 /* triggered by screenshot_record, periodically called to output video data stream */
 static int zmbvdrv_record(screenshot_t *screenshot)
 {
-    int ret = -1;
-    int32_t written;
-    int flags;
+    queue_entry_t *entry;
     CLOCK clk_diff;
 
     if (audio_init_done && video_init_done && !file_init_done) {
@@ -617,41 +883,24 @@ static int zmbvdrv_record(screenshot_t *screenshot)
         }
     }
 
-    zmbvdrv_fill_rgb_image(screenshot);
+    if (queue == NULL || encoder_failed()) {
+        log_debug(LOG_DEFAULT, "Error while writing video frame");
+        return -1;
+    }
+
+    /* hand the frame to the encoder thread, waits if it is behind */
+    entry = queue_get_entry();
+    entry->type = QUEUE_VIDEO;
+    zmbvdrv_fill_rgb_image(screenshot, entry);
 
-    flags = ((frameno % KEYFRAME_INTERVAL == 0) ? ZMBV_PREP_FLAG_KEYFRAME : ZMBV_PREP_FLAG_NONE);
+    entry->flags = ((frameno % KEYFRAME_INTERVAL == 0) ? ZMBV_PREP_FLAG_KEYFRAME : ZMBV_PREP_FLAG_NONE);
 
     frameno++;
+    entry->frameno = frameno;
 
     LOGFRAMES(("zmbvdrv_record: frame %d (clk:%ld)", frameno, clk_this_video_frame));
 
-    /* encode video frame */
-    if (zmbv_encode_prepare_frame(zcodec, flags, fmt, cur_pal, video_work_buffer, work_buffer_size) < 0) {
-        LOG(("FATAL: can't prepare frame for screen #%d", frameno));
-        goto quit;
-    }
-    for (int y = 0; y < video_height; ++y) {
-        if (zmbv_encode_line(zcodec, cur_screen+(y*video_width)) < 0) {
-            LOG(("FATAL: can't encode line #%d for screen #%d", y, frameno));
-            goto quit;
-        }
-    }
-    written = zmvb_encode_finish_frame(zcodec);
-    if (written < 0) {
-        LOG(("FATAL: can't finish frame for screen #%d", frameno));
-        goto quit;
-    }
-    /* write avi chunk */
-    if (zmbv_avi_write_chunk_video(zavi, video_work_buffer, written) < 0) {
-        LOG(("FATAL: can't write compressed frame for screen #%d", frameno));
-        goto quit;
-    }
-    ret = 0;
-quit:
-    if (ret < 0) {
-        log_debug(LOG_DEFAULT, "Error while writing video frame");
-        return -1;
-    }
+    queue_put_entry();
 
     return 0;
 }
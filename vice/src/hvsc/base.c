@@ -31,6 +31,8 @@
 #include <limits.h>
 #include <errno.h>
 #include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "hvsc.h"
 #include "hvsc_defs.h"
@@ -124,6 +126,15 @@ char *hvsc_stil_path;
  */
 char *hvsc_bugs_path;
 
+/** \brief  Last digest calculated by hvsc_md5_digest()
+ */
+static struct {
+    char   *path;                               /**< PSID file */
+    off_t   size;                               /**< size of the file */
+    time_t  mtime;                              /**< modification time */
+    char    digest[HVSC_DIGEST_SIZE * 2 + 1];   /**< digest as string */
+} md5_cache;
+
 
 /** \brief  Get error message for errno \a n
  *
@@ -570,6 +581,11 @@ void hvsc_free_paths(void)
         hvsc_free(hvsc_bugs_path);
         hvsc_bugs_path = NULL;
     }
+    /* also forget the cached MD5 digest */
+    if (md5_cache.path != NULL) {
+        hvsc_free(md5_cache.path);
+        md5_cache.path = NULL;
+    }
 }
 
 
@@ -848,8 +864,18 @@ bool hvsc_md5_digest(const char *psid, char *digest)
     FILE              *fp;
     uint8_t            hash[HVSC_DIGEST_SIZE];
     size_t             i;
+    struct stat        st;
+    bool               have_stat;
     static const char  digits[] = "0123456789abcdef";
 
+    /* reuse the digest of the previous call if the file didn't change */
+    have_stat = stat(psid, &st) == 0;
+    if (have_stat && md5_cache.path != NULL && strcmp(md5_cache.path, psid) == 0
+            && md5_cache.size == st.st_size && md5_cache.mtime == st.st_mtime) {
+        memcpy(digest, md5_cache.digest, sizeof md5_cache.digest);
+        return true;
+    }
+
     fp = fopen(psid, "rb");
     if (fp == NULL) {
         hvsc_errno = HVSC_ERR_IO;
@@ -864,5 +890,13 @@ bool hvsc_md5_digest(const char *psid, char *digest)
     }
     digest[i * 2] = '\0';
 
+    if (have_stat) {
+        hvsc_free(md5_cache.path);
+        md5_cache.path = hvsc_strdup(psid);
+        md5_cache.size = st.st_size;
+        md5_cache.mtime = st.st_mtime;
+        memcpy(md5_cache.digest, digest, sizeof md5_cache.digest);
+    }
+
     return true;
 }
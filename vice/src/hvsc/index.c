@@ -0,0 +1,767 @@
+/** \file   src/hvsc/index.c
+ * \brief   Binary indexes of the SLDB and STIL
+ *
+ * Looking up a tune in Songlengths.md5 or STIL.txt means scanning a text file
+ * of several megabytes. Instead both files are indexed once: the SLDB index
+ * maps MD5 digests to their SLDB line and HVSC path, the STIL index maps HVSC
+ * paths to the offset of their STIL entry.
+ *
+ * The indexes are stored in VICE's cache directory and memory-mapped when
+ * possible. They are rebuilt when the size or modification time of the text
+ * file changes. When no index can be used the callers scan the text files.
+ */
+
+/*
+ *  HVSClib - a library to work with High Voltage SID Collection files
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.*
+ */
+
+#undef HVSC_DEBUG
+
+#ifndef HVSC_STANDALONE
+# include "vice.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef HVSC_STANDALONE
+# include <sys/types.h>
+# include <sys/stat.h>
+# if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#  include <sys/mman.h>
+# endif
+# include "archdep.h"
+# include "lib.h"
+# include "log.h"
+# include "util.h"
+#endif
+#include "hvsc.h"
+#include "hvsc_defs.h"
+#include "base.h"
+
+#include "index.h"
+
+
+#ifndef HVSC_STANDALONE
+
+/** \brief  Magic bytes of an index file, including the format version
+ */
+#define INDEX_MAGIC         "VHVSCIX1"
+
+/** \brief  Value used to reject indexes written on a host of other endianess
+ */
+#define INDEX_BYTE_ORDER    0x01020304u
+
+/** \brief  String offset used for 'no string'
+ */
+#define INDEX_NONE          UINT32_MAX
+
+/** \brief  Header of an index file
+ *
+ * The header is followed by the sorted records and the string pool. All
+ * offsets are relative to the start of the file, except for string offsets,
+ * which are relative to the string pool.
+ */
+typedef struct index_header_s {
+    char     magic[8];      /**< INDEX_MAGIC */
+    uint32_t byte_order;    /**< INDEX_BYTE_ORDER */
+    uint32_t count;         /**< number of records */
+    uint64_t source_size;   /**< size of the text file */
+    int64_t  source_mtime;  /**< modification time of the text file */
+    uint32_t records;       /**< offset of the records */
+    uint32_t strings;       /**< offset of the string pool */
+    uint32_t strings_size;  /**< size of the string pool */
+    uint32_t source_path;   /**< path of the text file (string offset) */
+} index_header_t;
+
+/** \brief  SLDB index record, sorted on digest
+ */
+typedef struct sldb_record_s {
+    uint8_t  digest[HVSC_DIGEST_SIZE];  /**< binary MD5 digest */
+    uint32_t entry;                     /**< SLDB line (string offset) */
+    uint32_t path;                      /**< HVSC path (string offset) */
+} sldb_record_t;
+
+/** \brief  STIL index record, sorted on hash
+ */
+typedef struct stil_record_s {
+    uint32_t hash;      /**< hash of the HVSC path */
+    uint32_t path;      /**< HVSC path (string offset) */
+    uint32_t offset;    /**< file offset of the line following the path */
+    uint32_t lineno;    /**< line number of the path */
+} stil_record_t;
+
+/** \brief  Index being built
+ */
+typedef struct index_builder_s {
+    uint8_t *records;       /**< records */
+    size_t   record_size;   /**< size of a record */
+    size_t   count;         /**< number of records used */
+    size_t   max;           /**< number of records allocated */
+    char    *strings;       /**< string pool */
+    size_t   strings_size;  /**< size of the string pool */
+    size_t   strings_max;   /**< allocated size of the string pool */
+} index_builder_t;
+
+/** \brief  Loaded index
+ */
+typedef struct index_s {
+    const char *name;           /**< file name in the cache directory */
+    size_t      record_size;    /**< size of a record */
+    bool      (*build)(index_builder_t *, hvsc_text_file_t *);
+    int       (*compare)(const void *, const void *);
+    bool      (*check)(const void *, uint32_t);
+    uint8_t    *data;           /**< index file contents */
+    size_t      size;           /**< size of \a data */
+    bool        mapped;         /**< \a data is memory-mapped */
+} index_t;
+
+
+static bool build_sldb(index_builder_t *builder, hvsc_text_file_t *handle);
+static bool build_stil(index_builder_t *builder, hvsc_text_file_t *handle);
+static int  compare_sldb(const void *p1, const void *p2);
+static int  compare_stil(const void *p1, const void *p2);
+static bool check_sldb(const void *p, uint32_t strings_size);
+static bool check_stil(const void *p, uint32_t strings_size);
+
+/** \brief  SLDB index */
+static index_t sldb_index = {
+    "hvsc-sldb.idx", sizeof(sldb_record_t), build_sldb, compare_sldb,
+    check_sldb, NULL, 0, false
+};
+
+/** \brief  STIL index */
+static index_t stil_index = {
+    "hvsc-stil.idx", sizeof(stil_record_t), build_stil, compare_stil,
+    check_stil, NULL, 0, false
+};
+
+
+/** \brief  Hash HVSC \a path (FNV-1a)
+ *
+ * \param[in]   path    HVSC path
+ *
+ * \return  hash
+ */
+static uint32_t path_hash(const char *path)
+{
+    uint32_t hash = 2166136261u;
+
+    while (*path != '\0') {
+        hash ^= (uint8_t)*path++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/** \brief  Convert string representation of an MD5 digest to binary
+ *
+ * Only lower case digits are accepted, like the SLDB uses.
+ *
+ * \param[in]   s       string, at least 32 characters
+ * \param[out]  digest  binary digest
+ *
+ * \return  bool
+ */
+static bool parse_digest(const char *s, uint8_t *digest)
+{
+    int i;
+
+    for (i = 0; i < HVSC_DIGEST_SIZE * 2; i++) {
+        int c = (unsigned char)s[i];
+        int v;
+
+        if (c >= '0' && c <= '9') {
+            v = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            v = c - 'a' + 10;
+        } else {
+            return false;
+        }
+        if (i & 1) {
+            digest[i >> 1] = (uint8_t)((digest[i >> 1] << 4) | v);
+        } else {
+            digest[i >> 1] = (uint8_t)v;
+        }
+    }
+    return true;
+}
+
+
+/** \brief  Add string \a s to the string pool of \a builder
+ *
+ * \param[in,out]   builder index builder
+ * \param[in]       s       string
+ *
+ * \return  string offset
+ */
+static uint32_t builder_add_string(index_builder_t *builder, const char *s)
+{
+    size_t len = strlen(s) + 1;
+    uint32_t offset = (uint32_t)builder->strings_size;
+
+    while (builder->strings_size + len > builder->strings_max) {
+        builder->strings_max = builder->strings_max ? builder->strings_max * 2 : 0x10000;
+        builder->strings = hvsc_realloc(builder->strings, builder->strings_max);
+    }
+    memcpy(builder->strings + builder->strings_size, s, len);
+    builder->strings_size += len;
+    return offset;
+}
+
+/** \brief  Append a record to \a builder
+ *
+ * \param[in,out]   builder index builder
+ *
+ * \return  pointer to the (uninitialized) record
+ */
+static void *builder_add_record(index_builder_t *builder)
+{
+    if (builder->count == builder->max) {
+        builder->max = builder->max ? builder->max * 2 : 4096;
+        builder->records = hvsc_realloc(builder->records,
+                                        builder->max * builder->record_size);
+    }
+    return builder->records + builder->record_size * builder->count++;
+}
+
+
+/** \brief  Add the entries of Songlengths.md5 to \a builder
+ *
+ * \param[in,out]   builder index builder
+ * \param[in,out]   handle  text file handle of the SLDB
+ *
+ * \return  bool
+ */
+static bool build_sldb(index_builder_t *builder, hvsc_text_file_t *handle)
+{
+    const char *line;
+
+    while ((line = hvsc_text_file_read(handle)) != NULL) {
+        sldb_record_t *record;
+        uint8_t digest[HVSC_DIGEST_SIZE];
+        uint32_t entry;
+        uint32_t path = INDEX_NONE;
+
+        if (strlen(line) <= HVSC_DIGEST_SIZE * 2
+                || line[HVSC_DIGEST_SIZE * 2] != '='
+                || !parse_digest(line, digest)) {
+            continue;
+        }
+        entry = builder_add_string(builder, line);
+        /* the HVSC path is in the comment above the digest */
+        if (handle->prevbuf[0] == ';' && handle->prevbuf[1] == ' ') {
+            path = builder_add_string(builder, handle->prevbuf + 2);
+        }
+
+        record = builder_add_record(builder);
+        memcpy(record->digest, digest, sizeof record->digest);
+        record->entry = entry;
+        record->path = path;
+    }
+    return feof(handle->fp) != 0;
+}
+
+/** \brief  Add the entries of STIL.txt to \a builder
+ *
+ * \param[in,out]   builder index builder
+ * \param[in,out]   handle  text file handle of the STIL
+ *
+ * \return  bool
+ */
+static bool build_stil(index_builder_t *builder, hvsc_text_file_t *handle)
+{
+    const char *line;
+
+    while ((line = hvsc_text_file_read(handle)) != NULL) {
+        stil_record_t *record;
+        uint32_t path;
+        long offset;
+
+        if (*line != '/') {
+            continue;
+        }
+        offset = ftell(handle->fp);
+        if (offset < 0 || (unsigned long)offset >= INDEX_NONE) {
+            return false;
+        }
+        path = builder_add_string(builder, line);
+
+        record = builder_add_record(builder);
+        record->hash = path_hash(line);
+        record->path = path;
+        record->offset = (uint32_t)offset;
+        record->lineno = (uint32_t)handle->lineno;
+    }
+    return feof(handle->fp) != 0;
+}
+
+/** \brief  Order SLDB records on digest, keeping file order for duplicates
+ */
+static int compare_sldb(const void *p1, const void *p2)
+{
+    const sldb_record_t *r1 = p1;
+    const sldb_record_t *r2 = p2;
+    int result = memcmp(r1->digest, r2->digest, sizeof r1->digest);
+
+    if (result != 0) {
+        return result;
+    }
+    return r1->entry < r2->entry ? -1 : r1->entry > r2->entry;
+}
+
+/** \brief  Order STIL records on hash, keeping file order for duplicates
+ */
+static int compare_stil(const void *p1, const void *p2)
+{
+    const stil_record_t *r1 = p1;
+    const stil_record_t *r2 = p2;
+
+    if (r1->hash != r2->hash) {
+        return r1->hash < r2->hash ? -1 : 1;
+    }
+    return r1->offset < r2->offset ? -1 : r1->offset > r2->offset;
+}
+
+/** \brief  Check the string offsets of an SLDB record
+ */
+static bool check_sldb(const void *p, uint32_t strings_size)
+{
+    const sldb_record_t *record = p;
+
+    return record->entry < strings_size
+        && (record->path == INDEX_NONE || record->path < strings_size);
+}
+
+/** \brief  Check the string offsets of a STIL record
+ */
+static bool check_stil(const void *p, uint32_t strings_size)
+{
+    const stil_record_t *record = p;
+
+    return record->path < strings_size;
+}
+
+
+/** \brief  Get header of \a index
+ */
+static const index_header_t *index_header(const index_t *index)
+{
+    return (const index_header_t *)index->data;
+}
+
+/** \brief  Get record \a n of \a index
+ */
+static const void *index_record(const index_t *index, size_t n)
+{
+    return index->data + index_header(index)->records + n * index->record_size;
+}
+
+/** \brief  Get string at \a offset of \a index
+ */
+static const char *index_string(const index_t *index, uint32_t offset)
+{
+    if (offset == INDEX_NONE) {
+        return NULL;
+    }
+    return (const char *)index->data + index_header(index)->strings + offset;
+}
+
+/** \brief  Release memory used by \a index
+ *
+ * \param[in,out]   index   index
+ */
+static void index_free(index_t *index)
+{
+    if (index->data == NULL) {
+        return;
+    }
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+    if (index->mapped) {
+        munmap(index->data, index->size);
+    } else
+#endif
+    {
+        hvsc_free(index->data);
+    }
+    index->data = NULL;
+    index->size = 0;
+    index->mapped = false;
+}
+
+/** \brief  Check if the loaded \a index belongs to the text file \a source
+ *
+ * \param[in]   index   index
+ * \param[in]   source  path of the text file
+ * \param[in]   st      stat() result of \a source
+ *
+ * \return  bool
+ */
+static bool index_is_current(const index_t *index,
+                             const char *source,
+                             const struct stat *st)
+{
+    const index_header_t *header = index_header(index);
+
+    return header->source_size == (uint64_t)st->st_size
+        && header->source_mtime == (int64_t)st->st_mtime
+        && strcmp(index_string(index, header->source_path), source) == 0;
+}
+
+/** \brief  Validate the index file data in \a index
+ *
+ * The string pool must end in a NUL, so every string offset that is inside
+ * the pool gives a string that is terminated inside it.
+ *
+ * \param[in]   index   index
+ *
+ * \return  bool
+ */
+static bool index_is_valid(const index_t *index)
+{
+    const index_header_t *header = index_header(index);
+    uint32_t n;
+
+    if (index->size < sizeof *header
+            || memcmp(header->magic, INDEX_MAGIC, sizeof header->magic) != 0
+            || header->byte_order != INDEX_BYTE_ORDER
+            || header->records != sizeof *header
+            || header->strings < header->records
+            || (header->strings - header->records) / index->record_size < header->count
+            || header->strings_size == 0
+            || header->strings > index->size
+            || index->size - header->strings < header->strings_size
+            || index->data[header->strings + header->strings_size - 1] != '\0'
+            || header->source_path >= header->strings_size) {
+        return false;
+    }
+    for (n = 0; n < header->count; n++) {
+        if (!index->check(index_record(index, n), header->strings_size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** \brief  Load \a index from the cache file \a path
+ *
+ * \param[in,out]   index   index
+ * \param[in]       path    path of the index file
+ *
+ * \return  bool
+ */
+static bool index_load(index_t *index, const char *path)
+{
+    FILE *fp;
+    long size;
+
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < (long)sizeof(index_header_t)) {
+        fclose(fp);
+        return false;
+    }
+    index->size = (size_t)size;
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+    index->data = mmap(NULL, index->size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+    if (index->data != MAP_FAILED) {
+        index->mapped = true;
+    } else
+#endif
+    {
+        index->data = hvsc_malloc(index->size);
+        index->mapped = false;
+        if (fseek(fp, 0, SEEK_SET) != 0
+                || fread(index->data, 1, index->size, fp) != index->size) {
+            fclose(fp);
+            index_free(index);
+            return false;
+        }
+    }
+    fclose(fp);
+
+    if (!index_is_valid(index)) {
+        index_free(index);
+        return false;
+    }
+    return true;
+}
+
+/** \brief  Build \a index from the text file \a source
+ *
+ * \param[in,out]   index   index
+ * \param[in]       source  path of the text file
+ * \param[in]       st      stat() result of \a source
+ *
+ * \return  bool
+ */
+static bool index_build(index_t *index, const char *source, const struct stat *st)
+{
+    hvsc_text_file_t handle;
+    index_builder_t builder;
+    index_header_t header;
+    size_t records_size;
+    bool result;
+
+    if (!hvsc_text_file_open(source, &handle)) {
+        return false;
+    }
+    log_message(LOG_DEFAULT, "VSID: Indexing '%s'.", source);
+
+    memset(&builder, 0, sizeof builder);
+    builder.record_size = index->record_size;
+    result = index->build(&builder, &handle);
+    hvsc_text_file_close(&handle);
+
+    records_size = builder.count * builder.record_size;
+    if (result && (sizeof header + records_size + builder.strings_size
+                   + strlen(source) + 1 < INDEX_NONE)) {
+        if (builder.count > 0) {
+            qsort(builder.records, builder.count, builder.record_size,
+                  index->compare);
+        }
+
+        memset(&header, 0, sizeof header);
+        memcpy(header.magic, INDEX_MAGIC, sizeof header.magic);
+        header.byte_order = INDEX_BYTE_ORDER;
+        header.count = (uint32_t)builder.count;
+        header.source_size = (uint64_t)st->st_size;
+        header.source_mtime = (int64_t)st->st_mtime;
+        header.source_path = builder_add_string(&builder, source);
+        header.records = sizeof header;
+        header.strings = (uint32_t)(sizeof header + records_size);
+        header.strings_size = (uint32_t)builder.strings_size;
+
+        index->size = header.strings + builder.strings_size;
+        index->data = hvsc_malloc(index->size);
+        index->mapped = false;
+        memcpy(index->data, &header, sizeof header);
+        if (records_size > 0) {
+            memcpy(index->data + header.records, builder.records, records_size);
+        }
+        memcpy(index->data + header.strings, builder.strings, builder.strings_size);
+    } else {
+        result = false;
+    }
+
+    hvsc_free(builder.records);
+    hvsc_free(builder.strings);
+    return result;
+}
+
+/** \brief  Write \a index to the cache file \a path
+ *
+ * Failure isn't fatal, the index is then rebuilt on the next run.
+ *
+ * \param[in]   index   index
+ * \param[in]   path    path of the index file
+ */
+static void index_save(const index_t *index, const char *path)
+{
+    char *tmp_path = util_concat(path, ".tmp", NULL);
+    FILE *fp;
+
+    fp = fopen(tmp_path, "wb");
+    if (fp != NULL) {
+        bool ok = fwrite(index->data, 1, index->size, fp) == index->size;
+
+        if (fclose(fp) == 0 && ok) {
+            archdep_remove(path);
+            if (archdep_rename(tmp_path, path) == 0) {
+                lib_free(tmp_path);
+                return;
+            }
+        }
+        archdep_remove(tmp_path);
+    }
+    log_warning(LOG_DEFAULT, "VSID: Failed to write '%s'.", path);
+    lib_free(tmp_path);
+}
+
+/** \brief  Make sure \a index is loaded and up to date with \a source
+ *
+ * \param[in,out]   index   index
+ * \param[in]       source  path of the text file
+ *
+ * \return  bool
+ */
+static bool index_open(index_t *index, const char *source)
+{
+    struct stat st;
+    char *path;
+
+    if (source == NULL || stat(source, &st) != 0) {
+        index_free(index);
+        return false;
+    }
+    if (index->data != NULL && index_is_current(index, source, &st)) {
+        return true;
+    }
+    index_free(index);
+
+    path = util_join_paths(archdep_user_cache_path(), index->name, NULL);
+    if (index_load(index, path)) {
+        if (index_is_current(index, source, &st)) {
+            lib_free(path);
+            return true;
+        }
+        index_free(index);
+    }
+    if (!index_build(index, source, &st)) {
+        lib_free(path);
+        return false;
+    }
+    index_save(index, path);
+    lib_free(path);
+    return true;
+}
+
+
+/** \brief  Look up MD5 \a digest in the SLDB index
+ *
+ * The strings returned in \a entry and \a path are owned by the index and
+ * valid until the next index call.
+ *
+ * \param[in]   digest  MD5 digest as hexadecimal string literal
+ * \param[out]  entry   SLDB line for \a digest
+ * \param[out]  path    HVSC path for \a digest (can be `NULL`)
+ *
+ * \return  HVSC_INDEX_FOUND, HVSC_INDEX_NOT_FOUND or HVSC_INDEX_UNAVAILABLE
+ */
+int hvsc_index_sldb_find(const char *digest,
+                         const char **entry,
+                         const char **path)
+{
+    uint8_t key[HVSC_DIGEST_SIZE];
+    size_t lo;
+    size_t hi;
+
+    if (!parse_digest(digest, key) || !index_open(&sldb_index, hvsc_sldb_path)) {
+        return HVSC_INDEX_UNAVAILABLE;
+    }
+
+    /* find the first record with this digest */
+    lo = 0;
+    hi = index_header(&sldb_index)->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const sldb_record_t *record = index_record(&sldb_index, mid);
+
+        if (memcmp(record->digest, key, sizeof key) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < index_header(&sldb_index)->count) {
+        const sldb_record_t *record = index_record(&sldb_index, lo);
+
+        if (memcmp(record->digest, key, sizeof key) == 0) {
+            *entry = index_string(&sldb_index, record->entry);
+            *path = index_string(&sldb_index, record->path);
+            return HVSC_INDEX_FOUND;
+        }
+    }
+    hvsc_errno = HVSC_ERR_NOT_FOUND;
+    return HVSC_INDEX_NOT_FOUND;
+}
+
+/** \brief  Look up HVSC \a path in the STIL index
+ *
+ * \param[in]   path    HVSC path, with forward slashes
+ * \param[out]  offset  file offset of the line following \a path in STIL.txt
+ * \param[out]  lineno  line number of \a path in STIL.txt
+ *
+ * \return  HVSC_INDEX_FOUND, HVSC_INDEX_NOT_FOUND or HVSC_INDEX_UNAVAILABLE
+ */
+int hvsc_index_stil_find(const char *path, long *offset, long *lineno)
+{
+    uint32_t hash;
+    size_t count;
+    size_t lo;
+    size_t hi;
+
+    /* only lines starting with a slash are indexed */
+    if (*path != '/' || !index_open(&stil_index, hvsc_stil_path)) {
+        return HVSC_INDEX_UNAVAILABLE;
+    }
+
+    hash = path_hash(path);
+    count = index_header(&stil_index)->count;
+    lo = 0;
+    hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const stil_record_t *record = index_record(&stil_index, mid);
+
+        if (record->hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (; lo < count; lo++) {
+        const stil_record_t *record = index_record(&stil_index, lo);
+
+        if (record->hash != hash) {
+            break;
+        }
+        if (strcmp(index_string(&stil_index, record->path), path) == 0) {
+            *offset = (long)record->offset;
+            *lineno = (long)record->lineno;
+            return HVSC_INDEX_FOUND;
+        }
+    }
+    hvsc_errno = HVSC_ERR_NOT_FOUND;
+    return HVSC_INDEX_NOT_FOUND;
+}
+
+/** \brief  Release the indexes
+ */
+void hvsc_index_close(void)
+{
+    index_free(&sldb_index);
+    index_free(&stil_index);
+}
+
+#else   /* HVSC_STANDALONE */
+
+/* The standalone library has no cache directory, always scan the text. */
+
+int hvsc_index_sldb_find(const char *digest,
+                         const char **entry,
+                         const char **path)
+{
+    return HVSC_INDEX_UNAVAILABLE;
+}
+
+int hvsc_index_stil_find(const char *path, long *offset, long *lineno)
+{
+    return HVSC_INDEX_UNAVAILABLE;
+}
+
+void hvsc_index_close(void)
+{
+}
+
+#endif
@@ -0,0 +1,40 @@
+/** \file   src/hvsc/index.h
+ * \brief   Binary indexes of the SLDB and STIL - header
+ */
+
+/*
+ *  HVSClib - a library to work with High Voltage SID Collection files
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.*
+ */
+
+#ifndef HVSC_INDEX_H
+#define HVSC_INDEX_H
+
+/** \brief  Result of an index lookup
+ */
+enum {
+    HVSC_INDEX_UNAVAILABLE = -1,    /**< no usable index, scan the text file */
+    HVSC_INDEX_NOT_FOUND = 0,       /**< index says there is no such entry */
+    HVSC_INDEX_FOUND = 1            /**< entry found */
+};
+
+int  hvsc_index_sldb_find(const char *digest,
+                          const char **entry,
+                          const char **path);
+int  hvsc_index_stil_find(const char *path, long *offset, long *lineno);
+void hvsc_index_close(void);
+
+#endif
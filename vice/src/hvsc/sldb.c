@@ -43,6 +43,7 @@
 #include "hvsc.h"
 #include "hvsc_defs.h"
 #include "base.h"
+#include "index.h"
 
 #include "sldb.h"
 
@@ -104,6 +105,17 @@ static char *find_sldb_entry_md5(const char *digest)
 {
     hvsc_text_file_t  handle;
     const char       *line;
+    const char       *entry;
+    const char       *path;
+
+    switch (hvsc_index_sldb_find(digest, &entry, &path)) {
+        case HVSC_INDEX_FOUND:
+            return hvsc_strdup(entry);
+        case HVSC_INDEX_NOT_FOUND:
+            return NULL;
+        default:
+            break;
+    }
 
     if (!hvsc_text_file_open(hvsc_sldb_path, &handle)) {
         return NULL;
@@ -356,8 +368,9 @@ int hvsc_sldb_get_lengths(const char *psid, long **lengths)
 
 /** \brief  Get relative HVSC path for md5 digest in SLDB
  *
- * Iterate \c Songlengths.md5 looking for md5 \a digest and return the relative
- * path contained in the comment line just above the md5 line.
+ * Look up md5 \a digest in the SLDB index, or iterate \c Songlengths.md5 if
+ * there is no index, and return the relative path contained in the comment
+ * line just above the md5 line.
  *
  * \param[in]   digest  md5 digest (nul-terminated 32-byte hexadecimal literal)
  *
@@ -370,10 +383,21 @@ int hvsc_sldb_get_lengths(const char *psid, long **lengths)
 char *hvsc_sldb_get_path_for_md5(const char *digest)
 {
     hvsc_text_file_t handle;
+    const char      *entry;
+    const char      *path;
 #ifdef HVSC_DEBUG
     int              lineno = 1;
 #endif
 
+    switch (hvsc_index_sldb_find(digest, &entry, &path)) {
+        case HVSC_INDEX_FOUND:
+            return path != NULL ? hvsc_strdup(path) : NULL;
+        case HVSC_INDEX_NOT_FOUND:
+            return NULL;
+        default:
+            break;
+    }
+
     if (hvsc_text_file_open(hvsc_sldb_path, &handle)) {
         const char *line;
 
@@ -42,6 +42,7 @@
 #include "hvsc.h"
 #include "hvsc_defs.h"
 #include "base.h"
+#include "index.h"
 
 #include "stil.h"
 
@@ -424,6 +425,67 @@ static void stil_handle_add_block(hvsc_stil_t *handle, hvsc_stil_block_t *block)
 }
 
 
+/** \brief  Find the STIL entry for the PSID file of \a handle
+ *
+ * Looks up the entry in the STIL index, or scans STIL.txt if there's no
+ * index, and leaves the STIL file positioned just after the path line.
+ *
+ * \param[in,out]   handle  STIL handle with opened STIL file and psid_path
+ *
+ * \return  bool
+ */
+static bool stil_find_entry(hvsc_stil_t *handle)
+{
+    const char *line;
+    long        offset;
+    long        lineno;
+
+    switch (hvsc_index_stil_find(handle->psid_path, &offset, &lineno)) {
+        case HVSC_INDEX_FOUND:
+            if (fseek(handle->stil.fp, offset, SEEK_SET) != 0) {
+                hvsc_errno = HVSC_ERR_IO;
+                return false;
+            }
+            handle->stil.lineno = lineno;
+#ifndef HVSC_STANDALONE
+            log_message(LOG_DEFAULT,
+                    "VSID: Found '%s' at line %ld.", handle->psid_path, lineno);
+#endif
+            return true;
+        case HVSC_INDEX_NOT_FOUND:
+#ifndef HVSC_STANDALONE
+            log_message(LOG_DEFAULT, "VSID: No STIL entry found.");
+#endif
+            return false;
+        default:
+            break;
+    }
+
+    while (true) {
+        line = hvsc_text_file_read(&(handle->stil));
+        if (line == NULL) {
+            if (feof(handle->stil.fp)) {
+                /* EOF, so simply not found */
+                hvsc_errno = HVSC_ERR_NOT_FOUND;
+#ifndef HVSC_STANDALONE
+                log_message(LOG_DEFAULT, "VSID: No STIL entry found.");
+#endif
+            }
+            /* I/O error is already set */
+            return false;
+        }
+
+        if (strcmp(line, handle->psid_path) == 0) {
+#ifndef HVSC_STANDALONE
+            log_message(LOG_DEFAULT,
+                    "VSID: Found '%s' at line %ld.", line, handle->stil.lineno);
+#endif
+            return true;
+        }
+    }
+}
+
+
 /** \brief  Open STIL and look for PSID file \a psid
  *
  * \param[in]   psid    path to PSID file
@@ -433,8 +495,6 @@ static void stil_handle_add_block(hvsc_stil_t *handle, hvsc_stil_block_t *block)
  */
 bool hvsc_stil_open(const char *psid, hvsc_stil_t *handle)
 {
-    const char *line;
-
     stil_init_handle(handle);
     handle->entry_buffer = hvsc_malloc(HVSC_STIL_BUFFER_INIT *
                                        sizeof *(handle->entry_buffer));
@@ -486,29 +546,11 @@ bool hvsc_stil_open(const char *psid, hvsc_stil_t *handle)
     hvsc_dbg("stripped path is '%s'\n", handle->psid_path);
 
     /* find the entry */
-    while (true) {
-        line = hvsc_text_file_read(&(handle->stil));
-        if (line == NULL) {
-            if (feof(handle->stil.fp)) {
-                /* EOF, so simply not found */
-                hvsc_errno = HVSC_ERR_NOT_FOUND;
-#ifndef HVSC_STANDALONE
-                log_message(LOG_DEFAULT, "VSID: No STIL entry found.");
-#endif
-            }
-            hvsc_stil_close(handle);
-            /* I/O error is already set */
-            return false;
-        }
-
-        if (strcmp(line, handle->psid_path) == 0) {
-#ifndef HVSC_STANDALONE
-            log_message(LOG_DEFAULT,
-                    "VSID: Found '%s' at line %ld.", line, handle->stil.lineno);
-#endif
-            return true;
-        }
+    if (!stil_find_entry(handle)) {
+        hvsc_stil_close(handle);
+        return false;
     }
+    return true;
 }
 
 
@@ -542,29 +584,11 @@ bool hvsc_stil_open_md5(const char *digest, hvsc_stil_t *handle)
     }
 
     /* look up entry */
-    while (true) {
-        const char *line = hvsc_text_file_read(&(handle->stil));
-
-        if (line == NULL) {
-            if (feof(handle->stil.fp)) {
-                /* EOF, OK */
-                hvsc_errno = HVSC_ERR_NOT_FOUND;
-#ifndef HVSC_STANDALONE
-                log_message(LOG_DEFAULT, "VSID: No STIL entry found.");
-#endif
-            }
-            hvsc_stil_close(handle);
-            return false;
-        }
-
-        if (strcmp(line, handle->psid_path) == 0) {
-#ifndef HVSC_STANDALONE
-            log_message(LOG_DEFAULT,
-                    "VSID: Found '%s' at line %ld.", line, handle->stil.lineno);
-#endif
-            return true;
-        }
+    if (!stil_find_entry(handle)) {
+        hvsc_stil_close(handle);
+        return false;
     }
+    return true;
 }
 
 
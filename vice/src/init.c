@@ -48,6 +48,7 @@
 #include "palette.h"
 #include "ram.h"
 #include "resources.h"
+#include "rewind.h"
 #include "romset.h"
 #include "screenshot.h"
 #include "signals.h"
@@ -120,6 +121,10 @@ int init_resources(void)
         init_resource_fail("vsync");
         return -1;
     }
+    if (rewind_resources_init() < 0) {
+        init_resource_fail("rewind");
+        return -1;
+    }
     if (sound_resources_init() < 0) {
         init_resource_fail("sound");
         return -1;
@@ -205,6 +210,10 @@ int init_cmdline_options(void)
         init_cmdline_options_fail("vsync");
         return -1;
     }
+    if (rewind_cmdline_options_init() < 0) {
+        init_cmdline_options_fail("rewind");
+        return -1;
+    }
     if (sound_cmdline_options_init() < 0) {
         init_cmdline_options_fail("sound");
         return -1;
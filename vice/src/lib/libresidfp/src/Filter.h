@@ -107,6 +107,9 @@ private:
     uint8_t filt = 0;
 
 protected:
+    /// Position in the dither noise of the model configuration.
+    mutable unsigned int rndPos = 0;
+
     /**
      * Update filter cutoff frequency.
      */
@@ -133,7 +136,7 @@ protected:
 
     inline int32_t getNormalizedVoice(float v, uint8_t env) const
     {
-        return m_fmc.getNormalizedVoice(v, env);
+        return m_fmc.getNormalizedVoice(v, env, rndPos);
     }
 
     virtual int32_t getNormalizedMixerVoice(float v, uint8_t env) const = 0;
@@ -44,7 +44,7 @@ void Filter6581::updateCenterFrequency()
 void Filter6581::setFilterCurve(double curvePosition)
 {
     delete [] f0_dac;
-    f0_dac = FilterModelConfig6581::getInstance()->getDAC(curvePosition);
+    f0_dac = FilterModelConfig6581::getInstance()->getDAC(curvePosition, rndPos);
     updateCenterFrequency();
 }
 
@@ -352,7 +352,7 @@ public:
         Filter(*FilterModelConfig6581::getInstance(), hpIntegrator, bpIntegrator),
         hpIntegrator(*FilterModelConfig6581::getInstance()),
         bpIntegrator(*FilterModelConfig6581::getInstance()),
-        f0_dac(FilterModelConfig6581::getInstance()->getDAC(0.5))
+        f0_dac(FilterModelConfig6581::getInstance()->getDAC(0.5, rndPos))
     {}
 
     ~Filter6581() override;
@@ -91,6 +91,7 @@ private:
                 buffer[i] = unif(re);
         }
         double getNoise() const { index = (index + 1) & 0x3ff; return buffer[index]; }
+        double getNoise(unsigned int &pos) const { pos = (pos + 1) & 0x3ff; return buffer[pos]; }
     };
 
 protected:
@@ -299,6 +300,18 @@ public:
         return to_uint16_dither(N16 * (value - vmin), rnd.getNoise());
     }
 
+    /**
+     * As above, with the position in the noise kept by the caller.
+     * The model configuration is shared by all SID instances, so
+     * anything done per instance uses its own position: the output
+     * of a chip then does not depend on the other chips, and chips can
+     * be clocked on different threads.
+     */
+    inline uint16_t getNormalizedValue(double value, unsigned int &rndPos) const
+    {
+        return to_uint16_dither(N16 * (value - vmin), rnd.getNoise(rndPos));
+    }
+
     template<int N>
     inline uint16_t getNormalizedCurrentFactor(double wl) const
     {
@@ -310,9 +323,9 @@ public:
         return to_uint16(N16 * vmin);
     }
 
-    inline int32_t getNormalizedVoice(float value, uint8_t env) const
+    inline int32_t getNormalizedVoice(float value, uint8_t env, unsigned int &rndPos) const
     {
-        return static_cast<int32_t>(getNormalizedValue(getVoiceVoltage(value, env)));
+        return static_cast<int32_t>(getNormalizedValue(getVoiceVoltage(value, env), rndPos));
     }
 };
 
@@ -298,7 +298,7 @@ FilterModelConfig6581::FilterModelConfig6581() :
 #endif
 }
 
-uint16_t* FilterModelConfig6581::getDAC(double adjustment) const
+uint16_t* FilterModelConfig6581::getDAC(double adjustment, unsigned int &rndPos) const
 {
     const double new_dac_zero = getDacZero(adjustment);
 
@@ -307,7 +307,7 @@ uint16_t* FilterModelConfig6581::getDAC(double adjustment) const
     for (unsigned int i = 0; i < (1 << DAC_BITS); i++)
     {
         const double fcd = dac.getOutput(i);
-        f0_dac[i] = getNormalizedValue(new_dac_zero + fcd * dac_scale);
+        f0_dac[i] = getNormalizedValue(new_dac_zero + fcd * dac_scale, rndPos);
     }
 
     return f0_dac;
@@ -122,7 +122,7 @@ public:
      * @param adjustment
      * @return the DAC table
      */
-    uint16_t* getDAC(double adjustment) const;
+    uint16_t* getDAC(double adjustment, unsigned int &rndPos) const;
 
     inline double getWL_snake() const { return WL_snake; }
 
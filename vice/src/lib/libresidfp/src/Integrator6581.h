@@ -177,6 +177,9 @@ private:
 
     uint32_t nVddt_Vw_2;
 
+    /// Position in the dither noise of the model configuration.
+    unsigned int rndPos;
+
     const uint16_t nVddt;
     const uint16_t nVt;
     const uint16_t nVmin;
@@ -190,8 +193,9 @@ public:
         n(1.4),
 #endif
         nVddt_Vw_2(0),
-        nVddt(new_fmc.getNormalizedValue(new_fmc.getVddt())),
-        nVt(new_fmc.getNormalizedValue(new_fmc.getVth())),
+        rndPos(0),
+        nVddt(new_fmc.getNormalizedValue(new_fmc.getVddt(), rndPos)),
+        nVt(new_fmc.getNormalizedValue(new_fmc.getVth(), rndPos)),
         nVmin(new_fmc.getNVmin()),
         fmc(new_fmc) {}
 
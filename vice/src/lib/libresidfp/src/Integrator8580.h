@@ -57,6 +57,9 @@ class Integrator8580 : public Integrator
     friend class State;
 
 private:
+    /// Position in the dither noise of the model configuration.
+    unsigned int rndPos = 0;
+
     uint16_t nVgt;
     uint16_t n_dac;
 
@@ -91,7 +94,7 @@ public:
 
         // Vg - Vth, normalized so that translated values can be subtracted:
         // Vgt - x = (Vgt - t) - (x - t)
-        nVgt = fmc.getNormalizedValue(Vgt);
+        nVgt = fmc.getNormalizedValue(Vgt, rndPos);
     }
 
     int32_t solve(int32_t vi) const override;
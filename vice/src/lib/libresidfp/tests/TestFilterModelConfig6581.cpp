@@ -38,11 +38,12 @@ TEST(TestFilterCurve)
     // Check that values in the filter curve range do not
     // trigger assertions
     unsigned short* dac;
+    unsigned int rndPos = 0;
 
-    dac = FilterModelConfig6581::getInstance()->getDAC(0.0);
+    dac = FilterModelConfig6581::getInstance()->getDAC(0.0, rndPos);
     delete [] dac;
 
-    dac = FilterModelConfig6581::getInstance()->getDAC(1.0);
+    dac = FilterModelConfig6581::getInstance()->getDAC(1.0, rndPos);
     delete [] dac;
 }
 
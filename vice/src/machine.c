@@ -62,6 +62,7 @@
 #include "printer.h"
 #include "profiler.h"
 #include "resources.h"
+#include "rewind.h"
 #include "romset.h"
 #include "screenshot.h"
 #include "sound.h"
@@ -291,6 +292,7 @@ void machine_maincpu_init(void)
 void machine_early_init(void)
 {
     maincpu_alarm_context = alarm_context_new("MainCPU");
+    alarm_benchmark_init(maincpu_alarm_context);
 }
 
 int machine_init(void)
@@ -341,6 +343,15 @@ static void screenshot_at_exit(void)
     }
 }
 
+/* Frames that are not shown need not be drawn, unless the last one is saved
+   as the exit screenshot or a binary monitor client may read the display.  */
+int machine_draw_all_frames(void)
+{
+    return (ExitScreenshotName != NULL && ExitScreenshotName[0] != 0)
+           || (ExitScreenshotName1 != NULL && ExitScreenshotName1[0] != 0)
+           || monitor_is_binary();
+}
+
 void machine_shutdown(void)
 {
     int save_on_exit;
@@ -429,6 +440,8 @@ void machine_shutdown(void)
 
     event_shutdown();
 
+    rewind_shutdown();
+
     network_shutdown();
 
     autostart_resources_shutdown();
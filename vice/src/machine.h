@@ -192,6 +192,9 @@ struct canvas_refresh_s;
 int machine_screenshot(struct screenshot_s *screenshot, struct video_canvas_s *canvas);
 int machine_canvas_async_refresh(struct canvas_refresh_s *ref, struct video_canvas_s *canvas);
 
+/* Return non-zero if frames that are not shown must still be drawn.  */
+int machine_draw_all_frames(void);
+
 #define JAM_NONE        0
 #define JAM_RESET_CPU   1
 #define JAM_POWER_CYCLE 2
@@ -379,18 +379,26 @@ void maincpu_mainloop(void)
 
 #define GLOBAL_REGS maincpu_regs
 
-#include "65816core.c"
-
-        maincpu_int_status->num_dma_per_opcode = 0;
-
-        drive_cycle_hook();
+/* the core may go on with the next opcode itself, see 6510core.h */
+#define CPU_CHAIN_ALLOWED() 1
+
+#define CPU_OPCODE_DONE()                                               \
+    do {                                                                \
+        maincpu_int_status->num_dma_per_opcode = 0;                     \
+                                                                        \
+        drive_cycle_hook();                                             \
+                                                                        \
+        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {   \
+            log_error(LOG_DEFAULT, "cycle limit reached.");             \
+            archdep_vice_exit(EXIT_FAILURE);                            \
+        }                                                               \
+                                                                        \
+        autostart_advance();                                            \
+    } while (0)
 
-        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
-            log_error(LOG_DEFAULT, "cycle limit reached.");
-            archdep_vice_exit(EXIT_FAILURE);
-        }
+#include "65816core.c"
 
-        autostart_advance();
+        CPU_OPCODE_DONE();
 #if 0
         if (CLK > 246171754)
             debug.maincpu_traceflg = 1;
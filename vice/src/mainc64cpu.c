@@ -808,18 +808,26 @@ void maincpu_mainloop(void)
 
 #define GLOBAL_REGS maincpu_regs
 
-#include "6510dtvcore.c"
-
-        maincpu_int_status->num_dma_per_opcode = 0;
-
-        drive_cycle_hook();
+/* the core may go on with the next opcode itself, see 6510core.h */
+#define CPU_CHAIN_ALLOWED() 1
+
+#define CPU_OPCODE_DONE()                                               \
+    do {                                                                \
+        maincpu_int_status->num_dma_per_opcode = 0;                     \
+                                                                        \
+        drive_cycle_hook();                                             \
+                                                                        \
+        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {   \
+            log_error(maincpu_log, "cycle limit reached.");             \
+            archdep_vice_exit(EXIT_FAILURE);                            \
+        }                                                               \
+                                                                        \
+        autostart_advance();                                            \
+    } while (0)
 
-        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
-            log_error(maincpu_log, "cycle limit reached.");
-            archdep_vice_exit(EXIT_FAILURE);
-        }
+#include "6510dtvcore.c"
 
-        autostart_advance();
+        CPU_OPCODE_DONE();
 
 #if 0
         if (CLK > 246171754) {
@@ -62,12 +62,35 @@ struct checkpoint_list_s {
 };
 typedef struct checkpoint_list_s checkpoint_list_t;
 
+/* Per-page index of the checkpoints of one of the lists below. The entries
+   overlapping page `p' are cps[first[p]] .. cps[first[p + 1] - 1], in the
+   same order as in the list.  */
+struct checkpoint_index_s {
+    unsigned int first[257];
+    mon_checkpoint_t **cps;
+};
+typedef struct checkpoint_index_s checkpoint_index_t;
+
+/* Number of candidates mon_breakpoint_check_checkpoint() can handle without
+   allocating memory.  */
+#define CHECKPOINT_CANDIDATES   16
+
 static int breakpoint_count;
+/* Incremented whenever breakpoint_count starts over at 1, which happens
+   only once all checkpoints are gone; checkpoint numbers seen before
+   may then refer to new checkpoints.  */
+static unsigned int breakpoint_count_resets;
 static checkpoint_list_t *all_checkpoints;
 static checkpoint_list_t *breakpoints[NUM_MEMSPACES];
 static checkpoint_list_t *watchpoints_load[NUM_MEMSPACES];
 static checkpoint_list_t *watchpoints_store[NUM_MEMSPACES];
 
+static checkpoint_index_t breakpoints_index[NUM_MEMSPACES];
+static checkpoint_index_t watchpoints_load_index[NUM_MEMSPACES];
+static checkpoint_index_t watchpoints_store_index[NUM_MEMSPACES];
+
+uint8_t mon_checkpoint_page_ops[NUM_MEMSPACES][256];
+
 
 void mon_breakpoint_init(void)
 {
@@ -156,8 +179,68 @@ mon_checkpoint_t *mon_breakpoint_find_checkpoint(int brknum)
     return NULL;
 }
 
+static bool checkpoint_on_page(mon_checkpoint_t *cp, unsigned int page)
+{
+    unsigned int start, end;
+
+    start = addr_location(cp->start_addr);
+    if (mon_is_valid_addr(cp->end_addr)) {
+        end = addr_location(cp->end_addr);
+    } else {
+        end = start;
+    }
+
+    if (end < start) {
+        /* range wraps around $ffff */
+        return (page >= (start >> 8)) || (page <= (end >> 8));
+    }
+    return (page >= (start >> 8)) && (page <= (end >> 8));
+}
+
+static void build_checkpoint_index(checkpoint_index_t *index, checkpoint_list_t *head,
+                                   MEMSPACE mem, MEMORY_OP op)
+{
+    checkpoint_list_t *ptr;
+    unsigned int page, n = 0;
+
+    for (page = 0; page < 256; page++) {
+        index->first[page] = n;
+        for (ptr = head; ptr; ptr = ptr->next) {
+            if (checkpoint_on_page(ptr->checkpt, page)) {
+                n++;
+            }
+        }
+    }
+    index->first[256] = n;
+
+    lib_free(index->cps);
+    index->cps = n ? lib_malloc(n * sizeof(mon_checkpoint_t *)) : NULL;
+
+    n = 0;
+    for (page = 0; page < 256; page++) {
+        for (ptr = head; ptr; ptr = ptr->next) {
+            if (checkpoint_on_page(ptr->checkpt, page)) {
+                index->cps[n++] = ptr->checkpt;
+                mon_checkpoint_page_ops[mem][page] |= op;
+            }
+        }
+    }
+}
+
+/* Rebuild the per-page lookup tables after the lists of `mem' changed.  */
+static void update_checkpoint_index(MEMSPACE mem)
+{
+    memset(mon_checkpoint_page_ops[mem], 0, sizeof(mon_checkpoint_page_ops[mem]));
+
+    build_checkpoint_index(&breakpoints_index[mem], breakpoints[mem], mem, e_exec);
+    build_checkpoint_index(&watchpoints_load_index[mem], watchpoints_load[mem], mem, e_load);
+    build_checkpoint_index(&watchpoints_store_index[mem], watchpoints_store[mem], mem, e_store);
+}
+
 static void update_checkpoint_state(MEMSPACE mem)
 {
+    update_checkpoint_index(mem);
+
     /* calls mem_toggle_watchpoints() */
     if (watchpoints_load[mem] != NULL ||
         watchpoints_store[mem] != NULL) {
@@ -363,6 +446,7 @@ void mon_breakpoint_delete_checkpoint(int cp_num)
         }
         /* reset the index to 1 */
         breakpoint_count = 1;
+        breakpoint_count_resets++;
     } else if (!(cp = mon_breakpoint_find_checkpoint(cp_num))) {
         mon_out("#%d not a valid checkpoint\n", cp_num);
         return;
@@ -376,6 +460,7 @@ void mon_breakpoint_delete_checkpoint(int cp_num)
             }
         }
         breakpoint_count = 1;
+        breakpoint_count_resets++;
     }
 }
 
@@ -467,9 +552,12 @@ static void mon_breakpoint_event(mon_checkpoint_t *checkpt) {
 
 bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned int lastpc, MEMORY_OP op)
 {
-    checkpoint_list_t *ptr;
     mon_checkpoint_t *cp;
-    checkpoint_list_t *list;
+    checkpoint_index_t *index;
+    int candidates_buf[CHECKPOINT_CANDIDATES];
+    int *candidates;
+    int checknum;
+    unsigned int page, num_candidates, i, resets;
     monitor_cpu_type_t *monitor_cpu, *searchcpu;
     bool must_stop = FALSE;
     MON_ADDR instpc, searchpc;
@@ -480,6 +568,50 @@ bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned i
     supported_cpu_type_list_t *cpulist;
     int monbank = mon_interfaces[mem]->current_bank;
 
+    page = (addr >> 8) & 0xff;
+    if (!(mon_checkpoint_page_ops[mem][page] & op)) {
+        return FALSE;
+    }
+
+    switch (op) {
+        case e_load:
+            index = &watchpoints_load_index[mem];
+            op_str = "load";
+            is_loadstore = 1;
+            break;
+
+        case e_store:
+            index = &watchpoints_store_index[mem];
+            op_str = "store";
+            is_loadstore = 1;
+            break;
+
+        default: /* e_exec */
+            index = &breakpoints_index[mem];
+            op_str = "exec";
+            break;
+    }
+
+    /* Collect the numbers of the hits first: checkpoint commands may change
+       the index, and may delete checkpoints, so each one is looked up again
+       before it is used.  */
+    num_candidates = index->first[page + 1] - index->first[page];
+    if (num_candidates > CHECKPOINT_CANDIDATES) {
+        candidates = lib_malloc(num_candidates * sizeof(int));
+    } else {
+        candidates = candidates_buf;
+    }
+    num_candidates = 0;
+    for (i = index->first[page]; i < index->first[page + 1]; i++) {
+        cp = index->cps[i];
+        if (mon_is_in_range(cp->start_addr, cp->end_addr, addr)) {
+            candidates[num_candidates++] = cp->checknum;
+        }
+    }
+    if (num_candidates == 0) {
+        goto done;
+    }
+
     monitor_cpu = monitor_cpu_for_memspace[mem];
     instpc = new_addr(mem, (monitor_cpu->mon_register_get_val)(mem, e_PC));
     loadstorepc = new_addr(mem, lastpc);
@@ -513,33 +645,18 @@ bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned i
         }
     }
 
-    switch (op) {
-        case e_load:
-            list = watchpoints_load[mem];
-            op_str = "load";
-            is_loadstore = 1;
+    resets = breakpoint_count_resets;
+    for (i = 0; i < num_candidates; i++) {
+        if (breakpoint_count_resets != resets) {
+            /* all checkpoints were deleted, the numbers left are stale */
             break;
-
-        case e_store:
-            list = watchpoints_store[mem];
-            op_str = "store";
-            is_loadstore = 1;
-            break;
-
-        default: /* e_exec */
-            list = breakpoints[mem];
-            op_str = "exec";
-            break;
-    }
-
-    ptr = search_checkpoint_list(list, addr);
-
-    while (ptr) {
-        cp = ptr->checkpt;
-        ptr = ptr->next;
-        if (cp && (cp->enabled == e_ON) &&
-            mon_is_in_range(cp->start_addr, cp->end_addr, addr)) {
-
+        }
+        checknum = candidates[i];
+        cp = mon_breakpoint_find_checkpoint(checknum);
+        if (cp == NULL) {
+            continue;
+        }
+        if (cp->enabled == e_ON) {
             /* If condition test fails, skip this checkpoint */
             if (cp->condition) {
                 if (!mon_evaluate_conditional(cp->condition, is_loadstore ? loadstorepc : instpc)) {
@@ -603,14 +720,27 @@ bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned i
                 default_memspace = mem;
                 parse_and_execute_line(cp->command);
                 default_memspace = tmpmem;
+                /* the command may have deleted this checkpoint */
+                if (breakpoint_count_resets != resets) {
+                    break;
+                }
+                cp = mon_breakpoint_find_checkpoint(checknum);
+                if (cp == NULL) {
+                    continue;
+                }
             }
 
             if (cp->temporary) {
-                mon_breakpoint_delete_checkpoint(cp->checknum);
+                mon_breakpoint_delete_checkpoint(checknum);
             }
         }
     }
 
+done:
+    if (candidates != candidates_buf) {
+        lib_free(candidates);
+    }
+
     return must_stop;
 }
 
@@ -753,6 +883,7 @@ void mon_breakpoint_unset(MON_ADDR address)
         /* there's a breakpoint, so remove it */
         remove_checkpoint_from_list( &all_checkpoints, ptr->checkpt );
         remove_checkpoint_from_list( &breakpoints[mem], ptr->checkpt );
+        update_checkpoint_state(mem);
     }
 }
 
@@ -52,6 +52,10 @@ struct mon_checkpoint_s {
 };
 typedef struct mon_checkpoint_s mon_checkpoint_t;
 
+/* Bitmask of the MEMORY_OP types that have checkpoints on each page, so
+   accesses to other pages can be dismissed without a lookup.  */
+extern uint8_t mon_checkpoint_page_ops[NUM_MEMSPACES][256];
+
 void mon_breakpoint_init(void);
 
 void mon_breakpoint_switch_checkpoint(int op, int breakpt_num);
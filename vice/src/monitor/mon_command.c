@@ -175,6 +175,14 @@ static const mon_cmds_t mon_cmd_array[] = {
       FILENAME_ARG
     },
 
+    { "rewind", "",
+      "[<seconds>]",
+      "Step the machine back by at least <seconds> seconds (default 1) using"
+      " the in-memory rewind history. The history is only recorded while"
+      " the RewindEnable resource is set.",
+      NO_FILENAME_ARG
+    },
+
     { "bank", "",
       "[<memspace>] [bankname]",
       "If bankname is not given, print the possible banks for the memspace.\n"
@@ -250,7 +258,7 @@ static const mon_cmds_t mon_cmd_array[] = {
 
 
     { "profile", "prof",
-      "[on|off]|[flat [num]]|[graph [context] [depth]]|[func <function>]",
+      "[on|off]|[flat [num]]|[graph [context] [depth]]|[func <function>]|[sample [n]]|[flamegraph|callgrind \"<file>\"]",
       "Main CPU profiling functions. Commands:\n"
       "prof on - Start profiling and flush old profiling data.\n"
       "prof off - Stop profiling.\n"
@@ -261,7 +269,11 @@ static const mon_cmds_t mon_cmd_array[] = {
       "prof context <ctx> - Detailed context information including "
       " per-instruction profiling for function"
       " in a call graph context.\n"
-      "prof clear <function> - Clears all profiling stats for function.\n",
+      "prof clear <function> - Clears all profiling stats for function.\n"
+      "prof sample [<n>] - Only record every n-th instruction, for less overhead.\n"
+      "prof flamegraph \"<file>\" - Save call stacks in the folded format of flamegraph.pl.\n"
+      "prof callgrind \"<file>\" - Save call graph in callgrind format (for KCachegrind).\n"
+      "Labels are used as function names, interrupt handlers get an IRQ/NMI prefix.\n",
       NO_FILENAME_ARG
     },
 
@@ -154,8 +154,9 @@ void set_yydebug(int val);
 %token CMD_CPUHISTORY CMD_MEMMAPZAP CMD_MEMMAPSHOW CMD_MEMMAPSAVE
 %token CMD_COMMENT CMD_LIST CMD_STOPWATCH RESET
 %token CMD_EXPORT CMD_AUTOSTART CMD_AUTOLOAD CMD_MAINCPU_TRACE
-%token CMD_WARP
+%token CMD_WARP CMD_REWIND
 %token CMD_PROFILE FLAT GRAPH FUNC DEPTH DISASS PROFILE_CONTEXT CLEAR
+%token SAMPLE FLAMEGRAPH CALLGRIND
 %token<str> CMD_LABEL_ASGN
 %token<i> L_PAREN R_PAREN ARG_IMMEDIATE REG_A REG_X REG_Y COMMA INST_SEP
 %token<i> L_BRACKET R_BRACKET LESS_THAN REG_U REG_S REG_PC REG_PCR
@@ -265,6 +266,10 @@ machine_state_rules: CMD_BANK end_cmd
                      { mon_write_snapshot($2,0,0,0); /* FIXME */ }
                    | CMD_UNDUMP filename end_cmd
                      { mon_read_snapshot($2, 0); }
+                   | CMD_REWIND end_cmd
+                     { mon_rewind(-1); }
+                   | CMD_REWIND opt_sep d_number end_cmd
+                     { mon_rewind($3); }
                    | CMD_STEP end_cmd
                      { mon_instructions_step(-1); }
                    | CMD_STEP opt_sep expression end_cmd
@@ -625,6 +630,12 @@ monitor_misc_rules: CMD_DISK rest_of_line end_cmd
                      { mon_profile_clear($3); }
                   | CMD_PROFILE PROFILE_CONTEXT d_number end_cmd
                      { mon_profile_disass_context($3); }
+                  | CMD_PROFILE SAMPLE opt_d_number end_cmd
+                     { mon_profile_sample($3); }
+                  | CMD_PROFILE FLAMEGRAPH STRING end_cmd
+                     { mon_profile_save_flamegraph($3); }
+                  | CMD_PROFILE CALLGRIND STRING end_cmd
+                     { mon_profile_save_callgrind($3); }
                   ;
 
 disk_rules: CMD_LOAD filename device_num opt_address end_cmd
@@ -29,6 +29,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "archdep.h"
 #include "lib.h"
 #include "machine.h"
 #include "maincpu.h"
@@ -1139,3 +1140,160 @@ void mon_profile_clear(MON_ADDR function)
     clear_recursively(root_context, addr);
 }
 
+
+
+void mon_profile_sample(int interval)
+{
+    if (interval > 0) {
+        profile_set_sample_interval((unsigned)interval);
+    }
+    if (profile_get_sample_interval() > 1) {
+        mon_out("Recording every %u. instruction.\n", profile_get_sample_interval());
+    } else {
+        mon_out("Recording every instruction.\n");
+    }
+}
+
+/* name of a context as used in the exported files; contexts entered by an
+ * interrupt are prefixed with its type so each handler shows up separately */
+static void write_context_name(FILE *fp, profiling_context_t *context)
+{
+    char *name;
+
+    if (context->parent == NULL) {
+        fprintf(fp, "START");
+        return;
+    }
+
+    switch (context->pc_src) {
+    case 0xfffa: fprintf(fp, "NMI "); break;
+    case 0xfffc: fprintf(fp, "RST "); break;
+    case 0xfffe: fprintf(fp, "IRQ "); break;
+    default: break;
+    }
+
+    name = mon_symbol_table_lookup_name(default_memspace, context->pc_dst);
+    if (name) {
+        fprintf(fp, "%s", name);
+    } else {
+        fprintf(fp, "%04x", context->pc_dst);
+    }
+}
+
+static void write_folded_frames(FILE *fp, profiling_context_t *context)
+{
+    if (context->parent) {
+        write_folded_frames(fp, context->parent);
+        fprintf(fp, ";");
+    }
+    write_context_name(fp, context);
+}
+
+static void write_folded_stacks(FILE *fp, profiling_context_t *context)
+{
+    if (context->total_cycles_self > 0) {
+        write_folded_frames(fp, context);
+        fprintf(fp, " %u\n", context->total_cycles_self);
+    }
+
+    if (context->child) {
+        profiling_context_t *c = context->child;
+        do {
+            write_folded_stacks(fp, c);
+            c = c->next;
+        } while (c != context->child);
+    }
+}
+
+/* Save the call graph as "folded stacks", one line per call stack with the
+ * cycles spent in its innermost function, as read by flamegraph.pl and
+ * compatible tools. */
+void mon_profile_save_flamegraph(const char *filename)
+{
+    FILE *fp;
+
+    if (!init_profiling_data()) return;
+
+    fp = fopen(filename, MODE_WRITE_TEXT);
+    if (fp == NULL) {
+        mon_out("Saving to `%s' failed.\n", filename);
+        return;
+    }
+    write_folded_stacks(fp, root_context);
+    fclose(fp);
+
+    mon_out("Flame graph stacks saved to `%s'.\n", filename);
+}
+
+static void write_callgrind_context(FILE *fp, profiling_context_t *context)
+{
+    profiling_context_t *c;
+    int i, j;
+
+    fprintf(fp, "fn=");
+    write_context_name(fp, context);
+    fprintf(fp, "\n");
+
+    /* self cost per instruction, for all memory configs */
+    for (c = context; c; c = c->next_mem_config) {
+        for (i = 0; i < 256; i++) {
+            if (c->page[i]) {
+                for (j = 0; j < 256; j++) {
+                    if (c->page[i]->data[j].num_cycles > 0) {
+                        fprintf(fp, "0x%04x %u\n", (unsigned)(i << 8 | j),
+                                (unsigned)c->page[i]->data[j].num_cycles);
+                    }
+                }
+            }
+        }
+    }
+
+    /* inclusive cost of the calls, at the JSR (or interrupt vector) */
+    if (context->child) {
+        c = context->child;
+        do {
+            fprintf(fp, "cfn=");
+            write_context_name(fp, c);
+            fprintf(fp, "\ncalls=%u 0x%04x\n", c->num_enters, (unsigned)c->pc_dst);
+            fprintf(fp, "0x%04x %u\n",
+                    (unsigned)(is_interrupt(c->pc_src) ? c->pc_src : (uint16_t)(c->pc_src - 2)),
+                    c->total_cycles);
+            c = c->next;
+        } while (c != context->child);
+    }
+    fprintf(fp, "\n");
+
+    if (context->child) {
+        c = context->child;
+        do {
+            write_callgrind_context(fp, c);
+            c = c->next;
+        } while (c != context->child);
+    }
+}
+
+/* Save the call graph in the callgrind format, for KCachegrind and other
+ * callgrind viewers; the instruction addresses are used as positions. */
+void mon_profile_save_callgrind(const char *filename)
+{
+    FILE *fp;
+
+    if (!init_profiling_data()) return;
+
+    fp = fopen(filename, MODE_WRITE_TEXT);
+    if (fp == NULL) {
+        mon_out("Saving to `%s' failed.\n", filename);
+        return;
+    }
+
+    fprintf(fp, "# callgrind format\n");
+    fprintf(fp, "version: 1\n");
+    fprintf(fp, "creator: VICE %s\n", machine_get_name());
+    fprintf(fp, "positions: instr\n");
+    fprintf(fp, "events: Cycles\n");
+    fprintf(fp, "summary: %u\n\n", root_context->total_cycles);
+    write_callgrind_context(fp, root_context);
+    fclose(fp);
+
+    mon_out("Callgrind profile saved to `%s'.\n", filename);
+}
@@ -37,5 +37,8 @@ void mon_profile_func(MON_ADDR function);
 void mon_profile_disass(MON_ADDR function);
 void mon_profile_clear(MON_ADDR function);
 void mon_profile_disass_context(int context_id);
+void mon_profile_sample(int interval);
+void mon_profile_save_flamegraph(const char *filename);
+void mon_profile_save_callgrind(const char *filename);
 
 #endif /* VICE_MON_PROFILE_H */
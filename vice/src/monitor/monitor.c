@@ -81,6 +81,7 @@
 #include "joyport.h"
 
 #include "resources.h"
+#include "rewind.h"
 #include "screenshot.h"
 #include "sysfile.h"
 #include "tape.h"
@@ -2849,13 +2850,28 @@ int mon_read_snapshot(const char *name, int even_mode)
     return ret;
 }
 
+int mon_rewind(int seconds)
+{
+    int ret;
+
+    ret = rewind_step_back(seconds < 0 ? 1.0 : (double)seconds);
+    if (ret < 0) {
+        mon_out("Rewind failed, is RewindEnable set?\n");
+    }
+
+    /* Reset the current address */
+    dot_addr[e_comp_space] = new_addr(e_comp_space, ((uint16_t)((monitor_cpu_for_memspace[e_comp_space]->mon_register_get_val)(e_comp_space, e_PC))));
+
+    return ret;
+}
+
 
 /* *** WATCHPOINTS *** */
 
 
 void monitor_watch_push_load_addr(uint16_t addr, MEMSPACE mem)
 {
-    if (inside_monitor) {
+    if (inside_monitor || !(mon_checkpoint_page_ops[mem][addr >> 8] & e_load)) {
         return;
     }
 
@@ -2870,7 +2886,7 @@ void monitor_watch_push_load_addr(uint16_t addr, MEMSPACE mem)
 
 void monitor_watch_push_store_addr(uint16_t addr, MEMSPACE mem)
 {
-    if (inside_monitor) {
+    if (inside_monitor || !(mon_checkpoint_page_ops[mem][addr >> 8] & e_store)) {
         return;
     }
 
@@ -2993,6 +3009,9 @@ void monitor_check_icount_interrupt(void)
  */
 int monitor_check_breakpoints(MEMSPACE mem, uint16_t addr)
 {
+    if (!(mon_checkpoint_page_ops[mem][addr >> 8] & e_exec)) {
+        return 0;
+    }
     return mon_breakpoint_check_checkpoint(mem, addr, 0, e_exec); /* FIXME */
 }
 
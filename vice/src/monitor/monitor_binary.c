@@ -84,6 +84,7 @@ enum t_binary_command {
 
     e_MON_CMD_MEM_GET = 0x01,
     e_MON_CMD_MEM_SET = 0x02,
+    e_MON_CMD_MEM_SUBSCRIBE = 0x03,
 
     e_MON_CMD_CHECKPOINT_GET = 0x11,
     e_MON_CMD_CHECKPOINT_SET = 0x12,
@@ -112,6 +113,9 @@ enum t_binary_command {
     e_MON_CMD_DISPLAY_GET = 0x84,
     e_MON_CMD_VICE_INFO = 0x85,
     e_MON_CMD_CPUHISTORY_GET = 0x86,
+    e_MON_CMD_DISPLAY_SUBSCRIBE = 0x87,
+    e_MON_CMD_UNSUBSCRIBE = 0x88,
+    e_MON_CMD_DISPLAY_ENCODING_SET = 0x8a,
 
     e_MON_CMD_PALETTE_GET = 0x91,
 
@@ -130,6 +134,8 @@ enum t_binary_response {
     e_MON_RESPONSE_INVALID = 0x00,
     e_MON_RESPONSE_MEM_GET = 0x01,
     e_MON_RESPONSE_MEM_SET = 0x02,
+    e_MON_RESPONSE_MEM_SUBSCRIBE = 0x03,
+    e_MON_RESPONSE_MEM_CHANGED = 0x04,
 
     e_MON_RESPONSE_CHECKPOINT_INFO = 0x11,
 
@@ -161,6 +167,10 @@ enum t_binary_response {
     e_MON_RESPONSE_DISPLAY_GET = 0x84,
     e_MON_RESPONSE_VICE_INFO = 0x85,
     e_MON_RESPONSE_CPUHISTORY_GET = 0x86,
+    e_MON_RESPONSE_DISPLAY_SUBSCRIBE = 0x87,
+    e_MON_RESPONSE_UNSUBSCRIBE = 0x88,
+    e_MON_RESPONSE_DISPLAY_CHANGED = 0x89,
+    e_MON_RESPONSE_DISPLAY_ENCODING_SET = 0x8a,
 
     e_MON_RESPONSE_PALETTE_GET = 0x91,
 
@@ -192,6 +202,17 @@ enum t_display_get_mode {
 };
 typedef enum t_display_get_mode DISPLAY_GET_MODE;
 
+/* Encodings of the display buffer sent by e_MON_CMD_DISPLAY_GET, set per
+   connection with e_MON_CMD_DISPLAY_ENCODING_SET */
+enum t_display_encoding {
+    /* only the rectangle that changed since the last frame sent */
+    e_DISPLAY_ENCODING_DIFF = 0x01,
+    /* PackBits run length encoded */
+    e_DISPLAY_ENCODING_RLE = 0x02,
+};
+
+#define DISPLAY_ENCODINGS_SUPPORTED (e_DISPLAY_ENCODING_DIFF | e_DISPLAY_ENCODING_RLE)
+
 enum t_mon_resource_type {
     e_MON_RESOURCE_TYPE_STRING = 0x00,
     e_MON_RESOURCE_TYPE_INT = 0x01,
@@ -207,6 +228,67 @@ struct binary_command_s {
 };
 typedef struct binary_command_s binary_command_t;
 
+enum t_subscription_type {
+    e_SUBSCRIPTION_MEM,
+    e_SUBSCRIPTION_DISPLAY,
+};
+typedef enum t_subscription_type SUBSCRIPTION_TYPE;
+
+/*! \internal \brief A memory range or display the client gets the changes of
+    while the machine runs */
+struct subscription_s {
+    uint32_t id;
+    SUBSCRIPTION_TYPE type;
+    /* frames between two checks, and frames left until the next one */
+    uint16_t interval;
+    uint16_t countdown;
+
+    /* e_SUBSCRIPTION_MEM */
+    MEMSPACE memspace;
+    int banknum;
+    uint16_t startaddress;
+    uint16_t endaddress;
+
+    /* e_SUBSCRIPTION_DISPLAY */
+    uint8_t use_vic;
+    DISPLAY_GET_MODE format;
+    unsigned int width;
+    unsigned int height;
+
+    /* contents as last sent to the client, NULL before the first event */
+    uint8_t *shadow;
+
+    struct subscription_s *next;
+};
+typedef struct subscription_s subscription_t;
+
+static subscription_t *subscriptions = NULL;
+static uint32_t subscription_id = 0;
+
+/* Received bytes not yet processed as commands; the commands are parsed
+   from here so that a client can send several of them at once. */
+static unsigned char *rx_buffer = NULL;
+static size_t rx_buffer_size = 0;
+static size_t rx_start = 0;
+static size_t rx_length = 0;
+
+#define RX_CHUNK_SIZE 4096
+
+/* Responses collected while a batch of commands is processed, sent at
+   once by monitor_binary_flush() */
+static unsigned char *tx_buffer = NULL;
+static size_t tx_buffer_size = 0;
+static size_t tx_length = 0;
+static int tx_batch = 0;
+
+static uint8_t display_encoding = 0;
+
+/* Last frame sent by e_MON_CMD_DISPLAY_GET, for e_DISPLAY_ENCODING_DIFF */
+static uint8_t *display_last = NULL;
+static unsigned int display_last_width = 0;
+static unsigned int display_last_height = 0;
+static uint8_t display_last_use_vic = 0;
+
 int monitor_binary_transmit(const unsigned char *buffer, size_t buffer_length)
 {
     int error = 0;
@@ -224,10 +306,60 @@ int monitor_binary_transmit(const unsigned char *buffer, size_t buffer_length)
     return error;
 }
 
+static void monitor_binary_subscriptions_free(void)
+{
+    while (subscriptions != NULL) {
+        subscription_t *next = subscriptions->next;
+
+        lib_free(subscriptions->shadow);
+        lib_free(subscriptions);
+        subscriptions = next;
+    }
+}
+
+static void monitor_binary_display_last_free(void)
+{
+    lib_free(display_last);
+    display_last = NULL;
+}
+
 static void monitor_binary_quit(void)
 {
     vice_network_socket_close(connected_socket);
     connected_socket = NULL;
+
+    monitor_binary_subscriptions_free();
+    monitor_binary_display_last_free();
+    display_encoding = 0;
+    rx_start = 0;
+    rx_length = 0;
+    tx_length = 0;
+}
+
+/*! \internal \brief Send a response, or queue it while a batch is processed */
+static void monitor_binary_queue(const unsigned char *buffer, size_t buffer_length)
+{
+    if (!tx_batch) {
+        monitor_binary_transmit(buffer, buffer_length);
+        return;
+    }
+
+    if (tx_length + buffer_length > tx_buffer_size) {
+        tx_buffer_size = (tx_length + buffer_length) * 2;
+        tx_buffer = lib_realloc(tx_buffer, tx_buffer_size);
+    }
+    memcpy(tx_buffer + tx_length, buffer, buffer_length);
+    tx_length += buffer_length;
+}
+
+/*! \internal \brief Send the queued responses and stop queueing */
+static void monitor_binary_flush(void)
+{
+    if (tx_length > 0) {
+        monitor_binary_transmit(tx_buffer, tx_length);
+        tx_length = 0;
+    }
+    tx_batch = 0;
 }
 
 ssize_t monitor_binary_receive(unsigned char *buffer, size_t buffer_length)
@@ -278,13 +410,6 @@ static int monitor_binary_data_available(void)
     return available;
 }
 
-void monitor_check_binary(void)
-{
-    if (monitor_binary_data_available()) {
-        monitor_startup_trap();
-    }
-}
-
 #define ASC_STX 0x02
 
 #define MON_BINARY_API_VERSION 0x02
@@ -349,10 +474,10 @@ static void monitor_binary_response(uint32_t length, BINARY_RESPONSE response_ty
     response[7] = (uint8_t)errorcode;
     write_uint32(request_id, &response[8]);
 
-    monitor_binary_transmit(response, sizeof response);
+    monitor_binary_queue(response, sizeof response);
 
     if (body != NULL) {
-        monitor_binary_transmit(body, length);
+        monitor_binary_queue(body, length);
     }
 }
 
@@ -1226,35 +1351,20 @@ static void monitor_binary_screenshot_line_data(screenshot_t *screenshot, uint8_
     );
 }
 
-static void monitor_binary_process_display_get(binary_command_t *command)
-{
-    screenshot_t screenshot;
-    struct video_canvas_s *canvas;
-    unsigned char *response, *response_cursor;
-    uint32_t response_length, buffer_length;
-    unsigned int i;
-    uint8_t depth = 8;
-
-    uint32_t info_length = 13;
+/*! \internal \brief Length of the display information written by write_display_info(), without FL */
+#define DISPLAY_INFO_LENGTH 13
 
-    uint8_t use_vic = !!command->body[0];
+/*! \internal \brief Take a screenshot of the VIC-II, or of the VDC on the C128
 
-    DISPLAY_GET_MODE format = command->body[1];
+ \param screenshot  screenshot to fill in, its lines are converted with
+                    screenshot->convert_line()
+ \param use_vic     use the VIC-II on the C128
 
-    if(command->api_version < 0x02) {
-        monitor_binary_error(e_MON_ERR_CMD_INVALID_API_VERSION, command->request_id);
-        return;
-    }
-
-    if(command->length < 2) {
-        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
-        return;
-    }
-
-    if(format != e_DISPLAY_GET_MODE_INDEXED8) {
-        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
-        return;
-    }
+ \return 0 on success, -1 on failure
+*/
+static int monitor_binary_screenshot(screenshot_t *screenshot, uint8_t use_vic)
+{
+    struct video_canvas_s *canvas;
 
     if (machine_class == VICE_MACHINE_C128 && use_vic) {
         canvas = machine_video_canvas_get(1);
@@ -1262,19 +1372,21 @@ static void monitor_binary_process_display_get(binary_command_t *command)
         canvas = machine_video_canvas_get(0);
     }
 
-    if(machine_screenshot(&screenshot, canvas) < 0) {
-        monitor_binary_error(e_MON_ERR_CMD_FAILURE, command->request_id);
-        return;
+    if(machine_screenshot(screenshot, canvas) < 0) {
+        return -1;
     }
 
-    screenshot.width = screenshot.max_width & ~3;
-    screenshot.height = screenshot.last_displayed_line - screenshot.first_displayed_line + 1;
-    screenshot.y_offset = screenshot.first_displayed_line;
+    screenshot->width = screenshot->max_width & ~3;
+    screenshot->height = screenshot->last_displayed_line - screenshot->first_displayed_line + 1;
+    screenshot->y_offset = screenshot->first_displayed_line;
+    screenshot->convert_line = monitor_binary_screenshot_line_data;
 
-    buffer_length = (screenshot.debug_width * screenshot.debug_height) * (depth / 8);
-    response_length = (4 + 4) + info_length + buffer_length;
-    response = lib_malloc(response_length);
-    response_cursor = response;
+    return 0;
+}
+
+/*! \internal \brief Write the display information (FL DW DH XO YO IW IH BP) and return pointer to byte after */
+static unsigned char *write_display_info(screenshot_t *screenshot, uint8_t depth, unsigned char *response_cursor)
+{
 /*
     4 FL: 4 bytes: Length of the fields before the display buffer (DW...BP)
 
@@ -1285,34 +1397,226 @@ static void monitor_binary_process_display_get(binary_command_t *command)
     2 IW: 2 bytes: Width of the inner part of the screen.
     2 IH: 2 bytes: Height of the inner part of the screen.
     1 BP: 1 byte: Bits per pixel of display buffer (=8)
-
-    4 BL: 4 bytes: Length of display buffer
-    followed by display buffer, debug width * debug height bytes
 */
     /* Length of fields before display buffer */
-    response_cursor = write_uint32(info_length, response_cursor);
+    response_cursor = write_uint32(DISPLAY_INFO_LENGTH, response_cursor);
 
     /* Full width of buffer */
-    response_cursor = write_uint16(screenshot.debug_width, response_cursor);
+    response_cursor = write_uint16(screenshot->debug_width, response_cursor);
     /* Full height of buffer */
-    response_cursor = write_uint16(screenshot.debug_height, response_cursor);
+    response_cursor = write_uint16(screenshot->debug_height, response_cursor);
     /* X offset of the inner part of the screen */
-    response_cursor = write_uint16(screenshot.debug_offset_x, response_cursor);
+    response_cursor = write_uint16(screenshot->debug_offset_x, response_cursor);
     /* Y offset of the inner part of the screen */
-    response_cursor = write_uint16(screenshot.debug_offset_y, response_cursor);
+    response_cursor = write_uint16(screenshot->debug_offset_y, response_cursor);
     /* Width of the inner part of the screen */
-    response_cursor = write_uint16(screenshot.inner_width, response_cursor);
+    response_cursor = write_uint16(screenshot->inner_width, response_cursor);
     /* Height of the inner part of the screen */
-    response_cursor = write_uint16(screenshot.inner_height, response_cursor);
+    response_cursor = write_uint16(screenshot->inner_height, response_cursor);
     /* Bits per pixel of image */
     *response_cursor = depth;
     response_cursor++;
 
+    return response_cursor;
+}
+
+/*! \internal \brief Compress with PackBits and return pointer to byte after
+
+ A control byte n of 0x00-0x7f is followed by n + 1 literal bytes; one of
+ 0x81-0xff is followed by one byte, which is repeated 257 - n times.
+
+ \param input   data to compress
+ \param length  length of \a input
+ \param output  compressed data, length + length / 128 + 1 bytes at most
+*/
+static unsigned char *write_packbits(const uint8_t *input, size_t length, unsigned char *output)
+{
+    size_t i = 0;
+
+    while (i < length) {
+        size_t run = 1;
+
+        while (i + run < length && run < 128 && input[i + run] == input[i]) {
+            run++;
+        }
+
+        if (run >= 3) {
+            *output++ = (uint8_t)(257 - run);
+            *output++ = input[i];
+            i += run;
+        } else {
+            /* literals up to the next run of three */
+            size_t start = i;
+
+            while (i < length && i - start < 128
+                   && !(i + 2 < length && input[i] == input[i + 1] && input[i] == input[i + 2])) {
+                i++;
+            }
+            *output++ = (uint8_t)(i - start - 1);
+            memcpy(output, &input[start], i - start);
+            output += i - start;
+        }
+    }
+
+    return output;
+}
+
+/*! \internal \brief Respond to e_MON_CMD_DISPLAY_GET with the negotiated display_encoding */
+static void monitor_binary_display_get_encoded(binary_command_t *command, screenshot_t *screenshot,
+                                               uint8_t use_vic, DISPLAY_GET_MODE format)
+{
+    unsigned char *response, *response_cursor, *buffer_cursor;
+    uint8_t *frame, *data;
+    unsigned int i;
+    unsigned int width = screenshot->debug_width;
+    unsigned int height = screenshot->debug_height;
+    /* rectangle sent, right and bottom exclusive */
+    unsigned int x0 = 0, y0 = 0, x1 = width, y1 = height;
+    size_t data_length;
+    uint8_t depth = 8;
+
+    frame = lib_malloc(width * height);
+    for (i = 0; i < height; i++) {
+        screenshot->convert_line(screenshot, frame + i * width, i, format);
+    }
+
+    if (display_encoding & e_DISPLAY_ENCODING_DIFF) {
+        if (display_last != NULL
+            && display_last_width == width
+            && display_last_height == height
+            && display_last_use_vic == use_vic) {
+            x0 = width;
+            y0 = height;
+            x1 = 0;
+            y1 = 0;
+            for (i = 0; i < height; i++) {
+                uint8_t *row = frame + i * width;
+                uint8_t *last_row = display_last + i * width;
+                unsigned int left = 0, right = width;
+
+                if (memcmp(row, last_row, width) == 0) {
+                    continue;
+                }
+                while (row[left] == last_row[left]) {
+                    left++;
+                }
+                while (row[right - 1] == last_row[right - 1]) {
+                    right--;
+                }
+                if (left < x0) {
+                    x0 = left;
+                }
+                if (right > x1) {
+                    x1 = right;
+                }
+                if (i < y0) {
+                    y0 = i;
+                }
+                y1 = i + 1;
+            }
+            if (y1 == 0) {
+                /* nothing changed */
+                x0 = y0 = x1 = y1 = 0;
+            }
+        }
+    }
+
+    data_length = (x1 - x0) * (y1 - y0);
+    if (x1 - x0 == width) {
+        data = frame + y0 * width;
+    } else {
+        data = lib_malloc(data_length + 1);
+        for (i = y0; i < y1; i++) {
+            memcpy(data + (i - y0) * (x1 - x0), frame + i * width + x0, x1 - x0);
+        }
+    }
+
+    response = lib_malloc((4 + 4) + DISPLAY_INFO_LENGTH + 8 + data_length + data_length / 128 + 1);
+    response_cursor = write_display_info(screenshot, depth, response);
+    buffer_cursor = response_cursor;
+    response_cursor += 4;
+
+    if (display_encoding & e_DISPLAY_ENCODING_DIFF) {
+        response_cursor = write_uint16(x0, response_cursor);
+        response_cursor = write_uint16(y0, response_cursor);
+        response_cursor = write_uint16(x1 - x0, response_cursor);
+        response_cursor = write_uint16(y1 - y0, response_cursor);
+    }
+    if (display_encoding & e_DISPLAY_ENCODING_RLE) {
+        response_cursor = write_packbits(data, data_length, response_cursor);
+    } else {
+        memcpy(response_cursor, data, data_length);
+        response_cursor += data_length;
+    }
+
     /* Length of display buffer */
+    write_uint32((uint32_t)(response_cursor - buffer_cursor - 4), buffer_cursor);
+
+    monitor_binary_response((uint32_t)(response_cursor - response), e_MON_RESPONSE_DISPLAY_GET, e_MON_ERR_OK, command->request_id, response);
+
+    if (x1 - x0 != width) {
+        lib_free(data);
+    }
+    if (display_encoding & e_DISPLAY_ENCODING_DIFF) {
+        lib_free(display_last);
+        display_last = frame;
+        display_last_width = width;
+        display_last_height = height;
+        display_last_use_vic = use_vic;
+    } else {
+        lib_free(frame);
+    }
+    lib_free(response);
+}
+
+static void monitor_binary_process_display_get(binary_command_t *command)
+{
+    screenshot_t screenshot;
+    unsigned char *response, *response_cursor;
+    uint32_t response_length, buffer_length;
+    unsigned int i;
+    uint8_t depth = 8;
+
+    uint8_t use_vic = !!command->body[0];
+
+    DISPLAY_GET_MODE format = command->body[1];
+
+    if(command->api_version < 0x02) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_API_VERSION, command->request_id);
+        return;
+    }
+
+    if(command->length < 2) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    if(format != e_DISPLAY_GET_MODE_INDEXED8) {
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        return;
+    }
+
+    if(monitor_binary_screenshot(&screenshot, use_vic) < 0) {
+        monitor_binary_error(e_MON_ERR_CMD_FAILURE, command->request_id);
+        return;
+    }
+
+    if (display_encoding != 0) {
+        monitor_binary_display_get_encoded(command, &screenshot, use_vic, format);
+        return;
+    }
+
+    buffer_length = (screenshot.debug_width * screenshot.debug_height) * (depth / 8);
+    response_length = (4 + 4) + DISPLAY_INFO_LENGTH + buffer_length;
+    response = lib_malloc(response_length);
+
+    response_cursor = write_display_info(&screenshot, depth, response);
+
+    /* 4 BL: 4 bytes: Length of display buffer
+       followed by display buffer, debug width * debug height bytes */
     response_cursor = write_uint32(buffer_length, response_cursor);
 
     /* Buffer Data in requested format */
-    screenshot.convert_line = monitor_binary_screenshot_line_data;
     for(i = 0; i < screenshot.debug_height; i++) {
         screenshot.convert_line(&screenshot, response_cursor, i, format);
         response_cursor += screenshot.debug_width * depth / 8;
@@ -1322,6 +1626,24 @@ static void monitor_binary_process_display_get(binary_command_t *command)
     lib_free(response);
 }
 
+static void monitor_binary_process_display_encoding_set(binary_command_t *command)
+{
+    unsigned char response[1];
+
+    if(command->length < 1) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    /* unsupported encodings are dropped, the client learns from the response */
+    display_encoding = command->body[0] & DISPLAY_ENCODINGS_SUPPORTED;
+    monitor_binary_display_last_free();
+
+    response[0] = display_encoding;
+
+    monitor_binary_response(1, e_MON_RESPONSE_DISPLAY_ENCODING_SET, e_MON_ERR_OK, command->request_id, response);
+}
+
 static void monitor_binary_process_palette_get(binary_command_t *command)
 {
     screenshot_t screenshot;
@@ -1758,6 +2080,279 @@ static void monitor_binary_process_mem_set(binary_command_t *command)
 }
 
 
+static subscription_t *monitor_binary_subscription_new(SUBSCRIPTION_TYPE type, uint16_t interval)
+{
+    subscription_t *sub = lib_calloc(1, sizeof(subscription_t));
+
+    sub->id = ++subscription_id;
+    sub->type = type;
+    sub->interval = interval;
+    sub->countdown = 0;
+    sub->shadow = NULL;
+
+    sub->next = subscriptions;
+    subscriptions = sub;
+
+    return sub;
+}
+
+static void monitor_binary_response_subscribe(BINARY_RESPONSE response_type, uint32_t request_id, subscription_t *sub)
+{
+    unsigned char response[4];
+
+    write_uint32(sub->id, response);
+
+    monitor_binary_response(4, response_type, e_MON_ERR_OK, request_id, response);
+}
+
+static void monitor_binary_process_mem_subscribe(binary_command_t *command)
+{
+    subscription_t *sub;
+    MEMSPACE memspace;
+
+    unsigned char *body = command->body;
+
+    uint16_t startaddress = little_endian_to_uint16(&body[0]);
+    uint16_t endaddress = little_endian_to_uint16(&body[2]);
+
+    uint8_t requested_memspace = body[4];
+    uint16_t requested_banknum = little_endian_to_uint16(&body[5]);
+
+    uint16_t interval = little_endian_to_uint16(&body[7]);
+
+    if (command->length < 9) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    if (startaddress > endaddress || interval == 0) {
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        return;
+    }
+
+    memspace = get_requested_memspace(requested_memspace);
+
+    if(memspace == e_invalid_space) {
+        monitor_binary_error(e_MON_ERR_INVALID_MEMSPACE, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary memsubscribe: Unknown memspace %u", requested_memspace);
+        return;
+    }
+
+    if (mon_banknum_validate(memspace, requested_banknum) == 0) {
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary memsubscribe: Unknown bank %u", requested_banknum);
+        return;
+    }
+
+    sub = monitor_binary_subscription_new(e_SUBSCRIPTION_MEM, interval);
+    sub->memspace = memspace;
+    sub->banknum = requested_banknum;
+    sub->startaddress = startaddress;
+    sub->endaddress = endaddress;
+
+    monitor_binary_response_subscribe(e_MON_RESPONSE_MEM_SUBSCRIBE, command->request_id, sub);
+}
+
+static void monitor_binary_process_display_subscribe(binary_command_t *command)
+{
+    subscription_t *sub;
+
+    uint8_t use_vic = !!command->body[0];
+
+    DISPLAY_GET_MODE format = command->body[1];
+
+    uint16_t interval = little_endian_to_uint16(&command->body[2]);
+
+    if(command->length < 4) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    if(format != e_DISPLAY_GET_MODE_INDEXED8 || interval == 0) {
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        return;
+    }
+
+    sub = monitor_binary_subscription_new(e_SUBSCRIPTION_DISPLAY, interval);
+    sub->use_vic = use_vic;
+    sub->format = format;
+
+    monitor_binary_response_subscribe(e_MON_RESPONSE_DISPLAY_SUBSCRIBE, command->request_id, sub);
+}
+
+static void monitor_binary_process_unsubscribe(binary_command_t *command)
+{
+    subscription_t **link;
+    uint32_t id = little_endian_to_uint32(command->body);
+
+    if (command->length < 4) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    for (link = &subscriptions; *link != NULL; link = &(*link)->next) {
+        subscription_t *sub = *link;
+
+        if (sub->id == id) {
+            *link = sub->next;
+            lib_free(sub->shadow);
+            lib_free(sub);
+
+            monitor_binary_response(0, e_MON_RESPONSE_UNSUBSCRIBE, e_MON_ERR_OK, command->request_id, NULL);
+            return;
+        }
+    }
+
+    monitor_binary_error(e_MON_ERR_OBJECT_MISSING, command->request_id);
+}
+
+/*! \internal \brief Unchanged bytes up to which two changed runs are sent as one */
+#define MEM_RUN_GAP 4
+
+/*! \internal \brief Send the bytes of a memory subscription that changed since the last event */
+static void monitor_binary_stream_mem(subscription_t *sub)
+{
+    unsigned char *response, *response_cursor, *runs_cursor;
+    uint8_t *current;
+    uint16_t runs = 0;
+    unsigned int length = (sub->endaddress + 1) - sub->startaddress;
+    unsigned int i = 0;
+    int old_sidefx = sidefx;
+
+    if (sub->memspace != e_comp_space) {
+        drive_catch_up_hook(maincpu_clk);
+    }
+
+    current = lib_malloc(length);
+    sidefx = 0;
+    mon_get_mem_block_ex(sub->memspace, sub->banknum, sub->startaddress, sub->endaddress - sub->startaddress, current);
+    sidefx = old_sidefx;
+
+    /* every run takes at least one changed byte and MEM_RUN_GAP + 1 unchanged ones */
+    response = lib_malloc(4 + 2 + length + 4 * (length / (MEM_RUN_GAP + 2) + 1));
+    response_cursor = write_uint32(sub->id, response);
+    runs_cursor = response_cursor;
+    response_cursor += 2;
+
+    while (i < length) {
+        unsigned int start, end, j;
+
+        if (sub->shadow != NULL && current[i] == sub->shadow[i]) {
+            i++;
+            continue;
+        }
+
+        start = i;
+        end = i + 1;
+        for (j = i + 1; j < length && j - start < 0xffff; j++) {
+            if (sub->shadow == NULL || current[j] != sub->shadow[j]) {
+                end = j + 1;
+            } else if (j + 1 - end > MEM_RUN_GAP) {
+                break;
+            }
+        }
+
+        response_cursor = write_uint16((uint16_t)(sub->startaddress + start), response_cursor);
+        response_cursor = write_uint16((uint16_t)(end - start), response_cursor);
+        memcpy(response_cursor, &current[start], end - start);
+        response_cursor += end - start;
+        runs++;
+
+        i = end;
+    }
+
+    if (runs > 0) {
+        write_uint16(runs, runs_cursor);
+        monitor_binary_response((uint32_t)(response_cursor - response), e_MON_RESPONSE_MEM_CHANGED, e_MON_ERR_OK, MON_EVENT_ID, response);
+    }
+
+    lib_free(sub->shadow);
+    sub->shadow = current;
+    lib_free(response);
+}
+
+/*! \internal \brief Send the rows of a display subscription that changed since the last event */
+static void monitor_binary_stream_display(subscription_t *sub)
+{
+    screenshot_t screenshot;
+    unsigned char *response, *response_cursor, *rows_cursor;
+    unsigned int i, row_length;
+    uint16_t rows = 0;
+    int resized;
+    uint8_t depth = 8;
+
+    if (monitor_binary_screenshot(&screenshot, sub->use_vic) < 0) {
+        return;
+    }
+
+    row_length = screenshot.debug_width * depth / 8;
+
+    /* all rows are sent after the dimensions changed */
+    resized = sub->shadow == NULL
+              || sub->width != screenshot.debug_width
+              || sub->height != screenshot.debug_height;
+    if (resized) {
+        sub->width = screenshot.debug_width;
+        sub->height = screenshot.debug_height;
+        lib_free(sub->shadow);
+        sub->shadow = lib_malloc(row_length * sub->height);
+    }
+
+    response = lib_malloc(4 + (4 + DISPLAY_INFO_LENGTH) + 2 + (2 + row_length) * sub->height);
+    response_cursor = write_uint32(sub->id, response);
+    response_cursor = write_display_info(&screenshot, depth, response_cursor);
+    rows_cursor = response_cursor;
+    response_cursor += 2;
+
+    for (i = 0; i < sub->height; i++) {
+        uint8_t *row = response_cursor + 2;
+        uint8_t *shadow_row = sub->shadow + i * row_length;
+
+        screenshot.convert_line(&screenshot, row, i, sub->format);
+        if (resized || memcmp(row, shadow_row, row_length) != 0) {
+            memcpy(shadow_row, row, row_length);
+            write_uint16((uint16_t)i, response_cursor);
+            response_cursor += 2 + row_length;
+            rows++;
+        }
+    }
+
+    if (rows > 0) {
+        write_uint16(rows, rows_cursor);
+        monitor_binary_response((uint32_t)(response_cursor - response), e_MON_RESPONSE_DISPLAY_CHANGED, e_MON_ERR_OK, MON_EVENT_ID, response);
+    }
+
+    lib_free(response);
+}
+
+/*! \internal \brief Check the subscriptions that are due and send their changes */
+static void monitor_binary_stream_subscriptions(void)
+{
+    subscription_t *sub;
+
+    for (sub = subscriptions; sub != NULL; sub = sub->next) {
+        if (sub->countdown > 0) {
+            sub->countdown--;
+            continue;
+        }
+        sub->countdown = sub->interval - 1;
+
+        if (sub->type == e_SUBSCRIPTION_MEM) {
+            monitor_binary_stream_mem(sub);
+        } else {
+            monitor_binary_stream_display(sub);
+        }
+    }
+}
+
+/*! \internal \brief Commands that are answered without stopping the machine */
+static int monitor_binary_command_is_async(BINARY_COMMAND command_type)
+{
+    return command_type == e_MON_CMD_MEM_SUBSCRIBE
+        || command_type == e_MON_CMD_DISPLAY_SUBSCRIBE
+        || command_type == e_MON_CMD_UNSUBSCRIBE;
+}
+
 static void monitor_binary_process_command(unsigned char * pbuffer)
 {
     BINARY_COMMAND command_type;
@@ -1791,6 +2386,8 @@ static void monitor_binary_process_command(unsigned char * pbuffer)
         monitor_binary_process_mem_get(&command);
     } else if (command_type == e_MON_CMD_MEM_SET) {
         monitor_binary_process_mem_set(&command);
+    } else if (command_type == e_MON_CMD_MEM_SUBSCRIBE) {
+        monitor_binary_process_mem_subscribe(&command);
 
     } else if (command_type == e_MON_CMD_CHECKPOINT_GET) {
         monitor_binary_process_checkpoint_get(&command);
@@ -1847,6 +2444,12 @@ static void monitor_binary_process_command(unsigned char * pbuffer)
         monitor_binary_process_vice_info(&command);
     } else if (command_type == e_MON_CMD_CPUHISTORY_GET) {
         monitor_binary_process_cpuhistory(&command);
+    } else if (command_type == e_MON_CMD_DISPLAY_SUBSCRIBE) {
+        monitor_binary_process_display_subscribe(&command);
+    } else if (command_type == e_MON_CMD_UNSUBSCRIBE) {
+        monitor_binary_process_unsubscribe(&command);
+    } else if (command_type == e_MON_CMD_DISPLAY_ENCODING_SET) {
+        monitor_binary_process_display_encoding_set(&command);
 
     } else if (command_type == e_MON_CMD_EXIT) {
         monitor_binary_process_exit(&command);
@@ -1868,6 +2471,79 @@ static void monitor_binary_process_command(unsigned char * pbuffer)
     pbuffer[0] = 0;
 }
 
+/*! \internal \brief Append the data waiting on the socket to the receive buffer
+
+ Must only be called when monitor_binary_data_available() reports data, so
+ that it does not block.
+
+ \return 0 on success, -1 if the connection was closed
+*/
+static int monitor_binary_fill(void)
+{
+    ssize_t n;
+
+    if (rx_start > 0) {
+        memmove(rx_buffer, rx_buffer + rx_start, rx_length);
+        rx_start = 0;
+    }
+    if (rx_buffer_size - rx_length < RX_CHUNK_SIZE) {
+        rx_buffer_size = rx_length + RX_CHUNK_SIZE;
+        rx_buffer = lib_realloc(rx_buffer, rx_buffer_size);
+    }
+
+    n = vice_network_receive(connected_socket, rx_buffer + rx_length, rx_buffer_size - rx_length, 0);
+    if (n <= 0) {
+        log_message(LOG_DEFAULT,
+                    "monitor_binary_fill(): vice_network_receive() returned %"PRI_SSIZE_T", breaking connection",
+                    n);
+        monitor_binary_quit();
+        return -1;
+    }
+
+    rx_length += n;
+    return 0;
+}
+
+static void monitor_binary_consume(size_t size)
+{
+    rx_start += size;
+    rx_length -= size;
+}
+
+/*! \internal \brief Find the next complete command in the receive buffer
+
+ Anything in front of it that cannot be the start of a command is dropped.
+
+ \return size of the command at rx_buffer + rx_start, or 0 if it has not
+         been received completely yet
+*/
+static size_t monitor_binary_next_command(void)
+{
+    while (rx_length > 0) {
+        unsigned char *command = rx_buffer + rx_start;
+        unsigned char *next;
+
+        if (command[0] == ASC_STX
+            && (rx_length < 2 || (command[1] >= 0x01 && command[1] <= 0x02))) {
+            uint32_t body_length;
+
+            if (rx_length < 11) {
+                return 0;
+            }
+            body_length = little_endian_to_uint32(&command[2]);
+            if (body_length > rx_length - 11) {
+                return 0;
+            }
+            return 11 + (size_t)body_length;
+        }
+
+        next = memchr(command + 1, ASC_STX, rx_length - 1);
+        monitor_binary_consume(next != NULL ? (size_t)(next - command) : rx_length);
+    }
+
+    return 0;
+}
+
 static int monitor_binary_activate(void)
 {
     vice_network_socket_address_t * server_addr = NULL;
@@ -1900,83 +2576,80 @@ static int monitor_binary_activate(void)
     return error;
 }
 
-int monitor_binary_get_command_line(void)
-{
-    static size_t buffer_size = 0;
-    static unsigned char *buffer;
+/*! \brief Process the commands received while the machine runs
 
-    while (monitor_binary_data_available()) {
-        uint32_t body_length;
-        uint8_t api_version;
-        unsigned int remaining_header_size = 5;
-        unsigned int command_size;
-        ssize_t n;
+ Called once a frame. Subscription commands are answered right away; the
+ first command that needs the machine stopped makes the monitor open, which
+ then processes it and everything received after it. Finally the changes of
+ the subscriptions that are due are sent.
+*/
+void monitor_check_binary(void)
+{
+    size_t size;
 
-        if (!buffer) {
-            buffer = lib_malloc(300);
-            buffer_size = 300;
+    if (monitor_binary_data_available()) {
+        if (monitor_binary_fill() < 0) {
+            return;
         }
+    }
 
-        n = monitor_binary_receive(buffer, 1);
-        if (n == 0) {
-            monitor_binary_quit();
-            return 0;
-        } else if (n < 0) {
-            monitor_binary_quit();
-            return 0;
-        }
+    tx_batch = 1;
 
-        if (buffer[0] != ASC_STX) {
-            continue;
+    while ((size = monitor_binary_next_command()) > 0) {
+        unsigned char *command = rx_buffer + rx_start;
+
+        if (!monitor_binary_command_is_async(command[10])) {
+            monitor_startup_trap();
+            break;
         }
+        monitor_binary_process_command(command);
+        monitor_binary_consume(size);
+    }
 
-        n = 0;
+    monitor_binary_stream_subscriptions();
 
-        while (n < sizeof(api_version) + sizeof(body_length)) {
-            ssize_t o = monitor_binary_receive(&buffer[1 + n], (sizeof(api_version) + sizeof(body_length)) - n);
-            if (o <= 0) {
-                monitor_binary_quit();
-                return 0;
-            }
+    monitor_binary_flush();
+}
 
-            n += o;
-        }
+/*! \brief Check if a complete command is waiting in the receive buffer
 
-        api_version = buffer[1];
-        body_length = little_endian_to_uint32(&buffer[2]);
+ Such a command is not signalled by the socket anymore, so the monitor must
+ not wait for it to become readable.
+*/
+int monitor_binary_command_pending(void)
+{
+    return monitor_binary_next_command() > 0;
+}
 
-        if (api_version >= 0x01 && api_version <= 0x02) {
-            remaining_header_size = 5;
-        } else {
-            continue;
-        }
+/*! \brief Process all commands received so far while the monitor is open
 
-        command_size = sizeof(api_version) + sizeof(body_length) + remaining_header_size + body_length + 1;
-        if (!buffer || buffer_size < command_size + 1) {
-            buffer = lib_realloc(buffer, command_size + 1);
-            buffer_size = command_size + 1;
-        }
+ The responses are collected and sent at once, so that a client can send a
+ batch of commands and have it answered within one stop.
+
+ \return 0 if the monitor is to be left or the connection was closed, else 1
+*/
+int monitor_binary_get_command_line(void)
+{
+    size_t size;
+
+    tx_batch = 1;
 
-        n = 0;
+    do {
+        while ((size = monitor_binary_next_command()) > 0) {
+            monitor_binary_process_command(rx_buffer + rx_start);
+            monitor_binary_consume(size);
 
-        while (n < remaining_header_size + body_length) {
-            ssize_t o = monitor_binary_receive(&buffer[6 + n], remaining_header_size + body_length - n);
-            if (o <= 0) {
-                monitor_binary_quit();
+            if (exit_mon != exit_mon_no) {
+                /* the remaining commands are processed after the next stop */
+                monitor_binary_flush();
                 return 0;
             }
-
-            n += o;
         }
+    } while (monitor_binary_data_available() && monitor_binary_fill() == 0);
 
-        monitor_binary_process_command(buffer);
-
-        if (exit_mon != exit_mon_no) {
-            return 0;
-        }
-    }
+    monitor_binary_flush();
 
-    return 1;
+    return connected_socket != NULL;
 }
 
 static int monitor_binary_deactivate(void)
@@ -2162,6 +2835,11 @@ int monitor_binary_get_command_line(void)
     return 0;
 }
 
+int monitor_binary_command_pending(void)
+{
+    return 0;
+}
+
 int monitor_is_binary(void)
 {
     return 0;
@@ -44,6 +44,7 @@
 #include "archdep.h"
 #include "cmdline.h"
 #include "interrupt.h"
+#include "keyboard.h"
 #include "lib.h"
 #include "log.h"
 #include "machine.h"
@@ -51,6 +52,7 @@
 #include "mos6510.h"
 #include "network.h"
 #include "resources.h"
+#include "snapshot.h"
 #include "types.h"
 #include "uiapi.h"
 #include "util.h"
@@ -91,6 +93,79 @@ static int current_frame, frame_to_play;
 static event_list_state_t *frame_event_list = NULL;
 static char *snapshotfilename;
 
+/* Rollback mode: instead of waiting for the remote input of every frame,
+   the remote input is predicted to stay unchanged and the emulation runs
+   ahead by up to `rollback_window' frames. The machine state is kept for
+   the start of each of these frames; when the remote input for a frame
+   turns out to differ from the prediction, the state of that frame is
+   restored and the frames up to the present are emulated again in warp
+   mode. The window is taken from the server's NetworkRollbackFrames.
+
+   The state is a full in-memory snapshot per frame rather than a delta:
+   for x64sc with a true drive 1541 that is about 190 KiB and 26 us a
+   frame, and restoring one takes about 2 ms, which is only paid on a
+   misprediction.  */
+
+#define NETWORK_ROLLBACK_MAX 30
+
+/* Local input is applied this many frames after it was recorded, so that
+   it usually reaches the remote host in time and no rollback is needed.  */
+#define ROLLBACK_INPUT_DELAY 1
+
+/* Number of frames the input history reaches back and ahead.  */
+#define ROLLBACK_HISTORY     128
+
+#define ROLLBACK_SYNC_SIZE   (5 * 4)
+
+/* Seconds to wait for the remote input before disconnecting.  */
+#define ROLLBACK_TIMEOUT     10
+
+typedef struct rollback_frame_s {
+    int frame;                  /* frame this entry belongs to, -1 if unused */
+    uint8_t *local_input;       /* event buffers, NULL if empty or unknown */
+    uint8_t *remote_input;
+    int predicted;              /* emulated before the remote input arrived */
+    int local_sync_valid;
+    int remote_sync_valid;
+    uint8_t local_sync[ROLLBACK_SYNC_SIZE];
+    uint8_t remote_sync[ROLLBACK_SYNC_SIZE];
+} rollback_frame_t;
+
+static int rollback_frames;     /* NetworkRollbackFrames */
+static int rollback_window = 0; /* in use for this connection, 0: lockstep */
+static int rollback_frame;      /* frame currently emulated */
+static int rollback_live_frame; /* newest frame that has been emulated */
+static int rollback_confirmed;  /* remote input is known up to this frame */
+static int rollback_target;     /* frame to roll back to, -1 if none */
+static int rollback_sync_frame; /* newest frame with known correct state */
+static int rollback_resimulating;
+static int rollback_saved_warp;
+static unsigned long rollback_count;
+static unsigned long rollback_resimulated;
+static rollback_frame_t *rollback_history = NULL;
+static snapshot_memory_t rollback_states[NETWORK_ROLLBACK_MAX + 1];
+static int rollback_state_frame[NETWORK_ROLLBACK_MAX + 1];
+static event_list_state_t rollback_local_list;
+
+/* Artificial latency and jitter of outgoing frame packets, for testing
+   netplay on a single host. Packets are kept in a queue until they are due,
+   and never overtake each other, just like on a TCP connection.  */
+
+typedef struct delayed_packet_s {
+    tick_t due;
+    uint8_t *buf;
+    size_t len;
+    struct delayed_packet_s *next;
+} delayed_packet_t;
+
+static int network_latency;
+static int network_jitter;
+static delayed_packet_t *delay_queue_head = NULL;
+static delayed_packet_t *delay_queue_tail = NULL;
+static uint32_t jitter_state = 0x2545f491;
+
+static network_mode_t network_start_mode = NETWORK_IDLE;
+
 static int set_server_name(const char *val, void *param)
 {
     util_string_set(&server_name, val);
@@ -126,6 +201,39 @@ static int set_network_control(int val, void *param)
     return 0;
 }
 
+static int set_rollback_frames(int val, void *param)
+{
+    if (val < 0 || val > NETWORK_ROLLBACK_MAX) {
+        return -1;
+    }
+
+    rollback_frames = val;
+
+    return 0;
+}
+
+static int set_network_latency(int val, void *param)
+{
+    if (val < 0 || val > 5000) {
+        return -1;
+    }
+
+    network_latency = val;
+
+    return 0;
+}
+
+static int set_network_jitter(int val, void *param)
+{
+    if (val < 0 || val > 5000) {
+        return -1;
+    }
+
+    network_jitter = val;
+
+    return 0;
+}
+
 /*---------- Resources ------------------------------------------------*/
 
 static const resource_string_t resources_string[] = {
@@ -141,6 +249,12 @@ static const resource_int_t resources_int[] = {
       &res_server_port, set_server_port, NULL },
     { "NetworkControl", NETWORK_CONTROL_DEFAULT, RES_EVENT_SAME, NULL,
       &network_control, set_network_control, NULL },
+    { "NetworkRollbackFrames", 0, RES_EVENT_NO, NULL,
+      &rollback_frames, set_rollback_frames, NULL },
+    { "NetworkLatency", 0, RES_EVENT_NO, NULL,
+      &network_latency, set_network_latency, NULL },
+    { "NetworkJitter", 0, RES_EVENT_NO, NULL,
+      &network_jitter, set_network_jitter, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -211,6 +325,19 @@ static int network_control_cmd(const char *param, void *extra_param)
     return 0;
 }
 
+static int network_start_cmd(const char *param, void *extra_param)
+{
+    if (strcmp(param, "server") == 0) {
+        network_start_mode = NETWORK_SERVER;
+    } else if (strcmp(param, "client") == 0) {
+        network_start_mode = NETWORK_CLIENT;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
 static const cmdline_option_t cmdline_options[] =
 {
     { "-netplayserver", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
@@ -225,6 +352,18 @@ static const cmdline_option_t cmdline_options[] =
     { "-netplayctrl", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
       network_control_cmd, NULL, NULL, NULL,
       "<key,joy1,joy2,dev,rsrc>", "Set the netplay control elements (keyboard, joystick1, joystick2, devices and resources), each item takes a value (0: None, 1: Server, 2: Client, 3: Both)" },
+    { "-netplayrollback", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "NetworkRollbackFrames", NULL,
+      "<frames>", "Set how many frames the emulation may run ahead of the remote input, rolling back on misprediction (0: lockstep, up to 30; taken from the server)" },
+    { "-netplaylatency", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "NetworkLatency", NULL,
+      "<ms>", "Delay outgoing netplay frames by <ms> milliseconds, for testing" },
+    { "-netplayjitter", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "NetworkJitter", NULL,
+      "<ms>", "Vary the delay of outgoing netplay frames by up to <ms> milliseconds, for testing" },
+    { "-netplaystart", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      network_start_cmd, NULL, NULL, NULL,
+      "<server|client>", "Start a netplay server, or connect to it as a client, right after startup" },
     CMDLINE_LIST_END
 };
 
@@ -250,15 +389,20 @@ static void network_free_frame_event_list(void)
     event_destroy_image_list();
 }
 
-static void network_event_record_sync_test(uint16_t addr, void *data)
+static void network_get_sync_regs(uint8_t *regbuf)
 {
-    uint8_t regbuf[5 * 4];
-    DBGT(("network_event_record_sync_test"));
     util_dword_to_le_buf(&regbuf[0 * 4], (uint32_t)(maincpu_get_pc()));
     util_dword_to_le_buf(&regbuf[1 * 4], (uint32_t)(maincpu_get_a()));
     util_dword_to_le_buf(&regbuf[2 * 4], (uint32_t)(maincpu_get_x()));
     util_dword_to_le_buf(&regbuf[3 * 4], (uint32_t)(maincpu_get_y()));
     util_dword_to_le_buf(&regbuf[4 * 4], (uint32_t)(maincpu_get_sp()));
+}
+
+static void network_event_record_sync_test(uint16_t addr, void *data)
+{
+    uint8_t regbuf[5 * 4];
+    DBGT(("network_event_record_sync_test"));
+    network_get_sync_regs(regbuf);
 
     network_event_record(EVENT_SYNC_TEST, (void *)regbuf, sizeof(regbuf));
 }
@@ -361,17 +505,28 @@ static event_list_state_t *network_create_event_list(uint8_t *remote_event_buffe
     return list;
 }
 
+static int network_delay_flush(void);
+
 static ssize_t network_recv_buffer(vice_network_socket_t * s, uint8_t *buf, ssize_t len)
 {
     ssize_t t;
     ssize_t received_total = 0;
 
     DBGT(("network_recv_buffer len: %"PRI_SSIZE_T, len));
+
+    /* keep delayed packets going out while waiting, the remote host might
+       be waiting for them as well */
+    while (delay_queue_head != NULL && vice_network_select_poll_one(s) == 0) {
+        network_delay_flush();
+        tick_sleep(tick_per_second() / 1000);
+    }
+
     while (received_total < len) {
         t = vice_network_receive(s, buf, len - received_total, 0);
 
-        if (t < 0) {
-            return t;
+        if (t <= 0) {
+            /* 0 means the connection was closed */
+            return -1;
         }
 
         received_total += t;
@@ -405,6 +560,158 @@ static ssize_t network_send_buffer(vice_network_socket_t * s, const uint8_t *buf
     return 0;
 }
 
+/* send all delayed packets that are due, returns -1 on error */
+static int network_delay_flush(void)
+{
+    delayed_packet_t *p;
+    int ret = 0;
+
+    while (delay_queue_head != NULL
+           && (int32_t)(tick_now() - delay_queue_head->due) >= 0) {
+        p = delay_queue_head;
+        if (ret == 0 && network_send_buffer(network_socket, p->buf, (ssize_t)p->len) < 0) {
+            ret = -1;
+        }
+        delay_queue_head = p->next;
+        lib_free(p->buf);
+        lib_free(p);
+    }
+    if (delay_queue_head == NULL) {
+        delay_queue_tail = NULL;
+    }
+    return ret;
+}
+
+static void network_delay_clear(void)
+{
+    delayed_packet_t *p;
+
+    while (delay_queue_head != NULL) {
+        p = delay_queue_head;
+        delay_queue_head = p->next;
+        lib_free(p->buf);
+        lib_free(p);
+    }
+    delay_queue_tail = NULL;
+}
+
+/* Send a frame packet, which is its length followed by the data, right away
+   or after the artificial latency. Returns -1 on error.  */
+static int network_send_packet(const uint8_t *buf, unsigned int len)
+{
+    delayed_packet_t *p;
+    uint8_t *packet;
+    int delay;
+
+    packet = lib_malloc(len + 4);
+    util_int_to_le_buf4(packet, (int)len);
+    if (len > 0) {
+        memcpy(packet + 4, buf, len);
+    }
+
+    if (network_latency == 0 && network_jitter == 0 && delay_queue_head == NULL) {
+        int ret = network_send_buffer(network_socket, packet, len + 4) < 0 ? -1 : 0;
+
+        lib_free(packet);
+        return ret;
+    }
+
+    delay = network_latency;
+    if (network_jitter > 0) {
+        /* private generator, lib_unsigned_rand() must stay in sync between
+           the hosts */
+        jitter_state ^= jitter_state << 13;
+        jitter_state ^= jitter_state >> 17;
+        jitter_state ^= jitter_state << 5;
+        delay += (int)(jitter_state % (uint32_t)(2 * network_jitter + 1)) - network_jitter;
+        if (delay < 0) {
+            delay = 0;
+        }
+    }
+
+    p = lib_malloc(sizeof(delayed_packet_t));
+    p->due = tick_now() + (tick_t)delay * (tick_per_second() / 1000);
+    p->buf = packet;
+    p->len = len + 4;
+    p->next = NULL;
+    if (delay_queue_tail != NULL) {
+        if ((int32_t)(p->due - delay_queue_tail->due) < 0) {
+            p->due = delay_queue_tail->due;
+        }
+        delay_queue_tail->next = p;
+    } else {
+        delay_queue_head = p;
+    }
+    delay_queue_tail = p;
+
+    return network_delay_flush();
+}
+
+/*---------------------------------------------------------------------*/
+
+static void network_rollback_init(void)
+{
+    int i;
+
+    DBG(("network_rollback_init"));
+    rollback_history = lib_malloc(sizeof(rollback_frame_t) * ROLLBACK_HISTORY);
+    memset(rollback_history, 0, sizeof(rollback_frame_t) * ROLLBACK_HISTORY);
+    for (i = 0; i < ROLLBACK_HISTORY; i++) {
+        rollback_history[i].frame = -1;
+    }
+    for (i = 0; i <= NETWORK_ROLLBACK_MAX; i++) {
+        rollback_state_frame[i] = -1;
+    }
+    event_register_event_list(&rollback_local_list);
+    event_init_image_list();
+
+    rollback_frame = 0;
+    rollback_live_frame = 0;
+    /* no input is sent for the frames before the input delay */
+    rollback_confirmed = ROLLBACK_INPUT_DELAY;
+    rollback_target = -1;
+    rollback_sync_frame = -1;
+    rollback_resimulating = 0;
+    rollback_count = 0;
+    rollback_resimulated = 0;
+}
+
+static void network_rollback_free(void)
+{
+    int i;
+
+    if (rollback_history == NULL) {
+        return;
+    }
+
+    DBG(("network_rollback_free"));
+    log_message(LOG_DEFAULT, "netplay: %lu rollbacks, %lu frames emulated again.",
+                rollback_count, rollback_resimulated);
+
+    for (i = 0; i < ROLLBACK_HISTORY; i++) {
+        lib_free(rollback_history[i].local_input);
+        lib_free(rollback_history[i].remote_input);
+    }
+    lib_free(rollback_history);
+    rollback_history = NULL;
+
+    for (i = 0; i <= NETWORK_ROLLBACK_MAX; i++) {
+        lib_free(rollback_states[i].data);
+        rollback_states[i].data = NULL;
+        rollback_states[i].size = rollback_states[i].alloc = 0;
+    }
+
+    event_clear_list(&rollback_local_list);
+    rollback_local_list.base = NULL;
+    event_destroy_image_list();
+
+    if (rollback_resimulating) {
+        vsync_set_warp_mode(rollback_saved_warp);
+        rollback_resimulating = 0;
+    }
+    rollback_window = 0;
+}
+
 #define NUM_OF_TESTPACKETS 50
 
 typedef struct {
@@ -416,6 +723,7 @@ static int network_test_delay(void)
 {
     int i, j, ret = -1;
     uint8_t new_frame_delta = 5; /* default to use on error */
+    uint8_t new_rollback_window = 0;
     unsigned char *buf;
     testpacket pkt;
 
@@ -462,6 +770,10 @@ static int network_test_delay(void)
         if (network_send_buffer(network_socket, &new_frame_delta, sizeof(new_frame_delta)) < 0) {
             goto exiterror;
         }
+        new_rollback_window = (uint8_t)rollback_frames;
+        if (network_send_buffer(network_socket, &new_rollback_window, sizeof(new_rollback_window)) < 0) {
+            goto exiterror;
+        }
     } else {
         DBG(("network_test_delay (client)"));
         /* network_mode == NETWORK_CLIENT */
@@ -474,14 +786,24 @@ static int network_test_delay(void)
         }
         network_recv_buffer(network_socket, &new_frame_delta,
                             sizeof(new_frame_delta));
+        network_recv_buffer(network_socket, &new_rollback_window,
+                            sizeof(new_rollback_window));
     }
     ret = 0;
 exiterror:
     network_free_frame_event_list();
+    network_rollback_free();
     frame_delta = new_frame_delta;
-    network_init_frame_event_list();
-    sprintf(st, "Using %d frames delay.", frame_delta);
-    log_debug(LOG_DEFAULT, "netplay connected with %d frames delta.", frame_delta);
+    if (new_rollback_window > 0 && new_rollback_window <= NETWORK_ROLLBACK_MAX) {
+        rollback_window = new_rollback_window;
+        network_rollback_init();
+        sprintf(st, "Using rollback over up to %d frames.", rollback_window);
+        log_debug(LOG_DEFAULT, "netplay connected with rollback over %d frames.", rollback_window);
+    } else {
+        network_init_frame_event_list();
+        sprintf(st, "Using %d frames delay.", frame_delta);
+        log_debug(LOG_DEFAULT, "netplay connected with %d frames delta.", frame_delta);
+    }
     ui_display_statustext(st, true);
     return ret;
 }
@@ -667,6 +989,19 @@ void network_event_record(unsigned int type, void *data, unsigned int size)
         return;
     }
 
+    if (rollback_window > 0) {
+        if (type == EVENT_JOYSTICK_DELAY) {
+            /* latch the joystick right when the frame starts, so that the
+               latch is never pending when the state is saved for rollback */
+            CLOCK delay = 1;
+
+            event_record_in_list(&rollback_local_list, type, (void *)&delay, sizeof(delay));
+        } else {
+            event_record_in_list(&rollback_local_list, type, data, size);
+        }
+        return;
+    }
+
     event_record_in_list(&(frame_event_list[current_frame]), type, data, size);
 }
 
@@ -687,7 +1022,11 @@ void network_attach_image(unsigned int unit, const char *filename)
         return;
     }
 
-    event_record_attach_in_list(&(frame_event_list[current_frame]), unit, drive, filename, 1);
+    if (rollback_window > 0) {
+        event_record_attach_in_list(&rollback_local_list, unit, drive, filename, 1);
+    } else {
+        event_record_attach_in_list(&(frame_event_list[current_frame]), unit, drive, filename, 1);
+    }
 }
 
 int network_get_mode(void)
@@ -827,6 +1166,9 @@ int network_connect_client(void)
 void network_disconnect(void)
 {
     DBG(("network_disconnect (network_mode was:%u)", network_mode));
+    network_delay_flush();
+    network_delay_clear();
+    network_rollback_free();
     vice_network_socket_close(network_socket);
     if (network_mode == NETWORK_SERVER_CONNECTED) {
         network_mode = NETWORK_SERVER;
@@ -839,13 +1181,11 @@ void network_disconnect(void)
 
 void network_suspend(void)
 {
-    int dummy_buf_len = 0;
-
     if (!network_connected() || suspended == 1) {
         return;
     }
 
-    network_send_buffer(network_socket, (uint8_t *)&dummy_buf_len, sizeof(unsigned int));
+    network_send_packet(NULL, 0);
 
     suspended = 1;
 }
@@ -858,7 +1198,6 @@ static void network_hook_connected_send(void)
 {
     uint8_t *local_event_buf = NULL;
     unsigned int send_len;
-    uint8_t send_len4[4];
 
     DBGT(("network_hook_connected_send"));
 
@@ -870,11 +1209,7 @@ static void network_hook_connected_send(void)
     t1 = tick_now();
 #endif
 
-    util_int_to_le_buf4(send_len4, (int)send_len);
-    if (network_send_buffer(network_socket, send_len4, 4) < 0) {
-        ui_display_statustext("Remote host disconnected.", true);
-        network_disconnect();
-    } else if (network_send_buffer(network_socket, local_event_buf, send_len) < 0) {
+    if (network_send_packet(local_event_buf, send_len) < 0) {
         ui_display_statustext("Remote host disconnected.", true);
         network_disconnect();
     }
@@ -974,8 +1309,370 @@ static void network_hook_connected_receive(void)
 #endif
 }
 
+/*-------------------------------------------------------------------------*/
+
+/* get the history entry of a frame, clearing it if it was used for an
+   older one */
+static rollback_frame_t *network_rollback_get_frame(int frame)
+{
+    rollback_frame_t *f = &rollback_history[frame % ROLLBACK_HISTORY];
+
+    if (f->frame != frame) {
+        lib_free(f->local_input);
+        lib_free(f->remote_input);
+        memset(f, 0, sizeof(rollback_frame_t));
+        f->frame = frame;
+    }
+    return f;
+}
+
+/* compare the state of a frame with the remote one, returns -1 if they
+   differ, which ends the connection */
+static int network_rollback_check_sync(rollback_frame_t *f)
+{
+    if (!f->local_sync_valid || !f->remote_sync_valid) {
+        return 0;
+    }
+
+    f->remote_sync_valid = 0;
+    if (memcmp(f->local_sync, f->remote_sync, ROLLBACK_SYNC_SIZE) != 0) {
+        ui_error("Network out of sync - disconnecting.");
+        network_disconnect();
+        return -1;
+    }
+    return 0;
+}
+
+static void network_rollback_playback(uint8_t *buf)
+{
+    event_list_state_t *list;
+
+    if (buf == NULL) {
+        return;
+    }
+
+    list = network_create_event_list(buf);
+    event_playback_event_list(list);
+    event_clear_list(list);
+    lib_free(list);
+}
+
+static void network_rollback_save(int frame)
+{
+    int i = frame % (NETWORK_ROLLBACK_MAX + 1);
+    int err;
+
+    snapshot_set_memory(&rollback_states[i]);
+    err = machine_write_snapshot("", 0, 0, 0);
+    snapshot_set_memory(NULL);
+
+    rollback_state_frame[i] = (err < 0) ? -1 : frame;
+}
+
+static int network_rollback_restore(int frame)
+{
+    int i = frame % (NETWORK_ROLLBACK_MAX + 1);
+    int err;
+
+    if (rollback_state_frame[i] != frame) {
+        return -1;
+    }
+
+    snapshot_set_memory(&rollback_states[i]);
+    err = machine_read_snapshot("", 0);
+    snapshot_set_memory(NULL);
+
+    if (err < 0) {
+        return -1;
+    }
+
+    /* the matrix latched from the network must match the restored one */
+    keyboard_event_delayed_playback(keyarr);
+    return 0;
+}
+
+/* Send the local input recorded since the last frame, to be applied on
+   both hosts in `frame'. Returns -1 on error.  */
+static int network_rollback_send(int frame)
+{
+    rollback_frame_t *f = network_rollback_get_frame(frame);
+    rollback_frame_t *sync = NULL;
+    uint8_t *event_buf = NULL;
+    uint8_t *buf;
+    unsigned int event_len, len;
+    int ret;
+
+    event_len = network_create_event_buffer(&event_buf, &rollback_local_list);
+    event_clear_list(&rollback_local_list);
+    event_register_event_list(&rollback_local_list);
+
+    if (rollback_sync_frame >= 0) {
+        sync = &rollback_history[rollback_sync_frame % ROLLBACK_HISTORY];
+        if (sync->frame != rollback_sync_frame || !sync->local_sync_valid) {
+            sync = NULL;
+        }
+    }
+
+    /* frame, frame of the sync test (-1 for none), sync test, events */
+    len = 8 + ROLLBACK_SYNC_SIZE + event_len;
+    buf = lib_calloc(1, len);
+    util_dword_to_le_buf(&buf[0], (uint32_t)frame);
+    if (sync != NULL) {
+        util_dword_to_le_buf(&buf[4], (uint32_t)sync->frame);
+        memcpy(&buf[8], sync->local_sync, ROLLBACK_SYNC_SIZE);
+    } else {
+        util_dword_to_le_buf(&buf[4], 0xffffffff);
+    }
+    memcpy(&buf[8 + ROLLBACK_SYNC_SIZE], event_buf, event_len);
+
+    ret = network_send_packet(buf, len);
+    lib_free(buf);
+
+    if (util_le_buf_to_dword(event_buf) == EVENT_LIST_END) {
+        lib_free(event_buf);
+        event_buf = NULL;
+    }
+    lib_free(f->local_input);
+    f->local_input = event_buf;
+
+    return ret;
+}
+
+/* Take in the remote input that has arrived, without waiting for more.
+   Returns -1 if the connection was closed.  */
+static int network_rollback_receive(void)
+{
+    uint8_t recv_len4[4];
+    unsigned int recv_len;
+    uint8_t *buf;
+    rollback_frame_t *f;
+    int frame, sync_frame;
+    int ready;
+
+    while ((ready = vice_network_select_poll_one(network_socket)) > 0) {
+        if (network_recv_buffer(network_socket, recv_len4, 4) < 0) {
+            goto disconnected;
+        }
+        recv_len = util_le_buf4_to_int(recv_len4);
+        if (recv_len == 0) {
+            /* remote host suspended emulation */
+            ui_display_statustext("Remote host suspending...", false);
+            suspended = 1;
+            vsync_suspend_speed_eval();
+            continue;
+        }
+        if (suspended == 1) {
+            ui_display_statustext("", false);
+            suspended = 0;
+        }
+        if (recv_len < 8 + ROLLBACK_SYNC_SIZE + 12) {
+            goto disconnected;
+        }
+
+        buf = lib_malloc(recv_len);
+        if (network_recv_buffer(network_socket, buf, recv_len) < 0) {
+            lib_free(buf);
+            goto disconnected;
+        }
+
+        frame = (int)util_le_buf_to_dword(&buf[0]);
+        sync_frame = (int)util_le_buf_to_dword(&buf[4]);
+        if (frame != rollback_confirmed + 1) {
+            log_error(LOG_DEFAULT, "netplay: got input for frame %d, expected %d.",
+                      frame, rollback_confirmed + 1);
+            lib_free(buf);
+            goto disconnected;
+        }
+
+        f = network_rollback_get_frame(frame);
+        lib_free(f->remote_input);
+        f->remote_input = NULL;
+        if (util_le_buf_to_dword(&buf[8 + ROLLBACK_SYNC_SIZE]) != EVENT_LIST_END) {
+            f->remote_input = lib_malloc(recv_len - 8 - ROLLBACK_SYNC_SIZE);
+            memcpy(f->remote_input, &buf[8 + ROLLBACK_SYNC_SIZE],
+                   recv_len - 8 - ROLLBACK_SYNC_SIZE);
+        }
+        rollback_confirmed = frame;
+
+        /* the prediction of no change was wrong, go back to that frame */
+        if (f->predicted && frame <= rollback_frame && f->remote_input != NULL) {
+            if (rollback_target < 0 || frame < rollback_target) {
+                rollback_target = frame;
+            }
+        }
+        f->predicted = 0;
+
+        if (sync_frame >= 0) {
+            f = &rollback_history[sync_frame % ROLLBACK_HISTORY];
+            if (f->frame == sync_frame) {
+                memcpy(f->remote_sync, &buf[8], ROLLBACK_SYNC_SIZE);
+                f->remote_sync_valid = 1;
+                if (network_rollback_check_sync(f) < 0) {
+                    lib_free(buf);
+                    return -1;
+                }
+            }
+        }
+        lib_free(buf);
+    }
+
+    if (ready == 0) {
+        return 0;
+    }
+
+disconnected:
+    ui_display_statustext("Remote host disconnected.", true);
+    network_disconnect();
+    return -1;
+}
+
+/* Start a frame: go back to an earlier frame if the remote input was
+   mispredicted, save the state and apply the input of both hosts.  */
+static void network_rollback_trap(uint16_t addr, void *data)
+{
+    rollback_frame_t *f;
+    uint8_t *local_input, *remote_input;
+    int frame = rollback_frame + 1;
+
+    if (rollback_window == 0) {
+        return;
+    }
+
+    if (rollback_target >= 0) {
+        frame = rollback_target;
+        rollback_target = -1;
+        DBG(("network_rollback_trap: back from frame %d to %d", rollback_frame, frame));
+        if (network_rollback_restore(frame) < 0) {
+            ui_error("Netplay rollback failed - disconnecting.");
+            network_disconnect();
+            return;
+        }
+        if (!rollback_resimulating) {
+            rollback_saved_warp = vsync_get_warp_mode();
+            vsync_set_warp_mode(1);
+            rollback_resimulating = 1;
+        }
+        rollback_count++;
+    } else {
+        network_rollback_save(frame);
+    }
+
+    f = network_rollback_get_frame(frame);
+
+    /* all input up to here is known, so the state is the final one */
+    if (frame <= rollback_confirmed + 1 && frame > rollback_sync_frame) {
+        network_get_sync_regs(f->local_sync);
+        f->local_sync_valid = 1;
+        rollback_sync_frame = frame;
+        if (network_rollback_check_sync(f) < 0) {
+            return;
+        }
+    }
+
+    local_input = f->local_input;
+    remote_input = f->remote_input;
+    f->predicted = (frame > rollback_confirmed);
+
+    /* replay the input; server first, then client */
+    if (network_mode == NETWORK_SERVER_CONNECTED) {
+        network_rollback_playback(local_input);
+        network_rollback_playback(remote_input);
+    } else {
+        network_rollback_playback(remote_input);
+        network_rollback_playback(local_input);
+    }
+
+    if (rollback_resimulating) {
+        rollback_resimulated++;
+    }
+    rollback_frame = frame;
+    if (rollback_resimulating && frame >= rollback_live_frame) {
+        vsync_set_warp_mode(rollback_saved_warp);
+        rollback_resimulating = 0;
+    }
+}
+
+static void network_hook_rollback(void)
+{
+    int frame = rollback_frame + 1;
+
+    if (frame > rollback_live_frame) {
+        rollback_live_frame = frame;
+        if (network_rollback_send(frame + ROLLBACK_INPUT_DELAY) < 0) {
+            ui_display_statustext("Remote host disconnected.", true);
+            network_disconnect();
+            return;
+        }
+    }
+
+    if (network_delay_flush() < 0) {
+        ui_display_statustext("Remote host disconnected.", true);
+        network_disconnect();
+        return;
+    }
+    if (network_rollback_receive() < 0) {
+        return;
+    }
+
+    /* don't run further ahead of the remote input than the window; give
+       up if the remote host sends nothing for too long, unless it said
+       it is suspending */
+    if (frame - rollback_confirmed > rollback_window) {
+        tick_t start = tick_now();
+        int waiting = 0;
+
+        while (frame - rollback_confirmed > rollback_window) {
+            double seconds;
+
+            if (network_delay_flush() < 0) {
+                ui_display_statustext("Remote host disconnected.", true);
+                network_disconnect();
+                return;
+            }
+            if (network_rollback_receive() < 0) {
+                return;
+            }
+            if (frame - rollback_confirmed <= rollback_window) {
+                break;
+            }
+            if (suspended) {
+                start = tick_now();
+                waiting = 0;
+            }
+            seconds = (double)tick_now_delta(start) / tick_per_second();
+            if (seconds >= ROLLBACK_TIMEOUT) {
+                log_warning(LOG_DEFAULT, "netplay: no input from the remote host for %d seconds.",
+                            ROLLBACK_TIMEOUT);
+                ui_display_statustext("Remote host not responding - disconnecting.", true);
+                network_disconnect();
+                return;
+            }
+            if (!waiting && seconds >= 1.0) {
+                ui_display_statustext("Waiting for remote host...", false);
+                waiting = 1;
+            }
+            tick_sleep(tick_per_second() / 1000);
+        }
+        if (waiting) {
+            ui_display_statustext("", false);
+            vsync_suspend_speed_eval();
+        }
+    }
+
+    interrupt_maincpu_trigger_trap(network_rollback_trap, (void *)0);
+}
+
 void network_hook(void)
 {
+    if (network_start_mode != NETWORK_IDLE) {
+        if (network_start_mode == NETWORK_SERVER) {
+            network_start_server();
+        } else {
+            network_connect_client();
+        }
+        network_start_mode = NETWORK_IDLE;
+    }
+
     if (network_mode == NETWORK_IDLE) {
         return;
     }
@@ -991,7 +1688,9 @@ void network_hook(void)
         }
     }
 
-    if (network_connected()) {
+    if (network_connected() && rollback_window > 0) {
+        network_hook_rollback();
+    } else if (network_connected()) {
         network_hook_connected_send();
         network_hook_connected_receive();
         DBGT(("network_hook timing: %5ld %5ld %5ld; total: %5ld",
@@ -1006,6 +1705,7 @@ void network_shutdown(void)
     }
 
     network_free_frame_event_list();
+    network_rollback_free();
     lib_free(server_name);
     lib_free(server_bind_address);
 }
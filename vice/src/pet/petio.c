@@ -607,6 +607,11 @@ void cartio_set_highest_order(unsigned int nr)
     order = nr;
 }
 
+void io_source_ranges_changed(void)
+{
+    /* the device lists are walked on every access, nothing to update */
+}
+
 /* ---------------------------------------------------------------------------------------------------------- */
 
 uint8_t petio_8800_read(uint16_t addr)
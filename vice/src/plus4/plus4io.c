@@ -492,6 +492,11 @@ void cartio_set_highest_order(unsigned int nr)
     order = nr;
 }
 
+void io_source_ranges_changed(void)
+{
+    /* the device lists are walked on every access, nothing to update */
+}
+
 /* ---------------------------------------------------------------------------------------------------------- */
 
 uint8_t plus4io_fd00_read(uint16_t addr)
@@ -54,6 +54,14 @@ unsigned callstack_size = 0;
 bool     context_dirty = true;
 bool     maincpu_profiling = false;
 
+/* record every Nth instruction only, with N times the weight; the distance
+ * between samples is jittered so loops whose length divides N do not always
+ * get sampled at the same instruction */
+unsigned profile_sample_interval = 1;
+unsigned sample_countdown = 1;
+bool     sample_taken = false;
+uint32_t sample_jitter = 0x2545f491;
+
 /* (fragile) flags if the current command is a JSR/INT or RTS/RTI */
 bool     entered_context = false;
 bool     exited_context = false;
@@ -237,8 +245,29 @@ static void initialize_context(void) {
     current_context = get_mem_config_context(current_context, mem_get_current_bank_config());
 }
 
+/* 1 .. 2N-1, N on average; own xorshift PRNG so that profiling does not
+ * change the emulation's random number sequence */
+static unsigned next_sample_distance(void)
+{
+    if (profile_sample_interval == 1) {
+        return 1;
+    }
+    sample_jitter ^= sample_jitter << 13;
+    sample_jitter ^= sample_jitter >> 17;
+    sample_jitter ^= sample_jitter << 5;
+    return 1 + sample_jitter % (2 * profile_sample_interval - 1);
+}
+
 void profile_sample_start(uint16_t pc)
 {
+    sample_taken = (--sample_countdown == 0);
+    if (sample_taken) {
+        sample_countdown = next_sample_distance();
+    } else if (!exited_context && !entered_context && !context_dirty) {
+        /* nothing to record and the context is unchanged */
+        return;
+    }
+
     if (exited_context) {
         current_context->num_exits++;
         exited_context = false;
@@ -258,12 +287,17 @@ void profile_sample_start(uint16_t pc)
 
 void profile_sample_finish(uint16_t cycle_time, uint16_t stolen_cycles)
 {
-    profiling_data_t * data = &profiling_get_page(current_context,
-                                                 current_pc >> 8)
-                                  ->data[current_pc & 0xff];
-    data->num_cycles += cycle_time;
-    data->num_samples++;
-    current_context->total_stolen_cycles_self   += stolen_cycles;
+    profiling_data_t * data;
+
+    if (!sample_taken) {
+        return;
+    }
+
+    data = &profiling_get_page(current_context, current_pc >> 8)
+                ->data[current_pc & 0xff];
+    data->num_cycles += cycle_time * profile_sample_interval;
+    data->num_samples += profile_sample_interval;
+    current_context->total_stolen_cycles_self   += stolen_cycles * profile_sample_interval;
 }
 
 void profile_jsr(uint16_t pc_dst, uint16_t pc_src, uint8_t sp)
@@ -306,6 +340,7 @@ void profile_start(void)
     entered_context = false;
     exited_context  = false;
     context_dirty   = true;
+    sample_countdown = 1;
 }
 
 void compute_aggregate_stats(profiling_context_t *context) {
@@ -361,6 +396,20 @@ void profile_stop(void)
     maincpu_profiling = false;
 }
 
+void profile_set_sample_interval(unsigned interval)
+{
+    if (interval < 1) {
+        interval = 1;
+    }
+    profile_sample_interval = interval;
+    sample_countdown = 1;
+}
+
+unsigned profile_get_sample_interval(void)
+{
+    return profile_sample_interval;
+}
+
 static void profile_reset(void) {
     free_profiling_context(root_context);
     root_context = NULL;
@@ -37,6 +37,11 @@ void profile_start(void);
 /* stops profiling and writes profiling log to disk */
 void profile_stop(void);
 
+/* only record every Nth instruction (and count it N times); the call stack
+ * is still tracked for every instruction */
+void profile_set_sample_interval(unsigned interval);
+unsigned profile_get_sample_interval(void);
+
 /* called by the CPU for each instruction */
 void profile_sample_start(uint16_t pc);
 void profile_sample_finish(uint16_t cycle_time, uint16_t stolen_cycles);
@@ -35,6 +35,7 @@
 #include "machine.h"
 #include "raster-canvas.h"
 #include "raster.h"
+#include "screenshot.h"
 #include "video.h"
 #include "viewport.h"
 #include "vsync.h"
@@ -107,11 +108,22 @@ inline static void refresh_canvas(raster_t *raster)
 
 void raster_canvas_handle_end_of_frame(raster_t *raster)
 {
-    if (video_disabled_mode) {
-        return;
+    int skip = raster->skip_frame;
+
+    if (raster->sync_drawing != NULL) {
+        raster->sync_drawing(raster);
     }
 
-    if (vsync_should_skip_frame(raster->canvas)) {
+    /* Decide for the next frame now, so that it need not be drawn when it
+       is skipped.  Recording, the exit screenshot and the binary monitor
+       read frames from the draw buffer.  */
+    raster->skip_frame = video_disabled_mode || vsync_should_skip_frame(raster->canvas);
+    raster->skip_drawing = raster->skip_frame
+                           && raster->can_skip_drawing
+                           && !screenshot_is_recording()
+                           && !machine_draw_all_frames();
+
+    if (skip) {
         return;
     }
 
@@ -33,6 +33,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "benchmark.h"
 #include "raster-cache.h"
 #include "raster-canvas.h"
 #include "raster-changes.h"
@@ -650,6 +651,8 @@ inline static void handle_visible_line(raster_t *raster)
 
 void raster_line_emulate(raster_t *raster)
 {
+    BENCHMARK_ENTER(BENCHMARK_VIDEOCHIP);
+
     raster_draw_buffer_ptr_update(raster);
 
     /* Emulate the vertical blank flip-flops.  (Well, sort of.)  */
@@ -660,11 +663,12 @@ void raster_line_emulate(raster_t *raster)
         raster->blank_enabled = 1;
     }
 
-    if ((raster->current_line >= raster->geometry->first_displayed_line
-         && raster->current_line <= raster->geometry->last_displayed_line)
-        /* handle the case when lines 0+ are displayed in the lower border */
-        || (raster->current_line <= raster->geometry->last_displayed_line - raster->geometry->screen_size.height
-            && raster->geometry->screen_size.height <= raster->geometry->last_displayed_line)
+    if (!raster->skip_drawing
+        && ((raster->current_line >= raster->geometry->first_displayed_line
+             && raster->current_line <= raster->geometry->last_displayed_line)
+            /* handle the case when lines 0+ are displayed in the lower border */
+            || (raster->current_line <= raster->geometry->last_displayed_line - raster->geometry->screen_size.height
+                && raster->geometry->screen_size.height <= raster->geometry->last_displayed_line))
         ) {
         /* handle lines with no border or with changes that may affect
            the border as visible lines */
@@ -735,4 +739,6 @@ void raster_line_emulate(raster_t *raster)
     }
 
     raster->blank_this_line = 0;
+
+    BENCHMARK_LEAVE();
 }
@@ -276,6 +276,11 @@ int raster_init(raster_t *raster,
     raster->dont_cache_all = 1;
     raster->num_cached_lines = 0;
 
+    raster->skip_frame = 0;
+    raster->can_skip_drawing = 0;
+    raster->skip_drawing = 0;
+    raster->sync_drawing = NULL;
+
     raster->fake_draw_buffer_line = NULL;
 
     raster->can_disable_border = 0;
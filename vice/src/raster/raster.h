@@ -158,6 +158,18 @@ struct raster_s {
        is valid again.  */
     unsigned int num_cached_lines;
 
+    /* The frame being emulated is not shown on the host.  This is decided
+       at the end of the previous frame, so that the video chip can leave
+       it undrawn.  */
+    int skip_frame;
+
+    /* The video chip emulates everything the CPU can observe without
+       drawing, so skipped frames need not be drawn.  */
+    int can_skip_drawing;
+
+    /* The frame being emulated is neither shown nor drawn.  */
+    int skip_drawing;
+
     /* Area to update.  */
     struct raster_canvas_area_s *update_area;
 
@@ -179,6 +191,10 @@ struct raster_s {
     int (*fill_sprite_cache)(struct raster_s *, struct raster_cache_s *,
                              unsigned int *, unsigned int *);
 
+    /* If not NULL, called before the draw buffer is read at the end of a
+       frame, by video chips that draw lines on another thread.  */
+    void (*sync_drawing)(struct raster_s *);
+
     int intialized;
 };
 typedef struct raster_s raster_t;
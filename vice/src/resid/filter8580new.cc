@@ -632,6 +632,9 @@ Filter::Filter()
   set_chip_model(MOS6581);
   set_voice_mask(0x07);
   input(0);
+  // Vw_bias and nVgt are per instance, they are only set above for the
+  // first filter.
+  adjust_filter_bias(0);
   reset();
 }
 
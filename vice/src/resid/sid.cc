@@ -36,6 +36,13 @@ using namespace std;
 #define round(x) (x>=0.0?floor(x+0.5):ceil(x-0.5))
 #endif
 
+// Vectorized FIR convolution is only available on x86 with GCC or clang,
+// the instruction set is chosen at run time.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RESID_CONVOLVE_X86
+#include <immintrin.h>
+#endif
+
 namespace reSID
 {
 
@@ -56,6 +63,112 @@ inline short amplify(int input, int scaleFactor)
     return clip((scaleFactor * input) / 2);
 }
 
+
+// ----------------------------------------------------------------------------
+// FIR convolution, i.e. the dot product of n samples and n filter
+// coefficients. The vector versions compute the products and partial sums
+// in 32 bit integers exactly like the scalar version, so all versions yield
+// identical results.
+// ----------------------------------------------------------------------------
+static int convolve_scalar(const short* a, const short* b, int n)
+{
+  int out = 0;
+  for (int i = 0; i < n; i++) {
+    out += a[i]*b[i];
+  }
+  return out;
+}
+
+#ifdef RESID_CONVOLVE_X86
+__attribute__((target("sse2")))
+static int convolve_sse2(const short* a, const short* b, int n)
+{
+  __m128i acc = _mm_setzero_si128();
+  int i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+    __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(va, vb));
+  }
+
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+  int out = _mm_cvtsi128_si32(acc);
+
+  for (; i < n; i++) {
+    out += a[i]*b[i];
+  }
+  return out;
+}
+
+__attribute__((target("avx2")))
+static int convolve_avx2(const short* a, const short* b, int n)
+{
+  __m256i acc = _mm256_setzero_si256();
+  int i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+  }
+
+  __m128i acc128 = _mm_add_epi32(_mm256_castsi256_si128(acc),
+                                 _mm256_extracti128_si256(acc, 1));
+  if (i + 8 <= n) {
+    __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+    __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+    acc128 = _mm_add_epi32(acc128, _mm_madd_epi16(va, vb));
+    i += 8;
+  }
+
+  acc128 = _mm_add_epi32(acc128, _mm_shuffle_epi32(acc128, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc128 = _mm_add_epi32(acc128, _mm_shuffle_epi32(acc128, _MM_SHUFFLE(2, 3, 0, 1)));
+  int out = _mm_cvtsi128_si32(acc128);
+
+  for (; i < n; i++) {
+    out += a[i]*b[i];
+  }
+  return out;
+}
+#endif
+
+static int (*convolve)(const short* a, const short* b, int n) = 0;
+
+// Select the fastest convolution supported by the CPU, unless one has been
+// chosen with SID::set_convolve().
+static void convolve_init()
+{
+  if (!convolve) {
+    SID::set_convolve(SID::CONVOLVE_AUTO);
+  }
+}
+
+bool SID::set_convolve(convolve_type type)
+{
+#ifdef RESID_CONVOLVE_X86
+  __builtin_cpu_init();
+  if (type == CONVOLVE_AUTO) {
+    type = __builtin_cpu_supports("avx2") ? CONVOLVE_AVX2
+      : __builtin_cpu_supports("sse2") ? CONVOLVE_SSE2 : CONVOLVE_SCALAR;
+  }
+  if (type == CONVOLVE_AVX2 && __builtin_cpu_supports("avx2")) {
+    convolve = convolve_avx2;
+    return true;
+  }
+  if (type == CONVOLVE_SSE2 && __builtin_cpu_supports("sse2")) {
+    convolve = convolve_sse2;
+    return true;
+  }
+#endif
+  if (type == CONVOLVE_AUTO || type == CONVOLVE_SCALAR) {
+    convolve = convolve_scalar;
+    return true;
+  }
+  return false;
+}
+
 // ----------------------------------------------------------------------------
 // Constructor.
 // ----------------------------------------------------------------------------
@@ -64,12 +177,15 @@ SID::SID()
   // Initialize pointers.
   sample = 0;
   fir = 0;
+  fir_cached = false;
   fir_N = 0;
   fir_RES = 0;
   fir_beta = 0;
   fir_f_cycles_per_sample = 0;
   fir_filter_scale = 0;
 
+  convolve_init();
+
   sid_model = MOS6581;
   voice[0].set_sync_source(&voice[2]);
   voice[1].set_sync_source(&voice[0]);
@@ -95,7 +211,7 @@ SID::SID()
 SID::~SID()
 {
   delete[] sample;
-  delete[] fir;
+  release_fir();
 }
 
 
@@ -627,9 +743,8 @@ bool SID::set_sampling_parameters(double clock_freq, sampling_method method,
   if (method != SAMPLE_RESAMPLE && method != SAMPLE_RESAMPLE_FASTMEM)
   {
     delete[] sample;
-    delete[] fir;
+    release_fir();
     sample = 0;
-    fir = 0;
     return true;
   }
 
@@ -695,9 +810,20 @@ bool SID::set_sampling_parameters(double clock_freq, sampling_method method,
   fir_f_cycles_per_sample = f_cycles_per_sample;
   fir_filter_scale = filter_scale;
 
+  release_fir();
+
+  // Reuse a table generated earlier, possibly by another process.
+  if (fir_table_cache) {
+    fir = fir_table_cache->lookup(fir_N, fir_RES, f_cycles_per_sample,
+                                  filter_scale);
+    if (fir) {
+      fir_cached = true;
+      return true;
+    }
+  }
+
   // Allocate memory for FIR tables.
-  delete[] fir;
-  fir = new short[fir_N*fir_RES];
+  short* fir_new = new short[fir_N*fir_RES];
 
   // Calculate fir_RES FIR tables for linear interpolation.
   for (int i = 0; i < fir_RES; i++) {
@@ -712,14 +838,49 @@ bool SID::set_sampling_parameters(double clock_freq, sampling_method method,
       double Kaiser = fabs(temp) <= 1 ? I0(beta*sqrt(1 - temp*temp))/I0beta : 0;
       double sincwt = fabs(wt) >= 1e-6 ? sin(wt)/wt : 1;
       double val = (1 << FIR_SHIFT)*filter_scale*f_samples_per_cycle*wc/pi*sincwt*Kaiser;
-      fir[fir_offset + j] = (short)round(val);
+      fir_new[fir_offset + j] = (short)round(val);
     }
   }
 
+  fir = fir_new;
+
+  if (fir_table_cache) {
+    fir_table_cache->store(fir_N, fir_RES, f_cycles_per_sample, filter_scale,
+                           fir);
+  }
+
   return true;
 }
 
 
+// ----------------------------------------------------------------------------
+// Free the current FIR table, or hand it back to the table cache.
+// ----------------------------------------------------------------------------
+void SID::release_fir()
+{
+  if (fir_cached) {
+    fir_table_cache->release(fir);
+  }
+  else {
+    delete[] fir;
+  }
+  fir = 0;
+  fir_cached = false;
+}
+
+
+// ----------------------------------------------------------------------------
+// Install a cache for generated FIR tables, shared by all SID instances.
+// The cache must outlive all SID instances using it; pass 0 to disable.
+// ----------------------------------------------------------------------------
+FIRTableCache* SID::fir_table_cache = 0;
+
+void SID::set_fir_table_cache(FIRTableCache* cache)
+{
+  fir_table_cache = cache;
+}
+
+
 // ----------------------------------------------------------------------------
 // Adjustment of SID sampling frequency.
 //
@@ -1001,14 +1162,11 @@ int SID::clock_resample(cycle_count& delta_t, short* buf, int n, int interleave)
 
     int fir_offset = sample_offset*fir_RES >> FIXP_SHIFT;
     int fir_offset_rmd = sample_offset*fir_RES & FIXP_MASK;
-    short* fir_start = fir + fir_offset*fir_N;
+    const short* fir_start = fir + fir_offset*fir_N;
     short* sample_start = sample + sample_index - fir_N - 1 + RINGSIZE;
 
     // Convolution with filter impulse response.
-    int v1 = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v1 += sample_start[j]*fir_start[j];
-    }
+    int v1 = convolve(sample_start, fir_start, fir_N);
 
     // Use next FIR table, wrap around to first FIR table using
     // next sample.
@@ -1019,10 +1177,7 @@ int SID::clock_resample(cycle_count& delta_t, short* buf, int n, int interleave)
     fir_start = fir + fir_offset*fir_N;
 
     // Convolution with filter impulse response.
-    int v2 = 0;
-    for (int k = 0; k < fir_N; k++) {
-      v2 += sample_start[k]*fir_start[k];
-    }
+    int v2 = convolve(sample_start, fir_start, fir_N);
 
     // Linear interpolation.
     // fir_offset_rmd is equal for all samples, it can thus be factorized out:
@@ -1067,14 +1222,11 @@ int SID::clock_resample_fastmem(cycle_count& delta_t, short* buf, int n, int int
     sample_offset = next_sample_offset & FIXP_MASK;
 
     int fir_offset = sample_offset*fir_RES >> FIXP_SHIFT;
-    short* fir_start = fir + fir_offset*fir_N;
+    const short* fir_start = fir + fir_offset*fir_N;
     short* sample_start = sample + sample_index - fir_N + RINGSIZE;
 
     // Convolution with filter impulse response.
-    int v = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v += sample_start[j]*fir_start[j];
-    }
+    int v = convolve(sample_start, fir_start, fir_N);
 
     v >>= FIR_SHIFT;
 
@@ -35,6 +35,30 @@
 namespace reSID
 {
 
+// ----------------------------------------------------------------------------
+// Optional store for generated resampling FIR tables.
+// Building the FIR tables is expensive (tens of megabytes for
+// SAMPLE_RESAMPLE_FASTMEM), so an application may install a cache which
+// hands out previously generated tables, e.g. from a file on disk.
+// A table is fully determined by its length (fir_N), its resolution
+// (fir_RES), the number of clock cycles per sample and the filter scale.
+// ----------------------------------------------------------------------------
+class FIRTableCache
+{
+public:
+  virtual ~FIRTableCache() {}
+
+  // Return a table of fir_N*fir_RES coefficients, or 0 if none is cached.
+  virtual const short* lookup(int fir_N, int fir_RES,
+                              double cycles_per_sample,
+                              double filter_scale) = 0;
+  // Release a table returned by lookup().
+  virtual void release(const short* fir) = 0;
+  // Offer a freshly generated table for storage.
+  virtual void store(int fir_N, int fir_RES, double cycles_per_sample,
+                     double filter_scale, const short* fir) = 0;
+};
+
 class SID
 {
 public:
@@ -52,6 +76,14 @@ public:
   void adjust_sampling_frequency(double sample_freq);
   void enable_raw_debug_output(bool enable);
 
+  static void set_fir_table_cache(FIRTableCache* cache);
+
+  // FIR convolution used for resampling. CONVOLVE_AUTO selects the fastest
+  // one the CPU supports; set_convolve() returns false for others it does
+  // not support. The setting is shared by all instances.
+  enum convolve_type { CONVOLVE_AUTO = -1, CONVOLVE_SCALAR, CONVOLVE_SSE2, CONVOLVE_AVX2 };
+  static bool set_convolve(convolve_type type);
+
   void clock();
   void clock(cycle_count delta_t);
   int clock(cycle_count& delta_t, short* buf, int n, int interleave = 1);
@@ -105,6 +137,7 @@ public:
 
  protected:
   static double I0(double x);
+  void release_fir();
   int clock_fast(cycle_count& delta_t, short* buf, int n, int interleave);
   int clock_interpolate(cycle_count& delta_t, short* buf, int n, int interleave);
   int clock_resample(cycle_count& delta_t, short* buf, int n, int interleave);
@@ -170,7 +203,11 @@ public:
   short* sample;
 
   // FIR_RES filter tables (FIR_N*FIR_RES).
-  short* fir;
+  const short* fir;
+  // The FIR table was handed out by fir_table_cache.
+  bool fir_cached;
+
+  static FIRTableCache* fir_table_cache;
 
   bool raw_debug_output; // FIXME: should be private?
 };
@@ -0,0 +1,473 @@
+/** \file   rewind.c
+ * \brief   In-memory snapshot history for rewinding the emulation
+ *
+ * At a configurable frame interval the complete machine state is written to
+ * memory with machine_write_snapshot(). Only the newest state is kept in
+ * full; each older state is stored as a delta against the state captured
+ * after it, so stepping back means patching the newest state with the deltas
+ * backwards and handing the result to machine_read_snapshot(). The oldest
+ * deltas are dropped once the history exceeds the configured memory limit.
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmdline.h"
+#include "interrupt.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "maincpu.h"
+#include "network.h"
+#include "resources.h"
+#include "rewind.h"
+#include "snapshot.h"
+#include "types.h"
+#include "vice-event.h"
+
+/* A run of this many unchanged bytes ends a literal run in a delta.  */
+#define REWIND_MIN_MATCH    8
+
+/* One step of the history: the state captured at `clk', encoded as a delta
+   against the state captured directly after it.  */
+typedef struct rewind_entry_s {
+    uint8_t *delta;
+    size_t delta_size;
+    size_t state_size;
+    CLOCK clk;
+} rewind_entry_t;
+
+static log_t rewind_log = LOG_DEFAULT;
+
+/* Resources.  */
+static int rewind_enabled = 0;
+static int rewind_interval = 25;
+static int rewind_memory = 64;
+static int rewind_step = 1;
+
+/* History, oldest entry first.  */
+static rewind_entry_t *entries = NULL;
+static int entries_num = 0;
+static int entries_max = 0;
+static size_t entries_bytes = 0;
+
+/* Newest captured state, kept in full.  */
+static snapshot_memory_t current = { NULL, 0, 0 };
+static CLOCK current_clk = 0;
+
+/* Capture target, swapped with `current' after each capture.  */
+static snapshot_memory_t scratch = { NULL, 0, 0 };
+
+/* Output buffer for delta encoding.  */
+static uint8_t *delta_buf = NULL;
+static size_t delta_alloc = 0;
+
+static int frame_counter = 0;
+static int capture_pending = 0;
+
+/* ------------------------------------------------------------------------- */
+
+static void memory_reserve(uint8_t **buf, size_t *alloc, size_t size)
+{
+    if (size > *alloc) {
+        *alloc = size + size / 4;
+        *buf = lib_realloc(*buf, *alloc);
+    }
+}
+
+static size_t put_varint(uint8_t *p, size_t value)
+{
+    size_t n = 0;
+
+    while (value >= 0x80) {
+        p[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    p[n++] = (uint8_t)value;
+    return n;
+}
+
+static int get_varint(const uint8_t *p, size_t size, size_t *pos, size_t *value)
+{
+    size_t result = 0;
+    int shift = 0;
+
+    while (*pos < size && shift < (int)(sizeof(size_t) * 8)) {
+        uint8_t b = p[(*pos)++];
+
+        result |= (size_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *value = result;
+            return 0;
+        }
+        shift += 7;
+    }
+    return -1;
+}
+
+/* Encode `state' as a sequence of (copy length, literal length, literals)
+   tokens against `ref', into `delta_buf'. Copied bytes are taken from the
+   same offset in `ref'. Returns the size of the encoded delta.  */
+static size_t delta_encode(const uint8_t *state, size_t size,
+                           const uint8_t *ref, size_t ref_size)
+{
+    size_t common = size < ref_size ? size : ref_size;
+    size_t pos = 0;
+    size_t out = 0;
+
+    while (pos < size) {
+        size_t copy_start = pos;
+        size_t lit_start;
+
+        while (pos < common && state[pos] == ref[pos]) {
+            pos++;
+        }
+        lit_start = pos;
+
+        while (pos < size) {
+            size_t run = 0;
+
+            while (pos + run < common && run < REWIND_MIN_MATCH
+                   && state[pos + run] == ref[pos + run]) {
+                run++;
+            }
+            if (run == REWIND_MIN_MATCH) {
+                break;
+            }
+            pos += run ? run : 1;
+        }
+
+        memory_reserve(&delta_buf, &delta_alloc, out + 20 + (pos - lit_start));
+        out += put_varint(delta_buf + out, lit_start - copy_start);
+        out += put_varint(delta_buf + out, pos - lit_start);
+        memcpy(delta_buf + out, state + lit_start, pos - lit_start);
+        out += pos - lit_start;
+    }
+
+    return out;
+}
+
+/* Turn the state in `state' (`ref_size' valid bytes) into the one described
+   by `delta'. Copied bytes are already in place, so only the literals need
+   to be written and the cost is proportional to the size of the delta.  */
+static int delta_apply(const uint8_t *delta, size_t delta_size,
+                       uint8_t *state, size_t ref_size, size_t size)
+{
+    size_t in = 0;
+    size_t pos = 0;
+
+    while (in < delta_size) {
+        size_t copy, lit;
+
+        if (get_varint(delta, delta_size, &in, &copy) < 0
+            || get_varint(delta, delta_size, &in, &lit) < 0
+            || copy > size - pos || pos + copy > ref_size) {
+            return -1;
+        }
+        pos += copy;
+
+        if (lit > size - pos || lit > delta_size - in) {
+            return -1;
+        }
+        memcpy(state + pos, delta + in, lit);
+        pos += lit;
+        in += lit;
+    }
+
+    return pos == size ? 0 : -1;
+}
+
+static void swap_states(void)
+{
+    snapshot_memory_t tmp = current;
+
+    current = scratch;
+    scratch = tmp;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void drop_oldest(void)
+{
+    entries_bytes -= entries[0].delta_size;
+    lib_free(entries[0].delta);
+    entries_num--;
+    memmove(entries, entries + 1, entries_num * sizeof(rewind_entry_t));
+}
+
+/* Drop the oldest history entries until we are within `RewindMemory'.  */
+static void rewind_trim(void)
+{
+    size_t limit = (size_t)rewind_memory << 20;
+
+    while (entries_num > 0
+           && entries_bytes + current.alloc + scratch.alloc > limit) {
+        drop_oldest();
+    }
+}
+
+void rewind_clear(void)
+{
+    int i;
+
+    for (i = 0; i < entries_num; i++) {
+        lib_free(entries[i].delta);
+    }
+    lib_free(entries);
+    entries = NULL;
+    entries_num = 0;
+    entries_max = 0;
+    entries_bytes = 0;
+
+    lib_free(current.data);
+    lib_free(scratch.data);
+    lib_free(delta_buf);
+    current.data = scratch.data = delta_buf = NULL;
+    current.size = current.alloc = 0;
+    scratch.size = scratch.alloc = 0;
+    delta_alloc = 0;
+
+    frame_counter = 0;
+}
+
+static void rewind_capture(void)
+{
+    int err;
+
+    snapshot_set_memory(&scratch);
+    err = machine_write_snapshot("", 0, 0, 0);
+    snapshot_set_memory(NULL);
+
+    if (err < 0) {
+        log_error(rewind_log, "Cannot capture machine state, clearing history.");
+        rewind_clear();
+        return;
+    }
+
+    if (current.size > 0) {
+        rewind_entry_t *e;
+        size_t len = delta_encode(current.data, current.size, scratch.data, scratch.size);
+
+        if (entries_num == entries_max) {
+            entries_max = entries_max ? entries_max * 2 : 64;
+            entries = lib_realloc(entries, entries_max * sizeof(rewind_entry_t));
+        }
+        e = &entries[entries_num++];
+        e->delta = lib_malloc(len);
+        memcpy(e->delta, delta_buf, len);
+        e->delta_size = len;
+        e->state_size = current.size;
+        e->clk = current_clk;
+        entries_bytes += len;
+    }
+
+    swap_states();
+    current_clk = maincpu_clk;
+
+    rewind_trim();
+}
+
+static void rewind_capture_trap(uint16_t addr, void *data)
+{
+    capture_pending = 0;
+    if (rewind_enabled) {
+        rewind_capture();
+    }
+}
+
+/* Called once per frame from vsync_do_vsync().  */
+void rewind_vsync_hook(void)
+{
+    if (!rewind_enabled || capture_pending) {
+        return;
+    }
+    if (++frame_counter < rewind_interval) {
+        return;
+    }
+    frame_counter = 0;
+
+    /* Restoring an older state would break recordings and netplay.  */
+    if (event_record_active() || event_playback_active() || network_connected()) {
+        return;
+    }
+
+    capture_pending = 1;
+    interrupt_maincpu_trigger_trap(rewind_capture_trap, NULL);
+}
+
+/* Restore the newest captured state that is at least `seconds' old, or the
+   oldest one available. Must be called from a CPU trap. Returns -1 if there
+   is no history or it could not be restored.  */
+int rewind_step_back(double seconds)
+{
+    CLOCK cycles, target;
+    int err;
+
+    if (current.size == 0) {
+        log_warning(rewind_log, "No rewind history available.");
+        return -1;
+    }
+
+    cycles = (CLOCK)(seconds * (double)machine_get_cycles_per_second());
+    target = maincpu_clk > cycles ? maincpu_clk - cycles : 0;
+
+    while (current_clk > target && entries_num > 0) {
+        rewind_entry_t *e = &entries[entries_num - 1];
+
+        memory_reserve(&current.data, &current.alloc, e->state_size);
+        if (delta_apply(e->delta, e->delta_size, current.data, current.size,
+                        e->state_size) < 0) {
+            log_error(rewind_log, "Corrupt rewind history, clearing.");
+            rewind_clear();
+            return -1;
+        }
+        current.size = e->state_size;
+        current_clk = e->clk;
+
+        entries_bytes -= e->delta_size;
+        lib_free(e->delta);
+        entries_num--;
+    }
+
+    snapshot_set_memory(&current);
+    err = machine_read_snapshot("", 0);
+    snapshot_set_memory(NULL);
+
+    if (err < 0) {
+        log_error(rewind_log, "Cannot restore machine state, clearing history.");
+        rewind_clear();
+        return -1;
+    }
+
+    frame_counter = 0;
+    return 0;
+}
+
+static void rewind_step_back_trap(uint16_t addr, void *data)
+{
+    rewind_step_back((double)rewind_step);
+}
+
+/* Step back `RewindStep' seconds at the next opportunity, for UI actions.  */
+void rewind_trigger_step_back(void)
+{
+    interrupt_maincpu_trigger_trap(rewind_step_back_trap, NULL);
+}
+
+void rewind_shutdown(void)
+{
+    rewind_clear();
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int set_rewind_enabled(int val, void *param)
+{
+    rewind_enabled = val ? 1 : 0;
+    if (!rewind_enabled) {
+        rewind_clear();
+    }
+    return 0;
+}
+
+static int set_rewind_interval(int val, void *param)
+{
+    if (val < 1 || val > 3000) {
+        return -1;
+    }
+    rewind_interval = val;
+    return 0;
+}
+
+static int set_rewind_memory(int val, void *param)
+{
+    if (val < 1 || val > 4096) {
+        return -1;
+    }
+    rewind_memory = val;
+    rewind_trim();
+    return 0;
+}
+
+static int set_rewind_step(int val, void *param)
+{
+    if (val < 1 || val > 3600) {
+        return -1;
+    }
+    rewind_step = val;
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "RewindEnable", 0, RES_EVENT_NO, NULL,
+      &rewind_enabled, set_rewind_enabled, NULL },
+    { "RewindInterval", 25, RES_EVENT_NO, NULL,
+      &rewind_interval, set_rewind_interval, NULL },
+    { "RewindMemory", 64, RES_EVENT_NO, NULL,
+      &rewind_memory, set_rewind_memory, NULL },
+    { "RewindStep", 1, RES_EVENT_NO, NULL,
+      &rewind_step, set_rewind_step, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int rewind_resources_init(void)
+{
+    rewind_log = log_open("Rewind");
+
+    if (machine_class == VICE_MACHINE_VSID) {
+        return 0;
+    }
+    return resources_register_int(resources_int);
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-rewind", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "RewindEnable", (resource_value_t)1,
+      NULL, "Enable the in-memory rewind history" },
+    { "+rewind", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "RewindEnable", (resource_value_t)0,
+      NULL, "Disable the in-memory rewind history" },
+    { "-rewindinterval", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "RewindInterval", NULL,
+      "<frames>", "Capture the machine state for rewinding every <frames> frames" },
+    { "-rewindmemory", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "RewindMemory", NULL,
+      "<MiB>", "Limit the rewind history to <MiB> megabytes" },
+    { "-rewindstep", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "RewindStep", NULL,
+      "<seconds>", "Step back <seconds> seconds with the rewind hotkey" },
+    CMDLINE_LIST_END
+};
+
+int rewind_cmdline_options_init(void)
+{
+    if (machine_class == VICE_MACHINE_VSID) {
+        return 0;
+    }
+    return cmdline_register_options(cmdline_options);
+}
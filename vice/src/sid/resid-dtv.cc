@@ -335,4 +335,9 @@ sid_engine_t resid_hooks =
     resid_state_write
 };
 
+/* reSID-dtv has no FIR convolution variants to check */
+void resid_benchmark_init(void)
+{
+}
+
 } // extern "C"
@@ -37,8 +37,23 @@
 
 extern "C" {
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utime.h>
+#define RESID_FIR_CACHE_MMAP
+#endif
 
+#include "archdep.h"
+#include "benchmark.h"
+#include "crc32.h"
 #include "sid/sid.h" /* sid_engine_t */
 #include "lib.h"
 #include "log.h"
@@ -46,6 +61,7 @@ extern "C" {
 #include "resources.h"
 #include "sid-snapshot.h"
 #include "types.h"
+#include "util.h"
 
 /*#define DEBUG_RESID*/
 
@@ -73,28 +89,412 @@ struct sound_s
 
     /* resid sid implementation */
     reSID::SID *sid;
+    /* temporary sample buffer, kept per SID so that several SIDs can be
+       rendered at the same time (see SidResidParallel) */
+    short *buf;
+    int blen;
 };
 
 typedef struct sound_s sound_t;
 
 /* manage temporary buffers. if the requested size is smaller or equal to the
  * size of the already allocated buffer, reuse it.  */
-static short *buf = NULL;
+static short *getbuf(sound_t *psid, int len)
+{
+    if ((psid->buf == NULL) || (psid->blen < len)) {
+        if (psid->buf) {
+            lib_free(psid->buf);
+        }
+        psid->blen = len;
+        psid->buf = (short *)lib_calloc(len, 1);
+    }
+    return psid->buf;
+}
+
+} // extern "C"
+
+/* ------------------------------------------------------------------------- */
+
+/*
+ * On-disk cache of reSID resampling FIR tables.
+ *
+ * Generating the tables takes a noticeable amount of time, in particular for
+ * "fast resampling" where a single table is some 20MB. Generated tables are
+ * written to the user's cache directory, one file per set of parameters, and
+ * mapped into memory (or read, where mmap() is not available) on later use.
+ * Instances using identical parameters share a single mapping.
+ *
+ * The tables are only looked up, built and released while a SID is opened
+ * or (re)initialized, which only happens on the thread running the
+ * emulation, so the list of loaded tables is not locked. Tables are freed
+ * when the last SID using them is closed; whatever is left is freed at
+ * exit.
+ *
+ * Every clock, sampling rate and passband gives another file, so the
+ * directory is trimmed after each write: only the most recently used files
+ * are kept, at most RESID_FIR_CACHE_MAX_FILES of them and
+ * RESID_FIR_CACHE_MAX_SIZE bytes together. Where mmap() is available a
+ * file's modification time is updated when it is loaded; elsewhere the
+ * oldest written files go first.
+ */
+
+#define RESID_FIR_CACHE_MAGIC   "VICEFIR"
+#define RESID_FIR_CACHE_VERSION 1
+
+/* limits of the cache directory, a fast resampling table is some 20MB */
+#define RESID_FIR_CACHE_MAX_FILES   8
+#define RESID_FIR_CACHE_MAX_SIZE    (128 * 1024 * 1024)
+
+/* cache file header, followed by fir_N * fir_RES native endian shorts */
+typedef struct resid_fir_cache_header_s {
+    char magic[8];
+    uint32_t version;
+    int32_t fir_N;
+    int32_t fir_RES;
+    uint32_t crc;       /* CRC32 of the table */
+    double cycles_per_sample;
+    double filter_scale;
+} resid_fir_cache_header_t;
+
+typedef struct resid_fir_cache_entry_s {
+    int fir_N;
+    int fir_RES;
+    double cycles_per_sample;
+    double filter_scale;
+    const short *fir;
+    void *data;         /* mapped file or allocated copy */
+    size_t size;
+    int refcount;
+    struct resid_fir_cache_entry_s *next;
+} resid_fir_cache_entry_t;
+
+class ResidFIRTableCache : public reSID::FIRTableCache
+{
+public:
+    ResidFIRTableCache() : entries(NULL) {}
+    ~ResidFIRTableCache();
+
+    const short *lookup(int fir_N, int fir_RES, double cycles_per_sample,
+                        double filter_scale);
+    void release(const short *fir);
+    void store(int fir_N, int fir_RES, double cycles_per_sample,
+               double filter_scale, const short *fir);
+
+private:
+    resid_fir_cache_entry_t *entries;
+};
+
+static ResidFIRTableCache resid_fir_cache;
+
+/* build the name of the cache file for a set of parameters */
+static char *resid_fir_cache_filename(int fir_N, int fir_RES,
+                                      double cycles_per_sample,
+                                      double filter_scale)
+{
+    double key[2];
+    char name[64];
+
+    key[0] = cycles_per_sample;
+    key[1] = filter_scale;
+    sprintf(name, "resid-fir-%d-%d-%08x.bin", fir_N, fir_RES,
+            (unsigned int)crc32_buf((const char *)key, sizeof key));
+    return util_join_paths(archdep_user_cache_path(), name, NULL);
+}
 
-static int blen = 0;
+typedef struct resid_fir_cache_file_s {
+    char *path;
+    time_t mtime;
+    size_t size;
+} resid_fir_cache_file_t;
 
-static short *getbuf(int len)
+/* newest first */
+static int resid_fir_cache_file_cmp(const void *p1, const void *p2)
 {
-    if ((buf == NULL) || (blen < len)) {
-        if (buf) {
-            lib_free(buf);
+    const resid_fir_cache_file_t *f1 = (const resid_fir_cache_file_t *)p1;
+    const resid_fir_cache_file_t *f2 = (const resid_fir_cache_file_t *)p2;
+
+    if (f1->mtime != f2->mtime) {
+        return f1->mtime < f2->mtime ? 1 : -1;
+    }
+    return strcmp(f1->path, f2->path);
+}
+
+/* remove the least recently used cache files beyond the limits */
+static void resid_fir_cache_trim(void)
+{
+    archdep_dir_t *dir;
+    resid_fir_cache_file_t *files;
+    const char *name;
+    struct stat st;
+    size_t total = 0;
+    int num = 0;
+    int i;
+
+    dir = archdep_opendir(archdep_user_cache_path(), ARCHDEP_OPENDIR_ALL_FILES);
+    if (dir == NULL) {
+        return;
+    }
+    files = (resid_fir_cache_file_t *)lib_malloc(
+        (archdep_readdir_num_files(dir) + 1) * sizeof *files);
+
+    for (i = 0; (name = archdep_readdir_get_file(dir, i)) != NULL; i++) {
+        size_t len = strlen(name);
+
+        if (strncmp(name, "resid-fir-", 10) != 0 || len < 14
+            || strcmp(name + len - 4, ".bin") != 0) {
+            continue;
+        }
+        files[num].path = util_join_paths(archdep_user_cache_path(), name, NULL);
+        if (stat(files[num].path, &st) != 0) {
+            lib_free(files[num].path);
+            continue;
+        }
+        files[num].mtime = st.st_mtime;
+        files[num].size = (size_t)st.st_size;
+        num++;
+    }
+    archdep_closedir(dir);
+
+    qsort(files, (size_t)num, sizeof *files, resid_fir_cache_file_cmp);
+    for (i = 0; i < num; i++) {
+        /* a table that is still mapped stays valid after its file is gone */
+        if (i > 0 && (i >= RESID_FIR_CACHE_MAX_FILES
+                      || total + files[i].size > RESID_FIR_CACHE_MAX_SIZE)) {
+            DBG(("reSID: removing FIR table cache '%s'", files[i].path));
+            archdep_remove(files[i].path);
+        } else {
+            total += files[i].size;
         }
-        blen = len;
-        buf = (short *)lib_calloc(len, 1);
+        lib_free(files[i].path);
+    }
+    lib_free(files);
+}
+
+/* check header and checksum of a cache file loaded to memory */
+static int resid_fir_cache_validate(const void *data, size_t size,
+                                    int fir_N, int fir_RES,
+                                    double cycles_per_sample,
+                                    double filter_scale)
+{
+    const resid_fir_cache_header_t *header = (const resid_fir_cache_header_t *)data;
+    size_t table_size = (size_t)fir_N * fir_RES * sizeof(short);
+
+    if (size != sizeof *header + table_size
+        || memcmp(header->magic, RESID_FIR_CACHE_MAGIC, sizeof header->magic) != 0
+        || header->version != RESID_FIR_CACHE_VERSION
+        || header->fir_N != fir_N
+        || header->fir_RES != fir_RES
+        || header->cycles_per_sample != cycles_per_sample
+        || header->filter_scale != filter_scale) {
+        return 0;
+    }
+    return crc32_buf((const char *)(header + 1), (unsigned int)table_size) == header->crc;
+}
+
+/* release the memory holding a cache file */
+static void resid_fir_cache_unload(void *data, size_t size)
+{
+#ifdef RESID_FIR_CACHE_MMAP
+    munmap(data, size);
+#else
+    lib_free(data);
+#endif
+}
+
+/* map or read a cache file, returns NULL on failure */
+static void *resid_fir_cache_load(const char *filename, size_t *size)
+{
+#ifdef RESID_FIR_CACHE_MMAP
+    struct stat st;
+    void *data;
+    int fd;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size <= (off_t)sizeof(resid_fir_cache_header_t)) {
+        close(fd);
+        return NULL;
+    }
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    *size = (size_t)st.st_size;
+    return data;
+#else
+    FILE *fd;
+    void *data;
+    long len;
+
+    fd = fopen(filename, MODE_READ);
+    if (fd == NULL) {
+        return NULL;
     }
-    return buf;
+    if (fseek(fd, 0, SEEK_END) != 0 || (len = ftell(fd)) <= (long)sizeof(resid_fir_cache_header_t)) {
+        fclose(fd);
+        return NULL;
+    }
+    rewind(fd);
+    data = lib_malloc((size_t)len);
+    if (fread(data, 1, (size_t)len, fd) != (size_t)len) {
+        lib_free(data);
+        fclose(fd);
+        return NULL;
+    }
+    fclose(fd);
+    *size = (size_t)len;
+    return data;
+#endif
 }
 
+const short *ResidFIRTableCache::lookup(int fir_N, int fir_RES,
+                                        double cycles_per_sample,
+                                        double filter_scale)
+{
+    resid_fir_cache_entry_t *entry;
+    char *filename;
+    void *data;
+    size_t size;
+
+    /* already in use by another instance? */
+    for (entry = entries; entry != NULL; entry = entry->next) {
+        if (entry->fir_N == fir_N && entry->fir_RES == fir_RES
+            && entry->cycles_per_sample == cycles_per_sample
+            && entry->filter_scale == filter_scale) {
+            entry->refcount++;
+            return entry->fir;
+        }
+    }
+
+    if (archdep_user_cache_path() == NULL) {
+        return NULL;
+    }
+    filename = resid_fir_cache_filename(fir_N, fir_RES, cycles_per_sample,
+                                        filter_scale);
+    data = resid_fir_cache_load(filename, &size);
+    if (data == NULL) {
+        lib_free(filename);
+        return NULL;
+    }
+    if (!resid_fir_cache_validate(data, size, fir_N, fir_RES,
+                                  cycles_per_sample, filter_scale)) {
+        log_warning(sound_log, "reSID: ignoring invalid FIR table cache `%s'.",
+                    filename);
+        resid_fir_cache_unload(data, size);
+        lib_free(filename);
+        return NULL;
+    }
+    DBG(("reSID: loaded FIR table cache '%s'", filename));
+#ifdef RESID_FIR_CACHE_MMAP
+    /* mark as recently used for resid_fir_cache_trim() */
+    utime(filename, NULL);
+#endif
+    lib_free(filename);
+
+    entry = (resid_fir_cache_entry_t *)lib_malloc(sizeof *entry);
+    entry->fir_N = fir_N;
+    entry->fir_RES = fir_RES;
+    entry->cycles_per_sample = cycles_per_sample;
+    entry->filter_scale = filter_scale;
+    entry->fir = (const short *)((const resid_fir_cache_header_t *)data + 1);
+    entry->data = data;
+    entry->size = size;
+    entry->refcount = 1;
+    entry->next = entries;
+    entries = entry;
+
+    return entry->fir;
+}
+
+ResidFIRTableCache::~ResidFIRTableCache()
+{
+    resid_fir_cache_entry_t *entry;
+
+    while (entries != NULL) {
+        entry = entries;
+        entries = entry->next;
+        resid_fir_cache_unload(entry->data, entry->size);
+        lib_free(entry);
+    }
+}
+
+void ResidFIRTableCache::release(const short *fir)
+{
+    resid_fir_cache_entry_t **link;
+    resid_fir_cache_entry_t *entry;
+
+    for (link = &entries; *link != NULL; link = &(*link)->next) {
+        entry = *link;
+        if (entry->fir == fir) {
+            if (--entry->refcount == 0) {
+                *link = entry->next;
+                resid_fir_cache_unload(entry->data, entry->size);
+                lib_free(entry);
+            }
+            return;
+        }
+    }
+}
+
+void ResidFIRTableCache::store(int fir_N, int fir_RES,
+                               double cycles_per_sample,
+                               double filter_scale, const short *fir)
+{
+    resid_fir_cache_header_t header;
+    size_t table_size = (size_t)fir_N * fir_RES * sizeof(short);
+    char *filename;
+    char *tmpname;
+    FILE *fd;
+    int ok;
+
+    if (archdep_user_cache_path() == NULL) {
+        return;
+    }
+
+    memset(&header, 0, sizeof header);
+    memcpy(header.magic, RESID_FIR_CACHE_MAGIC, sizeof header.magic);
+    header.version = RESID_FIR_CACHE_VERSION;
+    header.fir_N = fir_N;
+    header.fir_RES = fir_RES;
+    header.crc = crc32_buf((const char *)fir, (unsigned int)table_size);
+    header.cycles_per_sample = cycles_per_sample;
+    header.filter_scale = filter_scale;
+
+    filename = resid_fir_cache_filename(fir_N, fir_RES, cycles_per_sample,
+                                        filter_scale);
+    tmpname = util_concat(filename, ".tmp", NULL);
+
+    /* write to a temporary file first so a concurrently running instance
+       never sees a partially written table */
+    fd = fopen(tmpname, MODE_WRITE);
+    if (fd == NULL) {
+        lib_free(tmpname);
+        lib_free(filename);
+        return;
+    }
+    ok = fwrite(&header, sizeof header, 1, fd) == 1
+         && fwrite(fir, 1, table_size, fd) == table_size;
+    if (fclose(fd) != 0) {
+        ok = 0;
+    }
+    if (!ok || archdep_rename(tmpname, filename) != 0) {
+        log_warning(sound_log, "reSID: failed to write FIR table cache `%s'.",
+                    filename);
+        archdep_remove(tmpname);
+    } else {
+        resid_fir_cache_trim();
+    }
+    lib_free(tmpname);
+    lib_free(filename);
+}
+
+/* ------------------------------------------------------------------------- */
+
+extern "C" {
+
 static sound_t *resid_open(uint8_t *sidstate)
 {
     sound_t *psid;
@@ -102,6 +502,10 @@ static sound_t *resid_open(uint8_t *sidstate)
     DBG(("resid_open"));
     psid = new sound_t;
     psid->sid = new reSID::SID;
+    psid->buf = NULL;
+    psid->blen = 0;
+
+    reSID::SID::set_fir_table_cache(&resid_fir_cache);
 
     for (i = 0x00; i <= 0x18; i++) {
         psid->sid->write(i, sidstate[i]);
@@ -250,13 +654,11 @@ static int resid_init(sound_t *psid, int speed, int cycles_per_sec, int factor)
 
 static void resid_close(sound_t *psid)
 {
+    if (psid->buf) {
+        lib_free(psid->buf);
+    }
     delete psid->sid;
     delete psid;
-
-    if (buf) {
-        lib_free(buf);
-        buf = NULL;
-    }
 }
 
 static uint8_t resid_read(sound_t *psid, uint16_t addr)
@@ -287,7 +689,7 @@ static int resid_calculate_samples(sound_t *psid, float *pbuf, int nr, CLOCK *de
     /* Tried not to mess with resid during 64-bit conversion. clock(...) wants to modify *delta_t ... */
 
     if (psid->factor == 1000) {
-        tmp_buf = getbuf(2 * nr);
+        tmp_buf = getbuf(psid, 2 * nr);
         retval = psid->sid->clock(int_delta_t, tmp_buf, nr, 0);
         (*delta_t) += int_delta_t - int_delta_t_original;
         for (i = 0; i < nr; i++) {
@@ -296,7 +698,7 @@ static int resid_calculate_samples(sound_t *psid, float *pbuf, int nr, CLOCK *de
         return retval;
     }
 
-    tmp_buf = getbuf(2 * nr * psid->factor / 1000);
+    tmp_buf = getbuf(psid, 2 * nr * psid->factor / 1000);
     retval = psid->sid->clock(int_delta_t, tmp_buf, nr * psid->factor / 1000, 0) * 1000 / psid->factor;
     (*delta_t) += int_delta_t - int_delta_t_original;
     for (i = 0; i < nr; i++) {
@@ -323,7 +725,7 @@ static int resid_calculate_samples(sound_t *psid, short *pbuf, int nr, int inter
     }
 
     /* Used when SID does not run at system clock ("SID card") */
-    tmp_buf = getbuf(2 * nr * psid->factor / 1000);
+    tmp_buf = getbuf(psid, 2 * nr * psid->factor / 1000);
     retval = psid->sid->clock(int_delta_t, tmp_buf, nr * psid->factor / 1000, interleave);
     (*delta_t) += int_delta_t - int_delta_t_original;
     memcpy(pbuf, tmp_buf, retval * 2);
@@ -448,6 +850,147 @@ static void resid_state_write(sound_t *psid, sid_snapshot_state_t *sid_state)
     psid->sid->write_state((const reSID::SID::State)state);
 }
 
+#ifdef FEATURE_BENCHMARK_HOOKS
+/* The "residfir" micro benchmark runs the same register writes through
+   resampling and fast resampling with each FIR convolution the CPU
+   supports, and checks that they all give the samples of the scalar one. */
+
+/* one second of PAL frames, 48 kHz output */
+#define RESIDFIR_BENCHMARK_FRAMES       50
+#define RESIDFIR_BENCHMARK_FRAME_CYCLES 19656
+#define RESIDFIR_BENCHMARK_CLOCK        985248
+#define RESIDFIR_BENCHMARK_SPEED        48000
+#define RESIDFIR_BENCHMARK_SAMPLES      (RESIDFIR_BENCHMARK_FRAMES * 1024)
+
+static uint32_t residfir_benchmark_random(uint32_t *seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 16;
+}
+
+/* render all frames into `out', returns the number of samples */
+static int residfir_benchmark_render(reSID::sampling_method method, short *out, double *seconds)
+{
+    static const reg8 waves[] = { 0x11, 0x21, 0x41, 0x81, 0x51, 0x10, 0x20, 0x40 };
+    reSID::SID *sid;
+    uint32_t seed = 1;
+    tick_t start;
+    int frame, i, n, nr = 0;
+
+    /* the filter noise is taken from rand() when the SID is created */
+    srand(1);
+    reSID::SID::set_fir_table_cache(&resid_fir_cache);
+    sid = new reSID::SID;
+    sid->set_sampling_parameters(RESIDFIR_BENCHMARK_CLOCK, method, RESIDFIR_BENCHMARK_SPEED);
+    sid->write(0x18, 0x0f);
+
+    start = tick_now();
+    for (frame = 0; frame < RESIDFIR_BENCHMARK_FRAMES; frame++) {
+        reSID::cycle_count delta_t = RESIDFIR_BENCHMARK_FRAME_CYCLES;
+
+        /* a few random notes, waveforms and filter settings per frame */
+        for (i = 0; i < 8; i++) {
+            uint32_t r = residfir_benchmark_random(&seed);
+            reg8 addr = (reg8)(r % 0x19);
+            reg8 byte = (reg8)(r >> 8);
+
+            if (addr % 7 == 4) {
+                byte = waves[byte & 7];
+            } else if (addr == 0x18) {
+                byte |= 0x0f;
+            }
+            sid->write(addr, byte);
+        }
+
+        while (delta_t > 0 && nr < RESIDFIR_BENCHMARK_SAMPLES) {
+            n = sid->clock(delta_t, out + nr, RESIDFIR_BENCHMARK_SAMPLES - nr, 1);
+            if (n <= 0) {
+                break;
+            }
+            nr += n;
+        }
+    }
+    *seconds = (double)tick_now_delta(start) / tick_per_second();
+
+    delete sid;
+
+    return nr;
+}
+
+static int residfir_benchmark(void)
+{
+    static const struct {
+        reSID::SID::convolve_type type;
+        const char *name;
+    } convolves[] = {
+        { reSID::SID::CONVOLVE_SCALAR, "scalar" },
+        { reSID::SID::CONVOLVE_SSE2, "SSE2" },
+        { reSID::SID::CONVOLVE_AVX2, "AVX2" }
+    };
+    static const struct {
+        reSID::sampling_method method;
+        const char *name;
+    } methods[] = {
+        { reSID::SAMPLE_RESAMPLE, "resampling" },
+        { reSID::SAMPLE_RESAMPLE_FASTMEM, "fast resampling" }
+    };
+    short *ref, *out;
+    unsigned long checks = 0, mismatches = 0;
+    int m, c, i, nr, ref_nr = 0;
+
+    ref = (short *)lib_malloc(RESIDFIR_BENCHMARK_SAMPLES * sizeof(short));
+    out = (short *)lib_malloc(RESIDFIR_BENCHMARK_SAMPLES * sizeof(short));
+
+    for (m = 0; m < (int)(sizeof(methods) / sizeof(methods[0])); m++) {
+        for (c = 0; c < (int)(sizeof(convolves) / sizeof(convolves[0])); c++) {
+            char test[64];
+            double seconds;
+
+            if (!reSID::SID::set_convolve(convolves[c].type)) {
+                printf("Benchmark residfir: %s %s not supported by the CPU\n",
+                       methods[m].name, convolves[c].name);
+                continue;
+            }
+            nr = residfir_benchmark_render(methods[m].method, c ? out : ref, &seconds);
+            sprintf(test, "%s %s", methods[m].name, convolves[c].name);
+            benchmark_kernel_result("residfir", test, seconds, nr, "samples");
+
+            if (c == 0) {
+                ref_nr = nr;
+                continue;
+            }
+            checks += (unsigned long)ref_nr;
+            if (nr != ref_nr) {
+                log_error(sound_log, "reSID FIR benchmark: %s gives %d samples instead of %d.",
+                          test, nr, ref_nr);
+                mismatches += (unsigned long)abs(nr - ref_nr);
+            }
+            for (i = 0; i < (nr < ref_nr ? nr : ref_nr); i++) {
+                if (out[i] != ref[i]) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+    reSID::SID::set_convolve(reSID::SID::CONVOLVE_AUTO);
+    printf("Benchmark residfir: %lu samples compared, %lu mismatches\n", checks, mismatches);
+
+    lib_free(out);
+    lib_free(ref);
+
+    return mismatches ? -1 : 0;
+}
+#endif
+
+void resid_benchmark_init(void)
+{
+#ifdef FEATURE_BENCHMARK_HOOKS
+    benchmark_kernel_register("residfir",
+                              "resample SID output with each FIR convolution, check against the scalar one",
+                              NULL, residfir_benchmark);
+#endif
+}
+
 sid_engine_t resid_hooks =
 {
     resid_open,
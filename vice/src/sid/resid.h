@@ -31,4 +31,6 @@
 
 extern sid_engine_t resid_hooks;
 
+void resid_benchmark_init(void);
+
 #endif
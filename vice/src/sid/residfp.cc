@@ -77,26 +77,26 @@ struct sound_s
 
     /* resid sid implementation */
     reSIDfp::SID *sid;
+    /* temporary sample buffer, kept per SID so that several SIDs can be
+       rendered at the same time (see SidResidParallel) */
+    short *buf;
+    int blen;
 };
 
 typedef struct sound_s sound_t;
 
 /* manage temporary buffers. if the requested size is smaller or equal to the
  * size of the already allocated buffer, reuse it.  */
-static short *buf = NULL;
-
-static int blen = 0;
-
-static short *getbuf(int len)
+static short *getbuf(sound_t *psid, int len)
 {
-    if ((buf == NULL) || (blen < len)) {
-        if (buf) {
-            lib_free(buf);
+    if ((psid->buf == NULL) || (psid->blen < len)) {
+        if (psid->buf) {
+            lib_free(psid->buf);
         }
-        blen = len;
-        buf = (short *)lib_calloc(len, 1);
+        psid->blen = len;
+        psid->buf = (short *)lib_calloc(len, 1);
     }
-    return buf;
+    return psid->buf;
 }
 
 static sound_t *residfp_open(uint8_t *sidstate)
@@ -108,6 +108,8 @@ static sound_t *residfp_open(uint8_t *sidstate)
 
     psid = new sound_t;
     psid->sid = new reSIDfp::SID;
+    psid->buf = NULL;
+    psid->blen = 0;
 
     for (i = 0x00; i <= 0x18; i++) {
         psid->sid->write(i, sidstate[i]);
@@ -239,13 +241,11 @@ static int residfp_init(sound_t *psid, int speed, int cycles_per_sec, int factor
 
 static void residfp_close(sound_t *psid)
 {
+    if (psid->buf) {
+        lib_free(psid->buf);
+    }
     delete psid->sid;
     delete psid;
-
-    if (buf) {
-        lib_free(buf);
-        buf = NULL;
-    }
 }
 
 static uint8_t residfp_read(sound_t *psid, uint16_t addr)
@@ -277,7 +277,7 @@ static int residfp_calculate_samples(sound_t *psid, float *pbuf, int nr, CLOCK *
     /* Tried not to mess with resid during 64-bit conversion. clock(...) wants to modify *delta_t ... */
 
     if (psid->factor == 1000) {
-        tmp_buf = getbuf(2 * nr);
+        tmp_buf = getbuf(psid, 2 * nr);
         retval = psid->sid->clock(int_delta_t, tmp_buf, nr, 0);
         (*delta_t) += int_delta_t - int_delta_t_original;
         for (i = 0; i < nr; i++) {
@@ -286,7 +286,7 @@ static int residfp_calculate_samples(sound_t *psid, float *pbuf, int nr, CLOCK *
         return retval;
     }
 
-    tmp_buf = getbuf(2 * nr * psid->factor / 1000);
+    tmp_buf = getbuf(psid, 2 * nr * psid->factor / 1000);
     retval = psid->sid->clock(int_delta_t, tmp_buf, nr * psid->factor / 1000, 0) * 1000 / psid->factor;
     (*delta_t) += int_delta_t - int_delta_t_original;
     for (i = 0; i < nr; i++) {
@@ -305,7 +305,7 @@ static int residfp_calculate_samples(sound_t *psid, short *pbuf, int nr, int int
     /* Tried not to mess with resid during 64-bit conversion. clock(...) wants to modify *delta_t ... */
     if ((nr > 0) && (int_delta_t > 0)) {
         if (psid->factor == 1000) {
-            tmp_buf = getbuf(2 * nr);
+            tmp_buf = getbuf(psid, 2 * nr);
 
             /* CAUTION: unlike ReSID; this does NOT return the number of cycles "left to do" in int_delta_t */
             retval = psid->sid->clock(int_delta_t, tmp_buf);
@@ -321,7 +321,7 @@ static int residfp_calculate_samples(sound_t *psid, short *pbuf, int nr, int int
         }
 
         /* Used when SID does not run at system clock ("SID card") */
-        tmp_buf = getbuf(2 * nr * psid->factor / 1000);
+        tmp_buf = getbuf(psid, 2 * nr * psid->factor / 1000);
         retval = psid->sid->clock(int_delta_t, tmp_buf);
         if (retval > 0) {
             int n, p = 0;
@@ -244,6 +244,10 @@ static const cmdline_option_t resid_cmdline_options[] =
     { "-residsamp", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "SidResidSampling", NULL,
       "<method>", "reSID sampling method (0: fast, 1: interpolating, 2: resampling, 3: fast resampling)" },
+    { "-residparallel", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "SidResidParallel", (void *)1, NULL, "Render multiple reSID SIDs in parallel on several threads." },
+    { "+residparallel", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "SidResidParallel", (void *)0, NULL, "Render multiple reSID SIDs one after the other." },
 #ifdef HAVE_RESID
     { "-residpass", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "SidResidPassband", NULL,
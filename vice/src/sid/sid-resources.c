@@ -68,6 +68,7 @@ static int sid_filters_enabled;       /* app_resources.sidFilters */
 static int sid_model;                 /* app_resources.sidModel */
 #if defined(HAVE_RESID) || defined(HAVE_RESIDFP)
 static int sid_resid_sampling;
+static int sid_resid_parallel;
 #endif
 #if defined(HAVE_RESID)
 static int sid_resid_passband;
@@ -301,6 +302,15 @@ static int set_sid_resid_sampling(int val, void *param)
     sid_state_changed = 1;
     return 0;
 }
+
+static int set_sid_resid_parallel(int val, void *param)
+{
+    sid_resid_parallel = val ? 1 : 0;
+
+    sid_state_changed = 1;
+
+    return 0;
+}
 #endif
 #if defined(HAVE_RESID) || defined(HAVE_RESID_DTV)
 static int set_sid_resid_passband(int i, void *param)
@@ -535,6 +545,8 @@ void sid_set_enable(int value)
 static const resource_int_t resid_resources_int[] = {
     { "SidResidSampling", SID_RESID_SAMPLING_RESAMPLING, RES_EVENT_NO, NULL,
       &sid_resid_sampling, set_sid_resid_sampling, NULL },
+    { "SidResidParallel", 0, RES_EVENT_NO, NULL,
+      &sid_resid_parallel, set_sid_resid_parallel, NULL },
 #if defined(HAVE_RESID) || defined(HAVE_RESID_DTV)
     { "SidResidEnableRawOutput", 0, RES_EVENT_NO, NULL,
       &sid_resid_enable_raw_output, set_sid_resid_enable_raw_output, NULL },
@@ -669,6 +681,8 @@ int sid_common_resources_init(void)
     }
 #endif
 
+    sid_benchmark_init();
+
     return resources_register_int(common_resources_int);
 }
 
@@ -32,15 +32,19 @@
 #include "vice.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "alarm.h"
+#include "archdep.h"
+#include "benchmark.h"
 #include "catweaselmkiii.h"
 #include "fastsid.h"
 #include "hardsid.h"
 #include "usbsid.h"
 #include "joyport.h"
 #include "lib.h"
+#include "log.h"
 #include "machine.h"
 #include "maincpu.h"
 #include "parsid.h"
@@ -693,10 +697,108 @@ GETBUFx(7)
 GETBUFx(8)
 GETBUFx(9)
 
+/* Parallel rendering of multiple SIDs (SidResidParallel).
+
+   Each SID is clocked independently into its own part of the output, so the
+   calculate_samples calls of one sid_sound_machine_calculate_samples() call
+   can run at the same time. While deferred, sid_render() only records the
+   calls, and sid_render_flush() runs them all before the results are mixed.
+   The calls and the mixing are exactly the same as in serial mode, so the
+   output is identical. Short runs (a few cycles between two register
+   writes) are not worth the thread overhead and are always done serially.
+*/
+
+#define SID_RENDER_PARALLEL_MIN_CYCLES  1000
+
+typedef struct sid_render_job_s {
+    sound_t *psid;
+    int16_t *pbuf;
+    int nr;
+    int interleave;
+    CLOCK delta_t;
+    CLOCK *delta_t_out;
+    int retval;
+} sid_render_job_t;
+
+static sid_render_job_t sid_render_jobs[SOUND_SIDS_MAX];
+static int sid_render_num_jobs = 0;
+static int sid_render_deferred = 0;
+static int sid_render_parallel = 0;
+
+static int sid_render(sound_t *psid, int16_t *pbuf, int nr, int interleave, CLOCK *delta_t)
+{
+    sid_render_job_t *job;
+
+    if (!sid_render_deferred) {
+        return sid_engine.calculate_samples(psid, pbuf, nr, interleave, delta_t);
+    }
+
+    job = &sid_render_jobs[sid_render_num_jobs++];
+    job->psid = psid;
+    job->pbuf = pbuf;
+    job->nr = nr;
+    job->interleave = interleave;
+    job->delta_t = *delta_t;
+    job->delta_t_out = delta_t;
+
+    /* the real value is returned by sid_render_flush() */
+    return nr;
+}
+
+/* run all recorded calls, returns the result of the last one */
+static int sid_render_flush(int retval)
+{
+    int i;
+
+    if (!sid_render_deferred) {
+        return retval;
+    }
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (i = 0; i < sid_render_num_jobs; i++) {
+        sid_render_job_t *job = &sid_render_jobs[i];
+
+        job->retval = sid_engine.calculate_samples(job->psid, job->pbuf, job->nr, job->interleave, &job->delta_t);
+    }
+
+    /* hand back the remaining cycles in call order, like the serial code */
+    for (i = 0; i < sid_render_num_jobs; i++) {
+        *sid_render_jobs[i].delta_t_out = sid_render_jobs[i].delta_t;
+    }
+    retval = sid_render_jobs[sid_render_num_jobs - 1].retval;
+
+    sid_render_num_jobs = 0;
+    sid_render_deferred = 0;
+
+    return retval;
+}
+
+/* Only the reSID engines keep all their temporary state per SID. The raw
+   output debug file of reSID is shared by all SIDs, so don't use parallel
+   rendering when it is enabled. */
+static void sid_render_update_parallel(void)
+{
+    int parallel = 0;
+    int raw_output = 0;
+
+    resources_get_int("SidResidParallel", &parallel);
+#ifdef HAVE_RESID
+    resources_get_int("SidResidEnableRawOutput", &raw_output);
+#endif
+
+    sid_render_parallel = parallel
+                          && !raw_output
+                          && (sid_engine_type == SID_ENGINE_RESID
+                              || sid_engine_type == SID_ENGINE_RESIDFP);
+}
+
 #endif
 
 int sid_sound_machine_init_vbr(sound_t *psid, int speed, int cycles_per_sec, int factor)
 {
+#ifndef SOUND_SYSTEM_FLOAT
+    sid_render_update_parallel();
+#endif
     return sid_engine.init(psid, speed * factor / 1000, cycles_per_sec, factor);
 }
 
@@ -705,6 +807,9 @@ int sid_sound_machine_init(sound_t *psid, int speed, int cycles_per_sec)
     #ifdef HAVE_USBSID
     usbsid_open();
     #endif
+#ifndef SOUND_SYSTEM_FLOAT
+    sid_render_update_parallel();
+#endif
     return sid_engine.init(psid, speed, cycles_per_sec, 1000);
 }
 
@@ -804,46 +909,47 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     int tmp_nr = 0;
     CLOCK tmp_delta_t = *delta_t;
 
+    sid_render_deferred = sid_render_parallel
+                          && scc > SOUND_1_DEVICE
+                          && *delta_t >= SID_RENDER_PARALLEL_MIN_CYCLES;
+
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_1_DEVICE) {
         return sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
     }
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_2_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
-        }
+        tmp_nr = sid_render(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr);
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_3_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
-        }
+        tmp_nr = sid_render(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr);
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_4_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf3[i]);
-        }
+        tmp_nr = sid_render(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf3, tmp_nr);
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_5_DEVICES) {
@@ -851,20 +957,19 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
         tmp_buf4 = getbuf4(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf3[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf4[i]);
-        }
+        tmp_nr = sid_render(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf3, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf4, tmp_nr);
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_6_DEVICES) {
@@ -873,23 +978,22 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf3 = getbuf3(2 * nr);
         tmp_buf4 = getbuf4(2 * nr);
         tmp_buf5 = getbuf5(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf3[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf4[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf5[i]);
-        }
+        tmp_nr = sid_render(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf3, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf4, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf5, tmp_nr);
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_7_DEVICES) {
@@ -899,26 +1003,25 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf4 = getbuf4(2 * nr);
         tmp_buf5 = getbuf5(2 * nr);
         tmp_buf6 = getbuf6(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf6, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf3[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf4[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf5[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf6[i]);
-        }
+        tmp_nr = sid_render(psid[6], tmp_buf6, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf3, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf4, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf5, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf6, tmp_nr);
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_8_DEVICES) {
@@ -929,29 +1032,28 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf5 = getbuf5(2 * nr);
         tmp_buf6 = getbuf6(2 * nr);
         tmp_buf7 = getbuf7(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf6, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[6], tmp_buf6, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[7], tmp_buf7, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf3[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf4[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf5[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf6[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf7[i]);
-        }
+        tmp_nr = sid_render(psid[7], tmp_buf7, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf3, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf4, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf5, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf6, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf7, tmp_nr);
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_9_DEVICES) {
@@ -963,32 +1065,31 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf6 = getbuf6(2 * nr);
         tmp_buf7 = getbuf7(2 * nr);
         tmp_buf8 = getbuf8(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf6, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[6], tmp_buf6, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[7], tmp_buf7, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[7], tmp_buf7, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[8], tmp_buf8, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf3[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf4[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf5[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf6[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf7[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf8[i]);
-        }
+        tmp_nr = sid_render(psid[8], tmp_buf8, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf3, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf4, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf5, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf6, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf7, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf8, tmp_nr);
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_10_DEVICES) {
@@ -1001,231 +1102,338 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf7 = getbuf7(2 * nr);
         tmp_buf8 = getbuf8(2 * nr);
         tmp_buf9 = getbuf9(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf6, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[6], tmp_buf6, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[7], tmp_buf7, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[7], tmp_buf7, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[8], tmp_buf8, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[8], tmp_buf8, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[9], tmp_buf9, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf3[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf4[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf5[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf6[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf7[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf8[i]);
-            pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf9[i]);
-        }
+        tmp_nr = sid_render(psid[9], tmp_buf9, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf3, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf4, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf5, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf6, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf7, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf8, tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf9, tmp_nr);
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_1_DEVICE) {
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, delta_t);
+        tmp_nr = sid_render(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[(i * 2) + 1] = pbuf[i * 2];
         }
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_2_DEVICES) {
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        tmp_nr = sid_render(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_3_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[i]);
-        }
+        tmp_nr = sid_render(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer_mono(pbuf, tmp_buf1, tmp_nr);
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_4_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
-        }
+        tmp_nr = sid_render(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr * 2);
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_5_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[4], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf2[i]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf2[i]);
-        }
+        tmp_nr = sid_render(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr * 2);
+        sound_audio_mix_buffer_mono(pbuf, tmp_buf2, tmp_nr);
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_6_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf2[i * 2]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf2[(i * 2) + 1]);
-        }
+        tmp_nr = sid_render(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr * 2);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr * 2);
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_7_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[6], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf2[i * 2]);
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf3[i]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf2[(i * 2) + 1]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf3[i]);
-        }
+        tmp_nr = sid_render(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr * 2);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr * 2);
+        sound_audio_mix_buffer_mono(pbuf, tmp_buf3, tmp_nr);
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_8_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf3, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[6], tmp_buf3, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[7], tmp_buf3 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[7], tmp_buf3 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf2[i * 2]);
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf3[i * 2]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf2[(i * 2) + 1]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf3[(i * 2) + 1]);
-        }
+        tmp_nr = sid_render(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr * 2);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr * 2);
+        sound_audio_mix_buffer(pbuf, tmp_buf3, tmp_nr * 2);
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_9_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
         tmp_buf4 = getbuf4(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf3, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[6], tmp_buf3, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[7], tmp_buf3 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[7], tmp_buf3 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[8], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[8], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf2[i * 2]);
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf3[i * 2]);
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf4[i]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf2[(i * 2) + 1]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf3[(i * 2) + 1]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf4[i]);
-        }
+        tmp_nr = sid_render(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr * 2);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr * 2);
+        sound_audio_mix_buffer(pbuf, tmp_buf3, tmp_nr * 2);
+        sound_audio_mix_buffer_mono(pbuf, tmp_buf4, tmp_nr);
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_10_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
         tmp_buf4 = getbuf4(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf3, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[6], tmp_buf3, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[7], tmp_buf3 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[7], tmp_buf3 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[8], tmp_buf4, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[8], tmp_buf4, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[9], tmp_buf4 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[9], tmp_buf4 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
-        for (i = 0; i < tmp_nr; i++) {
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf2[i * 2]);
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf3[i * 2]);
-            pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf4[i * 2]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf2[(i * 2) + 1]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf3[(i * 2) + 1]);
-            pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf4[(i * 2) + 1]);
-        }
+        tmp_nr = sid_render(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
+        tmp_nr = sid_render(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        tmp_nr = sid_render_flush(tmp_nr);
+        sound_audio_mix_buffer(pbuf, tmp_buf1, tmp_nr * 2);
+        sound_audio_mix_buffer(pbuf, tmp_buf2, tmp_nr * 2);
+        sound_audio_mix_buffer(pbuf, tmp_buf3, tmp_nr * 2);
+        sound_audio_mix_buffer(pbuf, tmp_buf4, tmp_nr * 2);
     }
     return tmp_nr;
 }
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+/* The "sidparallel" micro benchmark renders the same register writes to 8
+   SIDs with SidResidParallel off and on, in mono and in stereo, and checks
+   that both give exactly the same samples. */
+
+#define SIDPARALLEL_BENCHMARK_SIDS          8
+
+/* one second of PAL frames, 48 kHz output */
+#define SIDPARALLEL_BENCHMARK_FRAMES        50
+#define SIDPARALLEL_BENCHMARK_FRAME_CYCLES  19656
+#define SIDPARALLEL_BENCHMARK_CLOCK         985248
+#define SIDPARALLEL_BENCHMARK_SPEED         48000
+
+/* output space per frame, in samples per channel */
+#define SIDPARALLEL_BENCHMARK_FRAME_SAMPLES 1024
+
+static uint32_t sidparallel_benchmark_random(uint32_t *seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 16;
+}
+
+/* render all frames into `out', returns the number of samples per channel */
+static int sidparallel_benchmark_render(int16_t *out, int soc, int parallel)
+{
+    static const uint8_t waves[] = { 0x11, 0x21, 0x41, 0x81, 0x51, 0x10, 0x20, 0x40 };
+    sound_t *psid[SIDPARALLEL_BENCHMARK_SIDS];
+    uint8_t sidstate[0x20];
+    uint32_t seed = 1;
+    int saved_parallel = sid_render_parallel;
+    int chip, frame, i, nr = 0;
+
+    /* reSID fills the dither noise of each filter from rand(), and the
+       reSIDfp resampler only clears its buffer on reset, like the machine
+       does before the chips are used */
+    srand(1);
+    memset(sidstate, 0, sizeof(sidstate));
+    for (chip = 0; chip < SIDPARALLEL_BENCHMARK_SIDS; chip++) {
+        psid[chip] = sid_engine.open(sidstate);
+        sid_engine.init(psid[chip], SIDPARALLEL_BENCHMARK_SPEED, SIDPARALLEL_BENCHMARK_CLOCK, 1000);
+        sid_engine.reset(psid[chip], 0);
+        sid_engine.store(psid[chip], 0x18, 0x0f);
+    }
+    sid_render_parallel = parallel;
+
+    for (frame = 0; frame < SIDPARALLEL_BENCHMARK_FRAMES; frame++) {
+        CLOCK delta_t = SIDPARALLEL_BENCHMARK_FRAME_CYCLES;
+
+        /* a few random notes, waveforms and filter settings per frame */
+        for (chip = 0; chip < SIDPARALLEL_BENCHMARK_SIDS; chip++) {
+            for (i = 0; i < 8; i++) {
+                uint32_t r = sidparallel_benchmark_random(&seed);
+                uint16_t addr = (uint16_t)(r % 0x19);
+                uint8_t byte = (uint8_t)(r >> 8);
+
+                if (addr % 7 == 4) {
+                    byte = waves[byte & 7];
+                } else if (addr == 0x18) {
+                    byte |= 0x0f;
+                }
+                sid_engine.store(psid[chip], addr, byte);
+            }
+        }
+
+        while (delta_t > 0) {
+            int n = sid_sound_machine_calculate_samples(psid, out + nr * soc,
+                                                        SIDPARALLEL_BENCHMARK_FRAME_SAMPLES,
+                                                        soc, SIDPARALLEL_BENCHMARK_SIDS, &delta_t);
+            if (n <= 0) {
+                break;
+            }
+            nr += n;
+        }
+    }
+
+    sid_render_parallel = saved_parallel;
+    for (chip = 0; chip < SIDPARALLEL_BENCHMARK_SIDS; chip++) {
+        sid_engine.close(psid[chip]);
+    }
+
+    return nr;
+}
+
+static int sidparallel_benchmark(void)
+{
+    size_t size = SIDPARALLEL_BENCHMARK_FRAMES * SIDPARALLEL_BENCHMARK_FRAME_SAMPLES * 2;
+    int16_t *out[2];
+    unsigned long checks = 0, mismatches = 0;
+    int soc, parallel, i;
+
+    if (!sid_sound_machine_set_engine_hooks()
+        || (sidengine != SID_ENGINE_RESID && sidengine != SID_ENGINE_RESIDFP)) {
+        printf("Benchmark sidparallel: needs -sidengine 1 (reSID) or 8 (reSIDfp)\n");
+        return -1;
+    }
+
+    out[0] = lib_calloc(size, sizeof(int16_t));
+    out[1] = lib_calloc(size, sizeof(int16_t));
+
+    for (soc = SOUND_OUTPUT_MONO; soc <= SOUND_OUTPUT_STEREO; soc++) {
+        int nr[2];
+
+        for (parallel = 0; parallel < 2; parallel++) {
+            char test[32];
+            tick_t start = tick_now();
+            double seconds;
+
+            nr[parallel] = sidparallel_benchmark_render(out[parallel], soc, parallel);
+            seconds = (double)tick_now_delta(start) / tick_per_second();
+            sprintf(test, "8 SIDs %s %s", soc == SOUND_OUTPUT_MONO ? "mono" : "stereo",
+                    parallel ? "parallel" : "serial");
+            benchmark_kernel_result("sidparallel", test, seconds, nr[parallel], "samples");
+        }
+
+        checks += (unsigned long)nr[0] * soc;
+        if (nr[0] != nr[1]) {
+            log_error(LOG_DEFAULT, "SID parallel benchmark: %d samples serial, %d parallel.", nr[0], nr[1]);
+            mismatches += (unsigned long)abs(nr[0] - nr[1]) * soc;
+        }
+        for (i = 0; i < (nr[0] < nr[1] ? nr[0] : nr[1]) * soc; i++) {
+            if (out[0][i] != out[1][i]) {
+                mismatches++;
+            }
+        }
+    }
+    printf("Benchmark sidparallel: %lu samples compared, %lu mismatches\n", checks, mismatches);
+
+    lib_free(out[1]);
+    lib_free(out[0]);
+
+    return mismatches ? -1 : 0;
+}
+#endif
 #endif
 
 char *sid_sound_machine_dump_state(sound_t *psid)
@@ -1233,6 +1441,18 @@ char *sid_sound_machine_dump_state(sound_t *psid)
     return sid_engine.dump_state(psid);
 }
 
+void sid_benchmark_init(void)
+{
+#if defined(FEATURE_BENCHMARK_HOOKS) && !defined(SOUND_SYSTEM_FLOAT)
+    benchmark_kernel_register("sidparallel",
+                              "render 8 SIDs with SidResidParallel off and on, check the output is identical",
+                              NULL, sidparallel_benchmark);
+#endif
+#ifdef HAVE_RESID
+    resid_benchmark_init();
+#endif
+}
+
 int sid_sound_machine_cycle_based(void)
 {
     switch (sidengine) {
@@ -237,6 +237,7 @@ int sid10_dump(void);
 void sid_reset(void);
 
 void sid_set_machine_parameter(long clock_rate);
+void sid_benchmark_init(void);
 uint8_t *sid_get_siddata(unsigned int channel);
 int sid_engine_set(int engine);
 void sid_state_read(unsigned int channel, struct sid_snapshot_state_s *sid_state);
@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <zlib.h>
 
 #include "archdep.h"
 #include "lib.h"
@@ -41,6 +42,7 @@
 #endif
 #include "types.h"
 #include "uiapi.h"
+#include "util.h"
 #include "version.h"
 #include "vsync.h"
 #include "zfile.h"
@@ -55,6 +57,7 @@
 #endif
 
 static int snapshot_error = SNAPSHOT_NO_ERROR;
+static snapshot_memory_t *snapshot_memory = NULL;
 static char *current_module = NULL;
 static char read_name[SNAPSHOT_MACHINE_NAME_LEN];
 static char *current_machine_name = NULL;
@@ -68,8 +71,8 @@ static const char snapshot_version_magic_string[] = "VICE Version\032";
 #define SNAPSHOT_VERSION_MAGIC_LEN      13
 
 struct snapshot_module_s {
-    /* File descriptor.  */
-    FILE *file;
+    /* Snapshot the module belongs to.  */
+    snapshot_t *snapshot;
 
     /* Flag: are we writing it?  */
     int write_mode;
@@ -84,10 +87,42 @@ struct snapshot_module_s {
     long size_offset;
 };
 
+/* The whole snapshot is kept in memory: modules are serialized into a
+   growing buffer, which is appended to the file whenever a module has been
+   completed, and snapshot_open() reads the complete file up front.
+   Snapshots with a ".gz" extension are compressed/decompressed on the
+   fly.  */
 struct snapshot_s {
-    /* File descriptor.  */
+    /* File descriptor (write mode only).  */
     FILE *file;
 
+    /* Compressed file (write mode only, ".gz" snapshots).  */
+    gzFile gz;
+
+    /* File name (write mode only).  */
+    char *filename;
+
+    /* Snapshot data.  */
+    uint8_t *data;
+
+    /* Number of valid bytes in `data'.  */
+    size_t size;
+
+    /* Number of bytes allocated for `data' (write mode only).  */
+    size_t alloc;
+
+    /* Current read/write position.  */
+    size_t pos;
+
+    /* Number of bytes of `data' already written to the file.  */
+    size_t flushed;
+
+    /* Number of modules being written.  */
+    int open_modules;
+
+    /* Memory buffer the snapshot is written to or read from, if any.  */
+    snapshot_memory_t *memory;
+
     /* Offset of the first module.  */
     long first_module_offset;
 
@@ -95,192 +130,233 @@ struct snapshot_s {
     int write_mode;
 };
 
+/* Initial size of the snapshot write buffer.  */
+#define SNAPSHOT_BUFFER_SIZE    0x40000
+
 /* ------------------------------------------------------------------------- */
 
-static int snapshot_write_byte(FILE *f, uint8_t data)
+/* Make room for `num' more bytes at the current position.  */
+static uint8_t *snapshot_reserve(snapshot_t *s, size_t num)
 {
-    current_fpos = ftell(f);
-    if (fputc(data, f) == EOF) {
-        snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
-        return -1;
+    size_t end = s->pos + num;
+
+    if (end > s->alloc) {
+        size_t alloc = s->alloc ? s->alloc : SNAPSHOT_BUFFER_SIZE;
+
+        while (alloc < end) {
+            alloc *= 2;
+        }
+        s->data = lib_realloc(s->data, alloc);
+        s->alloc = alloc;
+    }
+    if (end > s->size) {
+        s->size = end;
     }
+    current_fpos = s->pos;
+    s->pos = end;
+    return s->data + end - num;
+}
 
-    return 0;
+/* Return pointer to the next `num' bytes to read, NULL at end of data.  */
+static const uint8_t *snapshot_consume(snapshot_t *s, size_t num)
+{
+    current_fpos = s->pos;
+    if (s->pos > s->size || num > s->size - s->pos) {
+        return NULL;
+    }
+    s->pos += num;
+    return s->data + s->pos - num;
 }
 
-static int snapshot_write_word(FILE *f, uint16_t data)
+/* Append the data not written yet to the file, if there is one.  A
+   short write sets SNAPSHOT_WRITE_EOF_ERROR if nothing could be written
+   and SNAPSHOT_WRITE_BYTE_ARRAY_ERROR otherwise.  */
+static int snapshot_flush(snapshot_t *s)
 {
-    current_fpos = ftell(f);
-    if (snapshot_write_byte(f, (uint8_t)(data & 0xff)) < 0
-        || snapshot_write_byte(f, (uint8_t)(data >> 8)) < 0) {
-        return -1;
+    size_t chunk, written;
+    int n;
+
+    while (s->flushed < s->size) {
+        chunk = s->size - s->flushed;
+        if (s->gz != NULL) {
+            if (chunk > SNAPSHOT_BUFFER_SIZE) {
+                chunk = SNAPSHOT_BUFFER_SIZE;
+            }
+            n = gzwrite(s->gz, s->data + s->flushed, (unsigned int)chunk);
+            written = n > 0 ? (size_t)n : 0;
+        } else if (s->file != NULL) {
+            written = fwrite(s->data + s->flushed, 1, chunk, s->file);
+        } else {
+            /* memory target */
+            return 0;
+        }
+        current_fpos = s->flushed + written;
+        if (written < chunk) {
+            snapshot_error = written == 0 ? SNAPSHOT_WRITE_EOF_ERROR
+                                          : SNAPSHOT_WRITE_BYTE_ARRAY_ERROR;
+            s->flushed = s->size;
+            return -1;
+        }
+        s->flushed += written;
     }
+    return 0;
+}
 
+static int snapshot_write_byte(snapshot_t *s, uint8_t data)
+{
+    *snapshot_reserve(s, 1) = data;
     return 0;
 }
 
-static int snapshot_write_dword(FILE *f, uint32_t data)
+static int snapshot_write_word(snapshot_t *s, uint16_t data)
 {
-    current_fpos = ftell(f);
-    if (snapshot_write_word(f, (uint16_t)(data & 0xffff)) < 0
-        || snapshot_write_word(f, (uint16_t)(data >> 16)) < 0) {
-        return -1;
-    }
+    uint8_t *p = snapshot_reserve(s, 2);
 
+    p[0] = (uint8_t)(data & 0xff);
+    p[1] = (uint8_t)(data >> 8);
     return 0;
 }
 
-static int snapshot_write_qword(FILE *f, uint64_t data)
+static int snapshot_write_dword(snapshot_t *s, uint32_t data)
 {
-    current_fpos = ftell(f);
-    if (snapshot_write_dword(f, (uint32_t)(data & 0xffffffff)) < 0
-        || snapshot_write_dword(f, (uint32_t)(data >> 32)) < 0) {
+    uint8_t *p = snapshot_reserve(s, 4);
+
+    p[0] = (uint8_t)(data & 0xff);
+    p[1] = (uint8_t)(data >> 8);
+    p[2] = (uint8_t)(data >> 16);
+    p[3] = (uint8_t)(data >> 24);
+    return 0;
+}
+
+static int snapshot_write_qword(snapshot_t *s, uint64_t data)
+{
+    if (snapshot_write_dword(s, (uint32_t)(data & 0xffffffff)) < 0
+        || snapshot_write_dword(s, (uint32_t)(data >> 32)) < 0) {
         return -1;
     }
 
     return 0;
 }
 
-static int snapshot_write_double(FILE *f, double data)
+static int snapshot_write_double(snapshot_t *s, double data)
 {
-    uint8_t *byte_data = (uint8_t *)&data;
-    int i;
-
-    current_fpos = ftell(f);
-    for (i = 0; i < sizeof(double); i++) {
-        if (snapshot_write_byte(f, byte_data[i]) < 0) {
-            return -1;
-        }
-    }
+    memcpy(snapshot_reserve(s, sizeof(double)), &data, sizeof(double));
     return 0;
 }
 
-static int snapshot_write_padded_string(FILE *f, const char *s, uint8_t pad_char,
+static int snapshot_write_padded_string(snapshot_t *s, const char *str, uint8_t pad_char,
                                         int len)
 {
     int i, found_zero;
-    uint8_t c;
+    uint8_t *p = snapshot_reserve(s, (size_t)len);
 
-    current_fpos = ftell(f);
     for (i = found_zero = 0; i < len; i++) {
-        if (!found_zero && s[i] == 0) {
+        if (!found_zero && str[i] == 0) {
             found_zero = 1;
         }
-        c = found_zero ? (uint8_t)pad_char : (uint8_t) s[i];
-        if (snapshot_write_byte(f, c) < 0) {
-            return -1;
-        }
+        p[i] = found_zero ? (uint8_t)pad_char : (uint8_t)str[i];
     }
 
     return 0;
 }
 
-static int snapshot_write_byte_array(FILE *f, const uint8_t *data, unsigned int num)
+static int snapshot_write_byte_array(snapshot_t *s, const uint8_t *data, unsigned int num)
 {
-    current_fpos = ftell(f);
-    if (num > 0 && fwrite(data, (size_t)num, 1, f) < 1) {
-        snapshot_error = SNAPSHOT_WRITE_BYTE_ARRAY_ERROR;
-        return -1;
+    if (num > 0) {
+        memcpy(snapshot_reserve(s, num), data, num);
     }
 
     return 0;
 }
 
-static int snapshot_write_word_array(FILE *f, const uint16_t *data, unsigned int num)
+static int snapshot_write_word_array(snapshot_t *s, const uint16_t *data, unsigned int num)
 {
     unsigned int i;
+    uint8_t *p = snapshot_reserve(s, (size_t)num * 2);
 
-    current_fpos = ftell(f);
     for (i = 0; i < num; i++) {
-        if (snapshot_write_word(f, data[i]) < 0) {
-            return -1;
-        }
+        *p++ = (uint8_t)(data[i] & 0xff);
+        *p++ = (uint8_t)(data[i] >> 8);
     }
 
     return 0;
 }
 
-static int snapshot_write_dword_array(FILE *f, const uint32_t *data, unsigned int num)
+static int snapshot_write_dword_array(snapshot_t *s, const uint32_t *data, unsigned int num)
 {
     unsigned int i;
+    uint8_t *p = snapshot_reserve(s, (size_t)num * 4);
 
-    current_fpos = ftell(f);
     for (i = 0; i < num; i++) {
-        if (snapshot_write_dword(f, data[i]) < 0) {
-            return -1;
-        }
+        *p++ = (uint8_t)(data[i] & 0xff);
+        *p++ = (uint8_t)(data[i] >> 8);
+        *p++ = (uint8_t)(data[i] >> 16);
+        *p++ = (uint8_t)(data[i] >> 24);
     }
 
     return 0;
 }
 
 
-static int snapshot_write_string(FILE *f, const char *s)
+static int snapshot_write_string(snapshot_t *s, const char *str)
 {
-    size_t len, i;
+    size_t len;
 
-    len = s ? (strlen(s) + 1) : 0;      /* length includes nullbyte */
+    len = str ? (strlen(str) + 1) : 0;      /* length includes nullbyte */
 
-    current_fpos = ftell(f);
-    if (snapshot_write_word(f, (uint16_t)len) < 0) {
+    if (len > 0xffff) {
         return -1;
     }
 
-    for (i = 0; i < len; i++) {
-        if (snapshot_write_byte(f, s[i]) < 0) {
-            return -1;
-        }
+    snapshot_write_word(s, (uint16_t)len);
+    if (len > 0) {
+        memcpy(snapshot_reserve(s, len), str, len);
     }
 
     return (int)(len + sizeof(uint16_t));
 }
 
-static int snapshot_read_byte(FILE *f, uint8_t *b_return)
+static int snapshot_read_byte(snapshot_t *s, uint8_t *b_return)
 {
-    int c;
+    const uint8_t *p = snapshot_consume(s, 1);
 
-    current_fpos = ftell(f);
-    c = fgetc(f);
-    if (c == EOF) {
+    if (p == NULL) {
         snapshot_error = SNAPSHOT_READ_EOF_ERROR;
         return -1;
     }
-    *b_return = (uint8_t)c;
+    *b_return = p[0];
     return 0;
 }
 
-static int snapshot_read_word(FILE *f, uint16_t *w_return)
+static int snapshot_read_word(snapshot_t *s, uint16_t *w_return)
 {
-    uint8_t lo, hi;
+    const uint8_t *p = snapshot_consume(s, 2);
 
-    current_fpos = ftell(f);
-    if (snapshot_read_byte(f, &lo) < 0 || snapshot_read_byte(f, &hi) < 0) {
+    if (p == NULL) {
+        snapshot_error = SNAPSHOT_READ_EOF_ERROR;
         return -1;
     }
-
-    *w_return = lo | (hi << 8);
+    *w_return = p[0] | (p[1] << 8);
     return 0;
 }
 
-static int snapshot_read_dword(FILE *f, uint32_t *dw_return)
+static int snapshot_read_dword(snapshot_t *s, uint32_t *dw_return)
 {
-    uint16_t lo, hi;
+    const uint8_t *p = snapshot_consume(s, 4);
 
-    current_fpos = ftell(f);
-    if (snapshot_read_word(f, &lo) < 0 || snapshot_read_word(f, &hi) < 0) {
+    if (p == NULL) {
+        snapshot_error = SNAPSHOT_READ_EOF_ERROR;
         return -1;
     }
-
-    *dw_return = lo | ((uint32_t)hi << 16);
+    *dw_return = p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
     return 0;
 }
 
-static int snapshot_read_qword(FILE *f, uint64_t *qw_return)
+static int snapshot_read_qword(snapshot_t *s, uint64_t *qw_return)
 {
     uint32_t lo, hi;
 
-    current_fpos = ftell(f);
-    if (snapshot_read_dword(f, &lo) < 0 || snapshot_read_dword(f, &hi) < 0) {
+    if (snapshot_read_dword(s, &lo) < 0 || snapshot_read_dword(s, &hi) < 0) {
         return -1;
     }
 
@@ -288,93 +364,87 @@ static int snapshot_read_qword(FILE *f, uint64_t *qw_return)
     return 0;
 }
 
-static int snapshot_read_double(FILE *f, double *d_return)
+static int snapshot_read_double(snapshot_t *s, double *d_return)
 {
-    int i;
-    int c;
-    double val;
-    uint8_t *byte_val = (uint8_t *)&val;
+    const uint8_t *p = snapshot_consume(s, sizeof(double));
 
-    current_fpos = ftell(f);
-    for (i = 0; i < sizeof(double); i++) {
-        c = fgetc(f);
-        if (c == EOF) {
-            snapshot_error = SNAPSHOT_READ_EOF_ERROR;
-            return -1;
-        }
-        byte_val[i] = (uint8_t)c;
+    if (p == NULL) {
+        snapshot_error = SNAPSHOT_READ_EOF_ERROR;
+        return -1;
     }
-    *d_return = val;
+    memcpy(d_return, p, sizeof(double));
     return 0;
 }
 
-static int snapshot_read_byte_array(FILE *f, uint8_t *b_return, unsigned int num)
+static int snapshot_read_byte_array(snapshot_t *s, uint8_t *b_return, unsigned int num)
 {
-    current_fpos = ftell(f);
-    if (num > 0 && fread(b_return, (size_t)num, 1, f) < 1) {
+    const uint8_t *p = snapshot_consume(s, num);
+
+    if (p == NULL) {
         snapshot_error = SNAPSHOT_READ_BYTE_ARRAY_ERROR;
         return -1;
     }
+    if (num > 0) {
+        memcpy(b_return, p, num);
+    }
 
     return 0;
 }
 
-static int snapshot_read_word_array(FILE *f, uint16_t *w_return, unsigned int num)
+static int snapshot_read_word_array(snapshot_t *s, uint16_t *w_return, unsigned int num)
 {
     unsigned int i;
+    const uint8_t *p = snapshot_consume(s, (size_t)num * 2);
 
-    current_fpos = ftell(f);
-    for (i = 0; i < num; i++) {
-        if (snapshot_read_word(f, w_return + i) < 0) {
-            return -1;
-        }
+    if (p == NULL) {
+        snapshot_error = SNAPSHOT_READ_EOF_ERROR;
+        return -1;
+    }
+    for (i = 0; i < num; i++, p += 2) {
+        w_return[i] = p[0] | (p[1] << 8);
     }
 
     return 0;
 }
 
-static int snapshot_read_dword_array(FILE *f, uint32_t *dw_return, unsigned int num)
+static int snapshot_read_dword_array(snapshot_t *s, uint32_t *dw_return, unsigned int num)
 {
     unsigned int i;
+    const uint8_t *p = snapshot_consume(s, (size_t)num * 4);
 
-    current_fpos = ftell(f);
-    for (i = 0; i < num; i++) {
-        if (snapshot_read_dword(f, dw_return + i) < 0) {
-            return -1;
-        }
+    if (p == NULL) {
+        snapshot_error = SNAPSHOT_READ_EOF_ERROR;
+        return -1;
+    }
+    for (i = 0; i < num; i++, p += 4) {
+        dw_return[i] = p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
     }
 
     return 0;
 }
 
-static int snapshot_read_string(FILE *f, char **s)
+static int snapshot_read_string(snapshot_t *s, char **str)
 {
-    int i, len;
     uint16_t w;
-    char *p = NULL;
+    const uint8_t *p;
 
     /* first free the previous string */
-    lib_free(*s);
-    *s = NULL;      /* don't leave a bogus pointer */
+    lib_free(*str);
+    *str = NULL;      /* don't leave a bogus pointer */
 
-    current_fpos = ftell(f);
-    if (snapshot_read_word(f, &w) < 0) {
+    if (snapshot_read_word(s, &w) < 0) {
         return -1;
     }
 
-    len = (int)w;
-
-    if (len) {
-        p = lib_malloc(len);
-        *s = p;
-
-        for (i = 0; i < len; i++) {
-            if (snapshot_read_byte(f, (uint8_t *)(p + i)) < 0) {
-                p[0] = 0;
-                return -1;
-            }
+    if (w) {
+        p = snapshot_consume(s, w);
+        if (p == NULL) {
+            snapshot_error = SNAPSHOT_READ_EOF_ERROR;
+            return -1;
         }
-        p[len - 1] = 0;   /* just to be save */
+        *str = lib_malloc(w);
+        memcpy(*str, p, w);
+        (*str)[w - 1] = 0;   /* just to be save */
     }
     return 0;
 }
@@ -383,7 +453,7 @@ static int snapshot_read_string(FILE *f, char **s)
 
 int snapshot_module_write_byte(snapshot_module_t *m, uint8_t b)
 {
-    if (snapshot_write_byte(m->file, b) < 0) {
+    if (snapshot_write_byte(m->snapshot, b) < 0) {
         return -1;
     }
 
@@ -393,7 +463,7 @@ int snapshot_module_write_byte(snapshot_module_t *m, uint8_t b)
 
 int snapshot_module_write_word(snapshot_module_t *m, uint16_t w)
 {
-    if (snapshot_write_word(m->file, w) < 0) {
+    if (snapshot_write_word(m->snapshot, w) < 0) {
         return -1;
     }
 
@@ -403,7 +473,7 @@ int snapshot_module_write_word(snapshot_module_t *m, uint16_t w)
 
 int snapshot_module_write_dword(snapshot_module_t *m, uint32_t dw)
 {
-    if (snapshot_write_dword(m->file, dw) < 0) {
+    if (snapshot_write_dword(m->snapshot, dw) < 0) {
         return -1;
     }
 
@@ -413,7 +483,7 @@ int snapshot_module_write_dword(snapshot_module_t *m, uint32_t dw)
 
 int snapshot_module_write_qword(snapshot_module_t *m, uint64_t qw)
 {
-    if (snapshot_write_qword(m->file, qw) < 0) {
+    if (snapshot_write_qword(m->snapshot, qw) < 0) {
         return -1;
     }
 
@@ -423,7 +493,7 @@ int snapshot_module_write_qword(snapshot_module_t *m, uint64_t qw)
 
 int snapshot_module_write_double(snapshot_module_t *m, double db)
 {
-    if (snapshot_write_double(m->file, db) < 0) {
+    if (snapshot_write_double(m->snapshot, db) < 0) {
         return -1;
     }
 
@@ -433,7 +503,7 @@ int snapshot_module_write_double(snapshot_module_t *m, double db)
 
 int snapshot_module_write_padded_string(snapshot_module_t *m, const char *s, uint8_t pad_char, int len)
 {
-    if (snapshot_write_padded_string(m->file, s, (uint8_t)pad_char, len) < 0) {
+    if (snapshot_write_padded_string(m->snapshot, s, (uint8_t)pad_char, len) < 0) {
         return -1;
     }
 
@@ -443,7 +513,7 @@ int snapshot_module_write_padded_string(snapshot_module_t *m, const char *s, uin
 
 int snapshot_module_write_byte_array(snapshot_module_t *m, const uint8_t *b, unsigned int num)
 {
-    if (snapshot_write_byte_array(m->file, b, num) < 0) {
+    if (snapshot_write_byte_array(m->snapshot, b, num) < 0) {
         return -1;
     }
 
@@ -453,7 +523,7 @@ int snapshot_module_write_byte_array(snapshot_module_t *m, const uint8_t *b, uns
 
 int snapshot_module_write_word_array(snapshot_module_t *m, const uint16_t *w, unsigned int num)
 {
-    if (snapshot_write_word_array(m->file, w, num) < 0) {
+    if (snapshot_write_word_array(m->snapshot, w, num) < 0) {
         return -1;
     }
 
@@ -463,7 +533,7 @@ int snapshot_module_write_word_array(snapshot_module_t *m, const uint16_t *w, un
 
 int snapshot_module_write_dword_array(snapshot_module_t *m, const uint32_t *dw, unsigned int num)
 {
-    if (snapshot_write_dword_array(m->file, dw, num) < 0) {
+    if (snapshot_write_dword_array(m->snapshot, dw, num) < 0) {
         return -1;
     }
 
@@ -474,7 +544,7 @@ int snapshot_module_write_dword_array(snapshot_module_t *m, const uint32_t *dw,
 int snapshot_module_write_string(snapshot_module_t *m, const char *s)
 {
     int len;
-    len = snapshot_write_string(m->file, s);
+    len = snapshot_write_string(m->snapshot, s);
     if (len < 0) {
         snapshot_error = SNAPSHOT_ILLEGAL_STRING_LENGTH_ERROR;
         return -1;
@@ -488,100 +558,100 @@ int snapshot_module_write_string(snapshot_module_t *m, const char *s)
 
 int snapshot_module_read_byte(snapshot_module_t *m, uint8_t *b_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint8_t) > m->offset + m->size) {
+    current_fpos = (long)m->snapshot->pos;
+    if ((long)m->snapshot->pos + sizeof(uint8_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_byte(m->file, b_return);
+    return snapshot_read_byte(m->snapshot, b_return);
 }
 
 int snapshot_module_read_word(snapshot_module_t *m, uint16_t *w_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
+    current_fpos = (long)m->snapshot->pos;
+    if ((long)m->snapshot->pos + sizeof(uint16_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_word(m->file, w_return);
+    return snapshot_read_word(m->snapshot, w_return);
 }
 
 int snapshot_module_read_dword(snapshot_module_t *m, uint32_t *dw_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint32_t) > m->offset + m->size) {
+    current_fpos = (long)m->snapshot->pos;
+    if ((long)m->snapshot->pos + sizeof(uint32_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_dword(m->file, dw_return);
+    return snapshot_read_dword(m->snapshot, dw_return);
 }
 
 int snapshot_module_read_qword(snapshot_module_t *m, uint64_t *qw_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint64_t) > m->offset + m->size) {
+    current_fpos = (long)m->snapshot->pos;
+    if ((long)m->snapshot->pos + sizeof(uint64_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_qword(m->file, qw_return);
+    return snapshot_read_qword(m->snapshot, qw_return);
 }
 
 int snapshot_module_read_double(snapshot_module_t *m, double *db_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(double) > m->offset + m->size) {
+    current_fpos = (long)m->snapshot->pos;
+    if ((long)m->snapshot->pos + sizeof(double) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_double(m->file, db_return);
+    return snapshot_read_double(m->snapshot, db_return);
 }
 
 int snapshot_module_read_byte_array(snapshot_module_t *m, uint8_t *b_return, unsigned int num)
 {
-    current_fpos = ftell(m->file);
-    if ((long)(ftell(m->file) + num) > (long)(m->offset + m->size)) {
+    current_fpos = (long)m->snapshot->pos;
+    if ((long)((long)m->snapshot->pos + num) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_byte_array(m->file, b_return, num);
+    return snapshot_read_byte_array(m->snapshot, b_return, num);
 }
 
 int snapshot_module_read_word_array(snapshot_module_t *m, uint16_t *w_return, unsigned int num)
 {
-    if ((long)(ftell(m->file) + num * sizeof(uint16_t)) > (long)(m->offset + m->size)) {
+    if ((long)((long)m->snapshot->pos + num * sizeof(uint16_t)) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_word_array(m->file, w_return, num);
+    return snapshot_read_word_array(m->snapshot, w_return, num);
 }
 
 int snapshot_module_read_dword_array(snapshot_module_t *m, uint32_t *dw_return, unsigned int num)
 {
-    current_fpos = ftell(m->file);
-    if ((long)(ftell(m->file) + num * sizeof(uint32_t)) > (long)(m->offset + m->size)) {
+    current_fpos = (long)m->snapshot->pos;
+    if ((long)((long)m->snapshot->pos + num * sizeof(uint32_t)) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_dword_array(m->file, dw_return, num);
+    return snapshot_read_dword_array(m->snapshot, dw_return, num);
 }
 
 int snapshot_module_read_string(snapshot_module_t *m, char **charp_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
+    current_fpos = (long)m->snapshot->pos;
+    if ((long)m->snapshot->pos + sizeof(uint16_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
 
-    return snapshot_read_string(m->file, charp_return);
+    return snapshot_read_string(m->snapshot, charp_return);
 }
 
 int snapshot_module_read_byte_into_int(snapshot_module_t *m, int *value_return)
@@ -681,24 +751,21 @@ snapshot_module_t *snapshot_module_create(snapshot_t *s, const char *name, uint8
     current_module = (char *)name;
 
     m = lib_malloc(sizeof(snapshot_module_t));
-    m->file = s->file;
-    m->offset = ftell(s->file);
-    if (m->offset == -1) {
-        snapshot_error = SNAPSHOT_ILLEGAL_OFFSET_ERROR;
-        lib_free(m);
-        return NULL;
-    }
+    m->snapshot = s;
+    m->offset = (long)s->pos;
     m->write_mode = 1;
 
-    if (snapshot_write_padded_string(s->file, name, (uint8_t)0, SNAPSHOT_MODULE_NAME_LEN) < 0
-        || snapshot_write_byte(s->file, major_version) < 0
-        || snapshot_write_byte(s->file, minor_version) < 0
-        || snapshot_write_dword(s->file, 0) < 0) {
+    if (snapshot_write_padded_string(s, name, (uint8_t)0, SNAPSHOT_MODULE_NAME_LEN) < 0
+        || snapshot_write_byte(s, major_version) < 0
+        || snapshot_write_byte(s, minor_version) < 0
+        || snapshot_write_dword(s, 0) < 0) {
+        lib_free(m);
         return NULL;
     }
 
-    m->size = (uint32_t)(ftell(s->file) - m->offset);
-    m->size_offset = ftell(s->file) - sizeof(uint32_t);
+    m->size = (uint32_t)(s->pos - m->offset);
+    m->size_offset = (long)(s->pos - sizeof(uint32_t));
+    s->open_modules++;
 
     return m;
 }
@@ -711,14 +778,15 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
 
     current_module = (char *)name;
 
-    if (fseek(s->file, s->first_module_offset, SEEK_SET) < 0) {
+    if ((size_t)s->first_module_offset > s->size) {
         snapshot_error = SNAPSHOT_FIRST_MODULE_NOT_FOUND_ERROR;
         DBG(("snapshot_module_open error: name: '%s' NOT found", name));
         return NULL;
     }
+    s->pos = (size_t)s->first_module_offset;
 
     m = lib_malloc(sizeof(snapshot_module_t));
-    m->file = s->file;
+    m->snapshot = s;
     m->write_mode = 0;
 
     m->offset = s->first_module_offset;
@@ -728,11 +796,11 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
     /* Search for the module name.  This is quite inefficient, but I don't
        think we care.  */
     while (1) {
-        if (snapshot_read_byte_array(s->file, (uint8_t *)n,
+        if (snapshot_read_byte_array(s, (uint8_t *)n,
                                      SNAPSHOT_MODULE_NAME_LEN) < 0
-            || snapshot_read_byte(s->file, major_version_return) < 0
-            || snapshot_read_byte(s->file, minor_version_return) < 0
-            || snapshot_read_dword(s->file, &m->size)) {
+            || snapshot_read_byte(s, major_version_return) < 0
+            || snapshot_read_byte(s, minor_version_return) < 0
+            || snapshot_read_dword(s, &m->size)) {
             snapshot_error = SNAPSHOT_MODULE_HEADER_READ_ERROR;
             goto fail;
         }
@@ -744,13 +812,14 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
         }
 
         m->offset += m->size;
-        if (fseek(s->file, m->offset, SEEK_SET) < 0) {
+        if (m->size == 0 || (size_t)m->offset > s->size) {
             snapshot_error = SNAPSHOT_MODULE_NOT_FOUND_ERROR;
             goto fail;
         }
+        s->pos = (size_t)m->offset;
     }
 
-    m->size_offset = ftell(s->file) - sizeof(uint32_t);
+    m->size_offset = (long)(s->pos - sizeof(uint32_t));
 #if 0
     /* HACK: if any of the errors *this* function can produce is still pending
              in snapshot_error, clear it out - else we might fail for no reason
@@ -766,7 +835,7 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
     return m;
 
 fail:
-    fseek(s->file, s->first_module_offset, SEEK_SET);
+    s->pos = (size_t)s->first_module_offset;
     lib_free(m);
     DBG(("snapshot_module_open error: name: '%s' NOT found", name));
     return NULL;
@@ -774,30 +843,115 @@ fail:
 
 int snapshot_module_close(snapshot_module_t *m)
 {
+    snapshot_t *s = m->snapshot;
+    int write_mode = m->write_mode;
+
     DBG(("snapshot_module_close name: '%s'", current_module));
     /* Backpatch module size if writing.  */
-    if (m->write_mode
-        && (fseek(m->file, m->size_offset, SEEK_SET) < 0
-            || snapshot_write_dword(m->file, m->size) < 0)) {
-        snapshot_error = SNAPSHOT_MODULE_CLOSE_ERROR;
-        DBG(("snapshot_module_close error"));
-        return -1;
+    if (write_mode) {
+        s->pos = (size_t)m->size_offset;
+        snapshot_write_dword(s, m->size);
     }
 
     /* Skip module.  */
-    if (fseek(m->file, m->offset + m->size, SEEK_SET) < 0) {
-        snapshot_error = SNAPSHOT_MODULE_SKIP_ERROR;
-        DBG(("snapshot_module_close error"));
+    s->pos = (size_t)(m->offset + m->size);
+
+    lib_free(m);
+
+    /* Nothing before the end of the module changes any more.  */
+    if (write_mode && --s->open_modules == 0 && snapshot_flush(s) < 0) {
         return -1;
     }
 
-    lib_free(m);
     DBG(("snapshot_module_close ok"));
     return 0;
 }
 
 /* ------------------------------------------------------------------------- */
 
+/* Check whether `filename' should be (de)compressed with zlib.  */
+static int snapshot_is_gzip(const char *filename)
+{
+    size_t len = strlen(filename);
+
+    return len > 3 && util_strcasecmp(filename + len - 3, ".gz") == 0;
+}
+
+/* Read the complete snapshot `filename' into memory.  */
+static int snapshot_load(snapshot_t *s, const char *filename)
+{
+    FILE *f;
+    long len;
+
+    if (snapshot_is_gzip(filename)) {
+        gzFile gz;
+        int n;
+
+        gz = gzopen(filename, MODE_READ);
+        if (gz == NULL) {
+            return -1;
+        }
+        s->alloc = SNAPSHOT_BUFFER_SIZE;
+        s->data = lib_malloc(s->alloc);
+        while ((n = gzread(gz, s->data + s->size, (unsigned int)(s->alloc - s->size))) > 0) {
+            s->size += (size_t)n;
+            if (s->size == s->alloc) {
+                s->alloc *= 2;
+                s->data = lib_realloc(s->data, s->alloc);
+            }
+        }
+        gzclose(gz);
+        return n < 0 ? -1 : 0;
+    }
+
+    /* zfile takes care of other archive formats */
+    f = zfile_fopen(filename, MODE_READ);
+    if (f == NULL) {
+        return -1;
+    }
+    if (fseek(f, 0, SEEK_END) < 0 || (len = ftell(f)) < 0) {
+        zfile_fclose(f);
+        return -1;
+    }
+    rewind(f);
+    s->data = lib_malloc((size_t)len + 1);
+    s->size = fread(s->data, 1, (size_t)len, f);
+    zfile_fclose(f);
+    return s->size == (size_t)len ? 0 : -1;
+}
+
+/* Write the rest of the snapshot data to the file opened by
+   snapshot_create() and close it.  */
+static int snapshot_save(snapshot_t *s)
+{
+    int ret = snapshot_flush(s);
+
+    if (s->gz != NULL) {
+        if (gzclose(s->gz) != Z_OK && ret == 0) {
+            snapshot_error = SNAPSHOT_WRITE_CLOSE_EOF_ERROR;
+            ret = -1;
+        }
+    } else if (fclose(s->file) == EOF && ret == 0) {
+        snapshot_error = SNAPSHOT_WRITE_CLOSE_EOF_ERROR;
+        ret = -1;
+    }
+    s->gz = NULL;
+    s->file = NULL;
+    return ret;
+}
+
+static void snapshot_free(snapshot_t *s)
+{
+    if (s->memory != NULL) {
+        /* the buffer belongs to the memory target */
+        lib_free(s);
+        return;
+    }
+    lib_free(s->data);
+    lib_free(s->filename);
+    lib_free(s);
+}
+
 snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t minor_version, const char *snapshot_machine_name)
 {
     FILE *f;
@@ -806,61 +960,59 @@ snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t
 
     current_filename = (char *)filename;
 
-    f = fopen(filename, MODE_WRITE);
-    if (f == NULL) {
-        snapshot_error = SNAPSHOT_CANNOT_CREATE_SNAPSHOT_ERROR;
-        return NULL;
+    s = lib_calloc(1, sizeof(snapshot_t));
+    s->write_mode = 1;
+
+    if (snapshot_memory != NULL) {
+        /* reuse the buffer of the memory target */
+        s->memory = snapshot_memory;
+        s->data = snapshot_memory->data;
+        s->alloc = snapshot_memory->alloc;
+    } else if (snapshot_is_gzip(filename)) {
+        s->gz = gzopen(filename, MODE_WRITE);
+        if (s->gz == NULL) {
+            snapshot_error = SNAPSHOT_CANNOT_CREATE_SNAPSHOT_ERROR;
+            lib_free(s);
+            return NULL;
+        }
+        s->filename = lib_strdup(filename);
+    } else {
+        f = fopen(filename, MODE_WRITE);
+        if (f == NULL) {
+            snapshot_error = SNAPSHOT_CANNOT_CREATE_SNAPSHOT_ERROR;
+            lib_free(s);
+            return NULL;
+        }
+        s->file = f;
+        s->filename = lib_strdup(filename);
     }
 
     /* Magic string.  */
-    if (snapshot_write_padded_string(f, snapshot_magic_string, (uint8_t)0, SNAPSHOT_MAGIC_LEN) < 0) {
-        snapshot_error = SNAPSHOT_CANNOT_WRITE_MAGIC_STRING_ERROR;
-        goto fail;
-    }
+    snapshot_write_padded_string(s, snapshot_magic_string, (uint8_t)0, SNAPSHOT_MAGIC_LEN);
 
     /* Version number.  */
-    if (snapshot_write_byte(f, major_version) < 0
-        || snapshot_write_byte(f, minor_version) < 0) {
-        snapshot_error = SNAPSHOT_CANNOT_WRITE_VERSION_ERROR;
-        goto fail;
-    }
+    snapshot_write_byte(s, major_version);
+    snapshot_write_byte(s, minor_version);
 
     /* Machine.  */
-    if (snapshot_write_padded_string(f, snapshot_machine_name, (uint8_t)0, SNAPSHOT_MACHINE_NAME_LEN) < 0) {
-        snapshot_error = SNAPSHOT_CANNOT_WRITE_MACHINE_NAME_ERROR;
-        goto fail;
-    }
+    snapshot_write_padded_string(s, snapshot_machine_name, (uint8_t)0, SNAPSHOT_MACHINE_NAME_LEN);
 
     /* VICE version and revision */
-    if (snapshot_write_padded_string(f, snapshot_version_magic_string, (uint8_t)0, SNAPSHOT_VERSION_MAGIC_LEN) < 0) {
-        snapshot_error = SNAPSHOT_CANNOT_WRITE_MAGIC_STRING_ERROR;
-        goto fail;
-    }
+    snapshot_write_padded_string(s, snapshot_version_magic_string, (uint8_t)0, SNAPSHOT_VERSION_MAGIC_LEN);
 
-    if (snapshot_write_byte(f, viceversion[0]) < 0
-        || snapshot_write_byte(f, viceversion[1]) < 0
-        || snapshot_write_byte(f, viceversion[2]) < 0
-        || snapshot_write_byte(f, viceversion[3]) < 0
+    snapshot_write_byte(s, viceversion[0]);
+    snapshot_write_byte(s, viceversion[1]);
+    snapshot_write_byte(s, viceversion[2]);
+    snapshot_write_byte(s, viceversion[3]);
 #ifdef USE_SVN_REVISION
-        || snapshot_write_dword(f, VICE_SVN_REV_NUMBER) < 0) {
+    snapshot_write_dword(s, VICE_SVN_REV_NUMBER);
 #else
-        || snapshot_write_dword(f, 0) < 0) {
+    snapshot_write_dword(s, 0);
 #endif
-        snapshot_error = SNAPSHOT_CANNOT_WRITE_VERSION_ERROR;
-        goto fail;
-    }
 
-    s = lib_malloc(sizeof(snapshot_t));
-    s->file = f;
-    s->first_module_offset = ftell(f);
-    s->write_mode = 1;
+    s->first_module_offset = (long)s->pos;
 
     return s;
-
-fail:
-    fclose(f);
-    archdep_remove(filename);
-    return NULL;
 }
 
 /* informal only, used by the error message created below */
@@ -869,7 +1021,6 @@ static uint32_t snapshot_vicerevision;
 
 snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, uint8_t *minor_version_return, const char *snapshot_machine_name)
 {
-    FILE *f;
     char magic[SNAPSHOT_MAGIC_LEN];
     snapshot_t *s = NULL;
     int machine_name_len;
@@ -879,28 +1030,34 @@ snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, u
     current_filename = (char *)filename;
     current_module = NULL;
 
-    f = zfile_fopen(filename, MODE_READ);
-    if (f == NULL) {
+    s = lib_calloc(1, sizeof(snapshot_t));
+    s->write_mode = 0;
+
+    if (snapshot_memory != NULL) {
+        s->memory = snapshot_memory;
+        s->data = snapshot_memory->data;
+        s->size = snapshot_memory->size;
+    } else if (snapshot_load(s, filename) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_OPEN_FOR_READ_ERROR;
-        return NULL;
+        goto fail;
     }
 
     /* Magic string.  */
-    if (snapshot_read_byte_array(f, (uint8_t *)magic, SNAPSHOT_MAGIC_LEN) < 0
+    if (snapshot_read_byte_array(s, (uint8_t *)magic, SNAPSHOT_MAGIC_LEN) < 0
         || memcmp(magic, snapshot_magic_string, SNAPSHOT_MAGIC_LEN) != 0) {
         snapshot_error = SNAPSHOT_MAGIC_STRING_MISMATCH_ERROR;
         goto fail;
     }
 
     /* Version number.  */
-    if (snapshot_read_byte(f, major_version_return) < 0
-        || snapshot_read_byte(f, minor_version_return) < 0) {
+    if (snapshot_read_byte(s, major_version_return) < 0
+        || snapshot_read_byte(s, minor_version_return) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_READ_VERSION_ERROR;
         goto fail;
     }
 
     /* Machine.  */
-    if (snapshot_read_byte_array(f, (uint8_t *)read_name, SNAPSHOT_MACHINE_NAME_LEN) < 0) {
+    if (snapshot_read_byte_array(s, (uint8_t *)read_name, SNAPSHOT_MACHINE_NAME_LEN) < 0) {
         snapshot_error = SNAPSHOT_CANNOT_READ_MACHINE_NAME_ERROR;
         goto fail;
     }
@@ -917,59 +1074,50 @@ snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, u
     /* VICE version and revision */
     memset(snapshot_viceversion, 0, 4);
     snapshot_vicerevision = 0;
-    offs = ftell(f);
+    offs = s->pos;
 
-    if (snapshot_read_byte_array(f, (uint8_t *)magic, SNAPSHOT_VERSION_MAGIC_LEN) < 0
+    if (snapshot_read_byte_array(s, (uint8_t *)magic, SNAPSHOT_VERSION_MAGIC_LEN) < 0
         || memcmp(magic, snapshot_version_magic_string, SNAPSHOT_VERSION_MAGIC_LEN) != 0) {
         /* old snapshots do not contain VICE version */
-        fseek(f, offs, SEEK_SET);
+        s->pos = offs;
         log_warning(LOG_DEFAULT, "attempting to load pre 2.4.30 snapshot");
     } else {
         /* actually read the version */
-        if (snapshot_read_byte(f, &snapshot_viceversion[0]) < 0
-            || snapshot_read_byte(f, &snapshot_viceversion[1]) < 0
-            || snapshot_read_byte(f, &snapshot_viceversion[2]) < 0
-            || snapshot_read_byte(f, &snapshot_viceversion[3]) < 0
-            || snapshot_read_dword(f, &snapshot_vicerevision) < 0) {
+        if (snapshot_read_byte(s, &snapshot_viceversion[0]) < 0
+            || snapshot_read_byte(s, &snapshot_viceversion[1]) < 0
+            || snapshot_read_byte(s, &snapshot_viceversion[2]) < 0
+            || snapshot_read_byte(s, &snapshot_viceversion[3]) < 0
+            || snapshot_read_dword(s, &snapshot_vicerevision) < 0) {
             snapshot_error = SNAPSHOT_CANNOT_READ_VERSION_ERROR;
             goto fail;
         }
     }
 
-    s = lib_malloc(sizeof(snapshot_t));
-    s->file = f;
-    s->first_module_offset = ftell(f);
-    s->write_mode = 0;
+    s->first_module_offset = (long)s->pos;
 
     vsync_suspend_speed_eval();
     return s;
 
 fail:
-    fclose(f);
+    snapshot_free(s);
     return NULL;
 }
 
 int snapshot_close(snapshot_t *s)
 {
-    int retval;
-
-    if (!s->write_mode) {
-        if (zfile_fclose(s->file) == EOF) {
-            snapshot_error = SNAPSHOT_READ_CLOSE_EOF_ERROR;
-            retval = -1;
-        } else {
-            retval = 0;
-        }
-    } else {
-        if (fclose(s->file) == EOF) {
-            snapshot_error = SNAPSHOT_WRITE_CLOSE_EOF_ERROR;
+    int retval = 0;
+
+    if (s->write_mode) {
+        if (s->memory != NULL) {
+            s->memory->data = s->data;
+            s->memory->size = s->size;
+            s->memory->alloc = s->alloc;
+        } else if (snapshot_save(s) < 0) {
             retval = -1;
-        } else {
-            retval = 0;
         }
     }
 
-    lib_free(s);
+    snapshot_free(s);
     return retval;
 }
 
@@ -1127,6 +1275,22 @@ void snapshot_display_error(void)
     }
 }
 
+/* Make snapshot_create() and snapshot_open() use the memory buffer `mem'
+   instead of a file, until called again with NULL.  snapshot_create()
+   reuses the buffer already allocated in `mem' and updates `mem' on
+   snapshot_close().  */
+void snapshot_set_memory(snapshot_memory_t *mem)
+{
+    snapshot_memory = mem;
+}
+
+/* Return non-zero if `s' lives in a memory buffer (see
+   snapshot_set_memory()) and never reaches a file.  */
+int snapshot_is_memory(snapshot_t *s)
+{
+    return s->memory != NULL;
+}
+
 void snapshot_set_error(int error)
 {
     snapshot_error = error;
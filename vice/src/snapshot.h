@@ -68,6 +68,13 @@
 typedef struct snapshot_module_s snapshot_module_t;
 typedef struct snapshot_s snapshot_t;
 
+/* Memory buffer holding a complete snapshot, see snapshot_set_memory().  */
+typedef struct snapshot_memory_s {
+    uint8_t *data;
+    size_t size;    /* number of valid bytes */
+    size_t alloc;   /* number of bytes allocated */
+} snapshot_memory_t;
+
 void snapshot_display_error(void);
 
 int snapshot_module_write_byte(snapshot_module_t *m, uint8_t data);
@@ -136,6 +143,9 @@ snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t
 snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, uint8_t *minor_version_return, const char *snapshot_machine_name);
 int snapshot_close(snapshot_t *s);
 
+void snapshot_set_memory(snapshot_memory_t *mem);
+int snapshot_is_memory(snapshot_t *s);
+
 void snapshot_set_error(int error);
 int snapshot_get_error(void);
 
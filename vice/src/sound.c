@@ -41,6 +41,7 @@
 #endif
 
 #include "archdep.h"
+#include "benchmark.h"
 #include "cmdline.h"
 #include "debug.h"
 #include "fixpoint.h"
@@ -274,6 +275,18 @@ static void sound_machine_close(sound_t *psid)
 #ifdef SOUND_SYSTEM_FLOAT
 static float *sound_buffer[SOUND_CHIPS_MAX][SOUND_CHIP_CHANNELS_MAX];
 
+/* interleaved mix of all chip channels, before clipping and conversion */
+static float *sound_mix_buffer = NULL;
+
+/* one chip channel that contributes to the mix, with its gain per output
+   channel (volume / 100) */
+typedef struct sound_mix_source_s {
+    const float *buffer;
+    float gain[SOUND_OUTPUT_CHANNELS_MAX];
+} sound_mix_source_t;
+
+static sound_mix_source_t sound_mix_sources[SOUND_CHIPS_MAX * SOUND_CHIP_CHANNELS_MAX];
+
 static void free_sound_buffers(void)
 {
     int i, j;
@@ -287,6 +300,10 @@ static void free_sound_buffers(void)
             }
         }
     }
+    if (sound_mix_buffer) {
+        lib_free(sound_mix_buffer);
+        sound_mix_buffer = NULL;
+    }
 }
 
 static void malloc_sound_buffers(int size)
@@ -299,9 +316,301 @@ static void malloc_sound_buffers(int size)
             sound_buffer[i][j] = lib_malloc(size);
         }
     }
+    sound_mix_buffer = lib_malloc(size);
+}
+
+/* Collect the chip channels which end up in the output, together with their
+   gains. Channels that are muted on all output channels are left out, so the
+   mixing loops below don't need to check anything per sample. */
+static int sound_mix_setup_sources(const int *sound_channels, int soc)
+{
+    int i, k, channels;
+    int n = 0;
+
+    for (i = 0; i < (offset >> 5); i++) {
+        if (!sound_calls[i]->chip_enabled) {
+            continue;
+        }
+        channels = sound_channels[i] > 1 ? sound_channels[i] : 1;
+        for (k = 0; k < channels; k++) {
+            sound_mix_source_t *source = &sound_mix_sources[n];
+
+            source->buffer = sound_buffer[i][k];
+            if (soc == SOUND_OUTPUT_MONO) {
+                /* mono output adds all channels at full volume */
+                source->gain[0] = 1.0f;
+            } else {
+                source->gain[0] = sound_calls[i]->sound_chip_channel_mixing[k].left_channel_volume / 100.0f;
+                source->gain[1] = sound_calls[i]->sound_chip_channel_mixing[k].right_channel_volume / 100.0f;
+                if (source->gain[0] == 0.0f && source->gain[1] == 0.0f) {
+                    continue;
+                }
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+/* Add all sources into the interleaved mix buffer. The loops are kept
+   simple and branch free so the compiler can vectorize them. */
+static void sound_mix_sources_add(float *mix, int num_sources, int nr, int soc)
+{
+    int i, j;
+
+    memset(mix, 0, nr * soc * sizeof(float));
+
+    for (i = 0; i < num_sources; i++) {
+        const float *src = sound_mix_sources[i].buffer;
+
+        if (soc == SOUND_OUTPUT_MONO) {
+            for (j = 0; j < nr; j++) {
+                mix[j] += src[j];
+            }
+        } else {
+            const float left = sound_mix_sources[i].gain[0];
+            const float right = sound_mix_sources[i].gain[1];
+
+            for (j = 0; j < nr; j++) {
+                mix[j * 2] += src[j] * left;
+                mix[j * 2 + 1] += src[j] * right;
+            }
+        }
+    }
+}
+
+/* clip to [-1.0, 1.0] and convert to int16_t in one pass */
+static void sound_mix_clip_convert(int16_t *pbuf, const float *mix, int n)
+{
+    int j;
+
+    for (j = 0; j < n; j++) {
+        float sample = mix[j];
+
+        sample = sample < -1.0f ? -1.0f : sample;
+        sample = sample > 1.0f ? 1.0f : sample;
+        pbuf[j] = (int16_t)(sample * 32767.0f);
+    }
 }
 #endif
 
+#ifndef SOUND_SYSTEM_FLOAT
+/* The multi chip mixing uses SSE2, which every x86-64 CPU has, when the
+   compiler targets it; otherwise the samples are mixed one by one. */
+#if defined(__SSE2__)
+#define SOUND_MIX_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef SOUND_MIX_SSE2
+/* sound_audio_mix() of 8 samples. It adds the samples, and when both have
+   the same sign it takes their product / 32768 off (positive) or adds it
+   (negative); that product is exact in the low 16 bits of
+   (a * b) >> 15, which is all the final 16 bit result needs. */
+static inline __m128i sound_audio_mix_sse2(__m128i a, __m128i b)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_mullo_epi16(a, b);
+    __m128i hi = _mm_mulhi_epi16(a, b);
+    __m128i prod = _mm_or_si128(_mm_slli_epi16(hi, 1), _mm_srli_epi16(lo, 15));
+    __m128i pos = _mm_and_si128(_mm_cmpgt_epi16(a, zero), _mm_cmpgt_epi16(b, zero));
+    __m128i neg = _mm_and_si128(_mm_cmplt_epi16(a, zero), _mm_cmplt_epi16(b, zero));
+    __m128i sum = _mm_add_epi16(a, b);
+
+    sum = _mm_sub_epi16(sum, _mm_and_si128(pos, prod));
+    return _mm_add_epi16(sum, _mm_and_si128(neg, prod));
+}
+#endif
+
+static void sound_audio_mix_buffer_scalar(int16_t *dst, const int16_t *src, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        dst[i] = sound_audio_mix(dst[i], src[i]);
+    }
+}
+
+static void sound_audio_mix_buffer_mono_scalar(int16_t *dst, const int16_t *src, int nr)
+{
+    int i;
+
+    for (i = 0; i < nr; i++) {
+        dst[i * 2] = sound_audio_mix(dst[i * 2], src[i]);
+        dst[i * 2 + 1] = sound_audio_mix(dst[i * 2 + 1], src[i]);
+    }
+}
+
+void sound_audio_mix_buffer(int16_t *dst, const int16_t *src, int n)
+{
+    int i = 0;
+
+#ifdef SOUND_MIX_SSE2
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+
+        _mm_storeu_si128((__m128i *)(dst + i), sound_audio_mix_sse2(a, b));
+    }
+#endif
+    sound_audio_mix_buffer_scalar(dst + i, src + i, n - i);
+}
+
+void sound_audio_mix_buffer_mono(int16_t *dst, const int16_t *src, int nr)
+{
+    int i = 0;
+
+#ifdef SOUND_MIX_SSE2
+    for (; i + 8 <= nr; i += 8) {
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i a0 = _mm_loadu_si128((const __m128i *)(dst + i * 2));
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(dst + i * 2 + 8));
+
+        _mm_storeu_si128((__m128i *)(dst + i * 2),
+                         sound_audio_mix_sse2(a0, _mm_unpacklo_epi16(b, b)));
+        _mm_storeu_si128((__m128i *)(dst + i * 2 + 8),
+                         sound_audio_mix_sse2(a1, _mm_unpackhi_epi16(b, b)));
+    }
+#endif
+    sound_audio_mix_buffer_mono_scalar(dst + i * 2, src + i, nr - i);
+}
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+/* The "soundmix" micro benchmark checks the mixing of whole buffers against
+   sound_audio_mix(), for every sample value against 256 others, and times
+   the mixing sid.c does for 8 SIDs in mono and 7 SIDs in stereo. */
+
+/* Each test is timed for this long.  */
+#define SOUNDMIX_BENCHMARK_SECONDS  0.5
+
+/* samples per SID and fragment, 48 kHz in 10 ms */
+#define SOUNDMIX_BENCHMARK_SAMPLES  480
+
+static uint32_t soundmix_benchmark_random(uint32_t *seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 16;
+}
+
+static int soundmix_benchmark(void)
+{
+    static const int16_t edges[] = {
+        0, 1, -1, 2, -2, 181, -181, 182, -182, 16384, -16384,
+        32766, -32766, 32767, -32767, -32768
+    };
+    int16_t *a, *b, *ref, *out;
+    uint32_t seed = 1;
+    unsigned long checks = 0, mismatches = 0;
+    int i, j, n, pass;
+
+    a = lib_malloc(65536 * 2 * sizeof(int16_t));
+    b = lib_malloc(65536 * sizeof(int16_t));
+    ref = lib_malloc(65536 * 2 * sizeof(int16_t));
+    out = lib_malloc(65536 * 2 * sizeof(int16_t));
+
+    /* every value of the first sample against edge cases and random ones,
+       at an odd offset so that the vector loops have a scalar tail */
+    for (j = 0; j < 256; j++) {
+        int16_t v = j < (int)(sizeof(edges) / sizeof(edges[0]))
+                    ? edges[j] : (int16_t)soundmix_benchmark_random(&seed);
+
+        for (i = 0; i < 65536; i++) {
+            a[i] = (int16_t)(i - 32768);
+            b[i] = v;
+            ref[i] = sound_audio_mix(a[i], v);
+        }
+        memcpy(out, a, 65536 * sizeof(int16_t));
+        sound_audio_mix_buffer(out + 1, b + 1, 65535);
+        checks += 65535;
+        for (i = 1; i < 65536; i++) {
+            if (out[i] != ref[i]) {
+                mismatches++;
+            }
+        }
+    }
+
+    /* a mono buffer into a stereo one */
+    for (i = 0; i < 65536; i++) {
+        a[i * 2] = (int16_t)soundmix_benchmark_random(&seed);
+        a[i * 2 + 1] = (int16_t)soundmix_benchmark_random(&seed);
+        b[i] = (int16_t)soundmix_benchmark_random(&seed);
+    }
+    memcpy(ref, a, 65536 * 2 * sizeof(int16_t));
+    memcpy(out, a, 65536 * 2 * sizeof(int16_t));
+    sound_audio_mix_buffer_mono_scalar(ref, b, 65533);
+    sound_audio_mix_buffer_mono(out, b, 65533);
+    checks += 65533 * 2;
+    for (i = 0; i < 65536 * 2; i++) {
+        if (out[i] != ref[i]) {
+            mismatches++;
+        }
+    }
+    if (mismatches) {
+        log_error(sound_log, "Sound mix benchmark: %lu of %lu samples differ.", mismatches, checks);
+    }
+
+    /* mono: 7 SIDs into the output of the eighth; stereo: 2 pairs of SIDs
+       and a mono one into the output of the first pair */
+    for (i = 0; i < 65536 * 2; i++) {
+        a[i] = (int16_t)(soundmix_benchmark_random(&seed) >> 2);
+    }
+    for (n = 0; n < 2; n++) {
+        for (pass = 0; pass < 2; pass++) {
+            char test[32];
+            unsigned long fragments = 0;
+            tick_t start;
+            double seconds;
+            int16_t *dst = out;
+            const int16_t *src = a + 2048;
+
+            start = tick_now();
+            do {
+                for (j = 0; j < 7; j++) {
+                    const int16_t *sid = src + j * SOUNDMIX_BENCHMARK_SAMPLES * 2;
+
+                    if (n == 0) {
+                        if (pass == 0) {
+                            sound_audio_mix_buffer_scalar(dst, sid, SOUNDMIX_BENCHMARK_SAMPLES);
+                        } else {
+                            sound_audio_mix_buffer(dst, sid, SOUNDMIX_BENCHMARK_SAMPLES);
+                        }
+                    } else if (j < 2) {
+                        if (pass == 0) {
+                            sound_audio_mix_buffer_scalar(dst, sid, SOUNDMIX_BENCHMARK_SAMPLES * 2);
+                        } else {
+                            sound_audio_mix_buffer(dst, sid, SOUNDMIX_BENCHMARK_SAMPLES * 2);
+                        }
+                    } else if (j == 2) {
+                        if (pass == 0) {
+                            sound_audio_mix_buffer_mono_scalar(dst, sid, SOUNDMIX_BENCHMARK_SAMPLES);
+                        } else {
+                            sound_audio_mix_buffer_mono(dst, sid, SOUNDMIX_BENCHMARK_SAMPLES);
+                        }
+                    }
+                }
+                /* start from fresh samples now and then, mixing saturates */
+                if ((++fragments & 63) == 0) {
+                    memcpy(dst, a, SOUNDMIX_BENCHMARK_SAMPLES * 2 * sizeof(int16_t));
+                }
+                seconds = (double)tick_now_delta(start) / tick_per_second();
+            } while (seconds < SOUNDMIX_BENCHMARK_SECONDS);
+            sprintf(test, "%s %s", n ? "7 SIDs stereo" : "8 SIDs mono", pass ? "vector" : "scalar");
+            benchmark_kernel_result("soundmix", test, seconds,
+                                    (double)fragments * SOUNDMIX_BENCHMARK_SAMPLES, "samples");
+        }
+    }
+    printf("Benchmark soundmix: %lu checks, %lu mismatches\n", checks, mismatches);
+
+    lib_free(out);
+    lib_free(ref);
+    lib_free(b);
+    lib_free(a);
+
+    return mismatches ? -1 : 0;
+}
+#endif
+#endif
+
 /*
     There is some inconsistency about when the buffer should be overwritten and
     when mixed. Usually it's overwritten by SID and other cycle based engines,
@@ -314,13 +623,14 @@ static int sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr
 {
 /* FIXME: fix mono stream to stereo mixing next */
 #ifdef SOUND_SYSTEM_FLOAT
-    int i, j, k;
+    int i, k;
     int temp;
+    int num_sources;
     int primary_sound_rendered = 0;
     int sound_channels[SOUND_CHIPS_MAX];
-    float *addition_buffer = NULL;
     CLOCK initial_delta_t = *delta_t;
     CLOCK delta_t_for_other_chips;
+    BENCHMARK_ENTER(BENCHMARK_SOUND);
 
     /* get the sound channels of the enabled sound devices */
     for (i = 0; i < (offset >> 5); i++) {
@@ -357,102 +667,19 @@ static int sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr
         }
     }
 
-    /* allocate buffer to hold added samples */
-    addition_buffer = lib_malloc(snddata.bufsize * soc * sizeof(float));
-
-    if (soc == SOUND_OUTPUT_MONO) {
-
-        /* Add all samples together for enabled sound devices and output in mono */
-        for (j = 0; j < temp; j++) {
-            addition_buffer[j] = 0.0;
-            for (i = 0; i < (offset >> 5); i++) {
-                if (sound_calls[i]->chip_enabled) {
-                    addition_buffer[j] += sound_buffer[i][0][j];
-                    if (sound_channels[i] > 1) {
-                        for (k = 1; k < sound_channels[i]; k++) {
-                            addition_buffer[j] += sound_buffer[i][k][j];
-                        }
-                    }
-                }
-            }
-        }
-    } else {
-
-        /* Add all samples together for enabled sound devices and output in stereo */
-        for (j = 0; j < temp; j++) {
-
-            /* left first */
-            addition_buffer[j * soc] = 0.0;
-            for (i = 0; i < (offset >> 5); i++) {
-                if (sound_calls[i]->chip_enabled) {
-                    if (sound_calls[i]->sound_chip_channel_mixing[0].left_channel_volume) {
-                        if (sound_calls[i]->sound_chip_channel_mixing[0].left_channel_volume == 100) {
-                            addition_buffer[j * soc] += sound_buffer[i][0][j];
-                        } else {
-                            addition_buffer[j * soc] += (sound_buffer[i][0][j] * sound_calls[i]->sound_chip_channel_mixing[0].left_channel_volume / 100.0);
-                        }
-                    }
-                    if (sound_channels[i] > 1) {
-                        for (k = 1; k < sound_channels[i]; k++) {
-                            if (sound_calls[i]->sound_chip_channel_mixing[k].left_channel_volume == 100) {
-                                addition_buffer[j * soc] += sound_buffer[i][k][j];
-                            } else {
-                                addition_buffer[j * soc] += (sound_buffer[i][k][j] * sound_calls[i]->sound_chip_channel_mixing[k].left_channel_volume / 100.0);
-                            }
-                        }
-                    }
-                }
-            }
-
-            /* now right */
-            addition_buffer[(j * soc) + 1] = 0.0;
-            for (i = 0; i < (offset >> 5); i++) {
-                if (sound_calls[i]->chip_enabled) {
-                    if (sound_calls[i]->sound_chip_channel_mixing[0].right_channel_volume) {
-                        if (sound_calls[i]->sound_chip_channel_mixing[0].right_channel_volume == 100) {
-                            addition_buffer[(j * soc) + 1] += sound_buffer[i][0][j];
-                        } else {
-                            addition_buffer[(j * soc) + 1] += (sound_buffer[i][0][j] * sound_calls[i]->sound_chip_channel_mixing[0].right_channel_volume / 100.0);
-                        }
-                    }
-                    if (sound_channels[i] > 1) {
-                        for (k = 1; k < sound_channels[i]; k++) {
-                            if (sound_calls[i]->sound_chip_channel_mixing[k].right_channel_volume == 100) {
-                                addition_buffer[(j * soc) + 1] += sound_buffer[i][k][j];
-                            } else {
-                                addition_buffer[(j * soc) + 1] += (sound_buffer[i][k][j] * sound_calls[i]->sound_chip_channel_mixing[k].right_channel_volume / 100.0);
-                            }
-                        }
-                    }
-                }
-            }
-
-        }
-    }
-
-    /* clip the addition buffer if needed */
-    for (j = 0; j < (temp * soc); j++) {
-        if (addition_buffer[j] < -1.0) {
-            addition_buffer[j] = -1.0;
-        } else if (addition_buffer[j] > 1.0) {
-            addition_buffer[j] = 1.0;
-        }
-    }
-
-    /* convert floats to int16_t for output */
-    for (j = 0; j < (temp * soc); j++) {
-        pbuf[j] = (int16_t)(addition_buffer[j] * 32767.0);
-    }
-
-    /* free addition buffer */
-    lib_free(addition_buffer);
+    /* mix all enabled chip channels, then clip and convert for output */
+    num_sources = sound_mix_setup_sources(sound_channels, soc);
+    sound_mix_sources_add(sound_mix_buffer, num_sources, temp, soc);
+    sound_mix_clip_convert(pbuf, sound_mix_buffer, temp * soc);
 
+    BENCHMARK_LEAVE();
     return temp;
 #else
     int i;
     int temp;
     CLOCK initial_delta_t = *delta_t;
     CLOCK delta_t_for_other_chips;
+    BENCHMARK_ENTER(BENCHMARK_SOUND);
 
     if (sound_calls[0]->cycle_based() || (!sound_calls[0]->cycle_based() && sound_calls[0]->chip_enabled)) {
         temp = sound_calls[0]->calculate_samples(psid, pbuf, nr, soc, scc, delta_t);
@@ -467,6 +694,7 @@ static int sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr
             sound_calls[i]->calculate_samples(psid, pbuf, temp, soc, scc, &delta_t_for_other_chips);
         }
     }
+    BENCHMARK_LEAVE();
     return temp;
 #endif
 }
@@ -1728,6 +1956,11 @@ void sound_init(unsigned int clock_rate, unsigned int ticks_per_frame)
 
     lib_free(devlist);
 
+#if defined(FEATURE_BENCHMARK_HOOKS) && !defined(SOUND_SYSTEM_FLOAT)
+    benchmark_kernel_register("soundmix", "mix the output of 8 SIDs, check against sound_audio_mix()",
+                              NULL, soundmix_benchmark);
+#endif
+
     archdep_sound_enable_default_device_tracking();
 }
 
@@ -244,6 +244,11 @@ static inline int16_t sound_audio_mix(int ch1, int ch2)
 
     return (int16_t)-((-(ch1) + -(ch2)) - (-(ch1) * -(ch2) / 32768));
 }
+
+/* sound_audio_mix() over whole buffers: `dst[i] = mix(dst[i], src[i])' for
+   `n' samples, and for a mono `src' into a stereo `dst' of `nr' frames */
+void sound_audio_mix_buffer(int16_t *dst, const int16_t *src, int n);
+void sound_audio_mix_buffer_mono(int16_t *dst, const int16_t *src, int nr);
 #endif
 
 sound_desc_t *sound_get_valid_devices(int type, int sort);
@@ -152,6 +152,12 @@ static const cmdline_option_t cmdline_options[] =
     { "+VICIIvspbug", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
       NULL, NULL, "VICIIVSPBug", (void *)0,
       NULL, "Disable VSP bug emulation" },
+    { "-VICIIrenderthread", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "VICIIRenderThread", (void *)1,
+      NULL, "Render the pixels on a separate thread, lines behind the emulation" },
+    { "+VICIIrenderthread", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "VICIIRenderThread", (void *)0,
+      NULL, "Render the pixels on the emulation thread" },
     /* NOTE: although we use CALL_FUNCTION, we put the resource that will be
              modified into the array - this helps reconstructing the cmdline */
     { "-VICIImodel", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
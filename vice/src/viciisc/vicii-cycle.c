@@ -33,6 +33,7 @@
 
 #include <string.h>
 
+#include "benchmark.h"
 #include "debug.h"
 #include "lib.h"
 #include "log.h"
@@ -385,6 +386,7 @@ int vicii_cycle(void)
     int ba_low = 0;
     int can_sprite_sprite, can_sprite_background;
     int vsp_may_crash;
+    BENCHMARK_ENTER(BENCHMARK_VIDEOCHIP);
 
     /*VICII_DEBUG_CYCLE(("cycle: line %i, clk %i", vicii.raster_line, vicii.raster_cycle));*/
 
@@ -621,6 +623,7 @@ int vicii_cycle(void)
         vicii_trigger_light_pen_internal(0);
     }
 
+    BENCHMARK_LEAVE();
     return ba_low;
 }
 
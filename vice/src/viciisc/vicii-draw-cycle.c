@@ -26,8 +26,13 @@
 
 #include "vice.h"
 
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#endif
 #include <string.h>
 
+#include "lib.h"
+#include "log.h"
 #include "types.h"
 #include "snapshot.h"
 #include "vicii-chip-model.h"
@@ -64,69 +69,97 @@
 #define COL_D02D     0x2d
 #define COL_D02E     0x2e
 
-/* foreground/background graphics */
-
-static uint8_t gbuf_pipe0_reg = 0;
-static uint8_t cbuf_pipe0_reg = 0;
-static uint8_t vbuf_pipe0_reg = 0;
-static uint8_t gbuf_pipe1_reg = 0;
-static uint8_t cbuf_pipe1_reg = 0;
-static uint8_t vbuf_pipe1_reg = 0;
-
-static uint8_t xscroll_pipe = 0;
-static uint8_t vmode11_pipe = 0;
-static uint8_t vmode16_pipe = 0;
-static uint8_t vmode16_pipe2 = 0;
-
-/* gbuf shift register */
-static uint8_t gbuf_reg = 0;
-static uint8_t gbuf_mc_flop = 0;
-static uint8_t gbuf_pixel_reg = 0;
-
-/* cbuf and vbuf registers */
-static uint8_t cbuf_reg = 0;
-static uint8_t vbuf_reg = 0;
-
-static uint8_t dmli = 0;
-
-/* sprites */
-static int sprite_x_pipe[8];
-static uint8_t sprite_pri_bits = 0;
-static uint8_t sprite_mc_bits = 0;
-static uint8_t sprite_expx_bits = 0;
-
-static uint8_t sprite_pending_bits = 0;
-static uint8_t sprite_active_bits = 0;
-static uint8_t sprite_halt_bits = 0;
-
-/* sbuf shift registers */
-static uint32_t sbuf_reg[8];
-static uint8_t sbuf_pixel_reg[8];
-static uint8_t sbuf_expx_flops;
-static uint8_t sbuf_mc_flops;
-
-/* border */
-static int border_state = 0;
-
-/* pixel buffer */
-static uint8_t render_buffer[8];
-static uint8_t pri_buffer[8];
-
-static uint8_t pixel_buffer[8];
-
-/* color resolution registers */
-static uint8_t cregs[0x2f];
-static uint8_t last_color_reg;
-static uint8_t last_color_value;
+/* state of the pixel pipeline */
+typedef struct draw_state_s {
+    /* foreground/background graphics */
+    uint8_t gbuf_pipe0_reg;
+    uint8_t cbuf_pipe0_reg;
+    uint8_t vbuf_pipe0_reg;
+    uint8_t gbuf_pipe1_reg;
+    uint8_t cbuf_pipe1_reg;
+    uint8_t vbuf_pipe1_reg;
+
+    uint8_t xscroll_pipe;
+    uint8_t vmode11_pipe;
+    uint8_t vmode16_pipe;
+    uint8_t vmode16_pipe2;
+
+    /* gbuf shift register */
+    uint8_t gbuf_reg;
+    uint8_t gbuf_mc_flop;
+    uint8_t gbuf_pixel_reg;
+
+    /* cbuf and vbuf registers */
+    uint8_t cbuf_reg;
+    uint8_t vbuf_reg;
+
+    uint8_t dmli;
+
+    /* sprites */
+    int sprite_x_pipe[8];
+    uint8_t sprite_pri_bits;
+    uint8_t sprite_mc_bits;
+    uint8_t sprite_expx_bits;
+
+    uint8_t sprite_pending_bits;
+    uint8_t sprite_active_bits;
+    uint8_t sprite_halt_bits;
+
+    /* sbuf shift registers */
+    uint32_t sbuf_reg[8];
+    uint8_t sbuf_pixel_reg[8];
+    uint8_t sbuf_expx_flops;
+    uint8_t sbuf_mc_flops;
+
+    /* border */
+    int border_state;
+
+    /* pixel buffer */
+    uint8_t render_buffer[8];
+    uint8_t pri_buffer[8];
+
+    uint8_t pixel_buffer[8];
+
+    /* color resolution registers */
+    uint8_t cregs[0x2f];
+    uint8_t last_color_reg;
+    uint8_t last_color_value;
+
+    unsigned int cycle_flags_pipe;
+
+    /* draw buffer the pixels go to */
+    uint8_t *dbuf;
+    int *dbuf_offset;
+} draw_state_t;
+
+/* inputs of the pipeline from the rest of the chip, for one cycle */
+typedef struct draw_input_s {
+    unsigned int cycle_flags;
+    uint32_t sprite_data;       /* only on sprite dma 1/2 cycles */
+    uint16_t sprite_x[8];
+    uint8_t flags;              /* DRAW_INPUT_* */
+    uint8_t reg_11;
+    uint8_t reg_16;
+    uint8_t reg_1b;
+    uint8_t reg_1c;
+    uint8_t reg_1d;
+    uint8_t gbuf;
+    uint8_t vbuf;               /* only when a new character is shifted in */
+    uint8_t cbuf;               /* only when a new character is shifted in */
+    uint8_t sprite_display_bits;
+    uint8_t last_color_reg;
+    uint8_t last_color_value;
+} draw_input_t;
+
+#define DRAW_INPUT_NEW_LINE         0x01
+#define DRAW_INPUT_COLOR_LATENCY    0x02
+#define DRAW_INPUT_VBORDER          0x04
+#define DRAW_INPUT_IDLE_STATE       0x08
+#define DRAW_INPUT_MAIN_BORDER      0x10
+
+/* the pipeline run on the emulation thread */
+static draw_state_t draw_state;
 
-static unsigned int cycle_flags_pipe;
-
-void vicii_monitor_colreg_store(int reg, int value)
-{
-    cregs[reg] = value;
-    last_color_reg = reg;
-    last_color_value = value;
-}
 
 /**************************************************************************
  *
@@ -145,7 +178,20 @@ static const uint8_t colors[] = {
     COL_NONE, COL_NONE, COL_NONE, COL_NONE          /* ECM=1 BMM=1 MCM=1 */
 };
 
-static DRAW_INLINE void draw_graphics(int i)
+/*
+ * The functions below work on the pipeline state 'ds' and read the chip
+ * only through the cycle's inputs 'in', so that they can also run on the
+ * render thread (see the deferred rendering section).
+ *
+ * They take a 'render' flag, which is 0 on frames that are not drawn (see
+ * raster_t.skip_drawing) and when the render thread draws. Only what the
+ * CPU can observe is emulated then: the pixel priorities and sprite pixels,
+ * for collisions. Colors are not resolved and nothing is written to the
+ * draw buffer. The 'collide' flag is 0 on the render thread, which must
+ * leave the collision registers alone.
+ */
+
+static DRAW_INLINE void draw_graphics(draw_state_t *ds, int i, int render)
 {
     uint8_t px;
     uint8_t cc;
@@ -153,27 +199,27 @@ static DRAW_INLINE void draw_graphics(int i)
     uint8_t vmode;
 
     /* Load new gbuf/vbuf/cbuf values at offset == xscroll */
-    if (i == xscroll_pipe) {
+    if (i == ds->xscroll_pipe) {
         /* latch values at time xs */
-        vbuf_reg = vbuf_pipe1_reg;
-        cbuf_reg = cbuf_pipe1_reg;
-        gbuf_reg = gbuf_pipe1_reg;
-        gbuf_mc_flop = 1;
+        ds->vbuf_reg = ds->vbuf_pipe1_reg;
+        ds->cbuf_reg = ds->cbuf_pipe1_reg;
+        ds->gbuf_reg = ds->gbuf_pipe1_reg;
+        ds->gbuf_mc_flop = 1;
     }
 
     /*
      * read pixels depending on video mode
      * mc pixels if MCM=1 and BMM=1, or MCM=1 and cbuf bit 3 = 1
      */
-    if (vmode16_pipe2) {
-        if ((vmode11_pipe & 0x08) || (cbuf_reg & 0x08)) {
+    if (ds->vmode16_pipe2) {
+        if ((ds->vmode11_pipe & 0x08) || (ds->cbuf_reg & 0x08)) {
             /* mc pixels */
-            if (gbuf_mc_flop) {
-                gbuf_pixel_reg = gbuf_reg >> 6;
+            if (ds->gbuf_mc_flop) {
+                ds->gbuf_pixel_reg = ds->gbuf_reg >> 6;
             }
         } else {
             /* hires pixels */
-            gbuf_pixel_reg = (gbuf_reg & 0x80) ? 3 : 0;
+            ds->gbuf_pixel_reg = (ds->gbuf_reg & 0x80) ? 3 : 0;
         }
     } else {
         /*
@@ -181,23 +227,29 @@ static DRAW_INLINE void draw_graphics(int i)
          * MC and non-MC chars.
          * This is rather ugly. There must be a simpler solution.
          */
-        if ((vmode11_pipe & 0x08) || (cbuf_reg & 0x08)) {
+        if ((ds->vmode11_pipe & 0x08) || (ds->cbuf_reg & 0x08)) {
             /* hires pixels */
-            gbuf_pixel_reg = (gbuf_reg & 0x80) ? 2 : 0;
+            ds->gbuf_pixel_reg = (ds->gbuf_reg & 0x80) ? 2 : 0;
         } else {
             /* hires pixels */
-            gbuf_pixel_reg = (gbuf_reg & 0x80) ? 3 : 0;
+            ds->gbuf_pixel_reg = (ds->gbuf_reg & 0x80) ? 3 : 0;
         }
     }
-    px = gbuf_pixel_reg;
+    px = ds->gbuf_pixel_reg;
 
     /* shift the graphics buffer */
-    gbuf_reg <<= 1;
-    gbuf_mc_flop ^= 1;
+    ds->gbuf_reg <<= 1;
+    ds->gbuf_mc_flop ^= 1;
 
     /* Determine pixel color and priority */
-    vmode = vmode11_pipe | vmode16_pipe;
     pixel_pri = (px & 0x2);
+    ds->pri_buffer[i] = pixel_pri;
+
+    if (!render) {
+        return;
+    }
+
+    vmode = ds->vmode11_pipe | ds->vmode16_pipe;
     cc = colors[vmode | px];
 
     /* lookup colors and render pixel */
@@ -206,29 +258,29 @@ static DRAW_INLINE void draw_graphics(int i)
             cc = 0;
             break;
         case COL_VBUF_L:
-            cc = vbuf_reg & 0x0f;
+            cc = ds->vbuf_reg & 0x0f;
             break;
         case COL_VBUF_H:
-            cc = vbuf_reg >> 4;
+            cc = ds->vbuf_reg >> 4;
             break;
         case COL_CBUF:
-            cc = cbuf_reg;
+            cc = ds->cbuf_reg;
             break;
         case COL_CBUF_MC:
-            cc = cbuf_reg & 0x07;
+            cc = ds->cbuf_reg & 0x07;
             break;
         case COL_D02X_EXT:
-            cc = COL_D021 + (vbuf_reg >> 6);
+            cc = COL_D021 + (ds->vbuf_reg >> 6);
             break;
         default:
             break;
     }
 
-    render_buffer[i] = cc;
-    pri_buffer[i] = pixel_pri;
+    ds->render_buffer[i] = cc;
 }
 
-static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
+static DRAW_INLINE void draw_graphics8(draw_state_t *ds, const draw_input_t *in,
+                                       unsigned int cycle_flags, int render)
 {
     int vis_en;
 
@@ -236,65 +288,65 @@ static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
 
     /* render pixels */
     /* pixel 0 */
-    draw_graphics(0);
+    draw_graphics(ds, 0, render);
     /* pixel 1 */
-    draw_graphics(1);
+    draw_graphics(ds, 1, render);
     /* pixel 2 */
-    draw_graphics(2);
+    draw_graphics(ds, 2, render);
     /* pixel 3 */
-    draw_graphics(3);
+    draw_graphics(ds, 3, render);
     /* pixel 4 */
-    vmode16_pipe = ( vicii.regs[0x16] & 0x10 ) >> 2;
-    if (vicii.color_latency) {
+    ds->vmode16_pipe = ( in->reg_16 & 0x10 ) >> 2;
+    if (in->flags & DRAW_INPUT_COLOR_LATENCY) {
         /* handle rising edge of internal signal */
-        vmode11_pipe |= ( vicii.regs[0x11] & 0x60 ) >> 2;
+        ds->vmode11_pipe |= ( in->reg_11 & 0x60 ) >> 2;
     }
-    draw_graphics(4);
+    draw_graphics(ds, 4, render);
     /* pixel 5 */
-    draw_graphics(5);
+    draw_graphics(ds, 5, render);
     /* pixel 6 */
-    if (vicii.color_latency) {
+    if (in->flags & DRAW_INPUT_COLOR_LATENCY) {
         /* handle falling edge of internal signal */
-        vmode11_pipe &= ( vicii.regs[0x11] & 0x60 ) >> 2;
+        ds->vmode11_pipe &= ( in->reg_11 & 0x60 ) >> 2;
     }
-    draw_graphics(6);
+    draw_graphics(ds, 6, render);
     /* pixel 7 */
-    if (vmode16_pipe && !vmode16_pipe2) {
-        gbuf_mc_flop = 0;
+    if (ds->vmode16_pipe && !ds->vmode16_pipe2) {
+        ds->gbuf_mc_flop = 0;
     }
-    vmode16_pipe2 = vmode16_pipe;
-    draw_graphics(7);
+    ds->vmode16_pipe2 = ds->vmode16_pipe;
+    draw_graphics(ds, 7, render);
 
-    if (!vicii.color_latency) {
-        vmode11_pipe = ( vicii.regs[0x11] & 0x60 ) >> 2;
+    if (!(in->flags & DRAW_INPUT_COLOR_LATENCY)) {
+        ds->vmode11_pipe = ( in->reg_11 & 0x60 ) >> 2;
     }
 
     /* shift and put the next data into the pipe. */
-    vbuf_pipe1_reg = vbuf_pipe0_reg;
-    cbuf_pipe1_reg = cbuf_pipe0_reg;
-    gbuf_pipe1_reg = gbuf_pipe0_reg;
+    ds->vbuf_pipe1_reg = ds->vbuf_pipe0_reg;
+    ds->cbuf_pipe1_reg = ds->cbuf_pipe0_reg;
+    ds->gbuf_pipe1_reg = ds->gbuf_pipe0_reg;
 
     /* this makes sure gbuf is 0 outside the visible area
        It should probably be done somewhere around the fetch instead */
-    if (vis_en && vicii.vborder == 0) {
-        gbuf_pipe0_reg = vicii.gbuf;
-        xscroll_pipe = vicii.regs[0x16] & 0x07;
+    if (vis_en && !(in->flags & DRAW_INPUT_VBORDER)) {
+        ds->gbuf_pipe0_reg = in->gbuf;
+        ds->xscroll_pipe = in->reg_16 & 0x07;
     } else {
-        gbuf_pipe0_reg = 0;
+        ds->gbuf_pipe0_reg = 0;
     }
 
     /* Only update vbuf and cbuf registers in the display state. */
-    if (vis_en && vicii.vborder == 0) {
-        if (!vicii.idle_state) {
-            vbuf_pipe0_reg = vicii.vbuf[dmli];
-            cbuf_pipe0_reg = vicii.cbuf[dmli];
-            dmli++;
+    if (vis_en && !(in->flags & DRAW_INPUT_VBORDER)) {
+        if (!(in->flags & DRAW_INPUT_IDLE_STATE)) {
+            ds->vbuf_pipe0_reg = in->vbuf;
+            ds->cbuf_pipe0_reg = in->cbuf;
+            ds->dmli++;
         } else {
-            vbuf_pipe0_reg = 0;
-            cbuf_pipe0_reg = 0;
+            ds->vbuf_pipe0_reg = 0;
+            ds->cbuf_pipe0_reg = 0;
         }
     } else {
-        dmli = 0;
+        ds->dmli = 0;
     }
 }
 
@@ -305,26 +357,26 @@ static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
  * SECTION  draw_sprites()
  *
  ******/
-static DRAW_INLINE uint8_t get_trigger_candidates(int xpos)
+static DRAW_INLINE uint8_t get_trigger_candidates(draw_state_t *ds, int xpos)
 {
     int s;
     uint8_t candidate_bits = 0;
 
     /* check for partial xpos match */
     for (s = 0; s < 8; s++) {
-        if ((xpos & 0x1f8) == (sprite_x_pipe[s] & 0x1f8)) {
+        if ((xpos & 0x1f8) == (ds->sprite_x_pipe[s] & 0x1f8)) {
             candidate_bits |= 1 << s;
         }
     }
     return candidate_bits;
 }
 
-static DRAW_INLINE void trigger_sprites(int xpos, uint8_t candidate_bits)
+static DRAW_INLINE void trigger_sprites(draw_state_t *ds, int xpos, uint8_t candidate_bits)
 {
     int s;
 
     /* do nothing if no sprites are candidates or pending */
-    if (!candidate_bits || !sprite_pending_bits) {
+    if (!candidate_bits || !ds->sprite_pending_bits) {
         return;
     }
 
@@ -333,24 +385,25 @@ static DRAW_INLINE void trigger_sprites(int xpos, uint8_t candidate_bits)
         uint8_t m = 1 << s;
 
         /* start rendering on position match */
-        if ((candidate_bits & m) && (sprite_pending_bits & m) && !(sprite_active_bits & m) && !(sprite_halt_bits & m)) {
-            if (xpos == sprite_x_pipe[s]) {
-                sbuf_expx_flops |= m;
-                sbuf_mc_flops |= m;
-                sprite_active_bits |= m;
+        if ((candidate_bits & m) && (ds->sprite_pending_bits & m) && !(ds->sprite_active_bits & m) && !(ds->sprite_halt_bits & m)) {
+            if (xpos == ds->sprite_x_pipe[s]) {
+                ds->sbuf_expx_flops |= m;
+                ds->sbuf_mc_flops |= m;
+                ds->sprite_active_bits |= m;
             }
         }
     }
 }
 
-static DRAW_INLINE void draw_sprites(int i)
+static DRAW_INLINE void draw_sprites(draw_state_t *ds, const draw_input_t *in,
+                                     int i, int render, int collide)
 {
     int s;
     int active_sprite;
     uint8_t collision_mask;
 
     /* do nothing if all sprites are inactive */
-    if (!sprite_active_bits) {
+    if (!ds->sprite_active_bits) {
         return;
     }
 
@@ -360,40 +413,40 @@ static DRAW_INLINE void draw_sprites(int i)
     for (s = 7; s >= 0; --s) {
         uint8_t m = 1 << s;
 
-        if (sprite_active_bits & m) {
+        if (ds->sprite_active_bits & m) {
             /* render pixels if shift register or pixel reg still contains data */
-            if (sbuf_reg[s] || sbuf_pixel_reg[s]) {
-                if (!(sprite_halt_bits & m)) {
-                    if (sbuf_expx_flops & m) {
-                        if (sprite_mc_bits & m) {
-                            if (sbuf_mc_flops & m) {
+            if (ds->sbuf_reg[s] || ds->sbuf_pixel_reg[s]) {
+                if (!(ds->sprite_halt_bits & m)) {
+                    if (ds->sbuf_expx_flops & m) {
+                        if (ds->sprite_mc_bits & m) {
+                            if (ds->sbuf_mc_flops & m) {
                                 /* fetch 2 bits */
-                                sbuf_pixel_reg[s] = (uint8_t)((sbuf_reg[s] >> 22) & 0x03);
+                                ds->sbuf_pixel_reg[s] = (uint8_t)((ds->sbuf_reg[s] >> 22) & 0x03);
                             }
-                            sbuf_mc_flops ^= m;
+                            ds->sbuf_mc_flops ^= m;
 #if SPRITESPLITPATCH
-                        } else if ((sbuf_mc_flops & m) || vicii.color_latency) {
+                        } else if ((ds->sbuf_mc_flops & m) || (in->flags & DRAW_INPUT_COLOR_LATENCY)) {
                             /* fetch 1 bit and make it 0 or 2 */
-                            sbuf_pixel_reg[s] = (uint8_t)(((sbuf_reg[s] >> 23) & 0x01 ) << 1);
+                            ds->sbuf_pixel_reg[s] = (uint8_t)(((ds->sbuf_reg[s] >> 23) & 0x01 ) << 1);
                         } else {
-                            sbuf_mc_flops |= m;
+                            ds->sbuf_mc_flops |= m;
                         }
 #else
                         } else {
                             /* fetch 1 bit and make it 0 or 2 */
-                            sbuf_pixel_reg[s] = (uint8_t)(((sbuf_reg[s] >> 23) & 0x01 ) << 1);
+                            ds->sbuf_pixel_reg[s] = (uint8_t)(((ds->sbuf_reg[s] >> 23) & 0x01 ) << 1);
                         }
 #endif
                     }
 
                     /* shift the sprite buffer and handle expansion flags */
-                    if (sbuf_expx_flops & m) {
-                        sbuf_reg[s] <<= 1;
+                    if (ds->sbuf_expx_flops & m) {
+                        ds->sbuf_reg[s] <<= 1;
                     }
-                    if (sprite_expx_bits & m) {
-                        sbuf_expx_flops ^= m;
+                    if (ds->sprite_expx_bits & m) {
+                        ds->sbuf_expx_flops ^= m;
                     } else {
-                        sbuf_expx_flops |= m;
+                        ds->sbuf_expx_flops |= m;
                     }
                 }
 
@@ -401,88 +454,90 @@ static DRAW_INLINE void draw_sprites(int i)
                  * set collision mask bits and determine the highest
                  * priority sprite number that has a pixel.
                  */
-                if (sbuf_pixel_reg[s]) {
+                if (ds->sbuf_pixel_reg[s]) {
                     active_sprite = s;
                     collision_mask |= m;
                 }
             } else {
-                sprite_active_bits &= ~m;
+                ds->sprite_active_bits &= ~m;
             }
         }
     }
 
     if (collision_mask) {
-        uint8_t pixel_pri = pri_buffer[i];
+        uint8_t pixel_pri = ds->pri_buffer[i];
         int as = active_sprite;
-        uint8_t spri = sprite_pri_bits & (1 << as);
-        if (!(pixel_pri && spri)) {
-            switch (sbuf_pixel_reg[as]) {
+        uint8_t spri = ds->sprite_pri_bits & (1 << as);
+        if (render && !(pixel_pri && spri)) {
+            switch (ds->sbuf_pixel_reg[as]) {
                 case 1:
-                    render_buffer[i] = COL_D025;
+                    ds->render_buffer[i] = COL_D025;
                     break;
                 case 2:
-                    render_buffer[i] = COL_D027 + as;
+                    ds->render_buffer[i] = COL_D027 + as;
                     break;
                 case 3:
-                    render_buffer[i] = COL_D026;
+                    ds->render_buffer[i] = COL_D026;
                     break;
                 default:
                     break;
             }
         }
         /* if there was a foreground pixel, trigger collision */
-        if (pixel_pri) {
+        if (collide && pixel_pri) {
             vicii.sprite_background_collisions |= collision_mask;
         }
     }
 
     /* if 2 or more bits are set, trigger collisions */
-    if (collision_mask & (collision_mask - 1)) {
+    if (collide && (collision_mask & (collision_mask - 1))) {
         vicii.sprite_sprite_collisions |= collision_mask;
     }
 }
 
 
-static DRAW_INLINE void update_sprite_mc_bits_6569(void)
+static DRAW_INLINE void update_sprite_mc_bits_6569(draw_state_t *ds, const draw_input_t *in)
 {
-    uint8_t next_mc_bits = vicii.regs[0x1c];
-    uint8_t toggled = next_mc_bits ^ sprite_mc_bits;
+    uint8_t next_mc_bits = in->reg_1c;
+    uint8_t toggled = next_mc_bits ^ ds->sprite_mc_bits;
 
-    sbuf_mc_flops &= ~toggled;
-    sprite_mc_bits = next_mc_bits;
+    ds->sbuf_mc_flops &= ~toggled;
+    ds->sprite_mc_bits = next_mc_bits;
 }
 
-static DRAW_INLINE void update_sprite_mc_bits_8565(void)
+static DRAW_INLINE void update_sprite_mc_bits_8565(draw_state_t *ds, const draw_input_t *in)
 {
-    uint8_t next_mc_bits = vicii.regs[0x1c];
-    uint8_t toggled = next_mc_bits ^ sprite_mc_bits;
+    uint8_t next_mc_bits = in->reg_1c;
+    uint8_t toggled = next_mc_bits ^ ds->sprite_mc_bits;
 
-    sbuf_mc_flops ^= toggled & (~sbuf_expx_flops);
+    ds->sbuf_mc_flops ^= toggled & (~ds->sbuf_expx_flops);
 #if SPRITESPLITPATCH
-    sbuf_mc_flops |= toggled & (~sbuf_expx_flops) & (~next_mc_bits);
+    ds->sbuf_mc_flops |= toggled & (~ds->sbuf_expx_flops) & (~next_mc_bits);
 #endif
-    sprite_mc_bits = next_mc_bits;
+    ds->sprite_mc_bits = next_mc_bits;
 }
 
-static DRAW_INLINE void update_sprite_data(unsigned int cycle_flags)
+static DRAW_INLINE void update_sprite_data(draw_state_t *ds, const draw_input_t *in,
+                                           unsigned int cycle_flags)
 {
     if (cycle_is_sprite_dma1_dma2(cycle_flags)) {
         int s = cycle_get_sprite_num(cycle_flags);
-        sbuf_reg[s] = vicii.sprite[s].data;
+        ds->sbuf_reg[s] = in->sprite_data;
     }
 }
 
-static DRAW_INLINE void update_sprite_xpos(void)
+static DRAW_INLINE void update_sprite_xpos(draw_state_t *ds, const draw_input_t *in)
 {
     int s;
     for (s = 0; s < 8; s++) {
-        sprite_x_pipe[s] = vicii.sprite[s].x;
+        ds->sprite_x_pipe[s] = in->sprite_x[s];
     }
 }
 
 
 
-static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
+static DRAW_INLINE void draw_sprites8(draw_state_t *ds, const draw_input_t *in,
+                                      unsigned int cycle_flags, int render, int collide)
 {
     uint8_t candidate_bits;
     uint8_t dma_cycle_0 = 0;
@@ -500,51 +555,51 @@ static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
     if (cycle_is_sprite_dma1_dma2(cycle_flags)) {
         dma_cycle_2 = 1 << cycle_get_sprite_num(cycle_flags);
     }
-    candidate_bits = get_trigger_candidates(xpos);
+    candidate_bits = get_trigger_candidates(ds, xpos);
 
     /* process and render sprites */
     /* pixel 0 */
-    trigger_sprites(xpos + 0, candidate_bits);
-    draw_sprites(0);
+    trigger_sprites(ds, xpos + 0, candidate_bits);
+    draw_sprites(ds, in, 0, render, collide);
     /* pixel 1 */
-    trigger_sprites(xpos + 1, candidate_bits);
-    draw_sprites(1);
+    trigger_sprites(ds, xpos + 1, candidate_bits);
+    draw_sprites(ds, in, 1, render, collide);
     /* pixel 2 */
-    sprite_active_bits &= ~dma_cycle_2;
-    trigger_sprites(xpos + 2, candidate_bits);
-    draw_sprites(2);
+    ds->sprite_active_bits &= ~dma_cycle_2;
+    trigger_sprites(ds, xpos + 2, candidate_bits);
+    draw_sprites(ds, in, 2, render, collide);
     /* pixel 3 */
-    sprite_halt_bits |= dma_cycle_0;
-    trigger_sprites(xpos + 3, candidate_bits);
-    draw_sprites(3);
+    ds->sprite_halt_bits |= dma_cycle_0;
+    trigger_sprites(ds, xpos + 3, candidate_bits);
+    draw_sprites(ds, in, 3, render, collide);
     /* pixel 4 */
     if (spr_en) {
-        sprite_pending_bits = vicii.sprite_display_bits;
+        ds->sprite_pending_bits = in->sprite_display_bits;
     }
-    update_sprite_data(cycle_flags);
-    trigger_sprites(xpos + 4, candidate_bits);
-    draw_sprites(4);
+    update_sprite_data(ds, in, cycle_flags);
+    trigger_sprites(ds, xpos + 4, candidate_bits);
+    draw_sprites(ds, in, 4, render, collide);
     /* pixel 5 */
-    trigger_sprites(xpos + 5, candidate_bits);
-    draw_sprites(5);
+    trigger_sprites(ds, xpos + 5, candidate_bits);
+    draw_sprites(ds, in, 5, render, collide);
     /* pixel 6 */
-    if (!vicii.color_latency) {
-        update_sprite_mc_bits_8565();
+    if (!(in->flags & DRAW_INPUT_COLOR_LATENCY)) {
+        update_sprite_mc_bits_8565(ds, in);
     }
-    sprite_pri_bits = vicii.regs[0x1b];
-    sprite_expx_bits = vicii.regs[0x1d];
-    trigger_sprites(xpos + 6, candidate_bits);
-    draw_sprites(6);
+    ds->sprite_pri_bits = in->reg_1b;
+    ds->sprite_expx_bits = in->reg_1d;
+    trigger_sprites(ds, xpos + 6, candidate_bits);
+    draw_sprites(ds, in, 6, render, collide);
     /* pixel 7 */
-    if (vicii.color_latency) {
-        update_sprite_mc_bits_6569();
+    if (in->flags & DRAW_INPUT_COLOR_LATENCY) {
+        update_sprite_mc_bits_6569(ds, in);
     }
-    sprite_halt_bits &= ~dma_cycle_2;
-    trigger_sprites(xpos + 7, candidate_bits);
-    draw_sprites(7);
+    ds->sprite_halt_bits &= ~dma_cycle_2;
+    trigger_sprites(ds, xpos + 7, candidate_bits);
+    draw_sprites(ds, in, 7, render, collide);
 
     /* pipe xpos */
-    update_sprite_xpos();
+    update_sprite_xpos(ds, in);
 }
 
 
@@ -554,18 +609,25 @@ static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
  *
  ******/
 
-static DRAW_INLINE void draw_border8(void)
+static DRAW_INLINE void draw_border8(draw_state_t *ds, const draw_input_t *in, int render)
 {
-    uint8_t csel = vicii.regs[0x16] & 0x8;
+    uint8_t csel = in->reg_16 & 0x8;
+    int main_border = (in->flags & DRAW_INPUT_MAIN_BORDER) ? 1 : 0;
+
+    /* the border only covers pixels, all cases below end up here */
+    if (!render) {
+        ds->border_state = main_border;
+        return;
+    }
 
 #if 1
     /* early exit for the no border case */
-    if (!(border_state || vicii.main_border)) {
+    if (!(ds->border_state || main_border)) {
         return;
     }
     /* early exit for the continuous border case */
-    if (border_state && vicii.main_border) {
-        memset(render_buffer, COL_D020, 8);
+    if (ds->border_state && main_border) {
+        memset(ds->render_buffer, COL_D020, 8);
         return;
     }
 #endif
@@ -575,17 +637,17 @@ static DRAW_INLINE void draw_border8(void)
      * (the code below can handle all border logic)
      */
     if (csel) {
-        if (border_state) {
-            memset(render_buffer, COL_D020, 8);
+        if (ds->border_state) {
+            memset(ds->render_buffer, COL_D020, 8);
         }
-        border_state = vicii.main_border;
+        ds->border_state = main_border;
     } else {
-        if (border_state) {
-            memset(render_buffer, COL_D020, 7);
+        if (ds->border_state) {
+            memset(ds->render_buffer, COL_D020, 7);
         }
-        border_state = vicii.main_border;
-        if (border_state) {
-            render_buffer[7] = COL_D020;
+        ds->border_state = main_border;
+        if (ds->border_state) {
+            ds->render_buffer[7] = COL_D020;
         }
     }
 }
@@ -598,28 +660,27 @@ static DRAW_INLINE void draw_border8(void)
  ******/
 
 /* used by draw_colors8() */
-static DRAW_INLINE void update_cregs(void)
+static DRAW_INLINE void update_cregs(draw_state_t *ds, const draw_input_t *in)
 {
-    last_color_reg = vicii.last_color_reg;
-    last_color_value = vicii.last_color_value;
-    vicii.last_color_reg = 0xff;
+    ds->last_color_reg = in->last_color_reg;
+    ds->last_color_value = in->last_color_value;
 }
 
-static DRAW_INLINE void draw_colors_6569(int offs, int i)
+static DRAW_INLINE void draw_colors_6569(draw_state_t *ds, int offs, int i)
 {
     int lookup_index;
 
     /* resolve any unresolved colors */
     lookup_index = (i + 1) & 0x07;
-    pixel_buffer[lookup_index] = cregs[pixel_buffer[lookup_index]];
+    ds->pixel_buffer[lookup_index] = ds->cregs[ds->pixel_buffer[lookup_index]];
 
     /* draw pixel to buffer */
-    vicii.dbuf[offs + i] = pixel_buffer[i];
+    ds->dbuf[offs + i] = ds->pixel_buffer[i];
 
-    pixel_buffer[i] = render_buffer[i];
+    ds->pixel_buffer[i] = ds->render_buffer[i];
 }
 
-static DRAW_INLINE void draw_colors_8565(int offs, int i)
+static DRAW_INLINE void draw_colors_8565(draw_state_t *ds, int offs, int i)
 {
     int lookup_index;
 
@@ -627,21 +688,21 @@ static DRAW_INLINE void draw_colors_8565(int offs, int i)
     /* resolve any unresolved colors */
 
     /* special case for grey dot handling */
-    if (i == 0 && pixel_buffer[lookup_index] == last_color_reg) {
-        pixel_buffer[lookup_index] = 0x0f;
+    if (i == 0 && ds->pixel_buffer[lookup_index] == ds->last_color_reg) {
+        ds->pixel_buffer[lookup_index] = 0x0f;
     } else {
-        pixel_buffer[lookup_index] = cregs[pixel_buffer[lookup_index]];
+        ds->pixel_buffer[lookup_index] = ds->cregs[ds->pixel_buffer[lookup_index]];
     }
 
     /* draw pixel to buffer */
-    vicii.dbuf[offs + i] = pixel_buffer[i];
+    ds->dbuf[offs + i] = ds->pixel_buffer[i];
 
-    pixel_buffer[i] = render_buffer[i];
+    ds->pixel_buffer[i] = ds->render_buffer[i];
 }
 
-static DRAW_INLINE void draw_colors8(void)
+static DRAW_INLINE void draw_colors8(draw_state_t *ds, const draw_input_t *in, int render)
 {
-    int offs = vicii.dbuf_offset;
+    int offs = *ds->dbuf_offset;
 
     /* guard (could possibly be removed) */
     if (offs > VICII_DRAW_BUFFER_SIZE - 8) {
@@ -649,58 +710,458 @@ static DRAW_INLINE void draw_colors8(void)
     }
 
     /* update color register (if written) */
-    if (last_color_reg != 0xff) {
-        cregs[last_color_reg] = last_color_value;
+    if (ds->last_color_reg != 0xff) {
+        ds->cregs[ds->last_color_reg] = ds->last_color_value;
     }
 
     /* render pixels */
-    if (vicii.color_latency) {
-        draw_colors_6569(offs, 0);
-        draw_colors_6569(offs, 1);
-        draw_colors_6569(offs, 2);
-        draw_colors_6569(offs, 3);
-        draw_colors_6569(offs, 4);
-        draw_colors_6569(offs, 5);
-        draw_colors_6569(offs, 6);
-        draw_colors_6569(offs, 7);
+    if (!render) {
+        /* nothing to resolve, the color registers are kept up to date */
+    } else if (in->flags & DRAW_INPUT_COLOR_LATENCY) {
+        draw_colors_6569(ds, offs, 0);
+        draw_colors_6569(ds, offs, 1);
+        draw_colors_6569(ds, offs, 2);
+        draw_colors_6569(ds, offs, 3);
+        draw_colors_6569(ds, offs, 4);
+        draw_colors_6569(ds, offs, 5);
+        draw_colors_6569(ds, offs, 6);
+        draw_colors_6569(ds, offs, 7);
     } else {
-        draw_colors_8565(offs, 0);
-        draw_colors_8565(offs, 1);
-        draw_colors_8565(offs, 2);
-        draw_colors_8565(offs, 3);
-        draw_colors_8565(offs, 4);
-        draw_colors_8565(offs, 5);
-        draw_colors_8565(offs, 6);
-        draw_colors_8565(offs, 7);
+        draw_colors_8565(ds, offs, 0);
+        draw_colors_8565(ds, offs, 1);
+        draw_colors_8565(ds, offs, 2);
+        draw_colors_8565(ds, offs, 3);
+        draw_colors_8565(ds, offs, 4);
+        draw_colors_8565(ds, offs, 5);
+        draw_colors_8565(ds, offs, 6);
+        draw_colors_8565(ds, offs, 7);
     }
-    vicii.dbuf_offset += 8;
+    *ds->dbuf_offset += 8;
 
-    update_cregs();
+    update_cregs(ds, in);
 }
 
 
 /**************************************************************************
  *
- * SECTION  vicii_draw_cycle()
+ * SECTION  draw_cycle()
  *
  ******/
 
-void vicii_draw_cycle(void)
+static DRAW_INLINE void draw_cycle(draw_state_t *ds, const draw_input_t *in,
+                                   int render, int collide)
 {
     /* reset rendering on raster cycle 1 */
+    if (in->flags & DRAW_INPUT_NEW_LINE) {
+        *ds->dbuf_offset = 0;
+    }
+
+    draw_graphics8(ds, in, ds->cycle_flags_pipe, render);
+
+    draw_sprites8(ds, in, ds->cycle_flags_pipe, render, collide);
+
+    draw_border8(ds, in, render);
+
+    draw_colors8(ds, in, render);
+
+    ds->cycle_flags_pipe = in->cycle_flags;
+}
+
+/* gather the inputs of the cycle for draw_state */
+static DRAW_INLINE void read_inputs(draw_input_t *in)
+{
+    unsigned int cycle_flags = draw_state.cycle_flags_pipe;
+    uint8_t flags = 0;
+    int s;
+
     if (vicii.raster_cycle == 1) {
-        vicii.dbuf_offset = 0;
+        flags |= DRAW_INPUT_NEW_LINE;
+    }
+    if (vicii.color_latency) {
+        flags |= DRAW_INPUT_COLOR_LATENCY;
+    }
+    if (vicii.vborder) {
+        flags |= DRAW_INPUT_VBORDER;
+    }
+    if (vicii.idle_state) {
+        flags |= DRAW_INPUT_IDLE_STATE;
+    }
+    if (vicii.main_border) {
+        flags |= DRAW_INPUT_MAIN_BORDER;
     }
+    in->flags = flags;
+    in->cycle_flags = vicii.cycle_flags;
+
+    in->reg_11 = vicii.regs[0x11];
+    in->reg_16 = vicii.regs[0x16];
+    in->reg_1b = vicii.regs[0x1b];
+    in->reg_1c = vicii.regs[0x1c];
+    in->reg_1d = vicii.regs[0x1d];
+
+    /* same conditions as in draw_graphics8(), dmli is only valid then */
+    in->gbuf = vicii.gbuf;
+    if (cycle_is_visible(cycle_flags) && !vicii.vborder && !vicii.idle_state) {
+        in->vbuf = vicii.vbuf[draw_state.dmli];
+        in->cbuf = vicii.cbuf[draw_state.dmli];
+    } else {
+        in->vbuf = 0;
+        in->cbuf = 0;
+    }
+
+    if (cycle_is_sprite_dma1_dma2(cycle_flags)) {
+        in->sprite_data = vicii.sprite[cycle_get_sprite_num(cycle_flags)].data;
+    } else {
+        in->sprite_data = 0;
+    }
+    for (s = 0; s < 8; s++) {
+        in->sprite_x[s] = (uint16_t)vicii.sprite[s].x;
+    }
+    in->sprite_display_bits = vicii.sprite_display_bits;
+
+    in->last_color_reg = vicii.last_color_reg;
+    in->last_color_value = vicii.last_color_value;
+}
+
+
+/**************************************************************************
+ *
+ * SECTION  deferred rendering
+ *
+ ******/
+
+/*
+ * With the render thread enabled (resource "VICIIRenderThread"), the
+ * emulation thread runs the pipeline without rendering, which keeps the
+ * collisions exact, and logs the inputs of every cycle into slots of a
+ * ring buffer. A slot holds the cycles of about one raster line, followed
+ * by the copy of the line to the frame buffer that the raster requested
+ * (see vicii-draw.c). The render thread replays the slots on its own
+ * pipeline state, one or more lines behind, and vicii_draw_cycle_sync()
+ * waits for it before the frame buffer is read.
+ *
+ * The render thread's state is copied from the emulation thread's state
+ * whenever the two may differ: when the render thread is switched on,
+ * after frames that were not drawn, after loading a snapshot and after
+ * the monitor changed a color register.
+ *
+ * Builds without thread support (USE_VICE_THREAD) always render on the
+ * emulation thread and ignore the resource.
+ */
+
+/* a slot is committed when the line is copied, or when it is full */
+#define RENDER_SLOT_CYCLES  72
+
+/* number of slots in the ring buffer, about a fifth of a frame */
+#define RENDER_NUM_SLOTS    64
+
+/* committed slots before the waiting render thread is woken up, so that it
+   does not have to be scheduled for every line */
+#define RENDER_WAKE_SLOTS   16
+
+typedef struct render_slot_s {
+    unsigned int num_cycles;
+    draw_input_t cycles[RENDER_SLOT_CYCLES];
+
+    /* copy of the line after the cycles, dest is NULL for no copy */
+    uint8_t *copy_dest;
+    unsigned int copy_offset;
+    unsigned int copy_length;
+} render_slot_t;
 
-    draw_graphics8(cycle_flags_pipe);
+/* the pipeline run on the render thread */
+static draw_state_t render_state;
+static uint8_t render_dbuf[VICII_DRAW_BUFFER_SIZE];
+static int render_dbuf_offset = 0;
 
-    draw_sprites8(cycle_flags_pipe);
+/* render_state was copied from draw_state and has seen all inputs since */
+static int render_state_valid = 0;
 
-    draw_border8();
+/* inputs go to the render thread */
+static int render_thread_active = 0;
 
-    draw_colors8();
+#ifdef USE_VICE_THREAD
+/* set by the resource, applied at the start of the next line */
+static int render_thread_enabled = 0;
 
-    cycle_flags_pipe = vicii.cycle_flags;
+static int render_thread_running = 0;
+static pthread_t render_thread;
+static pthread_mutex_t render_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t render_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t render_done_cond = PTHREAD_COND_INITIALIZER;
+
+/* ring buffer, slots from render_tail up to render_head are committed */
+static render_slot_t *render_slots = NULL;
+static unsigned int render_head = 0;
+static unsigned int render_tail = 0;
+static int render_waiting = 0;
+static int render_quit = 0;
+
+/* slot being filled by the emulation thread */
+static render_slot_t *render_slot = NULL;
+
+static void render_slot_play(render_slot_t *slot)
+{
+    unsigned int i;
+
+    for (i = 0; i < slot->num_cycles; i++) {
+        draw_cycle(&render_state, &slot->cycles[i], 1, 0);
+    }
+
+    if (slot->copy_dest != NULL) {
+        memcpy(slot->copy_dest, render_dbuf + slot->copy_offset, slot->copy_length);
+    }
+}
+
+static void *render_thread_main(void *unused)
+{
+    render_slot_t *slot;
+
+    pthread_mutex_lock(&render_lock);
+    while (1) {
+        while (render_tail == render_head && !render_quit) {
+            render_waiting = 1;
+            pthread_cond_wait(&render_work_cond, &render_lock);
+            render_waiting = 0;
+        }
+        if (render_quit) {
+            break;
+        }
+        slot = &render_slots[render_tail % RENDER_NUM_SLOTS];
+        pthread_mutex_unlock(&render_lock);
+
+        render_slot_play(slot);
+
+        pthread_mutex_lock(&render_lock);
+        render_tail++;
+        pthread_cond_signal(&render_done_cond);
+    }
+    pthread_mutex_unlock(&render_lock);
+
+    return NULL;
+}
+
+/* hand the current slot to the render thread and start the next one */
+static void render_commit(int wake)
+{
+    pthread_mutex_lock(&render_lock);
+    render_head++;
+    if (render_waiting && (wake || render_head - render_tail >= RENDER_WAKE_SLOTS)) {
+        pthread_cond_signal(&render_work_cond);
+    }
+    while (render_head - render_tail >= RENDER_NUM_SLOTS) {
+        pthread_cond_wait(&render_done_cond, &render_lock);
+    }
+    pthread_mutex_unlock(&render_lock);
+
+    render_slot = &render_slots[render_head % RENDER_NUM_SLOTS];
+    render_slot->num_cycles = 0;
+    render_slot->copy_dest = NULL;
+}
+
+/* commit the current slot and wait until the render thread has played it */
+static void render_wait(void)
+{
+    if (render_slot->num_cycles > 0) {
+        render_commit(1);
+    }
+
+    pthread_mutex_lock(&render_lock);
+    if (render_waiting && render_tail != render_head) {
+        pthread_cond_signal(&render_work_cond);
+    }
+    while (render_tail != render_head) {
+        pthread_cond_wait(&render_done_cond, &render_lock);
+    }
+    pthread_mutex_unlock(&render_lock);
+}
+
+static void copy_state(draw_state_t *dest, const draw_state_t *src)
+{
+    uint8_t *dbuf = dest->dbuf;
+    int *dbuf_offset = dest->dbuf_offset;
+
+    *dest = *src;
+    dest->dbuf = dbuf;
+    dest->dbuf_offset = dbuf_offset;
+
+    memcpy(dbuf, src->dbuf, VICII_DRAW_BUFFER_SIZE);
+    *dbuf_offset = *src->dbuf_offset;
+}
+
+static int render_thread_start(void)
+{
+    if (render_thread_running) {
+        return 0;
+    }
+
+    render_slots = lib_calloc(RENDER_NUM_SLOTS, sizeof(render_slot_t));
+    render_head = 0;
+    render_tail = 0;
+    render_quit = 0;
+    render_slot = &render_slots[0];
+
+    if (pthread_create(&render_thread, NULL, render_thread_main, NULL) != 0) {
+        log_error(vicii.log, "Cannot start the render thread, rendering on the emulation thread.");
+        lib_free(render_slots);
+        render_slots = NULL;
+        return -1;
+    }
+    render_thread_running = 1;
+
+    return 0;
+}
+
+/* switch the render thread on or off, at the start of a line */
+static void render_thread_switch(void)
+{
+    if (render_thread_enabled) {
+        if (render_thread_start() < 0) {
+            render_thread_enabled = 0;
+            return;
+        }
+        render_state_valid = 0;
+        render_thread_active = 1;
+    } else {
+        /* the render thread's state has seen the pixels, take it over */
+        render_wait();
+        if (render_state_valid) {
+            copy_state(&draw_state, &render_state);
+        }
+        render_thread_active = 0;
+    }
+}
+
+/* get the slot entry for the inputs of the current cycle */
+static inline draw_input_t *render_next_input(void)
+{
+    if (!render_state_valid) {
+        render_wait();
+        copy_state(&render_state, &draw_state);
+        render_state_valid = 1;
+    } else if (render_slot->num_cycles == RENDER_SLOT_CYCLES) {
+        render_commit(0);
+    }
+
+    return &render_slot->cycles[render_slot->num_cycles++];
+}
+
+void vicii_draw_cycle_set_render_thread(int enable)
+{
+    render_thread_enabled = enable ? 1 : 0;
+}
+
+int vicii_draw_cycle_queue_copy(uint8_t *dest, unsigned int offset, unsigned int length)
+{
+    if (!render_thread_active) {
+        return 0;
+    }
+
+    render_slot->copy_dest = dest;
+    render_slot->copy_offset = offset;
+    render_slot->copy_length = length;
+    render_commit(0);
+
+    return 1;
+}
+
+void vicii_draw_cycle_sync(void)
+{
+    if (!render_thread_active) {
+        return;
+    }
+
+    render_wait();
+
+    /* keep the draw buffer of the chip up to date, for snapshots */
+    if (render_state_valid) {
+        memcpy(vicii.dbuf, render_dbuf, VICII_DRAW_BUFFER_SIZE);
+    }
+}
+
+void vicii_draw_cycle_shutdown(void)
+{
+    if (!render_thread_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&render_lock);
+    render_quit = 1;
+    pthread_cond_signal(&render_work_cond);
+    pthread_mutex_unlock(&render_lock);
+    pthread_join(render_thread, NULL);
+
+    lib_free(render_slots);
+    render_slots = NULL;
+    render_slot = NULL;
+    render_thread_running = 0;
+    render_thread_active = 0;
+}
+
+#else /* USE_VICE_THREAD */
+
+void vicii_draw_cycle_set_render_thread(int enable)
+{
+}
+
+int vicii_draw_cycle_queue_copy(uint8_t *dest, unsigned int offset, unsigned int length)
+{
+    return 0;
+}
+
+void vicii_draw_cycle_sync(void)
+{
+}
+
+void vicii_draw_cycle_shutdown(void)
+{
+}
+
+#endif /* USE_VICE_THREAD */
+
+
+/**************************************************************************
+ *
+ * SECTION  vicii_draw_cycle()
+ *
+ ******/
+
+void vicii_draw_cycle(void)
+{
+    draw_input_t input;
+
+#ifdef USE_VICE_THREAD
+    if (vicii.raster_cycle == 1 && render_thread_enabled != render_thread_active) {
+        render_thread_switch();
+    }
+#endif
+
+    /* separate instances, so that the 'render' checks are resolved at compile time */
+    if (vicii.raster.skip_drawing) {
+        read_inputs(&input);
+        draw_cycle(&draw_state, &input, 0, 1);
+        render_state_valid = 0;
+#ifdef USE_VICE_THREAD
+    } else if (render_thread_active) {
+        draw_input_t *in = render_next_input();
+
+        read_inputs(in);
+        draw_cycle(&draw_state, in, 0, 1);
+#endif
+    } else {
+        read_inputs(&input);
+        draw_cycle(&draw_state, &input, 1, 1);
+    }
+
+    vicii.last_color_reg = 0xff;
+}
+
+void vicii_monitor_colreg_store(int reg, int value)
+{
+    draw_state.cregs[reg] = value;
+    draw_state.last_color_reg = reg;
+    draw_state.last_color_value = value;
+
+    render_state_valid = 0;
 }
 
 
@@ -708,22 +1169,29 @@ void vicii_draw_cycle_init(void)
 {
     int i;
 
+    draw_state.dbuf = vicii.dbuf;
+    draw_state.dbuf_offset = &vicii.dbuf_offset;
+    render_state.dbuf = render_dbuf;
+    render_state.dbuf_offset = &render_dbuf_offset;
+
     /* initialize the draw buffer */
     memset(vicii.dbuf, 0, VICII_DRAW_BUFFER_SIZE);
     vicii.dbuf_offset = 0;
 
     /* initialize the pixel ring buffer. */
-    memset(pixel_buffer, 0, sizeof(pixel_buffer));
+    memset(draw_state.pixel_buffer, 0, sizeof(draw_state.pixel_buffer));
 
     /* clear cregs and fill 0x00-0x0f with 1:1 mapping */
-    memset(cregs, 0, sizeof(cregs));
+    memset(draw_state.cregs, 0, sizeof(draw_state.cregs));
     for (i = 0; i < 0x10; i++) {
-        cregs[i] = i;
+        draw_state.cregs[i] = i;
     }
     vicii.last_color_reg = 0xff;
-    last_color_reg = 0xff;
+    draw_state.last_color_reg = 0xff;
+
+    draw_state.cycle_flags_pipe = 0;
 
-    cycle_flags_pipe = 0;
+    render_state_valid = 0;
 }
 
 
@@ -737,62 +1205,69 @@ void vicii_draw_cycle_init(void)
 
 int vicii_draw_cycle_snapshot_write(snapshot_module_t *m)
 {
+    draw_state_t *ds = &draw_state;
     int i;
 
+    /* the render thread's state also has the pixels, the caller has
+       already waited for it with vicii_draw_cycle_sync() */
+    if (render_thread_active && render_state_valid) {
+        ds = &render_state;
+    }
+
     if (0
-        || SMW_B(m, gbuf_pipe0_reg) < 0
-        || SMW_B(m, cbuf_pipe0_reg) < 0
-        || SMW_B(m, vbuf_pipe0_reg) < 0
-        || SMW_B(m, gbuf_pipe1_reg) < 0
-        || SMW_B(m, cbuf_pipe1_reg) < 0
-        || SMW_B(m, vbuf_pipe1_reg) < 0
-        || SMW_B(m, xscroll_pipe) < 0
-        || SMW_B(m, vmode11_pipe) < 0
-        || SMW_B(m, vmode16_pipe) < 0
-        || SMW_B(m, vmode16_pipe2) < 0
-        || SMW_B(m, gbuf_reg) < 0
-        || SMW_B(m, gbuf_mc_flop) < 0
-        || SMW_B(m, gbuf_pixel_reg) < 0
-        || SMW_B(m, cbuf_reg) < 0
-        || SMW_B(m, vbuf_reg) < 0
-        || SMW_B(m, dmli) < 0) {
+        || SMW_B(m, ds->gbuf_pipe0_reg) < 0
+        || SMW_B(m, ds->cbuf_pipe0_reg) < 0
+        || SMW_B(m, ds->vbuf_pipe0_reg) < 0
+        || SMW_B(m, ds->gbuf_pipe1_reg) < 0
+        || SMW_B(m, ds->cbuf_pipe1_reg) < 0
+        || SMW_B(m, ds->vbuf_pipe1_reg) < 0
+        || SMW_B(m, ds->xscroll_pipe) < 0
+        || SMW_B(m, ds->vmode11_pipe) < 0
+        || SMW_B(m, ds->vmode16_pipe) < 0
+        || SMW_B(m, ds->vmode16_pipe2) < 0
+        || SMW_B(m, ds->gbuf_reg) < 0
+        || SMW_B(m, ds->gbuf_mc_flop) < 0
+        || SMW_B(m, ds->gbuf_pixel_reg) < 0
+        || SMW_B(m, ds->cbuf_reg) < 0
+        || SMW_B(m, ds->vbuf_reg) < 0
+        || SMW_B(m, ds->dmli) < 0) {
         return -1;
     }
 
     for (i = 0; i < 8; i++) {
-        if (SMW_DW(m, (uint32_t)sprite_x_pipe[i]) < 0) {
+        if (SMW_DW(m, (uint32_t)ds->sprite_x_pipe[i]) < 0) {
             return -1;
         }
     }
 
     if (0
-        || SMW_B(m, sprite_pri_bits) < 0
-        || SMW_B(m, sprite_mc_bits) < 0
-        || SMW_B(m, sprite_expx_bits) < 0
-        || SMW_B(m, sprite_pending_bits) < 0
-        || SMW_B(m, sprite_active_bits) < 0
-        || SMW_B(m, sprite_halt_bits) < 0) {
+        || SMW_B(m, ds->sprite_pri_bits) < 0
+        || SMW_B(m, ds->sprite_mc_bits) < 0
+        || SMW_B(m, ds->sprite_expx_bits) < 0
+        || SMW_B(m, ds->sprite_pending_bits) < 0
+        || SMW_B(m, ds->sprite_active_bits) < 0
+        || SMW_B(m, ds->sprite_halt_bits) < 0) {
         return -1;
     }
 
     for (i = 0; i < 8; i++) {
-        if (SMW_DW(m, sbuf_reg[i]) < 0) {
+        if (SMW_DW(m, ds->sbuf_reg[i]) < 0) {
             return -1;
         }
     }
 
     if (0
-        || SMW_BA(m, sbuf_pixel_reg, 8) < 0
-        || SMW_B(m, sbuf_expx_flops) < 0
-        || SMW_B(m, sbuf_mc_flops) < 0
-        || SMW_B(m, (uint8_t)border_state) < 0
-        || SMW_BA(m, render_buffer, 8) < 0
-        || SMW_BA(m, pri_buffer, 8) < 0
-        || SMW_BA(m, pixel_buffer, 8) < 0
-        || SMW_BA(m, cregs, 0x2f) < 0
-        || SMW_B(m, last_color_reg) < 0
-        || SMW_B(m, last_color_value) < 0
-        || SMW_DW(m, (uint32_t)cycle_flags_pipe) < 0) {
+        || SMW_BA(m, ds->sbuf_pixel_reg, 8) < 0
+        || SMW_B(m, ds->sbuf_expx_flops) < 0
+        || SMW_B(m, ds->sbuf_mc_flops) < 0
+        || SMW_B(m, (uint8_t)ds->border_state) < 0
+        || SMW_BA(m, ds->render_buffer, 8) < 0
+        || SMW_BA(m, ds->pri_buffer, 8) < 0
+        || SMW_BA(m, ds->pixel_buffer, 8) < 0
+        || SMW_BA(m, ds->cregs, 0x2f) < 0
+        || SMW_B(m, ds->last_color_reg) < 0
+        || SMW_B(m, ds->last_color_value) < 0
+        || SMW_DW(m, (uint32_t)ds->cycle_flags_pipe) < 0) {
         return -1;
     }
 
@@ -801,62 +1276,65 @@ int vicii_draw_cycle_snapshot_write(snapshot_module_t *m)
 
 int vicii_draw_cycle_snapshot_read(snapshot_module_t *m)
 {
+    draw_state_t *ds = &draw_state;
     int i;
 
+    render_state_valid = 0;
+
     if (0
-        || SMR_B(m, &gbuf_pipe0_reg) < 0
-        || SMR_B(m, &cbuf_pipe0_reg) < 0
-        || SMR_B(m, &vbuf_pipe0_reg) < 0
-        || SMR_B(m, &gbuf_pipe1_reg) < 0
-        || SMR_B(m, &cbuf_pipe1_reg) < 0
-        || SMR_B(m, &vbuf_pipe1_reg) < 0
-        || SMR_B(m, &xscroll_pipe) < 0
-        || SMR_B(m, &vmode11_pipe) < 0
-        || SMR_B(m, &vmode16_pipe) < 0
-        || SMR_B(m, &vmode16_pipe2) < 0
-        || SMR_B(m, &gbuf_reg) < 0
-        || SMR_B(m, &gbuf_mc_flop) < 0
-        || SMR_B(m, &gbuf_pixel_reg) < 0
-        || SMR_B(m, &cbuf_reg) < 0
-        || SMR_B(m, &vbuf_reg) < 0
-        || SMR_B(m, &dmli) < 0) {
+        || SMR_B(m, &ds->gbuf_pipe0_reg) < 0
+        || SMR_B(m, &ds->cbuf_pipe0_reg) < 0
+        || SMR_B(m, &ds->vbuf_pipe0_reg) < 0
+        || SMR_B(m, &ds->gbuf_pipe1_reg) < 0
+        || SMR_B(m, &ds->cbuf_pipe1_reg) < 0
+        || SMR_B(m, &ds->vbuf_pipe1_reg) < 0
+        || SMR_B(m, &ds->xscroll_pipe) < 0
+        || SMR_B(m, &ds->vmode11_pipe) < 0
+        || SMR_B(m, &ds->vmode16_pipe) < 0
+        || SMR_B(m, &ds->vmode16_pipe2) < 0
+        || SMR_B(m, &ds->gbuf_reg) < 0
+        || SMR_B(m, &ds->gbuf_mc_flop) < 0
+        || SMR_B(m, &ds->gbuf_pixel_reg) < 0
+        || SMR_B(m, &ds->cbuf_reg) < 0
+        || SMR_B(m, &ds->vbuf_reg) < 0
+        || SMR_B(m, &ds->dmli) < 0) {
         return -1;
     }
 
     for (i = 0; i < 8; i++) {
-        if (SMR_DW_INT(m, &sprite_x_pipe[i]) < 0) {
+        if (SMR_DW_INT(m, &ds->sprite_x_pipe[i]) < 0) {
             return -1;
         }
     }
 
     if (0
-        || SMR_B(m, &sprite_pri_bits) < 0
-        || SMR_B(m, &sprite_mc_bits) < 0
-        || SMR_B(m, &sprite_expx_bits) < 0
-        || SMR_B(m, &sprite_pending_bits) < 0
-        || SMR_B(m, &sprite_active_bits) < 0
-        || SMR_B(m, &sprite_halt_bits) < 0) {
+        || SMR_B(m, &ds->sprite_pri_bits) < 0
+        || SMR_B(m, &ds->sprite_mc_bits) < 0
+        || SMR_B(m, &ds->sprite_expx_bits) < 0
+        || SMR_B(m, &ds->sprite_pending_bits) < 0
+        || SMR_B(m, &ds->sprite_active_bits) < 0
+        || SMR_B(m, &ds->sprite_halt_bits) < 0) {
         return -1;
     }
 
     for (i = 0; i < 8; i++) {
-        if (SMR_DW(m, &sbuf_reg[i]) < 0) {
+        if (SMR_DW(m, &ds->sbuf_reg[i]) < 0) {
             return -1;
         }
     }
 
     if (0
-        || SMR_BA(m, sbuf_pixel_reg, 8) < 0
-        || SMR_B(m, &sbuf_expx_flops) < 0
-        || SMR_B(m, &sbuf_mc_flops) < 0
-        || SMR_B_INT(m, &border_state) < 0
-        || SMR_BA(m, render_buffer, 8) < 0
-        || SMR_BA(m, pri_buffer, 8) < 0
-        || SMR_BA(m, pixel_buffer, 8) < 0
-        || SMR_BA(m, cregs, 0x2f) < 0
-        || SMR_B(m, &last_color_reg) < 0
-        || SMR_B(m, &last_color_value) < 0
-        || SMR_DW_UINT(m, &cycle_flags_pipe) < 0) {
+        || SMR_BA(m, ds->sbuf_pixel_reg, 8) < 0
+        || SMR_B(m, &ds->sbuf_expx_flops) < 0
+        || SMR_B(m, &ds->sbuf_mc_flops) < 0
+        || SMR_B_INT(m, &ds->border_state) < 0
+        || SMR_BA(m, ds->render_buffer, 8) < 0
+        || SMR_BA(m, ds->pri_buffer, 8) < 0
+        || SMR_BA(m, ds->pixel_buffer, 8) < 0
+        || SMR_BA(m, ds->cregs, 0x2f) < 0
+        || SMR_B(m, &ds->last_color_reg) < 0
+        || SMR_B(m, &ds->last_color_value) < 0
+        || SMR_DW_UINT(m, &ds->cycle_flags_pipe) < 0) {
         return -1;
     }
 
@@ -27,8 +27,15 @@
 #ifndef VICE_VICII_DRAW_CYCLE_H
 #define VICE_VICII_DRAW_CYCLE_H
 
+#include "types.h"
+
 void vicii_draw_cycle(void);
 void vicii_draw_cycle_init(void);
+void vicii_draw_cycle_shutdown(void);
+
+void vicii_draw_cycle_set_render_thread(int enable);
+int vicii_draw_cycle_queue_copy(uint8_t *dest, unsigned int offset, unsigned int length);
+void vicii_draw_cycle_sync(void);
 
 void vicii_monitor_colreg_store(int reg, int value);
 
@@ -33,6 +33,7 @@
 #include "raster-modes.h"
 #include "raster.h"
 #include "types.h"
+#include "vicii-draw-cycle.h"
 #include "vicii-draw.h"
 #include "viciitypes.h"
 #include "viewport.h"
@@ -94,8 +95,17 @@ inline static void _draw_dummy(uint8_t *p, unsigned int xs, unsigned int xe,
     memcpy(dest, src, (xe - xs + 1) * 8);
 }
 
+/* With the render thread, the line is copied once it has been rendered.  */
+#define QUEUE_COPY(xs, xe)                                              \
+    vicii_draw_cycle_queue_copy(GFX_PTR() + (xs) * 8,                   \
+                                DBUF_OFFSET + (xs) * 8,                 \
+                                ((xe) - (xs) + 1) * 8)
+
 static void draw_dummy(void)
 {
+    if (QUEUE_COPY(0, FULL_WIDTH_CHARS - 1)) {
+        return;
+    }
     ALIGN_DRAW_FUNC(_draw_dummy, 0, FULL_WIDTH_CHARS - 1,
                     vicii.raster.gfx_msk);
 }
@@ -103,6 +113,9 @@ static void draw_dummy(void)
 static void draw_dummy_cached(raster_cache_t *cache, unsigned int xs,
                               unsigned int xe)
 {
+    if (QUEUE_COPY(xs, xe)) {
+        return;
+    }
     ALIGN_DRAW_FUNC(_draw_dummy, xs, xe, cache->gfx_msk);
 }
 
@@ -114,6 +127,10 @@ static void draw_dummy_foreground(unsigned int start_char,
     uint8_t *src;
     uint8_t *dest;
 
+    if (QUEUE_COPY(start_char, end_char)) {
+        return;
+    }
+
     src = &(vicii.dbuf[DBUF_OFFSET + start_char * 8]);
     dest = (GFX_PTR() + start_char * 8);
 
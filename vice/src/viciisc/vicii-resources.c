@@ -37,6 +37,7 @@
 #include "vicii-chip-model.h"
 #include "vicii-cycle.h"
 #include "vicii-color.h"
+#include "vicii-draw-cycle.h"
 #include "vicii-resources.h"
 #include "vicii-timing.h"
 #include "vicii.h"
@@ -95,6 +96,13 @@ static int set_vsp_bug_enabled(int val, void *param)
     return 0;
 }
 
+static int set_render_thread_enabled(int val, void *param)
+{
+    vicii_resources.render_thread_enabled = val ? 1 : 0;
+    vicii_draw_cycle_set_render_thread(vicii_resources.render_thread_enabled);
+    return 0;
+}
+
 struct vicii_model_info_s {
     int video;
     int luma;
@@ -165,6 +173,9 @@ static const resource_int_t resources_int[] =
     { "VICIIVSPBug", 0, RES_EVENT_SAME, NULL,
       &vicii_resources.vsp_bug_enabled,
       set_vsp_bug_enabled, NULL },
+    { "VICIIRenderThread", 0, RES_EVENT_NO, NULL,
+      &vicii_resources.render_thread_enabled,
+      set_render_thread_enabled, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -45,6 +45,9 @@ struct vicii_resources_s {
 
     /* Flag: Do we emulate the "VSP bug" behaviour? */
     int vsp_bug_enabled;
+
+    /* Flag: Do we render the pixels on a separate thread? */
+    int render_thread_enabled;
 };
 typedef struct vicii_resources_s vicii_resources_t;
 
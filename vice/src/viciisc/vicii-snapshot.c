@@ -121,6 +121,9 @@ int vicii_snapshot_write_module(snapshot_t *s)
 
     mem_color_ram_to_snapshot(color_ram);
 
+    /* wait for the render thread, which also updates dbuf */
+    vicii_draw_cycle_sync();
+
     if (0
         /* VICII model (for sanity checks) */
         || SMW_B(m, (uint8_t)vicii_resources.model) < 0
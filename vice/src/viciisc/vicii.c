@@ -171,6 +171,9 @@ static void vicii_set_geometry(void)
 {
     unsigned int width, height;
 
+    /* lines still being rendered go to the old frame buffer */
+    vicii_draw_cycle_sync();
+
     width = vicii.screen_leftborderwidth + VICII_SCREEN_XPIX + vicii.screen_rightborderwidth;
     height = vicii.last_displayed_line - vicii.first_displayed_line + 1;
 
@@ -196,6 +199,11 @@ static void vicii_set_geometry(void)
     vicii.raster.viewport->crt_type = vicii_get_crt_type();
 }
 
+static void vicii_sync_drawing(raster_t *raster)
+{
+    vicii_draw_cycle_sync();
+}
+
 static int init_raster(void)
 {
     raster_t *raster;
@@ -212,6 +220,10 @@ static int init_raster(void)
     }
     raster_modes_set_idle_mode(raster->modes, VICII_DUMMY_MODE);
 
+    /* collisions are emulated in vicii_draw_cycle() even when not drawing */
+    raster->can_skip_drawing = 1;
+    raster->sync_drawing = vicii_sync_drawing;
+
     resources_touch("VICIIVideoCache");
 
     vicii_set_geometry();
@@ -459,6 +471,7 @@ void vicii_set_canvas_refresh(int enable)
 
 void vicii_shutdown(void)
 {
+    vicii_draw_cycle_shutdown();
     raster_shutdown(&vicii.raster);
 }
 
@@ -471,6 +484,8 @@ void vicii_screenshot(screenshot_t *screenshot)
     uint8_t *bitmap_high_base;       /* Pointer to bitmap memory (high part).  */
     int tmp, bitmap_bank, video;
 
+    vicii_draw_cycle_sync();
+
     resources_get_int("MachineVideoStandard", &video);
 
     screen_addr = vicii.vbank_phi2 + ((vicii.regs[0x18] & 0xf0) << 6);
@@ -151,6 +151,27 @@ typedef struct video_chip_cap_s video_chip_cap_t;
 
 #define VIDEO_MAX_OUTPUT_WIDTH  2048
 
+/* the PAL/NTSC renderers can split a frame into this many horizontal bands,
+   which are rendered in parallel */
+#define VIDEO_RENDER_MAX_BANDS  8
+
+/* line buffers of a band, other than the first one */
+typedef struct video_render_band_buffers_s {
+    int32_t line_yuv_0[VIDEO_MAX_OUTPUT_WIDTH * 3];
+    int16_t prevrgbline[VIDEO_MAX_OUTPUT_WIDTH * 3];
+    uint8_t rgbscratchbuffer[VIDEO_MAX_OUTPUT_WIDTH * 4];
+} video_render_band_buffers_t;
+
+/* a band as passed to the PAL/NTSC renderers */
+typedef struct video_render_band_s {
+    int32_t *line_yuv_0;
+    int16_t *prevrgbline;
+    uint8_t *rgbscratchbuffer;
+    int above;  /* render the line above the band to the scratch buffer first,
+                   to set up the line buffers */
+    int below;  /* leave the scanline below the band to the next band */
+} video_render_band_t;
+
 struct video_render_color_tables_s {
     int updated;                /* tables here are up to date */
     uint32_t physical_colors[256];
@@ -171,6 +192,8 @@ struct video_render_color_tables_s {
     int32_t line_yuv_0[VIDEO_MAX_OUTPUT_WIDTH * 3];
     int16_t prevrgbline[VIDEO_MAX_OUTPUT_WIDTH * 3];
     uint8_t rgbscratchbuffer[VIDEO_MAX_OUTPUT_WIDTH * 4];
+    /* VIDEO_RENDER_MAX_BANDS - 1 sets of line buffers, allocated on demand */
+    video_render_band_buffers_t *band_buffers;
 
     /*
      * All values below here formerly were globals in video-color.h.
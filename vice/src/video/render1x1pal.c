@@ -76,7 +76,8 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
                        unsigned int xt, const unsigned int yt,
                        const unsigned int pitchs, const unsigned int pitcht,
                        const unsigned int pixelstride,
-                       int yuvtarget, video_render_config_t *config)
+                       int yuvtarget, video_render_config_t *config,
+                       const video_render_band_t *band)
 {
     const int32_t *cbtable;
     const int32_t *crtable;
@@ -99,7 +100,7 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
     src = src + pitchs * ys + xs - 2;
     trg = trg + pitcht * yt + (xt >> 1) * pixelstride;
 
-    line = color_tab->line_yuv_0;
+    line = band->line_yuv_0;
     tmpsrc = ys > 0 ? src - pitchs : src;
 
     /* is the previous line odd or even? (inverted condition!) */
@@ -132,7 +133,7 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
         tmpsrc = src;
         tmptrg = trg;
 
-        line = color_tab->line_yuv_0;
+        line = band->line_yuv_0;
 
         if (y & 1) { /* odd sourceline */
             off_flip = off;
@@ -189,9 +190,10 @@ render_32_1x1_pal(video_render_color_tables_t *color_tab,
                   const unsigned int width, const unsigned int height,
                   const unsigned int xs, const unsigned int ys,
                   const unsigned int xt, const unsigned int yt,
-                  const unsigned int pitchs, const unsigned int pitcht, video_render_config_t *config)
+                  const unsigned int pitchs, const unsigned int pitcht, video_render_config_t *config,
+                  const video_render_band_t *band)
 {
     render_generic_1x1_pal(color_tab, src, trg, width, height, xs, ys, xt, yt,
                            pitchs, pitcht,
-                           8, 0, config);
+                           8, 0, config, band);
 }
@@ -38,5 +38,6 @@ void render_32_1x1_pal(video_render_color_tables_t *color_tab,
                        const unsigned int xs, const unsigned int ys,
                        const unsigned int xt, const unsigned int yt,
                        const unsigned int pitchs,
-                       const unsigned int pitcht, video_render_config_t *config);
+                       const unsigned int pitcht, video_render_config_t *config,
+                       const video_render_band_t *band);
 #endif
@@ -33,6 +33,18 @@
 #include "types.h"
 #include "video-color.h"
 
+/* The vectorized line renderer is only available on x86 with GCC or clang,
+   whether the CPU supports it is checked at run time. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RENDER_PAL_X86
+#include <immintrin.h>
+#endif
+
+#ifdef RENDER_PAL_X86
+/* set by render_32_2x2_pal_init() if the CPU has AVX2 */
+static int use_avx2 = 0;
+#endif
+
 /*
     YUV to RGB
 
@@ -87,6 +99,292 @@ void get_yuv_from_video(
     line[1] = vnew;
 }
 
+/* render one source line to the target line and the scanline above it */
+static inline
+void render_line_2x2_pal(video_render_color_tables_t *color_tab,
+                         const uint8_t *tmpsrc, int32_t *line,
+                         const int32_t *cbtable, const int32_t *crtable,
+                         const int32_t off_flip,
+                         uint8_t *tmptrg, uint8_t *tmptrgscanline,
+                         int16_t *prevrgblineptr, const int32_t shade,
+                         const unsigned int wfirst, const unsigned int width,
+                         const unsigned int wlast, const unsigned int pixelstride,
+                         const int write_interpolated_pixels)
+{
+    const int32_t *ytablel = color_tab->ytablel;
+    const int32_t *ytableh = color_tab->ytableh;
+    uint32_t x;
+    int32_t l, l2, u, u2, unew, v, v2, vnew;
+
+    l = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
+    unew = cbtable[tmpsrc[0]] + cbtable[tmpsrc[1]] + cbtable[tmpsrc[2]] + cbtable[tmpsrc[3]];
+    vnew = crtable[tmpsrc[0]] + crtable[tmpsrc[1]] + crtable[tmpsrc[2]] + crtable[tmpsrc[3]];
+    get_yuv_from_video(unew, vnew, line, off_flip, &u, &v);
+    unew -= cbtable[tmpsrc[0]];
+    vnew -= crtable[tmpsrc[0]];
+    tmpsrc += 1;
+    line += 2;
+
+    /* actual line */
+    if (wfirst) {
+        l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
+        unew += cbtable[tmpsrc[3]];
+        vnew += crtable[tmpsrc[3]];
+        get_yuv_from_video(unew, vnew, line, off_flip, &u2, &v2);
+        unew -= cbtable[tmpsrc[0]];
+        vnew -= crtable[tmpsrc[0]];
+        tmpsrc += 1;
+        line += 2;
+
+        if (write_interpolated_pixels) {
+            store_line_and_scanline_4(color_tab, tmptrg, tmptrgscanline, prevrgblineptr, shade, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
+            tmptrgscanline += pixelstride;
+            tmptrg += pixelstride;
+            prevrgblineptr += 3;
+        }
+
+        l = l2;
+        u = u2;
+        v = v2;
+    }
+    for (x = 0; x < width; x++) {
+        store_line_and_scanline_4(color_tab, tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v);
+        tmptrgscanline += pixelstride;
+        tmptrg += pixelstride;
+        prevrgblineptr += 3;
+
+        l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
+        unew += cbtable[tmpsrc[3]];
+        vnew += crtable[tmpsrc[3]];
+        get_yuv_from_video(unew, vnew, line, off_flip, &u2, &v2);
+        unew -= cbtable[tmpsrc[0]];
+        vnew -= crtable[tmpsrc[0]];
+        tmpsrc += 1;
+        line += 2;
+
+        if (write_interpolated_pixels) {
+            store_line_and_scanline_4(color_tab, tmptrg, tmptrgscanline, prevrgblineptr, shade, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
+            tmptrgscanline += pixelstride;
+            tmptrg += pixelstride;
+            prevrgblineptr += 3;
+        }
+
+        l = l2;
+        u = u2;
+        v = v2;
+    }
+    if (wlast) {
+        store_line_and_scanline_4(color_tab, tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v);
+    }
+}
+
+#ifdef RENDER_PAL_X86
+/*
+    AVX2 version of render_line_2x2_pal() for 32 bit pixels with interpolated
+    pixels. It computes exactly the same values, in passes over the line:
+
+    1. the table values of all source pixels
+    2. Y, U and V of each source pixel, updating the delay line
+    3. Y, U and V of each target pixel, every other one interpolated
+    4. RGB, and the gamma corrected line and scanline pixels
+
+    The previous line is kept as separate red, green and blue rows of
+    VIDEO_MAX_OUTPUT_WIDTH entries in prevrgbline, instead of interleaved.
+    The whole frame has to be rendered with the same version.
+*/
+
+/* the largest width of a line that can be rendered */
+#define AVX2_MAX_WIDTH  (VIDEO_MAX_OUTPUT_WIDTH - 32)
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_load_bytes(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)p));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_gather(const void *table, __m256i index)
+{
+    return _mm256_i32gather_epi32((const int *)table, index, 4);
+}
+
+/* store the 32 bit values in a and b interleaved to p */
+__attribute__((target("avx2")))
+static inline void avx2_store_interleaved(int32_t *p, __m256i a, __m256i b)
+{
+    __m256i lo = _mm256_unpacklo_epi32(a, b);
+    __m256i hi = _mm256_unpackhi_epi32(a, b);
+
+    _mm256_storeu_si256((__m256i *)p, _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i *)(p + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+/* the truncation to int16_t of the RGB values in store_line_and_scanline_4() */
+__attribute__((target("avx2")))
+static inline __m256i avx2_int16(__m256i a)
+{
+    return _mm256_srai_epi32(_mm256_slli_epi32(a, 16), 16);
+}
+
+__attribute__((target("avx2")))
+static void render_line_2x2_pal_avx2(video_render_color_tables_t *color_tab,
+                                     const uint8_t *tmpsrc, int32_t *line,
+                                     const int32_t *cbtable, const int32_t *crtable,
+                                     const int32_t off_flip,
+                                     uint8_t *tmptrg, uint8_t *tmptrgscanline,
+                                     int16_t *prevrgbline,
+                                     const unsigned int wfirst, const unsigned int width,
+                                     const unsigned int wlast)
+{
+    /* source pixels, and target pixels */
+    int32_t cb[AVX2_MAX_WIDTH / 2 + 16], cr[AVX2_MAX_WIDTH / 2 + 16];
+    int32_t yl[AVX2_MAX_WIDTH / 2 + 16], yh[AVX2_MAX_WIDTH / 2 + 16];
+    int32_t sy[AVX2_MAX_WIDTH / 2 + 16], su[AVX2_MAX_WIDTH / 2 + 16], sv[AVX2_MAX_WIDTH / 2 + 16];
+    int32_t ty[AVX2_MAX_WIDTH + 32], tu[AVX2_MAX_WIDTH + 32], tv[AVX2_MAX_WIDTH + 32];
+    int16_t *prev_red = prevrgbline;
+    int16_t *prev_grn = prevrgbline + VIDEO_MAX_OUTPUT_WIDTH;
+    int16_t *prev_blu = prevrgbline + VIDEO_MAX_OUTPUT_WIDTH * 2;
+    uint32_t *trg = (uint32_t *)tmptrg;
+    uint32_t *scanline = (uint32_t *)tmptrgscanline;
+    /* source pixels used, and their number of table values */
+    unsigned int n = width + wfirst + 1;
+    unsigned int nsrc = n + 3;
+    /* target pixels */
+    unsigned int ntrg = 2 * width + wfirst + wlast;
+    unsigned int i;
+    const __m256i voff = _mm256_set1_epi32(off_flip);
+    const __m256i valpha = _mm256_set1_epi32((int)color_tab->alpha);
+    const __m256i v256 = _mm256_set1_epi32(256);
+    const __m256i v512 = _mm256_set1_epi32(512);
+    const __m256i v50 = _mm256_set1_epi32(50);
+    const __m256i v130 = _mm256_set1_epi32(130);
+    const __m256i deinterleave = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+    /* 1. table values, don't read beyond the source line */
+    for (i = 0; i + 8 <= nsrc; i += 8) {
+        __m256i c = avx2_load_bytes(tmpsrc + i);
+
+        _mm256_storeu_si256((__m256i *)(cb + i), avx2_gather(cbtable, c));
+        _mm256_storeu_si256((__m256i *)(cr + i), avx2_gather(crtable, c));
+        _mm256_storeu_si256((__m256i *)(yl + i), avx2_gather(color_tab->ytablel, c));
+        _mm256_storeu_si256((__m256i *)(yh + i), avx2_gather(color_tab->ytableh, c));
+    }
+    for (; i < nsrc; i++) {
+        cb[i] = cbtable[tmpsrc[i]];
+        cr[i] = crtable[tmpsrc[i]];
+        yl[i] = color_tab->ytablel[tmpsrc[i]];
+        yh[i] = color_tab->ytableh[tmpsrc[i]];
+    }
+
+    /* 2. source pixels, the blocks of 8 may go beyond n into the padding of
+          the arrays, but the delay line is only updated up to n */
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m256i l = _mm256_add_epi32(_mm256_add_epi32(
+                        _mm256_loadu_si256((const __m256i *)(yl + i + 1)),
+                        _mm256_loadu_si256((const __m256i *)(yh + i + 2))),
+                        _mm256_loadu_si256((const __m256i *)(yl + i + 3)));
+        __m256i unew = _mm256_add_epi32(_mm256_add_epi32(
+                           _mm256_loadu_si256((const __m256i *)(cb + i)),
+                           _mm256_loadu_si256((const __m256i *)(cb + i + 1))),
+                           _mm256_add_epi32(
+                           _mm256_loadu_si256((const __m256i *)(cb + i + 2)),
+                           _mm256_loadu_si256((const __m256i *)(cb + i + 3))));
+        __m256i vnew = _mm256_add_epi32(_mm256_add_epi32(
+                           _mm256_loadu_si256((const __m256i *)(cr + i)),
+                           _mm256_loadu_si256((const __m256i *)(cr + i + 1))),
+                           _mm256_add_epi32(
+                           _mm256_loadu_si256((const __m256i *)(cr + i + 2)),
+                           _mm256_loadu_si256((const __m256i *)(cr + i + 3))));
+        __m256i a = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)(line + i * 2)), deinterleave);
+        __m256i b = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)(line + i * 2 + 8)), deinterleave);
+        __m256i uold = _mm256_permute2x128_si256(a, b, 0x20);
+        __m256i vold = _mm256_permute2x128_si256(a, b, 0x31);
+
+        _mm256_storeu_si256((__m256i *)(sy + i), l);
+        _mm256_storeu_si256((__m256i *)(su + i), _mm256_mullo_epi32(_mm256_add_epi32(unew, uold), voff));
+        _mm256_storeu_si256((__m256i *)(sv + i), _mm256_mullo_epi32(_mm256_add_epi32(vnew, vold), voff));
+        avx2_store_interleaved(line + i * 2, unew, vnew);
+    }
+    for (; i < n; i++) {
+        int32_t unew = cb[i] + cb[i + 1] + cb[i + 2] + cb[i + 3];
+        int32_t vnew = cr[i] + cr[i + 1] + cr[i + 2] + cr[i + 3];
+
+        sy[i] = yl[i + 1] + yh[i + 2] + yl[i + 3];
+        get_yuv_from_video(unew, vnew, line + i * 2, off_flip, &su[i], &sv[i]);
+    }
+    /* the pixels after the last one are only used for target pixels that are
+       not rendered */
+    for (i = n; i < n + 8; i++) {
+        sy[i] = su[i] = sv[i] = 0;
+    }
+
+    /* 3. target pixels, 2 * i is source pixel i, 2 * i + 1 is between i and i + 1 */
+    for (i = 0; i < n; i += 8) {
+        __m256i y = _mm256_loadu_si256((const __m256i *)(sy + i));
+        __m256i u = _mm256_loadu_si256((const __m256i *)(su + i));
+        __m256i v = _mm256_loadu_si256((const __m256i *)(sv + i));
+        __m256i y2 = _mm256_loadu_si256((const __m256i *)(sy + i + 1));
+        __m256i u2 = _mm256_loadu_si256((const __m256i *)(su + i + 1));
+        __m256i v2 = _mm256_loadu_si256((const __m256i *)(sv + i + 1));
+
+        avx2_store_interleaved(ty + i * 2, y, _mm256_srai_epi32(_mm256_add_epi32(y, y2), 1));
+        avx2_store_interleaved(tu + i * 2, u, _mm256_srai_epi32(_mm256_add_epi32(u, u2), 1));
+        avx2_store_interleaved(tv + i * 2, v, _mm256_srai_epi32(_mm256_add_epi32(v, v2), 1));
+    }
+
+    /* 4. the pixels of the line, without the first one if it is not a source pixel */
+    for (i = 0; i + 8 <= ntrg; i += 8) {
+        __m256i y = _mm256_loadu_si256((const __m256i *)(ty + i + wfirst));
+        __m256i u = _mm256_loadu_si256((const __m256i *)(tu + i + wfirst));
+        __m256i v = _mm256_loadu_si256((const __m256i *)(tv + i + wfirst));
+        __m256i red = avx2_int16(_mm256_srai_epi32(_mm256_add_epi32(y, v), 16));
+        __m256i blu = avx2_int16(_mm256_srai_epi32(_mm256_add_epi32(y, u), 16));
+        __m256i grn = avx2_int16(_mm256_srai_epi32(_mm256_sub_epi32(y,
+                          _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(u, v50),
+                                                             _mm256_mullo_epi32(v, v130)), 8)), 16));
+        __m256i pred = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(prev_red + i)));
+        __m256i pgrn = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(prev_grn + i)));
+        __m256i pblu = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(prev_blu + i)));
+        __m256i s, t;
+
+        s = _mm256_or_si256(_mm256_or_si256(
+                avx2_gather(color_tab->gamma_red_fac, _mm256_add_epi32(v512, _mm256_add_epi32(red, pred))),
+                avx2_gather(color_tab->gamma_grn_fac, _mm256_add_epi32(v512, _mm256_add_epi32(grn, pgrn)))),
+                _mm256_or_si256(
+                avx2_gather(color_tab->gamma_blu_fac, _mm256_add_epi32(v512, _mm256_add_epi32(blu, pblu))),
+                valpha));
+        t = _mm256_or_si256(_mm256_or_si256(
+                avx2_gather(color_tab->gamma_red, _mm256_add_epi32(v256, red)),
+                avx2_gather(color_tab->gamma_grn, _mm256_add_epi32(v256, grn))),
+                _mm256_or_si256(
+                avx2_gather(color_tab->gamma_blu, _mm256_add_epi32(v256, blu)),
+                valpha));
+        _mm256_storeu_si256((__m256i *)(scanline + i), s);
+        _mm256_storeu_si256((__m256i *)(trg + i), t);
+
+        /* the values are in the int16_t range, packing does not saturate */
+        _mm_storeu_si128((__m128i *)(prev_red + i),
+                         _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packs_epi32(red, red), 0x08)));
+        _mm_storeu_si128((__m128i *)(prev_grn + i),
+                         _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packs_epi32(grn, grn), 0x08)));
+        _mm_storeu_si128((__m128i *)(prev_blu + i),
+                         _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packs_epi32(blu, blu), 0x08)));
+    }
+    for (; i < ntrg; i++) {
+        int16_t prev[3];
+
+        prev[0] = prev_red[i];
+        prev[1] = prev_grn[i];
+        prev[2] = prev_blu[i];
+        store_line_and_scanline_4(color_tab, (uint8_t *)(trg + i), (uint8_t *)(scanline + i),
+                                  prev, 0, ty[i + wfirst], tu[i + wfirst], tv[i + wfirst]);
+        prev_red[i] = prev[0];
+        prev_grn[i] = prev[1];
+        prev_blu[i] = prev[2];
+    }
+}
+#endif
+
 static inline
 void render_generic_2x2_pal(video_render_color_tables_t *color_tab,
                             const uint8_t *src, uint8_t *trg,
@@ -96,18 +394,19 @@ void render_generic_2x2_pal(video_render_color_tables_t *color_tab,
                             const unsigned int pitchs, const unsigned int pitcht,
                             unsigned int viewport_first_line, unsigned int viewport_last_line,
                             unsigned int pixelstride,
-                            const int write_interpolated_pixels, video_render_config_t *config)
+                            const int write_interpolated_pixels, video_render_config_t *config,
+                            const video_render_band_t *band)
 {
-    int16_t *prevrgblineptr;
-    const int32_t *ytablel = color_tab->ytablel;
-    const int32_t *ytableh = color_tab->ytableh;
     const uint8_t *tmpsrc;
     uint8_t *tmptrg, *tmptrgscanline;
     int32_t *line, *cbtable, *crtable;
     uint32_t x, y, wfirst, wlast, yys;
-    int32_t l, l2, u, u2, unew, v, v2, vnew, off, off_flip, shade;
+    int32_t unew, vnew, off, off_flip, shade;
     int first_line = viewport_first_line * 2;
     int last_line = (viewport_last_line * 2) + 1;
+#ifdef RENDER_PAL_X86
+    int avx2;
+#endif
 
     src = src + pitchs * ys + xs - 2;
     trg = trg + pitcht * yt + xt * pixelstride;
@@ -117,7 +416,12 @@ void render_generic_2x2_pal(video_render_color_tables_t *color_tab,
     wlast = width & 1;
     width >>= 1;
 
-    line = color_tab->line_yuv_0;
+#ifdef RENDER_PAL_X86
+    avx2 = use_avx2 && pixelstride == 4 && write_interpolated_pixels
+           && 2 * width + wfirst + wlast <= AVX2_MAX_WIDTH;
+#endif
+
+    line = band->line_yuv_0;
     /* get previous line into buffer. */
     tmpsrc = ys > 0 ? src - pitchs : src;
 
@@ -153,8 +457,9 @@ void render_generic_2x2_pal(video_render_color_tables_t *color_tab,
     off = (int) (((float) config->video_resources.pal_oddlines_offset * (1.5f / 2000.0f) - (1.5f / 2.0f - 1.0f)) * (1 << 5));
     shade = (int) ((float) config->video_resources.pal_scanlineshade / 1000.0f * 256.f);
 
-    /* height & 1 == 0. */
-    for (y = yys; y < yys + height + 1; y += 2) {
+    /* height & 1 == 0. If there is another band below, it renders the last
+       scanline. */
+    for (y = yys; y < yys + height + (band->below ? 0 : 1); y += 2) {
         /* when we are dealing with the last line, the rules change:
          * we no longer write the main output to screen, we just put it into
          * the scanline. */
@@ -165,28 +470,28 @@ void render_generic_2x2_pal(video_render_color_tables_t *color_tab,
                 break;
             }
 
-            tmptrg = &color_tab->rgbscratchbuffer[0];
+            tmptrg = &band->rgbscratchbuffer[0];
             tmptrgscanline = trg - pitcht;
             if (y == (unsigned int)(last_line + 1)) {
                 /* src would point after the source area, so rewind one line */
                 src -= pitchs;
             }
         } else {
-            /* pixel data to surface */
-            tmptrg = trg;
+            /* pixel data to surface, unless it is the line above the band */
+            tmptrg = y == yys && band->above ? &band->rgbscratchbuffer[0] : trg;
             /* write scanline data to previous line if possible,
              * otherwise we dump it to the scratch region... We must never
              * render the scanline for the first row, because prevlinergb is not
              * yet initialized and scanline data would be bogus! */
             tmptrgscanline = y != yys && y > (unsigned int)first_line && y <= (unsigned int)last_line
                              ? trg - pitcht
-                             : &color_tab->rgbscratchbuffer[0];
+                             : &band->rgbscratchbuffer[0];
         }
 
         /* current source image for YUV xform */
         tmpsrc = src;
         /* prev line's YUV-xformed data */
-        line = color_tab->line_yuv_0;
+        line = band->line_yuv_0;
 
         if (y & 2) { /* odd sourceline */
             off_flip = off;
@@ -198,66 +503,18 @@ void render_generic_2x2_pal(video_render_color_tables_t *color_tab,
             crtable = write_interpolated_pixels ? color_tab->crtable : color_tab->cvtable;
         }
 
-        l = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
-        unew = cbtable[tmpsrc[0]] + cbtable[tmpsrc[1]] + cbtable[tmpsrc[2]] + cbtable[tmpsrc[3]];
-        vnew = crtable[tmpsrc[0]] + crtable[tmpsrc[1]] + crtable[tmpsrc[2]] + crtable[tmpsrc[3]];
-        get_yuv_from_video(unew, vnew, line, off_flip, &u, &v);
-        unew -= cbtable[tmpsrc[0]];
-        vnew -= crtable[tmpsrc[0]];
-        tmpsrc += 1;
-        line += 2;
-
-        /* actual line */
-        prevrgblineptr = &color_tab->prevrgbline[0];
-        if (wfirst) {
-            l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
-            unew += cbtable[tmpsrc[3]];
-            vnew += crtable[tmpsrc[3]];
-            get_yuv_from_video(unew, vnew, line, off_flip, &u2, &v2);
-            unew -= cbtable[tmpsrc[0]];
-            vnew -= crtable[tmpsrc[0]];
-            tmpsrc += 1;
-            line += 2;
-
-            if (write_interpolated_pixels) {
-                store_line_and_scanline_4(color_tab, tmptrg, tmptrgscanline, prevrgblineptr, shade, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
-                tmptrgscanline += pixelstride;
-                tmptrg += pixelstride;
-                prevrgblineptr += 3;
-            }
-
-            l = l2;
-            u = u2;
-            v = v2;
-        }
-        for (x = 0; x < width; x++) {
-            store_line_and_scanline_4(color_tab, tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v);
-            tmptrgscanline += pixelstride;
-            tmptrg += pixelstride;
-            prevrgblineptr += 3;
-
-            l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
-            unew += cbtable[tmpsrc[3]];
-            vnew += crtable[tmpsrc[3]];
-            get_yuv_from_video(unew, vnew, line, off_flip, &u2, &v2);
-            unew -= cbtable[tmpsrc[0]];
-            vnew -= crtable[tmpsrc[0]];
-            tmpsrc += 1;
-            line += 2;
-
-            if (write_interpolated_pixels) {
-                store_line_and_scanline_4(color_tab, tmptrg, tmptrgscanline, prevrgblineptr, shade, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
-                tmptrgscanline += pixelstride;
-                tmptrg += pixelstride;
-                prevrgblineptr += 3;
-            }
-
-            l = l2;
-            u = u2;
-            v = v2;
-        }
-        if (wlast) {
-            store_line_and_scanline_4(color_tab, tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v);
+#ifdef RENDER_PAL_X86
+        if (avx2) {
+            render_line_2x2_pal_avx2(color_tab, tmpsrc, line, cbtable, crtable, off_flip,
+                                     tmptrg, tmptrgscanline, band->prevrgbline,
+                                     wfirst, width, wlast);
+        } else
+#endif
+        {
+            render_line_2x2_pal(color_tab, tmpsrc, line, cbtable, crtable, off_flip,
+                                tmptrg, tmptrgscanline, band->prevrgbline, shade,
+                                wfirst, width, wlast, pixelstride,
+                                write_interpolated_pixels);
         }
 
         src += pitchs;
@@ -272,9 +529,30 @@ void render_32_2x2_pal(video_render_color_tables_t *color_tab,
                        const unsigned int xt, const unsigned int yt,
                        const unsigned int pitchs, const unsigned int pitcht,
                        unsigned int viewport_first_line, unsigned int viewport_last_line,
-                       video_render_config_t *config)
+                       video_render_config_t *config, const video_render_band_t *band)
+{
+    /* a band that is set up from the line above starts one line higher */
+    render_generic_2x2_pal(color_tab, src, trg, width, height + band->above * 2,
+                           xs, ys - band->above, xt, yt - band->above * 2, pitchs, pitcht,
+                           viewport_first_line, viewport_last_line,
+                           4, 1, config, band);
+}
+
+/* check which line renderer the CPU supports */
+void render_32_2x2_pal_init(void)
+{
+    render_32_2x2_pal_set_vector(1);
+}
+
+/* use the vectorized line renderer if `enable' is set and the CPU supports
+   it, return non-zero if it is used */
+int render_32_2x2_pal_set_vector(int enable)
 {
-    render_generic_2x2_pal(color_tab, src, trg, width, height, xs, ys,
-                           xt, yt, pitchs, pitcht, viewport_first_line, viewport_last_line,
-                           4, 1, config);
+#ifdef RENDER_PAL_X86
+    __builtin_cpu_init();
+    use_avx2 = enable && __builtin_cpu_supports("avx2");
+    return use_avx2;
+#else
+    return 0;
+#endif
 }
@@ -29,6 +29,7 @@
 #define VICE_RENDER2X2PAL_H
 
 #include "types.h"
+#include "video.h"
 #include "viewport.h"
 
 void render_32_2x2_pal(video_render_color_tables_t *colortab,
@@ -39,5 +40,8 @@ void render_32_2x2_pal(video_render_color_tables_t *colortab,
                        const unsigned int pitchs,
                        const unsigned int pitcht,
                        unsigned int viewport_first_line, unsigned int viewport_last_line,
-                       video_render_config_t *config);
+                       video_render_config_t *config,
+                       const video_render_band_t *band);
+void render_32_2x2_pal_init(void);
+int render_32_2x2_pal_set_vector(int enable);
 #endif
@@ -97,7 +97,8 @@ void render_generic_2x2_pal_u(video_render_color_tables_t *color_tab,
                             const unsigned int pitchs, const unsigned int pitcht,
                             unsigned int viewport_first_line, unsigned int viewport_last_line,
                             unsigned int pixelstride,
-                            const int write_interpolated_pixels, video_render_config_t *config)
+                            const int write_interpolated_pixels, video_render_config_t *config,
+                              const video_render_band_t *band)
 {
     int16_t *prevrgblineptr;
     const int32_t *ytablel = color_tab->ytablel;
@@ -118,7 +119,7 @@ void render_generic_2x2_pal_u(video_render_color_tables_t *color_tab,
     wlast = width & 1;
     width >>= 1;
 
-    line = color_tab->line_yuv_0;
+    line = band->line_yuv_0;
     /* get previous line into buffer. */
     tmpsrc = ys > 0 ? src - pitchs : src;
 
@@ -154,8 +155,9 @@ void render_generic_2x2_pal_u(video_render_color_tables_t *color_tab,
     off = (int) (((float) config->video_resources.pal_oddlines_offset * (1.5f / 2000.0f) - (1.5f / 2.0f - 1.0f)) * (1 << 5));
     shade = (int) ((float) config->video_resources.pal_scanlineshade / 1000.0f * 256.f);
 
-    /* height & 1 == 0. */
-    for (y = yys; y < yys + height + 1; y += 2) {
+    /* height & 1 == 0. If there is another band below, it renders the last
+       scanline. */
+    for (y = yys; y < yys + height + (band->below ? 0 : 1); y += 2) {
         /* when we are dealing with the last line, the rules change:
          * we no longer write the main output to screen, we just put it into
          * the scanline. */
@@ -166,28 +168,28 @@ void render_generic_2x2_pal_u(video_render_color_tables_t *color_tab,
                 break;
             }
 
-            tmptrg = &color_tab->rgbscratchbuffer[0];
+            tmptrg = &band->rgbscratchbuffer[0];
             tmptrgscanline = trg - pitcht;
             if (y == (unsigned int)(last_line + 1)) {
                 /* src would point after the source area, so rewind one line */
                 src -= pitchs;
             }
         } else {
-            /* pixel data to surface */
-            tmptrg = trg;
+            /* pixel data to surface, unless it is the line above the band */
+            tmptrg = y == yys && band->above ? &band->rgbscratchbuffer[0] : trg;
             /* write scanline data to previous line if possible,
              * otherwise we dump it to the scratch region... We must never
              * render the scanline for the first row, because prevlinergb is not
              * yet initialized and scanline data would be bogus! */
             tmptrgscanline = y != yys && y > (unsigned int)first_line && y <= (unsigned int)last_line
                              ? trg - pitcht
-                             : &color_tab->rgbscratchbuffer[0];
+                             : &band->rgbscratchbuffer[0];
         }
 
         /* current source image for YUV xform */
         tmpsrc = src;
         /* prev line's YUV-xformed data */
-        line = color_tab->line_yuv_0;
+        line = band->line_yuv_0;
 
         if (y & 2) { /* odd sourceline */
             off_flip = off;
@@ -209,7 +211,7 @@ void render_generic_2x2_pal_u(video_render_color_tables_t *color_tab,
         line += 2;
 
         /* actual line */
-        prevrgblineptr = &color_tab->prevrgbline[0];
+        prevrgblineptr = &band->prevrgbline[0];
         if (wfirst) {
             l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
             unew += cbtable[tmpsrc[3]];
@@ -273,9 +275,11 @@ void render_32_2x2_pal_u(video_render_color_tables_t *color_tab,
                        const unsigned int xt, const unsigned int yt,
                        const unsigned int pitchs, const unsigned int pitcht,
                        unsigned int viewport_first_line, unsigned int viewport_last_line,
-                       video_render_config_t *config)
+                       video_render_config_t *config, const video_render_band_t *band)
 {
-    render_generic_2x2_pal_u(color_tab, src, trg, width, height, xs, ys,
-                           xt, yt, pitchs, pitcht, viewport_first_line, viewport_last_line,
-                           4, 1, config);
+    /* a band that is set up from the line above starts one line higher */
+    render_generic_2x2_pal_u(color_tab, src, trg, width, height + band->above * 2,
+                           xs, ys - band->above, xt, yt - band->above * 2, pitchs, pitcht,
+                           viewport_first_line, viewport_last_line,
+                           4, 1, config, band);
 }
@@ -39,5 +39,6 @@ void render_32_2x2_pal_u(video_render_color_tables_t *colortab,
                          const unsigned int pitchs,
                          const unsigned int pitcht,
                          unsigned int viewport_first_line, unsigned int viewport_last_line,
-                         video_render_config_t *config);
+                         video_render_config_t *config,
+                         const video_render_band_t *band);
 #endif
@@ -39,6 +39,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "benchmark.h"
 #include "lib.h"
 #include "log.h"
 #include "machine.h"
@@ -103,6 +104,7 @@ void video_canvas_shutdown(video_canvas_t *canvas)
             }
         }
 
+        lib_free(canvas->videoconfig->color_tables.band_buffers);
         lib_free(canvas->videoconfig);
         lib_free(canvas->draw_buffer);
         lib_free(canvas->viewport);
@@ -116,6 +118,8 @@ void video_canvas_render(video_canvas_t *canvas, uint8_t *trg, int width,
                          int pitcht)
 {
     viewport_t *viewport = canvas->viewport;
+    BENCHMARK_ENTER(BENCHMARK_RENDER);
+
 #ifdef VIDEO_SCALE_SOURCE
     xs /= canvas->videoconfig->scalex;
     ys /= canvas->videoconfig->scaley;
@@ -134,6 +138,8 @@ void video_canvas_render(video_canvas_t *canvas, uint8_t *trg, int width,
                       trg, width, height, xs, ys, xt, yt,
                       canvas->draw_buffer->draw_buffer_width, pitcht,
                       viewport);
+
+    BENCHMARK_LEAVE();
 }
 
 /** \brief Force refresh all tracked canvases.
@@ -28,9 +28,20 @@
 
 #include "vice.h"
 
+#include "videoarch.h"
+
 #include <stdio.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
+#include "archdep.h"
+#include "benchmark.h"
+#include "lib.h"
 #include "log.h"
+#include "machine-video.h"
 #include "machine.h"
 #include "render1x1.h"
 #include "render1x1pal.h"
@@ -45,7 +56,139 @@
 #include "types.h"
 #include "video-render.h"
 #include "video.h"
+#include "viewport.h"
+
+
+/* the smallest number of target lines worth a band of its own */
+#define MIN_BAND_LINES  64
+
+/* Get the number of bands to render a frame of height target lines in,
+   depending on the number of threads OpenMP can use. The bands after the
+   first one need line buffers of their own. */
+static int get_num_bands(video_render_color_tables_t *colortab, int height)
+{
+    int bands = 1;
+
+#ifdef _OPENMP
+    bands = omp_get_max_threads();
+#endif
+    if (bands > VIDEO_RENDER_MAX_BANDS) {
+        bands = VIDEO_RENDER_MAX_BANDS;
+    }
+    if (bands > height / MIN_BAND_LINES) {
+        bands = height / MIN_BAND_LINES;
+    }
+    if (bands > 1 && colortab->band_buffers == NULL) {
+        colortab->band_buffers = lib_calloc(VIDEO_RENDER_MAX_BANDS - 1, sizeof(video_render_band_buffers_t));
+    }
+    return bands < 1 ? 1 : bands;
+}
+
+/* Set up band i of a frame in num_bands bands. The 2x2 renderers need bands
+   of an even number of target lines; each band after the first one is set
+   up from the line above it, and each band before the last one leaves the
+   scanline below it to the next one, so that they give the same result as
+   rendering the frame at once. */
+static void get_band(video_render_color_tables_t *colortab, int i, int num_bands,
+                     int height, int line_step, video_render_band_t *band,
+                     int *band_y, int *band_height)
+{
+    int lines = height / line_step;
+    int first = lines * i / num_bands;
+    int last = lines * (i + 1) / num_bands;
+
+    if (i == 0) {
+        band->line_yuv_0 = colortab->line_yuv_0;
+        band->prevrgbline = colortab->prevrgbline;
+        band->rgbscratchbuffer = colortab->rgbscratchbuffer;
+    } else {
+        band->line_yuv_0 = colortab->band_buffers[i - 1].line_yuv_0;
+        band->prevrgbline = colortab->band_buffers[i - 1].prevrgbline;
+        band->rgbscratchbuffer = colortab->band_buffers[i - 1].rgbscratchbuffer;
+    }
+    band->above = i > 0;
+    band->below = i < num_bands - 1;
+
+    *band_y = first * line_step;
+    *band_height = i == num_bands - 1 ? height - *band_y : (last - first) * line_step;
+}
+
+/* render one band with CRT emulation */
+static void render_crt_band(video_render_config_t *config,
+                            uint8_t *src, uint8_t *trg,
+                            int width, int height, int xs, int ys, int xt,
+                            int yt, int pitchs, int pitcht,
+                            int crt_type,
+                            unsigned int viewport_first_line, unsigned int viewport_last_line,
+                            const video_render_band_t *band)
+{
+    video_render_color_tables_t *colortab = &config->color_tables;
+
+    if (config->rendermode == VIDEO_RENDER_PAL_NTSC_1X1) {
+        switch (crt_type) {
+            case VIDEO_CRT_TYPE_NTSC:
+                render_32_1x1_ntsc(colortab, src, trg, width, height,
+                                xs, ys, xt, yt, pitchs, pitcht);
+                return;
+            default:
+                /* fall through */
+            case VIDEO_CRT_TYPE_PAL:
+                render_32_1x1_pal(colortab, src, trg, width, height,
+                                xs, ys, xt, yt, pitchs, pitcht, config, band);
+                return;
+        }
+    } else {
+        switch (crt_type) {
+            case VIDEO_CRT_TYPE_NTSC:
+                render_32_2x2_ntsc(colortab, src, trg, width, height,
+                                   xs, ys, xt, yt, pitchs, pitcht,
+                                   viewport_first_line, viewport_last_line, config, band);
+                return;
+            default:
+                /* fall through */
+            case VIDEO_CRT_TYPE_PAL:
+                if (config->video_resources.delaylinetype == 1) {
+                    /* delay U only (1084 style) */
+                    render_32_2x2_pal_u(colortab, src, trg, width, height,
+                                        xs, ys, xt, yt, pitchs, pitcht,
+                                        viewport_first_line, viewport_last_line, config, band);
+                    return;
+                }
+                render_32_2x2_pal(colortab, src, trg, width, height,
+                                  xs, ys, xt, yt, pitchs, pitcht,
+                                  viewport_first_line, viewport_last_line, config, band);
+                return;
+        }
+    }
+}
+
+/* render with CRT emulation, in bands that are rendered in parallel */
+static void render_crt(video_render_config_t *config,
+                       uint8_t *src, uint8_t *trg,
+                       int width, int height, int xs, int ys, int xt,
+                       int yt, int pitchs, int pitcht,
+                       int crt_type,
+                       unsigned int viewport_first_line, unsigned int viewport_last_line)
+{
+    video_render_color_tables_t *colortab = &config->color_tables;
+    int line_step = config->rendermode == VIDEO_RENDER_PAL_NTSC_2X2 ? 2 : 1;
+    int num_bands;
+    int i;
+
+    /* the interlaced NTSC renderer is not split up */
+    num_bands = config->interlaced ? 1 : get_num_bands(colortab, height);
 
+#pragma omp parallel for schedule(static, 1) if (num_bands > 1)
+    for (i = 0; i < num_bands; i++) {
+        video_render_band_t band;
+        int band_y, band_height;
+
+        get_band(colortab, i, num_bands, height, line_step, &band, &band_y, &band_height);
+        render_crt_band(config, src, trg, width, band_height,
+                        xs, ys + band_y / line_step, xt, yt + band_y, pitchs, pitcht,
+                        crt_type, viewport_first_line, viewport_last_line, &band);
+    }
+}
 
 void video_render_pal_ntsc_main(video_render_config_t *config,
                            uint8_t *src, uint8_t *trg,
@@ -81,18 +224,10 @@ void video_render_pal_ntsc_main(video_render_config_t *config,
 
         case VIDEO_RENDER_PAL_NTSC_1X1:
             if (crtemulation) {
-                switch (crt_type) {
-                    case VIDEO_CRT_TYPE_NTSC:
-                        render_32_1x1_ntsc(colortab, src, trg, width, height,
-                                        xs, ys, xt, yt, pitchs, pitcht);
-                        return;
-                    default:
-                        /* fall through */
-                    case VIDEO_CRT_TYPE_PAL:
-                        render_32_1x1_pal(colortab, src, trg, width, height,
-                                        xs, ys, xt, yt, pitchs, pitcht, config);
-                        return;
-                }
+                render_crt(config, src, trg, width, height, xs, ys, xt, yt,
+                           pitchs, pitcht, crt_type,
+                           viewport_first_line, viewport_last_line);
+                return;
             } else {
                 render_32_1x1_04(colortab, src, trg, width, height,
                                  xs, ys, xt, yt, pitchs, pitcht);
@@ -101,27 +236,10 @@ void video_render_pal_ntsc_main(video_render_config_t *config,
             return;
         case VIDEO_RENDER_PAL_NTSC_2X2:
             if (crtemulation) {
-                switch (crt_type) {
-                    case VIDEO_CRT_TYPE_NTSC:
-                        render_32_2x2_ntsc(colortab, src, trg, width, height,
-                                           xs, ys, xt, yt, pitchs, pitcht,
-                                           viewport_first_line, viewport_last_line, config);
-                        return;
-                    default:
-                        /* fall through */
-                    case VIDEO_CRT_TYPE_PAL:
-                        if (config->video_resources.delaylinetype == 1) {
-                            /* delay U only (1084 style) */
-                            render_32_2x2_pal_u(colortab, src, trg, width, height,
-                                                xs, ys, xt, yt, pitchs, pitcht,
-                                                viewport_first_line, viewport_last_line, config);
-                            return;
-                        }
-                        render_32_2x2_pal(colortab, src, trg, width, height,
-                                          xs, ys, xt, yt, pitchs, pitcht,
-                                          viewport_first_line, viewport_last_line, config);
-                        return;
-                }
+                render_crt(config, src, trg, width, height, xs, ys, xt, yt,
+                           pitchs, pitcht, crt_type,
+                           viewport_first_line, viewport_last_line);
+                return;
             } else if (scale2x) {
                 render_32_scale2x(colortab, src, trg, width, height,
                                   xs, ys, xt, yt, pitchs, pitcht);
@@ -134,3 +252,215 @@ void video_render_pal_ntsc_main(video_render_config_t *config,
     }
     log_debug(LOG_DEFAULT, "video_render_pal_ntsc_main unsupported rendermode (%d)\n", rendermode);
 }
+
+/* -------------------------------------------------------------------------- */
+
+/* The "crt" micro benchmark times the CRT emulation renderers on a test
+   frame, and checks that the vectorized 2x2 PAL line renderer and the
+   rendering in bands give the same image as the scalar renderer in one
+   band. It uses a copy of the render config of the first canvas.  */
+
+#ifdef FEATURE_BENCHMARK_HOOKS
+
+/* Each renderer is timed for this long.  */
+#define CRT_BENCHMARK_SECONDS   0.5
+
+/* Number of renderer settings checked: 1x1/2x2, PAL/NTSC, UV/U delay line,
+   4 scanline shades, 4 source and target offsets.  */
+#define CRT_CHECK_SETTINGS      (2 * 2 * 2 * 4 * 4)
+
+static void crt_benchmark_setup(video_canvas_t *canvas, int rendermode, int crt_type,
+                                int delaylinetype, int scanlineshade)
+{
+    video_render_config_t *config = canvas->videoconfig;
+    unsigned int i;
+
+    config->rendermode = rendermode;
+    config->filter = VIDEO_FILTER_CRT;
+    config->interlaced = 0;
+    config->video_resources.delaylinetype = delaylinetype;
+    config->video_resources.pal_scanlineshade = scanlineshade;
+    canvas->viewport->crt_type = crt_type;
+
+    /* 32-bit ABGR, as the GTK3 renderers use */
+    for (i = 0; i < 256; i++) {
+        video_render_setrawrgb(&config->color_tables, i, i, i << 8, i << 16);
+    }
+    video_render_setrawalpha(&config->color_tables, 0xffU << 24);
+    video_render_initraw(config);
+    video_color_update_palette(canvas);
+}
+
+/* render the test frame at the given offsets into trg */
+static void crt_benchmark_render(video_canvas_t *canvas, const uint8_t *src,
+                                 int sw, int sh, uint8_t *trg, int pitcht, int offset)
+{
+    video_render_config_t *config = canvas->videoconfig;
+    int xs = 8 + (offset & 1), ys = 4 + (offset >> 1);
+    int xt = offset & 1, yt = (offset >> 1) * 2;
+    int width, height;
+
+    if (config->rendermode == VIDEO_RENDER_PAL_NTSC_2X2) {
+        width = (sw - 20) * 2 - 3 * (offset & 1);
+        height = (sh - 12) * 2;
+    } else {
+        width = sw - 20 - (offset & 1);
+        height = sh - 8;
+    }
+    video_render_pal_ntsc_main(config, (uint8_t *)src, trg, width, height,
+                               xs, ys, xt, yt, sw, pitcht,
+                               canvas->viewport->crt_type, 16, sh - 24);
+}
+
+static void crt_benchmark_set_threads(int threads)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+}
+
+static int crt_benchmark(void)
+{
+    static const int shades[] = { 0, 333, 667, 1000 };
+    static const int threads[] = { 2, 3, 4, 8 };
+    static const struct {
+        const char *test;
+        int rendermode;
+        int crt_type;
+        int delaylinetype;
+    } timed[] = {
+        { "2x2 PAL",   VIDEO_RENDER_PAL_NTSC_2X2, VIDEO_CRT_TYPE_PAL,  0 },
+        { "2x2 PAL-U", VIDEO_RENDER_PAL_NTSC_2X2, VIDEO_CRT_TYPE_PAL,  1 },
+        { "2x2 NTSC",  VIDEO_RENDER_PAL_NTSC_2X2, VIDEO_CRT_TYPE_NTSC, 0 },
+        { "1x1 PAL",   VIDEO_RENDER_PAL_NTSC_1X1, VIDEO_CRT_TYPE_PAL,  0 },
+        { "1x1 NTSC",  VIDEO_RENDER_PAL_NTSC_1X1, VIDEO_CRT_TYPE_NTSC, 0 }
+    };
+    video_canvas_t *canvas = machine_video_canvas_get(0);
+    video_render_config_t *saved_config;
+    video_render_config_t *config;
+    int saved_crt_type;
+    int max_threads = 1;
+    int vector;
+    int sw, sh, pitcht;
+    size_t size;
+    uint8_t *src, *ref, *out;
+    int setting, variant, num_variants;
+    unsigned long checks = 0, mismatches = 0;
+    unsigned int i;
+    int x, y;
+
+    if (canvas == NULL || canvas->videoconfig == NULL || canvas->draw_buffer == NULL
+        || canvas->videoconfig->cbm_palette == NULL) {
+        log_error(LOG_DEFAULT, "The CRT benchmark needs a canvas with a palette.");
+        return -1;
+    }
+#ifdef _OPENMP
+    max_threads = omp_get_max_threads();
+#endif
+    vector = render_32_2x2_pal_set_vector(1);
+
+    /* a test frame of all 16 colours in blocks and single pixel lines */
+    sw = (int)canvas->draw_buffer->draw_buffer_width;
+    sh = (int)canvas->draw_buffer->draw_buffer_height;
+    src = lib_malloc((size_t)sw * sh);
+    for (y = 0; y < sh; y++) {
+        for (x = 0; x < sw; x++) {
+            src[y * sw + x] = (uint8_t)(((x / 8) + (y / 8) * 3 + ((x ^ y) & 1) * (y & 4)) & 15);
+        }
+    }
+    pitcht = sw * 2 * 4 + 64;
+    size = (size_t)pitcht * (sh * 2 + 8);
+    ref = lib_malloc(size);
+    out = lib_malloc(size);
+
+    saved_config = canvas->videoconfig;
+    saved_crt_type = canvas->viewport->crt_type;
+    config = lib_malloc(sizeof(video_render_config_t));
+    *config = *saved_config;
+    config->color_tables.band_buffers = NULL;
+    canvas->videoconfig = config;
+
+    /* compare with the scalar renderer in one band */
+    num_variants = 1 + (int)(sizeof(threads) / sizeof(threads[0])) * 2;
+    for (setting = 0; setting < CRT_CHECK_SETTINGS; setting++) {
+        int offset = setting & 3;
+
+        crt_benchmark_setup(canvas,
+                            (setting & 64) ? VIDEO_RENDER_PAL_NTSC_2X2 : VIDEO_RENDER_PAL_NTSC_1X1,
+                            (setting & 32) ? VIDEO_CRT_TYPE_NTSC : VIDEO_CRT_TYPE_PAL,
+                            (setting >> 4) & 1, shades[(setting >> 2) & 3]);
+        render_32_2x2_pal_set_vector(0);
+        crt_benchmark_set_threads(1);
+        memset(ref, 0x5a, size);
+        crt_benchmark_render(canvas, src, sw, sh, ref, pitcht, offset);
+        for (variant = 1; variant < num_variants; variant++) {
+            /* the vectorized renderer in one band, then both renderers in
+               2, 3, 4 and 8 bands */
+            render_32_2x2_pal_set_vector(variant & 1);
+            crt_benchmark_set_threads(variant == 1 ? 1 : threads[(variant - 2) / 2]);
+            memset(out, 0x5a, size);
+            crt_benchmark_render(canvas, src, sw, sh, out, pitcht, offset);
+            checks++;
+            if (memcmp(ref, out, size) != 0) {
+                log_error(LOG_DEFAULT, "CRT benchmark: setting %d, variant %d differs.",
+                          setting, variant);
+                mismatches++;
+            }
+        }
+    }
+    crt_benchmark_set_threads(max_threads);
+
+    /* time each renderer with the default number of threads */
+    for (i = 0; i < sizeof(timed) / sizeof(timed[0]); i++) {
+        int pass;
+
+        for (pass = 0; pass < 2; pass++) {
+            char test[32];
+            unsigned long frames = 0;
+            tick_t start;
+            double seconds;
+
+            /* the 2x2 PAL renderer is timed scalar and vectorized */
+            if (pass == 1 && (i != 0 || !vector)) {
+                break;
+            }
+            crt_benchmark_setup(canvas, timed[i].rendermode, timed[i].crt_type,
+                                timed[i].delaylinetype, 667);
+            render_32_2x2_pal_set_vector(pass);
+            start = tick_now();
+            do {
+                crt_benchmark_render(canvas, src, sw, sh, out, pitcht, 0);
+                frames++;
+                seconds = (double)tick_now_delta(start) / tick_per_second();
+            } while (seconds < CRT_BENCHMARK_SECONDS);
+            sprintf(test, "%s%s", timed[i].test, i == 0 ? (pass ? " vector" : " scalar") : "");
+            benchmark_kernel_result("crt", test, seconds, (double)frames, "frames");
+        }
+    }
+    printf("Benchmark crt: %dx%d source, %d threads, %lu checks, %lu mismatches\n",
+           sw, sh, max_threads, checks, mismatches);
+
+    render_32_2x2_pal_set_vector(1);
+    canvas->videoconfig = saved_config;
+    canvas->viewport->crt_type = saved_crt_type;
+    video_color_update_palette(canvas);
+    lib_free(config->color_tables.band_buffers);
+    lib_free(config);
+    lib_free(out);
+    lib_free(ref);
+    lib_free(src);
+
+    return mismatches ? -1 : 0;
+}
+
+#endif
+
+/* Register the "crt" micro benchmark.  */
+void video_render_pal_ntsc_benchmark_init(void)
+{
+#ifdef FEATURE_BENCHMARK_HOOKS
+    benchmark_kernel_register("crt",
+                              "render the PAL/NTSC CRT emulation, check vector and band output",
+                              NULL, crt_benchmark);
+#endif
+}
@@ -30,6 +30,7 @@
 #include <stdio.h>
 
 #include "log.h"
+#include "render2x2pal.h"
 #include "types.h"
 #include "video-render.h"
 #include "video-sound.h"
@@ -49,6 +50,9 @@ void video_render_initconfig(video_render_config_t *config)
     for (i = 0; i < 256; i++) {
         config->color_tables.physical_colors[i] = 0;
     }
+
+    render_32_2x2_pal_init();
+    video_render_pal_ntsc_benchmark_init();
 }
 
 /* called from archdep code */
@@ -83,4 +83,6 @@ void video_render_crt_mono_main(video_render_config_t *config,
                                 int yt, int pitchs, int pitcht,
                                 unsigned int viewport_first_line, unsigned int viewport_last_line);
 
+void video_render_pal_ntsc_benchmark_init(void);
+
 #endif
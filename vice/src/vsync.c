@@ -50,6 +50,7 @@
 #endif
 
 #include "archdep.h"
+#include "benchmark.h"
 #include "cmdline.h"
 #include "debug.h"
 #include "joystick.h"
@@ -64,6 +65,7 @@
 #endif
 #include "network.h"
 #include "resources.h"
+#include "rewind.h"
 #include "sound.h"
 #include "types.h"
 #include "videoarch.h"
@@ -669,6 +671,7 @@ void vsync_do_vsync(struct video_canvas_s *c)
 
     tick_t now;
     tick_t network_hook_time = 0;
+    BENCHMARK_ENTER(BENCHMARK_OTHER);
 
     monitor_vsync_hook();
 
@@ -712,7 +715,11 @@ void vsync_do_vsync(struct video_canvas_s *c)
 
     execute_vsync_callbacks();
 
+    rewind_vsync_hook();
+
     kbdbuf_flush();
 
     last_vsync = now;
+
+    BENCHMARK_LEAVE();
 }
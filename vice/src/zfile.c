@@ -44,6 +44,9 @@
 #include <errno.h>
 #endif
 #include <zlib.h>
+#ifdef HAVE_LIBBZ2
+#include <bzlib.h>
+#endif
 
 #ifdef HAVE_STRINGS_H
 #include <strings.h>
@@ -91,6 +94,7 @@ struct zfile_s {
     struct zfile_s *prev, *next; /* Link to the previous and next nodes.  */
     zfile_action_t action;       /* action on close */
     char *request_string;        /* ui string for action=ZFILE_REQUEST */
+    uint8_t *buffer;             /* Uncompressed data behind a memory stream */
 };
 typedef struct zfile_s zfile_t;
 
@@ -134,6 +138,7 @@ static void zfile_list_destroy(void)
 
         lib_free(p->orig_name);
         lib_free(p->tmp_name);
+        lib_free(p->buffer);
         next = p->next;
         lib_free(p);
         p = next;
@@ -175,6 +180,7 @@ static void zfile_list_add(const char *tmp_name,
     new_zfile->type = type;
     new_zfile->action = ZFILE_KEEP;
     new_zfile->request_string = NULL;
+    new_zfile->buffer = NULL;
     new_zfile->next = zfile_list;
     new_zfile->prev = NULL;
     if (zfile_list != NULL) {
@@ -789,6 +795,485 @@ static enum compression_type try_uncompress(const char *name,
 
 /* ------------------------------------------------------------------------- */
 
+/* In-process uncompression.
+
+   Files that are opened read-only are uncompressed straight into memory and
+   handed out as a `fmemopen()' stream, which saves the helper process and
+   the temporary file.  Files opened for writing still go through a
+   temporary file, as they are recompressed when closed.  Whatever cannot
+   be handled here (lynx and tzx images, zip64 or encrypted archives, ...)
+   is left to the external tools above.  */
+
+#ifdef HAVE_FMEMOPEN
+
+/* Larger files are uncompressed into a temporary file instead.  */
+#define ZFILE_MEMORY_MAX    (64 * 1024 * 1024)
+
+#define ZFILE_CHUNK_SIZE    0x10000
+
+typedef struct zbuffer_s {
+    uint8_t *data;
+    size_t size;
+    size_t alloc;
+} zbuffer_t;
+
+static void zbuffer_free(zbuffer_t *buf)
+{
+    lib_free(buf->data);
+    buf->data = NULL;
+    buf->size = 0;
+    buf->alloc = 0;
+}
+
+/* Make room for `len' more bytes at the end of `buf' and return a pointer
+   to them, or NULL if this would exceed `ZFILE_MEMORY_MAX'.  */
+static uint8_t *zbuffer_reserve(zbuffer_t *buf, size_t len)
+{
+    if (len > ZFILE_MEMORY_MAX - buf->size) {
+        return NULL;
+    }
+    if (buf->size + len > buf->alloc) {
+        size_t alloc = buf->alloc ? buf->alloc : ZFILE_CHUNK_SIZE;
+
+        while (alloc < buf->size + len) {
+            alloc *= 2;
+        }
+        buf->data = lib_realloc(buf->data, alloc);
+        buf->alloc = alloc;
+    }
+    return buf->data + buf->size;
+}
+
+static int is_tar_name(const char *name)
+{
+    size_t l = strlen(name);
+
+    return (l > 7 && util_strcasecmp(name + l - 7, ".tar.gz") == 0)
+           || (l > 4 && util_strcasecmp(name + l - 4, ".tgz") == 0);
+}
+
+static int mem_uncompress_gzip(const char *name, zbuffer_t *buf)
+{
+    gzFile fdsrc;
+    uint8_t *p;
+    int len;
+
+    /* tarballs are left to tar */
+    if (!file_is_gzip(name) || is_tar_name(name)) {
+        return -1;
+    }
+
+    fdsrc = gzopen(name, MODE_READ);
+    if (fdsrc == NULL) {
+        return -1;
+    }
+
+    do {
+        p = zbuffer_reserve(buf, ZFILE_CHUNK_SIZE);
+        if (p == NULL) {
+            len = -1;
+            break;
+        }
+        len = gzread(fdsrc, p, ZFILE_CHUNK_SIZE);
+        if (len > 0) {
+            buf->size += (size_t)len;
+        }
+    } while (len > 0);
+
+    gzclose(fdsrc);
+
+    return len < 0 ? -1 : 0;
+}
+
+#ifdef HAVE_LIBBZ2
+static int mem_uncompress_bzip(const char *name, zbuffer_t *buf)
+{
+    FILE *fdsrc;
+    BZFILE *bz;
+    size_t l = strlen(name);
+    uint8_t *p;
+    void *unused;
+    int nunused;
+    int len;
+    int bzerr;
+    int retval = -1;
+
+    if (l < 5 || util_strcasecmp(name + l - 4, ".bz2") != 0) {
+        return -1;
+    }
+
+    fdsrc = fopen(name, MODE_READ);
+    if (fdsrc == NULL) {
+        return -1;
+    }
+
+    bz = BZ2_bzReadOpen(&bzerr, fdsrc, 0, 0, NULL, 0);
+    if (bzerr == BZ_OK) {
+        do {
+            p = zbuffer_reserve(buf, ZFILE_CHUNK_SIZE);
+            if (p == NULL) {
+                break;
+            }
+            len = BZ2_bzRead(&bzerr, bz, p, ZFILE_CHUNK_SIZE);
+            if (bzerr == BZ_OK || bzerr == BZ_STREAM_END) {
+                buf->size += (size_t)len;
+            }
+        } while (bzerr == BZ_OK);
+
+        /* Concatenated streams are left to the bzip2 tool.  */
+        if (bzerr == BZ_STREAM_END) {
+            BZ2_bzReadGetUnused(&bzerr, bz, &unused, &nunused);
+            if (bzerr == BZ_OK && nunused == 0 && fgetc(fdsrc) == EOF) {
+                retval = 0;
+            }
+        }
+    }
+    BZ2_bzReadClose(&bzerr, bz);
+    fclose(fdsrc);
+
+    return retval;
+}
+#endif
+
+/* Unpack the zipcode parts in `parts' into a D64 image in `buf'.  */
+static int mem_unpack_zipcode(FILE *parts[4], zbuffer_t *buf)
+{
+    uint8_t *p = zbuffer_reserve(buf, ZIPCODE_D64_SIZE);
+
+    if (p == NULL || zipcode_unpack_d64(parts, p) < 0) {
+        return -1;
+    }
+    buf->size += ZIPCODE_D64_SIZE;
+    return 0;
+}
+
+static int mem_uncompress_zipcode(const char *name, zbuffer_t *buf)
+{
+    FILE *parts[4] = { NULL, NULL, NULL, NULL };
+    char *part_name;
+    char *base;
+    int i;
+    int retval = -1;
+
+    part_name = lib_strdup(name);
+    base = strrchr(part_name, ARCHDEP_DIR_SEP_CHR);
+    base = base ? base + 1 : part_name;
+
+    if (strlen(base) >= 3 && is_zipcode_name(base)) {
+        for (i = 0; i < 4; i++) {
+            base[0] = (char)('1' + i);
+            parts[i] = fopen(part_name, MODE_READ);
+            if (parts[i] == NULL) {
+                break;
+            }
+        }
+        if (i == 4) {
+            retval = mem_unpack_zipcode(parts, buf);
+        }
+        for (i = 0; i < 4; i++) {
+            if (parts[i] != NULL) {
+                fclose(parts[i]);
+            }
+        }
+    }
+
+    lib_free(part_name);
+    return retval;
+}
+
+/* Zip archives: offsets into the central directory entry.  */
+#define ZIP_CDE_SIZE            46
+#define ZIP_CDE_FLAGS           8
+#define ZIP_CDE_METHOD          10
+#define ZIP_CDE_CRC             16
+#define ZIP_CDE_COMPRESSED      20
+#define ZIP_CDE_UNCOMPRESSED    24
+#define ZIP_CDE_NAME_LEN        28
+#define ZIP_CDE_EXTRA_LEN       30
+#define ZIP_CDE_COMMENT_LEN     32
+#define ZIP_CDE_OFFSET          42
+
+#define ZIP_EOCD_SIZE           22
+#define ZIP_LOCAL_SIZE          30
+
+#define ZIP_NAME_MAX            1024
+
+/* Extract the member described by the central directory entry `cde' of the
+   zip archive `fd', appending its data to `buf'.  */
+static int zip_extract(FILE *fd, uint8_t *cde, zbuffer_t *buf)
+{
+    uint8_t local[ZIP_LOCAL_SIZE];
+    uint8_t *data;
+    uint8_t *p;
+    unsigned int method = util_le_buf_to_word(cde + ZIP_CDE_METHOD);
+    uint32_t csize = util_le_buf_to_dword(cde + ZIP_CDE_COMPRESSED);
+    uint32_t usize = util_le_buf_to_dword(cde + ZIP_CDE_UNCOMPRESSED);
+    uint32_t offset = util_le_buf_to_dword(cde + ZIP_CDE_OFFSET);
+    z_stream zs;
+    int retval = -1;
+
+    /* no encryption, no zip64 */
+    if ((util_le_buf_to_word(cde + ZIP_CDE_FLAGS) & 1)
+        || csize == 0xffffffff || usize == 0xffffffff || offset == 0xffffffff
+        || (method != 0 && method != Z_DEFLATED)
+        || csize > ZFILE_MEMORY_MAX) {
+        return -1;
+    }
+
+    p = zbuffer_reserve(buf, usize);
+    if (p == NULL) {
+        return -1;
+    }
+
+    if (fseek(fd, (long)offset, SEEK_SET) < 0
+        || fread(local, ZIP_LOCAL_SIZE, 1, fd) < 1
+        || util_le_buf_to_dword(local) != 0x04034b50) {
+        return -1;
+    }
+    offset += ZIP_LOCAL_SIZE + util_le_buf_to_word(local + 26)
+              + util_le_buf_to_word(local + 28);
+
+    data = lib_malloc(csize + 1);
+    if (fseek(fd, (long)offset, SEEK_SET) < 0
+        || fread(data, 1, csize, fd) < csize) {
+        lib_free(data);
+        return -1;
+    }
+
+    if (method == 0) {
+        if (csize == usize) {
+            memcpy(p, data, usize);
+            retval = 0;
+        }
+    } else {
+        memset(&zs, 0, sizeof zs);
+        if (inflateInit2(&zs, -MAX_WBITS) == Z_OK) {
+            zs.next_in = data;
+            zs.avail_in = csize;
+            zs.next_out = p;
+            zs.avail_out = usize;
+            if (inflate(&zs, Z_FINISH) == Z_STREAM_END && zs.total_out == usize) {
+                retval = 0;
+            }
+            inflateEnd(&zs);
+        }
+    }
+    lib_free(data);
+
+    if (retval == 0
+        && crc32(0L, p, usize) != util_le_buf_to_dword(cde + ZIP_CDE_CRC)) {
+        ZDEBUG(("zip_extract: CRC error."));
+        retval = -1;
+    }
+    if (retval == 0) {
+        buf->size += usize;
+    }
+    return retval;
+}
+
+/* Find the central directory entry for `member' in `cd' and extract it.  */
+static int zip_extract_name(FILE *fd, uint8_t *cd, size_t cd_size,
+                            const char *member, zbuffer_t *buf)
+{
+    size_t pos = 0;
+    size_t len = strlen(member);
+    size_t name_len;
+
+    while (pos + ZIP_CDE_SIZE <= cd_size
+           && util_le_buf_to_dword(cd + pos) == 0x02014b50) {
+        name_len = util_le_buf_to_word(cd + pos + ZIP_CDE_NAME_LEN);
+        if (name_len == len && pos + ZIP_CDE_SIZE + name_len <= cd_size
+            && memcmp(cd + pos + ZIP_CDE_SIZE, member, len) == 0) {
+            return zip_extract(fd, cd + pos, buf);
+        }
+        pos += ZIP_CDE_SIZE + name_len
+               + util_le_buf_to_word(cd + pos + ZIP_CDE_EXTRA_LEN)
+               + util_le_buf_to_word(cd + pos + ZIP_CDE_COMMENT_LEN);
+    }
+    return -1;
+}
+
+/* Read the central directory of a zip archive and extract the first file
+   with a proper extension, like `try_uncompress_archive()' does with
+   `unzip'.  The four parts of a zipcoded disk are unpacked into a D64.  */
+static int mem_uncompress_zip(const char *name, zbuffer_t *buf)
+{
+    FILE *fd;
+    uint8_t *tail = NULL;
+    uint8_t *cd = NULL;
+    char member[ZIP_NAME_MAX + 1];
+    long size;
+    size_t tail_size;
+    size_t cd_size;
+    size_t pos;
+    size_t name_len;
+    uint32_t cd_offset;
+    int i;
+    int retval = -1;
+
+    pos = strlen(name);
+    if (pos <= 4 || util_strcasecmp(name + pos - 4, ".zip") != 0) {
+        return -1;
+    }
+
+    fd = fopen(name, MODE_READ);
+    if (fd == NULL) {
+        return -1;
+    }
+
+    /* The end of central directory record is followed by a comment of up
+       to 64 KiB.  */
+    if (fseek(fd, 0, SEEK_END) < 0 || (size = ftell(fd)) < ZIP_EOCD_SIZE) {
+        goto out;
+    }
+    tail_size = (size_t)size < ZIP_EOCD_SIZE + 0xffff
+                ? (size_t)size : ZIP_EOCD_SIZE + 0xffff;
+    tail = lib_malloc(tail_size);
+    if (fseek(fd, size - (long)tail_size, SEEK_SET) < 0
+        || fread(tail, 1, tail_size, fd) < tail_size) {
+        goto out;
+    }
+    pos = tail_size - ZIP_EOCD_SIZE + 1;
+    do {
+        if (pos-- == 0) {
+            goto out;
+        }
+    } while (util_le_buf_to_dword(tail + pos) != 0x06054b50);
+
+    cd_size = util_le_buf_to_dword(tail + pos + 12);
+    cd_offset = util_le_buf_to_dword(tail + pos + 16);
+    if (cd_offset == 0xffffffff || cd_size > ZFILE_MEMORY_MAX
+        || (long)cd_offset + (long)cd_size > size) {
+        goto out;
+    }
+    cd = lib_malloc(cd_size + 1);
+    if (fseek(fd, (long)cd_offset, SEEK_SET) < 0
+        || fread(cd, 1, cd_size, fd) < cd_size) {
+        goto out;
+    }
+
+    ZDEBUG(("mem_uncompress_zip: searching for the first valid file."));
+
+    pos = 0;
+    while (pos + ZIP_CDE_SIZE <= cd_size
+           && util_le_buf_to_dword(cd + pos) == 0x02014b50) {
+        name_len = util_le_buf_to_word(cd + pos + ZIP_CDE_NAME_LEN);
+        if (name_len <= ZIP_NAME_MAX && pos + ZIP_CDE_SIZE + name_len <= cd_size) {
+            memcpy(member, cd + pos + ZIP_CDE_SIZE, name_len);
+            member[name_len] = 0;
+            if (is_valid_extension(member, name_len, 0)) {
+                break;
+            }
+        }
+        pos += ZIP_CDE_SIZE + name_len
+               + util_le_buf_to_word(cd + pos + ZIP_CDE_EXTRA_LEN)
+               + util_le_buf_to_word(cd + pos + ZIP_CDE_COMMENT_LEN);
+    }
+    if (pos + ZIP_CDE_SIZE > cd_size
+        || util_le_buf_to_dword(cd + pos) != 0x02014b50) {
+        ZDEBUG(("mem_uncompress_zip: no valid file found."));
+        goto out;
+    }
+
+    ZDEBUG(("mem_uncompress_zip: found `%s'.", member));
+
+    if (is_zipcode_name(member)) {
+        zbuffer_t parts_buf[4];
+        FILE *parts[4] = { NULL, NULL, NULL, NULL };
+
+        memset(parts_buf, 0, sizeof parts_buf);
+        for (i = 0; i < 4; i++) {
+            member[0] = (char)('1' + i);
+            if (zip_extract_name(fd, cd, cd_size, member, &parts_buf[i]) < 0
+                || parts_buf[i].size == 0) {
+                break;
+            }
+            parts[i] = fmemopen(parts_buf[i].data, parts_buf[i].size, MODE_READ);
+            if (parts[i] == NULL) {
+                break;
+            }
+        }
+        if (i == 4) {
+            retval = mem_unpack_zipcode(parts, buf);
+        }
+        for (i = 0; i < 4; i++) {
+            if (parts[i] != NULL) {
+                fclose(parts[i]);
+            }
+            zbuffer_free(&parts_buf[i]);
+        }
+    } else {
+        retval = zip_extract(fd, cd + pos, buf);
+    }
+
+out:
+    lib_free(cd);
+    lib_free(tail);
+    fclose(fd);
+    return retval;
+}
+
+struct memory_uncompressor_s {
+    int (*uncompress)(const char *name, zbuffer_t *buf);
+    enum compression_type type;
+    int read_only;      /* cannot be written back */
+};
+typedef struct memory_uncompressor_s memory_uncompressor_t;
+
+static const memory_uncompressor_t memory_uncompressors[] = {
+    { mem_uncompress_zip,     COMPR_ARCHIVE, 1 },
+    { mem_uncompress_gzip,    COMPR_GZIP,    0 },
+#ifdef HAVE_LIBBZ2
+    { mem_uncompress_bzip,    COMPR_BZIP,    0 },
+#endif
+    { mem_uncompress_zipcode, COMPR_ZIPCODE, 1 },
+    { NULL, COMPR_NONE, 0 }
+};
+
+/* Try to uncompress file `name' into memory.  If this is not possible,
+   return `COMPR_NONE'.  Otherwise, return the type of algorithm used, a
+   read-only stream on the uncompressed data in `stream' and the buffer
+   behind it in `buffer', which must be freed after the stream is closed.
+   If `write_mode' is non-zero, only formats that cannot be written back
+   are tried, and `stream' is set to NULL if one of them matches.  */
+static enum compression_type try_uncompress_to_memory(const char *name,
+                                                      int write_mode,
+                                                      FILE **stream,
+                                                      uint8_t **buffer)
+{
+    zbuffer_t buf = { NULL, 0, 0 };
+    int i;
+
+    for (i = 0; memory_uncompressors[i].uncompress; i++) {
+        if (write_mode && !memory_uncompressors[i].read_only) {
+            continue;
+        }
+        if (memory_uncompressors[i].uncompress(name, &buf) == 0
+            && buf.size > 0) {
+            if (write_mode) {
+                ZDEBUG(("try_uncompress_to_memory: cannot open `%s' in write mode.",
+                        name));
+                zbuffer_free(&buf);
+                *stream = NULL;
+                return memory_uncompressors[i].type;
+            }
+            *stream = fmemopen(buf.data, buf.size, MODE_READ);
+            if (*stream != NULL) {
+                ZDEBUG(("try_uncompress_to_memory: `%s' uncompressed, %lu bytes.",
+                        name, (unsigned long)buf.size));
+                *buffer = buf.data;
+                return memory_uncompressors[i].type;
+            }
+        }
+        zbuffer_free(&buf);
+    }
+    return COMPR_NONE;
+}
+
+#endif /* HAVE_FMEMOPEN */
+
+/* ------------------------------------------------------------------------- */
+
 /* Compression.  */
 
 /* Compress `src' into `dest' using gzip.  */
@@ -972,6 +1457,9 @@ FILE *zfile_fopen(const char *name, const char *mode)
     FILE *stream;
     enum compression_type type;
     int write_mode = 0;
+#ifdef HAVE_FMEMOPEN
+    uint8_t *buffer = NULL;
+#endif
 
     if (!zinit_done) {
         zinit();
@@ -991,6 +1479,19 @@ FILE *zfile_fopen(const char *name, const char *mode)
         return NULL;
     }
 
+#ifdef HAVE_FMEMOPEN
+    type = try_uncompress_to_memory(name, write_mode, &stream, &buffer);
+    if (type != COMPR_NONE) {
+        if (stream == NULL) {
+            errno = EACCES;
+            return NULL;
+        }
+        zfile_list_add(NULL, name, type, write_mode, stream, NULL);
+        zfile_list->buffer = buffer;
+        return stream;
+    }
+#endif
+
     type = try_uncompress(name, &tmp_name, write_mode);
     if (type == COMPR_NONE) {
         stream = fopen(name, mode);
@@ -1086,6 +1587,9 @@ static int handle_close(zfile_t *ptr)
     if (ptr->request_string) {
         lib_free(ptr->request_string);
     }
+    if (ptr->buffer) {
+        lib_free(ptr->buffer);
+    }
 
     lib_free(ptr);
 
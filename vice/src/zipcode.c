@@ -28,6 +28,8 @@
 
 #include <stdio.h>
 
+#include <string.h>
+
 #include "types.h"
 #include "zipcode.h"
 
@@ -61,6 +63,9 @@ int zipcode_read_sector(FILE *zip_fd, int track, int *sector, char *buf)
             }
 
             if (chra != rep) {
+                if (count >= 256) {
+                    return -6;
+                }
                 buf[count++] = chra;
                 continue;
             }
@@ -71,6 +76,9 @@ int zipcode_read_sector(FILE *zip_fd, int track, int *sector, char *buf)
                 return 1;
             }
             i += 2;
+            if (count + repnum > 256) {
+                return -6;
+            }
             for (j = 0; j < repnum; j++) {
                 buf[count++] = chra;
             }
@@ -96,3 +104,46 @@ int zipcode_read_sector(FILE *zip_fd, int track, int *sector, char *buf)
 
     return 0;
 }
+
+/* Number of sectors on the 35 tracks of a 1541 disk.  */
+static int zipcode_sectors_per_track(int track)
+{
+    if (track <= 17) {
+        return 21;
+    } else if (track <= 24) {
+        return 19;
+    } else if (track <= 30) {
+        return 18;
+    }
+    return 17;
+}
+
+/* Unpack a zipcoded disk into a D64 image of `ZIPCODE_D64_SIZE' bytes.
+   `zip_fd' holds the four parts ("1!" to "4!") of the zipcode, which cover
+   tracks 1-8, 9-16, 17-25 and 26-35.  Return 0 on success, -1 if any part
+   is damaged.  */
+int zipcode_unpack_d64(FILE *zip_fd[4], uint8_t *image)
+{
+    static const int first_track[5] = { 1, 9, 17, 26, 36 };
+    int part, track, count, sectors, sector;
+    char buf[256];
+
+    for (part = 0; part < 4; part++) {
+        /* the first part has the disk id in front of the load address */
+        if (fseek(zip_fd[part], part == 0 ? 4 : 2, SEEK_SET) < 0) {
+            return -1;
+        }
+        for (track = first_track[part]; track < first_track[part + 1]; track++) {
+            sectors = zipcode_sectors_per_track(track);
+            for (count = 0; count < sectors; count++) {
+                if (zipcode_read_sector(zip_fd[part], track, &sector, buf) != 0
+                    || sector >= sectors) {
+                    return -1;
+                }
+                memcpy(image + sector * 256, buf, 256);
+            }
+            image += sectors * 256;
+        }
+    }
+    return 0;
+}
@@ -29,6 +29,12 @@
 
 #include <stdio.h>
 
+#include "types.h"
+
+/* Size of the 35 track D64 image produced by `zipcode_unpack_d64()'.  */
+#define ZIPCODE_D64_SIZE    174848
+
 int zipcode_read_sector(FILE *zip_fd, int track, int *sector, char *buf);
+int zipcode_unpack_d64(FILE *zip_fd[4], uint8_t *image);
 
 #endif /* _ZIPCODE_H */